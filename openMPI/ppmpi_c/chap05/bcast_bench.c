@@ -0,0 +1,163 @@
+/* bcast_bench.c -- compare the broadcasts in bcast_lib.c with
+ *     MPI_Bcast.
+ *
+ * Input:
+ *     max_size: largest message, in bytes
+ *     reps: number of broadcasts of each size
+ *     root: rank of the root
+ * Output:
+ *     The a, b and n read by the root, broadcast in one message
+ *     by Bcast_params.  Then for message sizes 1, 4, 16, ...,
+ *     max_size bytes, the mean time of one broadcast with MPI_Bcast,
+ *     with Bcast (automatic choice), and with each of the algorithms
+ *     in bcast_lib.c.  The data left by the last timed broadcast
+ *     are checked, and a time is followed by the number of wrong
+ *     bytes, summed over the processes, if there are any.
+ *
+ * See Chap 5, pp. 65 & ff in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+#include "bcast_lib.h"
+
+#define MPI_BCAST  BCAST_ALGORITHMS   /* Column for MPI_Bcast */
+
+#define Byte(i,alg) ((char) (((i)*7 + (alg)) & 0x7f))
+
+double Time_bcast(char* buf, int size, int alg, int reps, int root,
+           int my_rank);
+int    Bad_bytes(char* buf, int size, int alg);
+
+/********************************************************************/
+int main(int argc, char* argv[]) {
+    int           my_rank;
+    int           p;
+    float         a, b;
+    int           n;
+    void*         params[3];
+    int           counts[3] = {1, 1, 1};
+    MPI_Datatype  types[3];
+    int           input[3];
+    int           max_size, reps, root;
+    int           size, alg;
+    int           ok, all_ok;
+    int           bad, total_bad;
+    char*         buf;
+    double        elapsed, max_elapsed;
+    static char*  names[BCAST_ALGORITHMS + 1] = {"auto", "binomial",
+                      "scat-allg", "pipeline", "two-level", "MPI_Bcast"};
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &p);
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+
+    if (my_rank == 0) {
+        printf("Enter max size (bytes), reps, root\n");
+        scanf("%d %d %d", &input[0], &input[1], &input[2]);
+    }
+    MPI_Bcast(input, 3, MPI_INT, 0, MPI_COMM_WORLD);
+    max_size = input[0];
+    reps = (input[1] > 0 ? input[1] : 1);
+    root = input[2] % p;
+
+    /* The input for get_data1.c, in one message */
+    a = b = 0.0;
+    n = 0;
+    if (my_rank == root) {
+        a = 0.0;
+        b = 1.0;
+        n = 1024;
+    }
+    params[0] = &a;  types[0] = MPI_FLOAT;
+    params[1] = &b;  types[1] = MPI_FLOAT;
+    params[2] = &n;  types[2] = MPI_INT;
+    Bcast_params(3, params, counts, types, root, MPI_COMM_WORLD);
+    ok = (a == 0.0 && b == 1.0 && n == 1024);
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    if (my_rank == 0)
+        printf("Bcast_params:  a = %f, b = %f, n = %d on root, %s\n",
+            a, b, n, all_ok ? "ok on all processes" : "ERROR");
+
+    buf = (char*) malloc(max_size > 0 ? max_size : 1);
+    if (buf == (char*) NULL) {
+        fprintf(stderr, "Process %d > Can't allocate buffer\n", my_rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    if (my_rank == 0) {
+        printf("%10s", "bytes");
+        for (alg = 0; alg <= MPI_BCAST; alg++)
+            printf(" %11s", names[alg]);
+        printf("\n");
+    }
+    for (size = 1; size <= max_size; size *= 4) {
+        if (my_rank == 0)
+            printf("%10d", size);
+        for (alg = 0; alg <= MPI_BCAST; alg++) {
+            elapsed = Time_bcast(buf, size, alg, reps, root, my_rank);
+            bad = Bad_bytes(buf, size, alg);
+            MPI_Reduce(&elapsed, &max_elapsed, 1, MPI_DOUBLE, MPI_MAX, 0,
+                MPI_COMM_WORLD);
+            MPI_Reduce(&bad, &total_bad, 1, MPI_INT, MPI_SUM, 0,
+                MPI_COMM_WORLD);
+            if (my_rank == 0) {
+                printf(" %11.3e", max_elapsed);
+                if (total_bad > 0)
+                    printf(" (%d bad)", total_bad);
+            }
+        }
+        if (my_rank == 0)
+            printf("\n");
+        if (size > max_size/4) break;
+    }
+
+    free(buf);
+    Bcast_free(MPI_COMM_WORLD);
+    MPI_Finalize();
+    return 0;
+}  /* main */
+
+
+/********************************************************************/
+/* Mean time of reps broadcasts of size bytes from root.  The root's
+ *     bytes depend on alg, and the other processes' are zeroed first,
+ *     so Bad_bytes can tell whether the data arrived.
+ */
+double Time_bcast(
+           char*  buf      /* in/out */,
+           int    size     /* in     */,
+           int    alg      /* in     */,
+           int    reps     /* in     */,
+           int    root     /* in     */,
+           int    my_rank  /* in     */) {
+    int    i, rep;
+    double start;
+
+    for (i = 0; i < size; i++)
+        buf[i] = (my_rank == root ? Byte(i, alg) : 0);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+    for (rep = 0; rep < reps; rep++)
+        if (alg == MPI_BCAST)
+            MPI_Bcast(buf, size, MPI_CHAR, root, MPI_COMM_WORLD);
+        else
+            Bcast_alg(buf, size, MPI_CHAR, root, MPI_COMM_WORLD, alg);
+    return (MPI_Wtime() - start)/reps;
+}  /* Time_bcast */
+
+
+/********************************************************************/
+/* Number of bytes in buf that differ from the root's */
+int Bad_bytes(
+        char*  buf   /* in */,
+        int    size  /* in */,
+        int    alg   /* in */) {
+    int i;
+    int bad = 0;
+
+    for (i = 0; i < size; i++)
+        if (buf[i] != Byte(i, alg)) bad++;
+    return bad;
+}  /* Bad_bytes */
@@ -0,0 +1,502 @@
+/* bcast_lib.c -- broadcasts built from point-to-point communication.
+ *     Generalizes the tree-structured broadcast in get_data1.c to any
+ *     root, datatype and message size.
+ *
+ * Algorithms:
+ *     Binomial tree.  As in get_data1.c, the number of processes
+ *         that have the data doubles at each stage, so there are
+ *         ceiling(log_2(p)) stages.  But each process sends the whole
+ *         message at each stage, so for long messages the time is
+ *         about log_2(p) times the time to send the message once.
+ *     Scatter-allgather (van de Geijn).  The message is divided
+ *         into p blocks, which are scattered with a binomial tree,
+ *         and then gathered onto every process around a ring.  Each
+ *         process sends and receives about 2 times the message,
+ *         independent of p, at the cost of p-1 extra stages.
+ *     Pipeline.  The processes form a chain, and the message is
+ *         divided into segments of BCAST_SEGMENT bytes.  Each
+ *         process forwards segment k to its successor while it's
+ *         receiving segment k+1 from its predecessor.  For very long
+ *         messages, the time is about the time to send the message
+ *         once, plus p-2 segment times to fill the pipeline.
+ *     Two level.  The processes on each node (found with
+ *         MPI_Comm_split_type) elect a leader.  The leaders broadcast
+ *         among themselves, and then each leader broadcasts within
+ *         its node.  Each of these two broadcasts chooses one of the
+ *         algorithms above, so only one copy of the message crosses
+ *         the network to each node.
+ *
+ * Bcast chooses the algorithm by the size of the message, and uses
+ *     the two-level scheme when comm spans more than one node and
+ *     some node has more than one process.
+ *
+ * The trees use the numbering of MPICH's broadcast rather than
+ *     get_data1.c's:  process r receives from r - 2^k, where 2^k is
+ *     the lowest nonzero bit of r.  Then the processes that get their
+ *     data from r have consecutive ranks, so in the scatter each
+ *     process can receive the blocks for its subtree with a single
+ *     message.
+ *
+ * Noncontiguous datatypes are packed on the root, broadcast as
+ *     bytes, and unpacked.  So a derived datatype built with
+ *     MPI_Type_create_struct (see Bcast_params) carries several
+ *     variables in one message.
+ *
+ * Define EMULATE_NODE_SIZE=<s> to treat each block of s consecutive
+ *     ranks as a node.  This is useful for testing the two-level
+ *     broadcast on a single machine.
+ *
+ * See Chap 5, pp. 65 & ff in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "mpi.h"
+#include "bcast_lib.h"
+#include "block_dist.h"
+
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+#define BCAST_TAG 0
+
+/* Rank in comm of the process that's vrank processes after root */
+#define Real_rank(vrank,root,p) (((vrank) + (root)) % (p))
+
+/* Communicators and topology cached on the user's comm */
+typedef struct {
+    MPI_Comm  comm;          /* Dup of the user's comm            */
+    int       p;
+    int       my_rank;
+    MPI_Comm  node_comm;     /* Processes on my node              */
+    MPI_Comm  leader_comm;   /* Rank 0 of each node_comm.         */
+                             /*     MPI_COMM_NULL on the others   */
+    int       num_nodes;
+    int       max_node_size;
+    int*      node_rank;     /* node_rank[q] = q's rank in its    */
+                             /*     node_comm                     */
+    int*      leader_rank;   /* leader_rank[q] = rank in          */
+                             /*     leader_comm of q's leader     */
+} BCAST_INFO_T;
+
+static int bcast_key = MPI_KEYVAL_INVALID;
+
+static BCAST_INFO_T* Get_info(MPI_Comm comm);
+static int  Info_delete(MPI_Comm comm, int keyval, void* attr,
+                void* extra_state);
+static void Binomial(char* buf, int size, int root, MPI_Comm comm);
+static void Scatter_allgather(char* buf, int size, int root,
+                MPI_Comm comm);
+static void Pipeline(char* buf, int size, int root, MPI_Comm comm);
+static void Flat_bcast(char* buf, int size, int root, MPI_Comm comm,
+                int algorithm);
+static void Two_level(char* buf, int size, int root,
+                BCAST_INFO_T* info);
+
+/********************************************************************/
+int Bcast(
+        void*         buffer    /* in/out */,
+        int           count     /* in     */,
+        MPI_Datatype  datatype  /* in     */,
+        int           root      /* in     */,
+        MPI_Comm      comm      /* in     */) {
+    return Bcast_alg(buffer, count, datatype, root, comm, BCAST_AUTO);
+}  /* Bcast */
+
+
+/********************************************************************/
+int Bcast_alg(
+        void*         buffer     /* in/out */,
+        int           count      /* in     */,
+        MPI_Datatype  datatype   /* in     */,
+        int           root       /* in     */,
+        MPI_Comm      comm       /* in     */,
+        int           algorithm  /* in     */) {
+    BCAST_INFO_T*  info;
+    int            type_size;
+    int            size;
+    int            position;
+    MPI_Aint       lb, extent;
+    MPI_Aint       true_lb, true_extent;
+    char*          bytes;
+    char*          packed = (char*) NULL;
+
+    info = Get_info(comm);
+    if (info == (BCAST_INFO_T*) NULL)
+        return -1;
+    if (info->p == 1 || count == 0)
+        return 0;
+
+    MPI_Type_size(datatype, &type_size);
+    if (((long) count)*type_size > INT_MAX)
+        return -2;
+    MPI_Type_get_extent(datatype, &lb, &extent);
+    MPI_Type_get_true_extent(datatype, &true_lb, &true_extent);
+
+    if ((extent == type_size) && (true_extent == type_size)) {
+        /* The data are contiguous:  send them as they are */
+        size = count*type_size;
+        bytes = ((char*) buffer) + true_lb;
+    } else {
+        MPI_Pack_size(count, datatype, info->comm, &size);
+        packed = (char*) malloc(size > 0 ? size : 1);
+        if (packed == (char*) NULL)
+            return -1;
+        if (info->my_rank == root) {
+            position = 0;
+            MPI_Pack(buffer, count, datatype, packed, size, &position,
+                info->comm);
+        }
+        bytes = packed;
+    }
+
+    if (algorithm == BCAST_TWO_LEVEL ||
+            (algorithm == BCAST_AUTO && info->num_nodes > 1 &&
+             info->max_node_size > 1))
+        Two_level(bytes, size, root, info);
+    else
+        Flat_bcast(bytes, size, root, info->comm, algorithm);
+
+    if (packed != (char*) NULL) {
+        if (info->my_rank != root) {
+            position = 0;
+            MPI_Unpack(packed, size, &position, buffer, count, datatype,
+                info->comm);
+        }
+        free(packed);
+    }
+    return 0;
+}  /* Bcast_alg */
+
+
+/********************************************************************/
+/* Build a struct datatype with absolute addresses, and broadcast */
+/*     MPI_BOTTOM.                                                */
+int Bcast_params(
+        int            num_params  /* in     */,
+        void*          params[]    /* in/out */,
+        int            counts[]    /* in     */,
+        MPI_Datatype   types[]     /* in     */,
+        int            root        /* in     */,
+        MPI_Comm       comm        /* in     */) {
+    MPI_Aint*     displacements;
+    MPI_Datatype  param_mpi_t;
+    int           i;
+    int           retval;
+
+    displacements = (MPI_Aint*) malloc(
+        (num_params > 0 ? num_params : 1)*sizeof(MPI_Aint));
+    if (displacements == (MPI_Aint*) NULL)
+        return -1;
+    for (i = 0; i < num_params; i++)
+        MPI_Get_address(params[i], &displacements[i]);
+    MPI_Type_create_struct(num_params, counts, displacements, types,
+        &param_mpi_t);
+    MPI_Type_commit(&param_mpi_t);
+
+    retval = Bcast(MPI_BOTTOM, 1, param_mpi_t, root, comm);
+
+    MPI_Type_free(&param_mpi_t);
+    free(displacements);
+    return retval;
+}  /* Bcast_params */
+
+
+/********************************************************************/
+void Bcast_free(
+         MPI_Comm  comm  /* in */) {
+    int   flag;
+    void* info;
+
+    if (bcast_key == MPI_KEYVAL_INVALID) return;
+    MPI_Comm_get_attr(comm, bcast_key, &info, &flag);
+    if (flag)
+        MPI_Comm_delete_attr(comm, bcast_key);
+}  /* Bcast_free */
+
+
+/********************************************************************/
+/* Return the cached info for comm.  The first call on a comm builds */
+/*     it, so the first broadcast on a comm is collective over comm  */
+/*     in the stronger sense that every process must make it.        */
+static BCAST_INFO_T* Get_info(
+                         MPI_Comm  comm  /* in */) {
+    BCAST_INFO_T*  info;
+    int            flag;
+    int            node_size;
+    int            leader = 0;
+    int            local[2], global[2];
+    int            pair[2];
+    int*           pairs;
+    int            q;
+
+    if (bcast_key == MPI_KEYVAL_INVALID)
+        MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, Info_delete,
+            &bcast_key, NULL);
+    MPI_Comm_get_attr(comm, bcast_key, &info, &flag);
+    if (flag)
+        return info;
+
+    info = (BCAST_INFO_T*) malloc(sizeof(BCAST_INFO_T));
+    if (info == (BCAST_INFO_T*) NULL)
+        return info;
+
+    /* Our messages can't be confused with the user's */
+    MPI_Comm_dup(comm, &(info->comm));
+    MPI_Comm_size(info->comm, &(info->p));
+    MPI_Comm_rank(info->comm, &(info->my_rank));
+
+#ifdef EMULATE_NODE_SIZE
+    MPI_Comm_split(info->comm, info->my_rank/EMULATE_NODE_SIZE,
+        info->my_rank, &(info->node_comm));
+#else
+    MPI_Comm_split_type(info->comm, MPI_COMM_TYPE_SHARED, info->my_rank,
+        MPI_INFO_NULL, &(info->node_comm));
+#endif
+    MPI_Comm_rank(info->node_comm, &pair[0]);
+    MPI_Comm_size(info->node_comm, &node_size);
+    MPI_Comm_split(info->comm, (pair[0] == 0 ? 0 : MPI_UNDEFINED),
+        info->my_rank, &(info->leader_comm));
+    if (pair[0] == 0)
+        MPI_Comm_rank(info->leader_comm, &leader);
+    MPI_Bcast(&leader, 1, MPI_INT, 0, info->node_comm);
+    pair[1] = leader;
+
+    local[0] = leader + 1;
+    local[1] = node_size;
+    MPI_Allreduce(local, global, 2, MPI_INT, MPI_MAX, info->comm);
+    info->num_nodes = global[0];
+    info->max_node_size = global[1];
+
+    pairs = (int*) malloc(2*info->p*sizeof(int));
+    info->node_rank = (int*) malloc(2*info->p*sizeof(int));
+    if ((pairs == (int*) NULL) || (info->node_rank == (int*) NULL)) {
+        fprintf(stderr, "Process %d > Can't allocate bcast info\n",
+            info->my_rank);
+        MPI_Abort(comm, -1);
+    }
+    info->leader_rank = info->node_rank + info->p;
+    MPI_Allgather(pair, 2, MPI_INT, pairs, 2, MPI_INT, info->comm);
+    for (q = 0; q < info->p; q++) {
+        info->node_rank[q] = pairs[2*q];
+        info->leader_rank[q] = pairs[2*q + 1];
+    }
+    free(pairs);
+
+    MPI_Comm_set_attr(comm, bcast_key, info);
+    return info;
+}  /* Get_info */
+
+
+/********************************************************************/
+/* Called when the user's comm is freed or Bcast_free is called */
+static int Info_delete(
+               MPI_Comm  comm         /* in */,
+               int       keyval       /* in */,
+               void*     attr         /* in */,
+               void*     extra_state  /* in */) {
+    BCAST_INFO_T* info = (BCAST_INFO_T*) attr;
+
+    (void) comm;
+    (void) keyval;
+    (void) extra_state;
+    if (info->leader_comm != MPI_COMM_NULL)
+        MPI_Comm_free(&(info->leader_comm));
+    MPI_Comm_free(&(info->node_comm));
+    MPI_Comm_free(&(info->comm));
+    free(info->node_rank);
+    free(info);
+    return MPI_SUCCESS;
+}  /* Info_delete */
+
+
+/********************************************************************/
+/* Binomial tree.  vrank receives from vrank - mask, where mask is */
+/*     its lowest nonzero bit, and then sends to vrank + mask/2,   */
+/*     vrank + mask/4, ..., vrank + 1.                             */
+static void Binomial(
+                char*     buf   /* in/out */,
+                int       size  /* in     */,
+                int       root  /* in     */,
+                MPI_Comm  comm  /* in     */) {
+    int        p, my_rank, vrank;
+    int        mask;
+    MPI_Status status;
+
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &my_rank);
+    vrank = (my_rank - root + p) % p;
+
+    for (mask = 1; mask < p; mask <<= 1)
+        if (vrank & mask) {
+            MPI_Recv(buf, size, MPI_BYTE,
+                Real_rank(vrank - mask, root, p), BCAST_TAG, comm,
+                &status);
+            break;
+        }
+
+    for (mask >>= 1; mask > 0; mask >>= 1)
+        if (vrank + mask < p)
+            MPI_Send(buf, size, MPI_BYTE,
+                Real_rank(vrank + mask, root, p), BCAST_TAG, comm);
+}  /* Binomial */
+
+
+/********************************************************************/
+/* Block b of the message goes to vrank b.  The subtree of vrank in */
+/*     the binomial tree is vrank, ..., vrank + mask - 1, so it gets */
+/*     the corresponding blocks in one message.  Then the blocks go  */
+/*     around the ring:  at step s, each process sends the block it  */
+/*     got at step s-1 to vrank + 1.                                 */
+static void Scatter_allgather(
+                char*     buf   /* in/out */,
+                int       size  /* in     */,
+                int       root  /* in     */,
+                MPI_Comm  comm  /* in     */) {
+    int        p, my_rank, vrank;
+    int        mask;
+    int        lo, hi;
+    int        left, right;
+    int        step, send_block, recv_block;
+    MPI_Status status;
+
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &my_rank);
+    vrank = (my_rank - root + p) % p;
+
+    /* Scatter */
+    for (mask = 1; mask < p; mask <<= 1)
+        if (vrank & mask) {
+            lo = Block_low(vrank, p, size);
+            hi = Block_low(MIN(vrank + mask, p), p, size);
+            MPI_Recv(buf + lo, hi - lo, MPI_BYTE,
+                Real_rank(vrank - mask, root, p), BCAST_TAG, comm,
+                &status);
+            break;
+        }
+    for (mask >>= 1; mask > 0; mask >>= 1)
+        if (vrank + mask < p) {
+            lo = Block_low(vrank + mask, p, size);
+            hi = Block_low(MIN(vrank + 2*mask, p), p, size);
+            MPI_Send(buf + lo, hi - lo, MPI_BYTE,
+                Real_rank(vrank + mask, root, p), BCAST_TAG, comm);
+        }
+
+    /* Ring allgather */
+    left = Real_rank(vrank - 1 + p, root, p);
+    right = Real_rank(vrank + 1, root, p);
+    for (step = 0; step < p - 1; step++) {
+        send_block = (vrank - step + p) % p;
+        recv_block = (vrank - step - 1 + p) % p;
+        MPI_Sendrecv(buf + Block_low(send_block, p, size),
+            Block_size(send_block, p, size), MPI_BYTE, right, BCAST_TAG,
+            buf + Block_low(recv_block, p, size),
+            Block_size(recv_block, p, size), MPI_BYTE, left, BCAST_TAG,
+            comm, &status);
+    }
+}  /* Scatter_allgather */
+
+
+/********************************************************************/
+/* Chain root -> root+1 -> ... -> root-1.  The receive of segment */
+/*     k+1 is posted before segment k is forwarded.               */
+static void Pipeline(
+                char*     buf   /* in/out */,
+                int       size  /* in     */,
+                int       root  /* in     */,
+                MPI_Comm  comm  /* in     */) {
+    int         p, my_rank, vrank;
+    int         left, right;
+    int         segments, k;
+    int         lo;
+    MPI_Request recv_request = MPI_REQUEST_NULL;
+    MPI_Request send_request = MPI_REQUEST_NULL;
+
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &my_rank);
+    vrank = (my_rank - root + p) % p;
+    left = Real_rank(vrank - 1 + p, root, p);
+    right = Real_rank(vrank + 1, root, p);
+    segments = (size + BCAST_SEGMENT - 1)/BCAST_SEGMENT;
+
+    if (vrank > 0 && segments > 0)
+        MPI_Irecv(buf, MIN(BCAST_SEGMENT, size), MPI_BYTE, left,
+            BCAST_TAG, comm, &recv_request);
+    for (k = 0; k < segments; k++) {
+        lo = k*BCAST_SEGMENT;
+        if (vrank > 0) {
+            MPI_Wait(&recv_request, MPI_STATUS_IGNORE);
+            if (k + 1 < segments)
+                MPI_Irecv(buf + lo + BCAST_SEGMENT,
+                    MIN(BCAST_SEGMENT, size - lo - BCAST_SEGMENT),
+                    MPI_BYTE, left, BCAST_TAG, comm, &recv_request);
+        }
+        if (vrank < p - 1) {
+            MPI_Wait(&send_request, MPI_STATUS_IGNORE);
+            MPI_Isend(buf + lo, MIN(BCAST_SEGMENT, size - lo), MPI_BYTE,
+                right, BCAST_TAG, comm, &send_request);
+        }
+    }
+    MPI_Wait(&send_request, MPI_STATUS_IGNORE);
+}  /* Pipeline */
+
+
+/********************************************************************/
+/* One of the single-level algorithms.  BCAST_AUTO (or            */
+/*     BCAST_TWO_LEVEL, inside Two_level) chooses by size.        */
+static void Flat_bcast(
+                char*     buf        /* in/out */,
+                int       size       /* in     */,
+                int       root       /* in     */,
+                MPI_Comm  comm       /* in     */,
+                int       algorithm  /* in     */) {
+    int p;
+
+    MPI_Comm_size(comm, &p);
+    if (p == 1) return;
+
+    if (algorithm != BCAST_BINOMIAL &&
+            algorithm != BCAST_SCATTER_ALLGATHER &&
+            algorithm != BCAST_PIPELINE) {
+        if (size < BCAST_SHORT || size < p)
+            algorithm = BCAST_BINOMIAL;
+        else if (size < BCAST_LONG)
+            algorithm = BCAST_SCATTER_ALLGATHER;
+        else
+            algorithm = BCAST_PIPELINE;
+    }
+
+    if (algorithm == BCAST_BINOMIAL)
+        Binomial(buf, size, root, comm);
+    else if (algorithm == BCAST_SCATTER_ALLGATHER)
+        Scatter_allgather(buf, size, root, comm);
+    else
+        Pipeline(buf, size, root, comm);
+}  /* Flat_bcast */
+
+
+/********************************************************************/
+/* If the root isn't its node's leader, it first sends the message */
+/*     to the leader.  Then the leaders broadcast, and each leader  */
+/*     broadcasts to its node.                                      */
+static void Two_level(
+                char*          buf   /* in/out */,
+                int            size  /* in     */,
+                int            root  /* in     */,
+                BCAST_INFO_T*  info  /* in     */) {
+    int        my_rank = info->my_rank;
+    int        root_node_rank = info->node_rank[root];
+    MPI_Status status;
+
+    if (root_node_rank != 0) {
+        if (my_rank == root)
+            MPI_Send(buf, size, MPI_BYTE, 0, BCAST_TAG, info->node_comm);
+        else if (info->node_rank[my_rank] == 0 &&
+                 info->leader_rank[my_rank] == info->leader_rank[root])
+            MPI_Recv(buf, size, MPI_BYTE, root_node_rank, BCAST_TAG,
+                info->node_comm, &status);
+    }
+
+    if (info->leader_comm != MPI_COMM_NULL)
+        Flat_bcast(buf, size, info->leader_rank[root],
+            info->leader_comm, BCAST_AUTO);
+    Flat_bcast(buf, size, 0, info->node_comm, BCAST_AUTO);
+}  /* Two_level */
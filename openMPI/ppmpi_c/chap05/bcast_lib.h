@@ -0,0 +1,53 @@
+/* bcast_lib.h -- definitions and declarations for bcast_lib.c,
+ *     broadcasts built from point-to-point communication.
+ *
+ * See bcast_lib.c
+ */
+#ifndef BCAST_LIB_H
+#define BCAST_LIB_H
+
+#include "mpi.h"
+
+/* Algorithms */
+#define BCAST_AUTO              0  /* Choose by size and topology  */
+#define BCAST_BINOMIAL          1
+#define BCAST_SCATTER_ALLGATHER 2
+#define BCAST_PIPELINE          3
+#define BCAST_TWO_LEVEL         4  /* Leaders, then within nodes    */
+#define BCAST_ALGORITHMS        5
+
+/* BCAST_AUTO uses the binomial tree for messages of fewer than  */
+/*     BCAST_SHORT bytes, scatter-allgather for fewer than       */
+/*     BCAST_LONG bytes, and the pipeline for the rest.          */
+#ifndef BCAST_SHORT
+#define BCAST_SHORT  12288
+#endif
+#ifndef BCAST_LONG
+#define BCAST_LONG   (1 << 22)
+#endif
+
+/* Bytes in each message of the pipeline */
+#ifndef BCAST_SEGMENT
+#define BCAST_SEGMENT  (1 << 17)
+#endif
+
+/* All return 0 on success and a negative value if malloc fails or */
+/*     the message has more than INT_MAX bytes.  The arguments are */
+/*     the same as MPI_Bcast's, and they must be the same on every */
+/*     process.                                                    */
+int  Bcast(void* buffer, int count, MPI_Datatype datatype, int root,
+         MPI_Comm comm);
+int  Bcast_alg(void* buffer, int count, MPI_Datatype datatype, int root,
+         MPI_Comm comm, int algorithm);
+
+/* Broadcast num_params variables, e.g., the input a, b and n in    */
+/*     get_data1.c, in one message.  params[i] is the address of    */
+/*     counts[i] elements of type types[i].                         */
+int  Bcast_params(int num_params, void* params[], int counts[],
+         MPI_Datatype types[], int root, MPI_Comm comm);
+
+/* The communicators used by the broadcasts are cached on comm.     */
+/*     They're freed when comm is freed, or by Bcast_free.          */
+void Bcast_free(MPI_Comm comm);
+
+#endif
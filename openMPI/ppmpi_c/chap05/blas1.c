@@ -0,0 +1,436 @@
+/* blas1.c -- distributed vector operations for iterative solvers.
+ *     Based on parallel_dot1.c, but
+ *
+ *     1.  The vectors are distributed by blocks with Block_low and
+ *         Block_size, so n needn't be divisible by p, and they're
+ *         allocated on the heap.  Vectors with the same partition
+ *         share a VEC_LAYOUT_T, which is set up once.
+ *     2.  A solver usually needs several dot products or norms at
+ *         the same point of an iteration, and each MPI_Allreduce of
+ *         a single scalar costs about as much as one of 16 scalars.
+ *         So the local values are collected in a REDUCTION_T, and
+ *         they're all added with one MPI_Iallreduce.  Since the
+ *         reduction is nonblocking, the caller can do local work
+ *         between Start_reduction and Finish_reduction.
+ *     3.  Add_axpy_dot computes y = alpha*x + y and the local part
+ *         of y.z in one pass through the vectors.
+ *     4.  The local sums are compensated (Kahan summation), and
+ *         each kernel keeps SUM_LANES independent sums, so the
+ *         compiler can use SIMD instructions without reordering
+ *         the floating point additions.
+ *     5.  The order in which MPI_Iallreduce adds the processes'
+ *         values depends on the implementation, and can change
+ *         with the message sizes or the placement of the processes.
+ *         With DETERMINISTIC_ORDER the local values are gathered
+ *         onto every process with MPI_Iallgather, and added in
+ *         rank order, so for a given p the results are the same on
+ *         every process and in every run.  This costs p values per
+ *         reduction on each process, so it's only worthwhile for
+ *         debugging, or when reproducibility is required.
+ *
+ * The nonblocking collectives need an MPI-3 implementation.
+ *
+ * See Chap 5, pp. 76 & ff in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "mpi.h"
+#include "blas1.h"
+
+static double Sum_lanes(double sum[], double comp[]);
+static double Local_dot(int n, double* x, double* y);
+static double Local_axpy_dot(int n, double alpha, double* x, double* y,
+                  double* z);
+
+/*****************************************************************/
+/* Returns 0 on success, negative if n < 0 */
+int Setup_vec_layout(
+        VEC_LAYOUT_T*  layout  /* out */,
+        int            n       /* in  */,
+        int            order   /* in  */,
+        MPI_Comm       comm    /* in  */) {
+
+    if (n < 0) return -1;
+
+    /* Keep our reductions separate from the user's messages */
+    MPI_Comm_dup(comm, &(layout->comm));
+    MPI_Comm_size(layout->comm, &(layout->p));
+    MPI_Comm_rank(layout->comm, &(layout->my_rank));
+    layout->n = n;
+    layout->local_n = Block_size(layout->my_rank, layout->p, n);
+    layout->first = Block_low(layout->my_rank, layout->p, n);
+    layout->order = order;
+    return 0;
+}  /* Setup_vec_layout */
+
+
+/*****************************************************************/
+void Free_vec_layout(
+         VEC_LAYOUT_T*  layout  /* in/out */) {
+    MPI_Comm_free(&(layout->comm));
+}  /* Free_vec_layout */
+
+
+/*****************************************************************/
+/* Returns NULL if malloc fails */
+DIST_VEC_T* Allocate_vec(
+                VEC_LAYOUT_T*  layout  /* in */) {
+    DIST_VEC_T* temp;
+
+    temp = (DIST_VEC_T*) malloc(sizeof(DIST_VEC_T));
+    if (temp == (DIST_VEC_T*) NULL)
+        return temp;
+    temp->layout = layout;
+
+    /* A process may have no entries */
+    temp->entries = (double*) malloc(
+        (layout->local_n > 0 ? layout->local_n : 1)*sizeof(double));
+    if (temp->entries == (double*) NULL) {
+        free(temp);
+        return (DIST_VEC_T*) NULL;
+    }
+    return temp;
+}  /* Allocate_vec */
+
+
+/*****************************************************************/
+void Free_vec(
+         DIST_VEC_T**  x_ptr  /* in/out */) {
+    free((*x_ptr)->entries);
+    free(*x_ptr);
+    *x_ptr = (DIST_VEC_T*) NULL;
+}  /* Free_vec */
+
+
+/*****************************************************************/
+/* Returns 0 on success, negative if malloc fails */
+int Setup_reduction(
+        REDUCTION_T*   red     /* out */,
+        VEC_LAYOUT_T*  layout  /* in  */) {
+
+    red->layout = layout;
+    red->count = 0;
+    red->request = MPI_REQUEST_NULL;
+    if (layout->order == DETERMINISTIC_ORDER) {
+        red->gathered = (double*) malloc(
+            layout->p*MAX_BATCH*sizeof(double));
+        if (red->gathered == (double*) NULL)
+            return -1;
+    } else {
+        red->gathered = (double*) NULL;
+    }
+    return 0;
+}  /* Setup_reduction */
+
+
+/*****************************************************************/
+void Free_reduction(
+         REDUCTION_T*  red  /* in/out */) {
+    if (red->request != MPI_REQUEST_NULL)
+        MPI_Wait(&(red->request), MPI_STATUS_IGNORE);
+    if (red->gathered != (double*) NULL)
+        free(red->gathered);
+    red->gathered = (double*) NULL;
+}  /* Free_reduction */
+
+
+/*****************************************************************/
+void Vec_set(
+         double       alpha  /* in  */,
+         DIST_VEC_T*  x      /* out */) {
+    int i;
+
+    for (i = 0; i < Local_n(x); i++)
+        x->entries[i] = alpha;
+}  /* Vec_set */
+
+
+/*****************************************************************/
+/* y = x */
+void Vec_copy(
+         DIST_VEC_T*  x  /* in  */,
+         DIST_VEC_T*  y  /* out */) {
+    int i;
+
+    for (i = 0; i < Local_n(x); i++)
+        y->entries[i] = x->entries[i];
+}  /* Vec_copy */
+
+
+/*****************************************************************/
+/* x = alpha*x */
+void Vec_scal(
+         double       alpha  /* in     */,
+         DIST_VEC_T*  x      /* in/out */) {
+    int i;
+
+    for (i = 0; i < Local_n(x); i++)
+        x->entries[i] *= alpha;
+}  /* Vec_scal */
+
+
+/*****************************************************************/
+/* y = alpha*x + y */
+void Vec_axpy(
+         double       alpha  /* in     */,
+         DIST_VEC_T*  x      /* in     */,
+         DIST_VEC_T*  y      /* in/out */) {
+    int i;
+
+    for (i = 0; i < Local_n(x); i++)
+        y->entries[i] += alpha*x->entries[i];
+}  /* Vec_axpy */
+
+
+/*****************************************************************/
+/* y = x + alpha*y, e.g., the update of the search direction */
+/*     in CG                                                 */
+void Vec_aypx(
+         double       alpha  /* in     */,
+         DIST_VEC_T*  x      /* in     */,
+         DIST_VEC_T*  y      /* in/out */) {
+    int i;
+
+    for (i = 0; i < Local_n(x); i++)
+        y->entries[i] = x->entries[i] + alpha*y->entries[i];
+}  /* Vec_aypx */
+
+
+/*****************************************************************/
+/* Add the SUM_LANES compensated partial sums */
+static double Sum_lanes(
+                  double  sum[]   /* in */,
+                  double  comp[]  /* in */) {
+    int    l;
+    double total = 0.0;
+    double c = 0.0;
+    double term, temp;
+
+    for (l = 0; l < SUM_LANES; l++) {
+        term = sum[l] - comp[l] - c;
+        temp = total + term;
+        c = (temp - total) - term;
+        total = temp;
+    }
+    return total;
+}  /* Sum_lanes */
+
+
+/*****************************************************************/
+/* Kahan summation of x[i]*y[i].  Lane l adds the products for
+ *     i = l, l + SUM_LANES, l + 2*SUM_LANES, ..., and comp[l] is
+ *     the rounding error in sum[l] that hasn't been added yet.
+ *     The lanes are independent, so the inner loop can be done
+ *     with SIMD instructions.  Don't compile with options that
+ *     allow the compiler to reassociate floating point sums
+ *     (e.g., -ffast-math):  they can remove the compensation.
+ */
+static double Local_dot(
+                  int      n  /* in */,
+                  double*  x  /* in */,
+                  double*  y  /* in */) {
+    int    i, l;
+    int    n_lanes = n - n % SUM_LANES;
+    double sum[SUM_LANES];
+    double comp[SUM_LANES];
+    double term, temp;
+
+    for (l = 0; l < SUM_LANES; l++)
+        sum[l] = comp[l] = 0.0;
+    for (i = 0; i < n_lanes; i += SUM_LANES)
+        for (l = 0; l < SUM_LANES; l++) {
+            term = x[i+l]*y[i+l] - comp[l];
+            temp = sum[l] + term;
+            comp[l] = (temp - sum[l]) - term;
+            sum[l] = temp;
+        }
+    for (i = n_lanes; i < n; i++) {
+        term = x[i]*y[i] - comp[0];
+        temp = sum[0] + term;
+        comp[0] = (temp - sum[0]) - term;
+        sum[0] = temp;
+    }
+    return Sum_lanes(sum, comp);
+}  /* Local_dot */
+
+
+/*****************************************************************/
+/* y = alpha*x + y, and return the compensated sum of y[i]*z[i]. */
+/*     z may be y.                                               */
+static double Local_axpy_dot(
+                  int      n      /* in     */,
+                  double   alpha  /* in     */,
+                  double*  x      /* in     */,
+                  double*  y      /* in/out */,
+                  double*  z      /* in     */) {
+    int    i, l;
+    int    n_lanes = n - n % SUM_LANES;
+    double sum[SUM_LANES];
+    double comp[SUM_LANES];
+    double term, temp;
+
+    for (l = 0; l < SUM_LANES; l++)
+        sum[l] = comp[l] = 0.0;
+    for (i = 0; i < n_lanes; i += SUM_LANES)
+        for (l = 0; l < SUM_LANES; l++) {
+            y[i+l] += alpha*x[i+l];
+            term = y[i+l]*z[i+l] - comp[l];
+            temp = sum[l] + term;
+            comp[l] = (temp - sum[l]) - term;
+            sum[l] = temp;
+        }
+    for (i = n_lanes; i < n; i++) {
+        y[i] += alpha*x[i];
+        term = y[i]*z[i] - comp[0];
+        temp = sum[0] + term;
+        comp[0] = (temp - sum[0]) - term;
+        sum[0] = temp;
+    }
+    return Sum_lanes(sum, comp);
+}  /* Local_axpy_dot */
+
+
+/*****************************************************************/
+/* Add the local part of x.y to the batch */
+int Add_dot(
+        REDUCTION_T*  red  /* in/out */,
+        DIST_VEC_T*   x    /* in     */,
+        DIST_VEC_T*   y    /* in     */) {
+
+    if ((red->count >= MAX_BATCH) || (red->request != MPI_REQUEST_NULL))
+        return -1;
+    red->is_norm[red->count] = 0;
+    red->local[red->count] = Local_dot(Local_n(x), x->entries,
+        y->entries);
+    return red->count++;
+}  /* Add_dot */
+
+
+/*****************************************************************/
+/* Add the local part of ||x||_2^2 to the batch.  The square  */
+/*     root is taken by Finish_reduction.                     */
+int Add_nrm2(
+        REDUCTION_T*  red  /* in/out */,
+        DIST_VEC_T*   x    /* in     */) {
+
+    if ((red->count >= MAX_BATCH) || (red->request != MPI_REQUEST_NULL))
+        return -1;
+    red->is_norm[red->count] = 1;
+    red->local[red->count] = Local_dot(Local_n(x), x->entries,
+        x->entries);
+    return red->count++;
+}  /* Add_nrm2 */
+
+
+/*****************************************************************/
+/* y = alpha*x + y, and add the local part of y.z to the batch. */
+/*     If the batch can't take it, y isn't changed.             */
+int Add_axpy_dot(
+        REDUCTION_T*  red    /* in/out */,
+        double        alpha  /* in     */,
+        DIST_VEC_T*   x      /* in     */,
+        DIST_VEC_T*   y      /* in/out */,
+        DIST_VEC_T*   z      /* in     */) {
+
+    if ((red->count >= MAX_BATCH) || (red->request != MPI_REQUEST_NULL))
+        return -1;
+    red->is_norm[red->count] = 0;
+    red->local[red->count] = Local_axpy_dot(Local_n(x), alpha,
+        x->entries, y->entries, z->entries);
+    return red->count++;
+}  /* Add_axpy_dot */
+
+
+/*****************************************************************/
+/* Start adding the values in the batch across the processes.  */
+/*     The Add functions refuse new values until the reduction  */
+/*     is finished, since the local values mustn't change.      */
+void Start_reduction(
+         REDUCTION_T*  red  /* in/out */) {
+    VEC_LAYOUT_T* layout = red->layout;
+
+    if (layout->order == DETERMINISTIC_ORDER)
+        MPI_Iallgather(red->local, red->count, MPI_DOUBLE,
+            red->gathered, red->count, MPI_DOUBLE, layout->comm,
+            &(red->request));
+    else
+        MPI_Iallreduce(red->local, red->global, red->count, MPI_DOUBLE,
+            MPI_SUM, layout->comm, &(red->request));
+}  /* Start_reduction */
+
+
+/*****************************************************************/
+/* Wait for the reduction, and empty the batch.  The results are */
+/*     available with Reduction_value until the next reduction   */
+/*     is finished.                                              */
+void Finish_reduction(
+         REDUCTION_T*  red  /* in/out */) {
+    VEC_LAYOUT_T* layout = red->layout;
+    int           slot, q;
+    double        sum, c, term, temp;
+
+    MPI_Wait(&(red->request), MPI_STATUS_IGNORE);
+
+    if (layout->order == DETERMINISTIC_ORDER) {
+        /* Process q's values are in gathered[q*count], ... */
+        for (slot = 0; slot < red->count; slot++) {
+            sum = c = 0.0;
+            for (q = 0; q < layout->p; q++) {
+                term = red->gathered[q*red->count + slot] - c;
+                temp = sum + term;
+                c = (temp - sum) - term;
+                sum = temp;
+            }
+            red->global[slot] = sum;
+        }
+    }
+
+    for (slot = 0; slot < red->count; slot++)
+        if (red->is_norm[slot])
+            red->global[slot] = sqrt(red->global[slot]);
+    red->count = 0;
+}  /* Finish_reduction */
+
+
+/*****************************************************************/
+/* Blocking x.y.  Any values already in the batch are reduced too, */
+/*     and a pending reduction is finished, so its values are       */
+/*     replaced.                                                    */
+double Dot(
+           REDUCTION_T*  red  /* in/out */,
+           DIST_VEC_T*   x    /* in     */,
+           DIST_VEC_T*   y    /* in     */) {
+    int slot;
+
+    slot = Add_dot(red, x, y);
+    if (slot < 0) {
+        /* Batch is full or being reduced:  flush it and try again */
+        if (red->request == MPI_REQUEST_NULL) Start_reduction(red);
+        Finish_reduction(red);
+        slot = Add_dot(red, x, y);
+    }
+    Start_reduction(red);
+    Finish_reduction(red);
+    return Reduction_value(red, slot);
+}  /* Dot */
+
+
+/*****************************************************************/
+/* Blocking ||x||_2.  As with Dot, values already in the batch    */
+/*     are reduced too.                                           */
+double Nrm2(
+           REDUCTION_T*  red  /* in/out */,
+           DIST_VEC_T*   x    /* in     */) {
+    int slot;
+
+    slot = Add_nrm2(red, x);
+    if (slot < 0) {
+        if (red->request == MPI_REQUEST_NULL) Start_reduction(red);
+        Finish_reduction(red);
+        slot = Add_nrm2(red, x);
+    }
+    Start_reduction(red);
+    Finish_reduction(red);
+    return Reduction_value(red, slot);
+}  /* Nrm2 */
@@ -0,0 +1,93 @@
+/* blas1.h -- definitions and declarations for blas1.c, distributed
+ *     vector operations with batched reductions.
+ *
+ * See blas1.c
+ */
+#ifndef BLAS1_H
+#define BLAS1_H
+
+#include "mpi.h"
+#include "block_dist.h"
+
+/* Reduction orders */
+#define FAST_ORDER           0  /* Whatever MPI_Iallreduce does */
+#define DETERMINISTIC_ORDER  1  /* Always by rank               */
+
+/* Maximum number of values in one batched reduction */
+#ifndef MAX_BATCH
+#define MAX_BATCH 16
+#endif
+
+/* Number of independent compensated sums in the local kernels */
+#ifndef SUM_LANES
+#define SUM_LANES 4
+#endif
+
+/* The partition of an order n vector among the processes in comm. */
+/*     Every vector with the same partition shares one of these.    */
+typedef struct {
+    MPI_Comm  comm;      /* Duplicate of the user's comm    */
+    int       p;
+    int       my_rank;
+    int       n;         /* Global order                    */
+    int       local_n;   /* Number of entries I have        */
+    int       first;     /* Global index of my first entry  */
+    int       order;     /* FAST_ORDER or DETERMINISTIC_ORDER */
+} VEC_LAYOUT_T;
+
+typedef struct {
+    VEC_LAYOUT_T*  layout;
+    double*        entries;
+} DIST_VEC_T;
+
+#define Local_n(x)       ((x)->layout->local_n)
+#define Vec_entry(x,i)   ((x)->entries[i])
+
+/* A batch of dot products and norms that are added across the     */
+/*     processes with a single reduction.  Allocated once and reused: */
+/*     add local values with Add_dot, Add_nrm2 and Add_axpy_dot,     */
+/*     start the reduction, do something else, and finish it.        */
+typedef struct {
+    VEC_LAYOUT_T*  layout;
+    int            count;              /* Values in current batch   */
+    int            is_norm[MAX_BATCH]; /* Take sqrt when finished   */
+    double         local[MAX_BATCH];
+    double         global[MAX_BATCH];
+    double*        gathered;           /* p*MAX_BATCH local values, */
+                                       /*     DETERMINISTIC_ORDER   */
+    MPI_Request    request;
+} REDUCTION_T;
+
+/* Value of the slot'th reduction in the batch, once it's finished */
+#define Reduction_value(red,slot) ((red)->global[slot])
+
+int          Setup_vec_layout(VEC_LAYOUT_T* layout, int n, int order,
+                 MPI_Comm comm);
+void         Free_vec_layout(VEC_LAYOUT_T* layout);
+DIST_VEC_T*  Allocate_vec(VEC_LAYOUT_T* layout);
+void         Free_vec(DIST_VEC_T** x_ptr);
+int          Setup_reduction(REDUCTION_T* red, VEC_LAYOUT_T* layout);
+void         Free_reduction(REDUCTION_T* red);
+
+/* Local operations:  no communication */
+void         Vec_set(double alpha, DIST_VEC_T* x);
+void         Vec_copy(DIST_VEC_T* x, DIST_VEC_T* y);
+void         Vec_scal(double alpha, DIST_VEC_T* x);
+void         Vec_axpy(double alpha, DIST_VEC_T* x, DIST_VEC_T* y);
+void         Vec_aypx(double alpha, DIST_VEC_T* x, DIST_VEC_T* y);
+
+/* Batched reductions.  The Add functions return the slot of */
+/*     the result, or -1 if the batch is full or between     */
+/*     Start_reduction and Finish_reduction.                 */
+int          Add_dot(REDUCTION_T* red, DIST_VEC_T* x, DIST_VEC_T* y);
+int          Add_nrm2(REDUCTION_T* red, DIST_VEC_T* x);
+int          Add_axpy_dot(REDUCTION_T* red, double alpha, DIST_VEC_T* x,
+                 DIST_VEC_T* y, DIST_VEC_T* z);
+void         Start_reduction(REDUCTION_T* red);
+void         Finish_reduction(REDUCTION_T* red);
+
+/* Blocking versions of single reductions */
+double       Dot(REDUCTION_T* red, DIST_VEC_T* x, DIST_VEC_T* y);
+double       Nrm2(REDUCTION_T* red, DIST_VEC_T* x);
+
+#endif
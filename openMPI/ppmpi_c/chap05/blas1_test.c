@@ -0,0 +1,152 @@
+/* blas1_test.c -- test and time the batched reductions in blas1.c
+ *
+ * Input:
+ *     n: order of the vectors
+ *     k: number of dot products in a batch (at most MAX_BATCH)
+ *     reps: number of times to compute each batch
+ *     order: 0 for MPI_Iallreduce, 1 for deterministic order
+ * Output:
+ *     The time for k blocking dot products, and for one batch of
+ *     k, the largest difference between the two sets of results,
+ *     the error in the fused axpy and dot, whether Add_dot is
+ *     refused while a reduction is pending, and the error in the
+ *     sum of 1/(i+1), i = 0, ..., n-1.
+ *
+ * Notes:
+ *     1.  The entries of the vectors in the dot products are small
+ *         integers, so the dot products should be exact.
+ *     2.  n needn't be divisible by p.
+ *
+ * See Chap 5, pp. 76 & ff in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "mpi.h"
+#include "blas1.h"
+
+#define X_entry(j,i) ((double) (((j) + 3*(i)) % 7 - 3))
+#define Y_entry(i)   ((double) ((5*(i)) % 11 - 5))
+
+/*****************************************************************/
+int main(int argc, char* argv[]) {
+    int           my_rank;
+    VEC_LAYOUT_T  layout;
+    REDUCTION_T   red;
+    DIST_VEC_T*   x[MAX_BATCH];
+    DIST_VEC_T*   y;
+    DIST_VEC_T*   w;
+    int           input[4];
+    int           n, k, reps, rep;
+    int           i, j;
+    int           refused;
+    int           slot[MAX_BATCH];
+    double        blocking[MAX_BATCH];
+    double        batched[MAX_BATCH];
+    double        start, separate_time, batch_time;
+    double        max_diff, value, exact;
+    long double   serial;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+
+    if (my_rank == 0) {
+        printf("Enter n, k, reps, order (0 = fast, 1 = deterministic)\n");
+        scanf("%d %d %d %d", &input[0], &input[1], &input[2], &input[3]);
+    }
+    MPI_Bcast(input, 4, MPI_INT, 0, MPI_COMM_WORLD);
+    n = input[0];
+    k = input[1];
+    if (k < 1) k = 1;
+    if (k > MAX_BATCH) k = MAX_BATCH;
+    reps = (input[2] > 0 ? input[2] : 1);
+
+    if ((Setup_vec_layout(&layout, n, input[3], MPI_COMM_WORLD) < 0)
+            || (Setup_reduction(&red, &layout) < 0)) {
+        fprintf(stderr, "Process %d > Can't set up layout\n", my_rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    for (j = 0; j < k; j++)
+        x[j] = Allocate_vec(&layout);
+    y = Allocate_vec(&layout);
+    w = Allocate_vec(&layout);
+    for (j = 0; j < k; j++)
+        if (x[j] == (DIST_VEC_T*) NULL) y = (DIST_VEC_T*) NULL;
+    if ((y == (DIST_VEC_T*) NULL) || (w == (DIST_VEC_T*) NULL)) {
+        fprintf(stderr, "Process %d > Can't allocate vectors\n",
+            my_rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    for (i = 0; i < Local_n(y); i++) {
+        for (j = 0; j < k; j++)
+            Vec_entry(x[j], i) = X_entry(j, layout.first + i);
+        Vec_entry(y, i) = Y_entry(layout.first + i);
+    }
+
+    /* k reductions of one value each */
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+    for (rep = 0; rep < reps; rep++)
+        for (j = 0; j < k; j++)
+            blocking[j] = Dot(&red, x[j], y);
+    separate_time = (MPI_Wtime() - start)/reps;
+
+    /* One reduction of k values */
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+    for (rep = 0; rep < reps; rep++) {
+        for (j = 0; j < k; j++)
+            slot[j] = Add_dot(&red, x[j], y);
+        Start_reduction(&red);
+        Finish_reduction(&red);
+        for (j = 0; j < k; j++)
+            batched[j] = Reduction_value(&red, slot[j]);
+    }
+    batch_time = (MPI_Wtime() - start)/reps;
+
+    max_diff = 0.0;
+    for (j = 0; j < k; j++)
+        if (fabs(blocking[j] - batched[j]) > max_diff)
+            max_diff = fabs(blocking[j] - batched[j]);
+
+    /* w = 2*x[0] + y, and w.w two ways */
+    Vec_copy(y, w);
+    slot[0] = Add_axpy_dot(&red, 2.0, x[0], w, w);
+    Start_reduction(&red);
+    refused = (Add_dot(&red, x[0], y) < 0);
+    Finish_reduction(&red);
+    value = Reduction_value(&red, slot[0]);
+    exact = Dot(&red, w, w);
+
+    if (my_rank == 0) {
+        printf("k blocking dot products = %e seconds\n", separate_time);
+        printf("One batch of k          = %e seconds\n", batch_time);
+        printf("Max difference = %e\n", max_diff);
+        printf("Axpy_dot error = %e\n", fabs(value - exact));
+        printf("Add_dot during a reduction %s\n",
+            refused ? "refused" : "ACCEPTED");
+    }
+
+    /* sum of 1/(i+1) */
+    for (i = 0; i < Local_n(y); i++)
+        Vec_entry(w, i) = 1.0/(layout.first + i + 1);
+    Vec_set(1.0, y);
+    value = Dot(&red, w, y);
+    if (my_rank == 0) {
+        serial = 0.0;
+        for (i = n - 1; i >= 0; i--)
+            serial += 1.0L/(i + 1);
+        printf("Harmonic sum error = %e\n", fabs(value - (double) serial));
+    }
+
+    for (j = 0; j < k; j++)
+        Free_vec(&x[j]);
+    Free_vec(&y);
+    Free_vec(&w);
+    Free_reduction(&red);
+    Free_vec_layout(&layout);
+
+    MPI_Finalize();
+    return 0;
+}  /* main */
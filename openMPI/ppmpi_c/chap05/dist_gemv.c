@@ -0,0 +1,491 @@
+/* dist_gemv.c -- functions for multiplying a matrix by a vector when
+ *     the matrix is distributed by blocks over a 2-dimensional grid
+ *     of processes.
+ *
+ * Unlike parallel_mat_vect.c, the orders of the matrix needn't be
+ *     divisible by the number of processes, the blocks are allocated
+ *     on the heap, so there's no MAX_ORDER, and the grid can be
+ *     rows x cols for any factorization of p:
+ *
+ *     p x 1:  block rows.  This is the distribution used by
+ *             parallel_mat_vect.c.
+ *     1 x p:  block columns.
+ *     q x r:  checkerboard.  Process (i,j) has the block of A in
+ *             block row i and block column j.
+ *
+ * x is split like the columns of A:  the piece of x needed by grid
+ *     column j is divided by blocks among the processes in that
+ *     column.  y is split like the rows of A.  (See dist_gemv.h.)
+ *     To compute y = Ax,
+ *
+ *         1.  each grid column gathers its piece of x with
+ *             MPI_Allgatherv on the column communicator,
+ *         2.  each process multiplies its block of A by the piece
+ *             of x, giving a partial sum for its rows of y, and
+ *         3.  the partial sums are added and scattered across each
+ *             grid row with MPI_Reduce_scatter on the row
+ *             communicator.
+ *
+ *     So on a q x q grid each process sends and receives about
+ *     n/q + m/q floats, instead of the n floats each process
+ *     receives from the MPI_Allgather in parallel_mat_vect.c.  On a
+ *     p x 1 grid, step 3 is omitted, and on a 1 x p grid step 1 is.
+ *
+ * The local product is computed by Local_gemv, which keeps
+ *     VECTOR_WIDTH independent partial sums for each row so that
+ *     the compiler can use SIMD instructions for the inner loop.
+ *
+ * See Chap 5, pp. 78 & ff and Chap 7, pp. 113 & ff in PPMPI
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+#include "dist_gemv.h"
+
+#define MAX(a,b) ((a) > (b) ? (a) : (b))
+
+static void Vector_block(int n, int dist, int row, int col,
+                GRID_INFO_T* grid, int* first, int* count);
+
+/*********************************************************/
+/* Build a rows x cols grid.  If rows or cols is 0, it's   */
+/*     chosen by MPI_Dims_create.                          */
+void Setup_grid(
+         GRID_INFO_T*  grid  /* out */,
+         int           rows  /* in  */,
+         int           cols  /* in  */) {
+    int dimensions[2];
+    int wrap_around[2];
+    int coordinates[2];
+    int free_coords[2];
+
+    /* Set up Global Grid Information */
+    MPI_Comm_size(MPI_COMM_WORLD, &(grid->p));
+
+    dimensions[0] = rows;
+    dimensions[1] = cols;
+    MPI_Dims_create(grid->p, 2, dimensions);
+    grid->rows = dimensions[0];
+    grid->cols = dimensions[1];
+
+    wrap_around[0] = wrap_around[1] = 0;
+    MPI_Cart_create(MPI_COMM_WORLD, 2, dimensions,
+        wrap_around, 1, &(grid->comm));
+    MPI_Comm_rank(grid->comm, &(grid->my_rank));
+    MPI_Cart_coords(grid->comm, grid->my_rank, 2,
+        coordinates);
+    grid->my_row = coordinates[0];
+    grid->my_col = coordinates[1];
+
+    /* Set up row communicators.  Rank in row_comm = my_col */
+    free_coords[0] = 0;
+    free_coords[1] = 1;
+    MPI_Cart_sub(grid->comm, free_coords,
+        &(grid->row_comm));
+
+    /* Set up column communicators.  Rank in col_comm = my_row */
+    free_coords[0] = 1;
+    free_coords[1] = 0;
+    MPI_Cart_sub(grid->comm, free_coords,
+        &(grid->col_comm));
+} /* Setup_grid */
+
+
+/*********************************************************/
+void Free_grid(
+         GRID_INFO_T*  grid  /* in/out */) {
+    MPI_Comm_free(&(grid->row_comm));
+    MPI_Comm_free(&(grid->col_comm));
+    MPI_Comm_free(&(grid->comm));
+}  /* Free_grid */
+
+
+/*********************************************************/
+/* Returns NULL if malloc fails */
+DIST_MATRIX_T* Allocate_dist_matrix(
+                   int           m     /* in */,
+                   int           n     /* in */,
+                   GRID_INFO_T*  grid  /* in */) {
+    DIST_MATRIX_T* temp;
+    int            size;
+
+    temp = (DIST_MATRIX_T*) malloc(sizeof(DIST_MATRIX_T));
+    if (temp == (DIST_MATRIX_T*) NULL)
+        return temp;
+
+    temp->m = m;
+    temp->n = n;
+    temp->local_m = Block_size(grid->my_row, grid->rows, m);
+    temp->local_n = Block_size(grid->my_col, grid->cols, n);
+    temp->first_row = Block_low(grid->my_row, grid->rows, m);
+    temp->first_col = Block_low(grid->my_col, grid->cols, n);
+
+    /* A process may have an empty block */
+    size = temp->local_m*temp->local_n;
+    temp->entries = (float*) malloc((size > 0 ? size : 1)*sizeof(float));
+    if (temp->entries == (float*) NULL) {
+        free(temp);
+        return (DIST_MATRIX_T*) NULL;
+    }
+    return temp;
+}  /* Allocate_dist_matrix */
+
+
+/*********************************************************/
+void Free_dist_matrix(
+         DIST_MATRIX_T** A_ptr  /* in/out */) {
+    free((*A_ptr)->entries);
+    free(*A_ptr);
+    *A_ptr = (DIST_MATRIX_T*) NULL;
+}  /* Free_dist_matrix */
+
+
+/*********************************************************/
+/* Find the entries of an order n vector with distribution
+ *     dist that belong to grid process (row, col).
+ */
+static void Vector_block(
+                int           n      /* in  */,
+                int           dist   /* in  */,
+                int           row    /* in  */,
+                int           col    /* in  */,
+                GRID_INFO_T*  grid   /* in  */,
+                int*          first  /* out */,
+                int*          count  /* out */) {
+    int lo, size;
+
+    if (dist == COL_DIST) {
+        lo = Block_low(col, grid->cols, n);
+        size = Block_size(col, grid->cols, n);
+        *first = lo + Block_low(row, grid->rows, size);
+        *count = Block_size(row, grid->rows, size);
+    } else {
+        lo = Block_low(row, grid->rows, n);
+        size = Block_size(row, grid->rows, n);
+        *first = lo + Block_low(col, grid->cols, size);
+        *count = Block_size(col, grid->cols, size);
+    }
+}  /* Vector_block */
+
+
+/*********************************************************/
+/* dist is COL_DIST or ROW_DIST.  Returns NULL if malloc  */
+/*     fails.                                             */
+DIST_VECTOR_T* Allocate_dist_vector(
+                   int           n     /* in */,
+                   int           dist  /* in */,
+                   GRID_INFO_T*  grid  /* in */) {
+    DIST_VECTOR_T* temp;
+
+    temp = (DIST_VECTOR_T*) malloc(sizeof(DIST_VECTOR_T));
+    if (temp == (DIST_VECTOR_T*) NULL)
+        return temp;
+
+    temp->n = n;
+    temp->dist = dist;
+    Vector_block(n, dist, grid->my_row, grid->my_col, grid,
+        &(temp->first), &(temp->local_n));
+
+    temp->entries = (float*) malloc(
+        (temp->local_n > 0 ? temp->local_n : 1)*sizeof(float));
+    if (temp->entries == (float*) NULL) {
+        free(temp);
+        return (DIST_VECTOR_T*) NULL;
+    }
+    return temp;
+}  /* Allocate_dist_vector */
+
+
+/*********************************************************/
+void Free_dist_vector(
+         DIST_VECTOR_T** x_ptr  /* in/out */) {
+    free((*x_ptr)->entries);
+    free(*x_ptr);
+    *x_ptr = (DIST_VECTOR_T*) NULL;
+}  /* Free_dist_vector */
+
+
+/*********************************************************/
+/* Read and distribute matrix:
+ *     foreach global row of the matrix,
+ *         foreach grid column
+ *             read the block of the row belonging to the
+ *             grid column on process 0, and send it to the
+ *             appropriate process.
+ */
+void Read_matrix(
+         char*           prompt  /* in  */,
+         DIST_MATRIX_T*  A       /* out */,
+         GRID_INFO_T*    grid    /* in  */) {
+
+    int        mat_row, mat_col;
+    int        grid_col;
+    int        dest;
+    int        coords[2];
+    int        count;
+    float*     temp;
+    MPI_Status status;
+
+    if (grid->my_rank == 0) {
+        temp = (float*) malloc((A->n/grid->cols + 1)*sizeof(float));
+        printf("%s\n", prompt);
+        fflush(stdout);
+        for (mat_row = 0;  mat_row < A->m; mat_row++) {
+            coords[0] = Block_owner(mat_row, grid->rows, A->m);
+            for (grid_col = 0; grid_col < grid->cols; grid_col++) {
+                coords[1] = grid_col;
+                count = Block_size(grid_col, grid->cols, A->n);
+                MPI_Cart_rank(grid->comm, coords, &dest);
+                if (dest == 0) {
+                    for (mat_col = 0; mat_col < count; mat_col++)
+                        scanf("%f", &Entry(A, mat_row, mat_col));
+                } else {
+                    for (mat_col = 0; mat_col < count; mat_col++)
+                        scanf("%f", temp + mat_col);
+                    MPI_Send(temp, count, MPI_FLOAT, dest, 0,
+                        grid->comm);
+                }
+            }
+        }
+        free(temp);
+    } else {
+        for (mat_row = 0; mat_row < Local_rows(A); mat_row++)
+            MPI_Recv(&Entry(A, mat_row, 0), Local_cols(A),
+                MPI_FLOAT, 0, 0, grid->comm, &status);
+    }
+
+}  /* Read_matrix */
+
+
+/*********************************************************/
+void Print_matrix(
+         char*           title  /* in  */,
+         DIST_MATRIX_T*  A      /* in  */,
+         GRID_INFO_T*    grid   /* in  */) {
+    int        mat_row, mat_col;
+    int        grid_col;
+    int        source;
+    int        coords[2];
+    int        count;
+    float*     temp;
+    MPI_Status status;
+
+    if (grid->my_rank == 0) {
+        temp = (float*) malloc((A->n/grid->cols + 1)*sizeof(float));
+        printf("%s\n", title);
+        for (mat_row = 0;  mat_row < A->m; mat_row++) {
+            coords[0] = Block_owner(mat_row, grid->rows, A->m);
+            for (grid_col = 0; grid_col < grid->cols; grid_col++) {
+                coords[1] = grid_col;
+                count = Block_size(grid_col, grid->cols, A->n);
+                MPI_Cart_rank(grid->comm, coords, &source);
+                if (source == 0) {
+                    for(mat_col = 0; mat_col < count; mat_col++)
+                        printf("%4.1f ", Entry(A, mat_row, mat_col));
+                } else {
+                    MPI_Recv(temp, count, MPI_FLOAT, source, 0,
+                        grid->comm, &status);
+                    for(mat_col = 0; mat_col < count; mat_col++)
+                        printf("%4.1f ", temp[mat_col]);
+                }
+            }
+            printf("\n");
+        }
+        free(temp);
+    } else {
+        for (mat_row = 0; mat_row < Local_rows(A); mat_row++)
+            MPI_Send(&Entry(A, mat_row, 0), Local_cols(A),
+                MPI_FLOAT, 0, 0, grid->comm);
+    }
+
+}  /* Print_matrix */
+
+
+/*********************************************************/
+/* Process 0 reads the whole vector, and sends each of  */
+/*     the other processes its block.                   */
+void Read_vector(
+         char*           prompt  /* in  */,
+         DIST_VECTOR_T*  x       /* out */,
+         GRID_INFO_T*    grid    /* in  */) {
+    int        i;
+    int        dest;
+    int        coords[2];
+    int        first, count;
+    float*     temp;
+    MPI_Status status;
+
+    if (grid->my_rank == 0) {
+        temp = (float*) malloc((x->n > 0 ? x->n : 1)*sizeof(float));
+        printf("%s\n", prompt);
+        fflush(stdout);
+        for (i = 0; i < x->n; i++)
+            scanf("%f", &temp[i]);
+        for (dest = 0; dest < grid->p; dest++) {
+            MPI_Cart_coords(grid->comm, dest, 2, coords);
+            Vector_block(x->n, x->dist, coords[0], coords[1], grid,
+                &first, &count);
+            if (dest == 0)
+                memcpy(x->entries, temp + first, count*sizeof(float));
+            else
+                MPI_Send(temp + first, count, MPI_FLOAT, dest, 0,
+                    grid->comm);
+        }
+        free(temp);
+    } else {
+        MPI_Recv(x->entries, Local_size(x), MPI_FLOAT, 0, 0,
+            grid->comm, &status);
+    }
+}  /* Read_vector */
+
+
+/*********************************************************/
+void Print_vector(
+         char*           title  /* in  */,
+         DIST_VECTOR_T*  x      /* in  */,
+         GRID_INFO_T*    grid   /* in  */) {
+    int        i;
+    int        source;
+    int        coords[2];
+    int        first, count;
+    float*     temp;
+    MPI_Status status;
+
+    if (grid->my_rank == 0) {
+        temp = (float*) malloc((x->n > 0 ? x->n : 1)*sizeof(float));
+        memcpy(temp + x->first, x->entries,
+            Local_size(x)*sizeof(float));
+        for (source = 1; source < grid->p; source++) {
+            MPI_Cart_coords(grid->comm, source, 2, coords);
+            Vector_block(x->n, x->dist, coords[0], coords[1], grid,
+                &first, &count);
+            MPI_Recv(temp + first, count, MPI_FLOAT, source, 0,
+                grid->comm, &status);
+        }
+        printf("%s\n", title);
+        for (i = 0; i < x->n; i++)
+            printf("%4.1f ", temp[i]);
+        printf("\n");
+        free(temp);
+    } else {
+        MPI_Send(x->entries, Local_size(x), MPI_FLOAT, 0, 0,
+            grid->comm);
+    }
+}  /* Print_vector */
+
+
+/*********************************************************/
+/* y = A*x, where A is m x n and stored by rows, and the
+ *     distance between the starts of consecutive rows is lda.
+ *     Each row is multiplied by x with VECTOR_WIDTH partial
+ *     sums:  sum[l] accumulates the products in columns
+ *     l, l + VECTOR_WIDTH, l + 2*VECTOR_WIDTH, ...  The
+ *     partial sums don't depend on each other, so the inner
+ *     loop is a vector multiply-add, and the compiler can
+ *     use SIMD instructions without reordering any floating
+ *     point sums.
+ */
+void Local_gemv(
+         int     m    /* in  */,
+         int     n    /* in  */,
+         float*  A    /* in  */,
+         int     lda  /* in  */,
+         float*  x    /* in  */,
+         float*  y    /* out */) {
+    int     i, j, l;
+    int     n_vec;
+    float   sum[VECTOR_WIDTH];
+    float   total;
+    float*  a_row;
+
+    n_vec = n - n % VECTOR_WIDTH;
+    for (i = 0; i < m; i++) {
+        a_row = A + i*lda;
+        for (l = 0; l < VECTOR_WIDTH; l++)
+            sum[l] = 0.0;
+        for (j = 0; j < n_vec; j += VECTOR_WIDTH)
+            for (l = 0; l < VECTOR_WIDTH; l++)
+                sum[l] += a_row[j + l]*x[j + l];
+        total = 0.0;
+        for (j = n_vec; j < n; j++)
+            total += a_row[j]*x[j];
+        for (l = 0; l < VECTOR_WIDTH; l++)
+            total += sum[l];
+        y[i] = total;
+    }
+}  /* Local_gemv */
+
+
+/*********************************************************/
+/* y = A*x.  x should be COL_DIST and y ROW_DIST.  Returns
+ *     0 on success, and a negative value if the orders or
+ *     distributions don't match, or malloc fails.
+ */
+int Gemv(
+        DIST_MATRIX_T*  A     /* in  */,
+        DIST_VECTOR_T*  x     /* in  */,
+        DIST_VECTOR_T*  y     /* out */,
+        GRID_INFO_T*    grid  /* in  */) {
+    int     i;
+    int*    counts;
+    int*    displs;
+    float*  x_block;   /* Entries of x for my block column */
+    float*  y_part;    /* My partial sums for my block row */
+
+    if ((A->n != x->n) || (A->m != y->n) || (x->dist != COL_DIST)
+            || (y->dist != ROW_DIST))
+        return -1;
+
+    counts = (int*) malloc(2*MAX(grid->rows, grid->cols)*sizeof(int));
+    if (counts == (int*) NULL)
+        return -2;
+    displs = counts + MAX(grid->rows, grid->cols);
+
+    /* On a 1 x p grid, my piece of x is the whole block */
+    if (grid->rows == 1) {
+        x_block = x->entries;
+    } else {
+        x_block = (float*) malloc(
+            (Local_cols(A) > 0 ? Local_cols(A) : 1)*sizeof(float));
+        if (x_block == (float*) NULL) {
+            free(counts);
+            return -2;
+        }
+        for (i = 0; i < grid->rows; i++) {
+            counts[i] = Block_size(i, grid->rows, Local_cols(A));
+            displs[i] = Block_low(i, grid->rows, Local_cols(A));
+        }
+        MPI_Allgatherv(x->entries, Local_size(x), MPI_FLOAT,
+            x_block, counts, displs, MPI_FLOAT, grid->col_comm);
+    }
+
+    /* On a p x 1 grid, my partial sums are my block of y */
+    if (grid->cols == 1) {
+        y_part = y->entries;
+    } else {
+        y_part = (float*) malloc(
+            (Local_rows(A) > 0 ? Local_rows(A) : 1)*sizeof(float));
+        if (y_part == (float*) NULL) {
+            if (x_block != x->entries)
+                free(x_block);
+            free(counts);
+            return -2;
+        }
+    }
+
+    Local_gemv(Local_rows(A), Local_cols(A), A->entries,
+        Local_cols(A), x_block, y_part);
+
+    if (grid->cols > 1) {
+        for (i = 0; i < grid->cols; i++)
+            counts[i] = Block_size(i, grid->cols, Local_rows(A));
+        MPI_Reduce_scatter(y_part, y->entries, counts, MPI_FLOAT,
+            MPI_SUM, grid->row_comm);
+        free(y_part);
+    }
+    if (x_block != x->entries)
+        free(x_block);
+    free(counts);
+    return 0;
+}  /* Gemv */
@@ -0,0 +1,90 @@
+/* dist_gemv.h -- definitions and declarations for distributed
+ *     matrix-vector multiplication on a 2-dimensional grid of
+ *     processes.
+ *
+ * See dist_gemv.c
+ */
+#ifndef DIST_GEMV_H
+#define DIST_GEMV_H
+
+#include "mpi.h"
+#include "block_dist.h"
+
+typedef struct {
+    int       p;         /* Total number of processes    */
+    MPI_Comm  comm;      /* Communicator for entire grid */
+    MPI_Comm  row_comm;  /* Communicator for my row      */
+    MPI_Comm  col_comm;  /* Communicator for my col      */
+    int       rows;      /* Number of rows in the grid   */
+    int       cols;      /* Number of cols in the grid   */
+    int       my_row;    /* My row number                */
+    int       my_col;    /* My column number             */
+    int       my_rank;   /* My rank in the grid comm     */
+} GRID_INFO_T;
+
+/* The block of an m x n matrix assigned to one process.  Process  */
+/*     (i,j) gets rows Block_low(i,rows,m), ..., Block_high(i,rows,m) */
+/*     and columns Block_low(j,cols,n), ..., Block_high(j,cols,n).  */
+/*     The entries are stored by rows.                               */
+typedef struct {
+    int     m;           /* Global number of rows        */
+    int     n;           /* Global number of columns     */
+    int     local_m;     /* Number of rows in my block   */
+    int     local_n;     /* Number of cols in my block   */
+    int     first_row;   /* Global index of my first row */
+    int     first_col;   /* Global index of my first col */
+    float*  entries;
+} DIST_MATRIX_T;
+
+#define Local_rows(A)  ((A)->local_m)
+#define Local_cols(A)  ((A)->local_n)
+#define Entry(A,i,j) (*(((A)->entries) + ((A)->local_n)*(i) + (j)))
+
+/* Vector distributions.  A COL_DIST vector is split like the      */
+/*     columns of the matrix:  the block of entries belonging to   */
+/*     grid column j is divided by blocks among the rows processes */
+/*     of the column.  A ROW_DIST vector is split like the rows:   */
+/*     the block belonging to grid row i is divided among the cols */
+/*     processes of the row.  In y = Ax, x is COL_DIST and y is    */
+/*     ROW_DIST.  On a p x 1 or a 1 x p grid both are the usual    */
+/*     block distribution over the p processes.                    */
+#define COL_DIST 0
+#define ROW_DIST 1
+
+typedef struct {
+    int     n;           /* Global order                  */
+    int     dist;        /* COL_DIST or ROW_DIST          */
+    int     local_n;     /* Number of entries I have      */
+    int     first;       /* Global index of my first one  */
+    float*  entries;
+} DIST_VECTOR_T;
+
+#define Local_size(x)     ((x)->local_n)
+#define Vector_entry(x,i) ((x)->entries[i])
+
+/* Number of independent partial sums in Local_gemv.  Should be */
+/*     a multiple of the number of floats in a SIMD register.   */
+#ifndef VECTOR_WIDTH
+#define VECTOR_WIDTH 8
+#endif
+
+void            Setup_grid(GRID_INFO_T* grid, int rows, int cols);
+void            Free_grid(GRID_INFO_T* grid);
+DIST_MATRIX_T*  Allocate_dist_matrix(int m, int n, GRID_INFO_T* grid);
+void            Free_dist_matrix(DIST_MATRIX_T** A_ptr);
+DIST_VECTOR_T*  Allocate_dist_vector(int n, int dist, GRID_INFO_T* grid);
+void            Free_dist_vector(DIST_VECTOR_T** x_ptr);
+void            Read_matrix(char* prompt, DIST_MATRIX_T* A,
+                    GRID_INFO_T* grid);
+void            Print_matrix(char* title, DIST_MATRIX_T* A,
+                    GRID_INFO_T* grid);
+void            Read_vector(char* prompt, DIST_VECTOR_T* x,
+                    GRID_INFO_T* grid);
+void            Print_vector(char* title, DIST_VECTOR_T* x,
+                    GRID_INFO_T* grid);
+void            Local_gemv(int m, int n, float* A, int lda, float* x,
+                    float* y);
+int             Gemv(DIST_MATRIX_T* A, DIST_VECTOR_T* x,
+                    DIST_VECTOR_T* y, GRID_INFO_T* grid);
+
+#endif
@@ -0,0 +1,165 @@
+/* gemv_test.c -- test and time the distributed matrix-vector
+ *     multiplication in dist_gemv.c
+ *
+ * Input:
+ *     m, n: order of the matrix
+ *     rows, cols: order of the process grid (0 to let MPI choose).
+ *         Use p 1 for block rows, 1 p for block columns.
+ *     reps: number of times to compute the product
+ *     read_flag: 1 to read A and x, 0 to generate them
+ * Output:
+ *     Mean elapsed time for one product, and the largest error
+ *     in y.  If the matrix is small, A, x and y are printed.
+ *
+ * Notes:
+ *     1.  The generated entries are small integers, so the
+ *         entries of y are computed exactly, and the error
+ *         should be 0.
+ *     2.  m and n needn't be divisible by p, rows or cols.
+ *
+ * See Chap 5, pp. 78 & ff in PPMPI
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "mpi.h"
+#include "dist_gemv.h"
+
+#define PRINT_MAX 10
+
+#define A_entry(i,j) ((float) (((i) + 2*(j)) % 5 - 2))
+#define X_entry(j)   ((float) ((3*(j)) % 7 - 3))
+
+void Generate(DIST_MATRIX_T* A, DIST_VECTOR_T* x);
+float Check(DIST_VECTOR_T* x, DIST_VECTOR_T* y, GRID_INFO_T* grid);
+
+/*********************************************************/
+int main(int argc, char* argv[]) {
+    int             my_rank;
+    GRID_INFO_T     grid;
+    DIST_MATRIX_T*  A;
+    DIST_VECTOR_T*  x;
+    DIST_VECTOR_T*  y;
+    int             input[6];
+    int             m, n;
+    int             reps, rep;
+    int             read_flag;
+    int             error = 0;
+    double          start, elapsed, max_elapsed;
+    float           max_error;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+
+    if (my_rank == 0) {
+        printf("Enter m, n, grid rows, grid cols, reps, read flag\n");
+        scanf("%d %d %d %d %d %d", &input[0], &input[1], &input[2],
+            &input[3], &input[4], &input[5]);
+    }
+    MPI_Bcast(input, 6, MPI_INT, 0, MPI_COMM_WORLD);
+    m = input[0];
+    n = input[1];
+    reps = (input[4] > 0 ? input[4] : 1);
+    read_flag = input[5];
+
+    Setup_grid(&grid, input[2], input[3]);
+    if (my_rank == 0)
+        printf("Grid is %d x %d\n", grid.rows, grid.cols);
+
+    A = Allocate_dist_matrix(m, n, &grid);
+    x = Allocate_dist_vector(n, COL_DIST, &grid);
+    y = Allocate_dist_vector(m, ROW_DIST, &grid);
+    if ((A == (DIST_MATRIX_T*) NULL) || (x == (DIST_VECTOR_T*) NULL)
+            || (y == (DIST_VECTOR_T*) NULL)) {
+        fprintf(stderr, "Process %d > Can't allocate storage\n",
+            my_rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    if (read_flag) {
+        Read_matrix("Enter the matrix", A, &grid);
+        Read_vector("Enter the vector", x, &grid);
+    } else {
+        Generate(A, x);
+    }
+    if ((m <= PRINT_MAX) && (n <= PRINT_MAX)) {
+        Print_matrix("We read", A, &grid);
+        Print_vector("We read", x, &grid);
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+    for (rep = 0; rep < reps && error == 0; rep++)
+        error = Gemv(A, x, y, &grid);
+    elapsed = (MPI_Wtime() - start)/reps;
+    if (error < 0) {
+        fprintf(stderr, "Process %d > Gemv failed\n", my_rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    MPI_Reduce(&elapsed, &max_elapsed, 1, MPI_DOUBLE, MPI_MAX, 0,
+        MPI_COMM_WORLD);
+
+    if ((m <= PRINT_MAX) && (n <= PRINT_MAX))
+        Print_vector("The product is", y, &grid);
+    if (!read_flag) {
+        max_error = Check(x, y, &grid);
+        if (my_rank == 0)
+            printf("Max error = %e\n", max_error);
+    }
+    if (my_rank == 0) {
+        printf("Elapsed time = %e seconds\n", max_elapsed);
+        if (max_elapsed > 0.0)
+            printf("Mflop/s = %f\n",
+                2.0*m*((double) n)/(max_elapsed*1.0e6));
+    }
+
+    Free_dist_matrix(&A);
+    Free_dist_vector(&x);
+    Free_dist_vector(&y);
+    Free_grid(&grid);
+
+    MPI_Finalize();
+    return 0;
+}  /* main */
+
+
+/*********************************************************/
+void Generate(
+         DIST_MATRIX_T*  A  /* out */,
+         DIST_VECTOR_T*  x  /* out */) {
+    int i, j;
+
+    for (i = 0; i < Local_rows(A); i++)
+        for (j = 0; j < Local_cols(A); j++)
+            Entry(A,i,j) = A_entry(A->first_row + i, A->first_col + j);
+    for (j = 0; j < Local_size(x); j++)
+        Vector_entry(x,j) = X_entry(x->first + j);
+}  /* Generate */
+
+
+/*********************************************************/
+/* Compare each local entry of y with the dot product of  */
+/*     the generated row of A and x.  Returns the largest */
+/*     error on process 0.                                */
+float Check(
+          DIST_VECTOR_T*  x     /* in */,
+          DIST_VECTOR_T*  y     /* in */,
+          GRID_INFO_T*    grid  /* in */) {
+    int    i, j;
+    int    row;
+    float  sum;
+    float  my_error = 0.0;
+    float  max_error;
+
+    for (i = 0; i < Local_size(y); i++) {
+        row = y->first + i;
+        sum = 0.0;
+        for (j = 0; j < x->n; j++)
+            sum += A_entry(row, j)*X_entry(j);
+        if (fabs(Vector_entry(y,i) - sum) > my_error)
+            my_error = fabs(Vector_entry(y,i) - sum);
+    }
+    MPI_Reduce(&my_error, &max_error, 1, MPI_FLOAT, MPI_MAX, 0,
+        grid->comm);
+    return max_error;
+}  /* Check */
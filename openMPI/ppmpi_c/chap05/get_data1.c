@@ -11,6 +11,8 @@
  *    1.  f(x) is hardwired.
  *    2.  the number of processes (p) should evenly divide
  *        the number of trapezoids (n).
+ *    3.  See bcast_lib.c for a broadcast library that sends the
+ *        input in one message, and has algorithms for long messages.
  *
  * See Chap. 5, pp. 65 & ff. in PPMPI.
  */
@@ -11,6 +11,9 @@
  *     n, the global order of the vectors, is evenly divisible by p, the
  *     number of processes.
  *
+ *     See blas1.c for dot products and norms of heap-allocated vectors
+ *     of any order, with several reductions combined into one.
+ *
  * See Chap 5, pp. 76 & ff in PPMPI.
  */
 #include <stdio.h>
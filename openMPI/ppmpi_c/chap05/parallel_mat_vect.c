@@ -11,6 +11,10 @@
  * Notes:  
  *     1.  Local storage for A, x, and y is statically allocated.
  *     2.  Number of processes (p) should evenly divide both m and n.
+ *     3.  See dist_gemv.c for a version that doesn't have these
+ *         restrictions, and that can use a 2-dimensional grid.
+ *     4.  Every process stores all of x in global_x.  See
+ *         chap10/shared_buf.c for keeping one copy per node.
  *
  * See Chap 5, p. 78 & ff in PPMPI.
  */
@@ -0,0 +1,634 @@
+/* redist.c -- move a distributed matrix from one layout to another,
+ *     optionally transposing it.  Generalizes send_col_to_row.c, which
+ *     sends one column on process 0 to one row on process 1.
+ *
+ * The layouts (see redist.h) are block rows, block columns, 2-D blocks
+ *     and 2-D block-cyclic.  Each dimension of a layout is a
+ *     distribution of indices among the rows or the columns of a grid
+ *     of processes, so the elements process me sends process d are a
+ *     cross product:  my local rows whose destination is in d's grid
+ *     row (or grid column, when transposing) times my local columns
+ *     whose destination is in d's grid column (or row).  Redist_plan
+ *     computes these index lists once, with a counting sort for each
+ *     dimension, and Redistribute can then be called any number of
+ *     times.
+ *
+ * The elements are always sent in the order of the sender's local
+ *     array:  row by row.  Since local indices increase with global
+ *     indices in all the layouts, the receiver stores them row by
+ *     row too, or, when transposing, column by column.  So the
+ *     receiver's column-major unpack is a local transpose.
+ *
+ * There are three methods:
+ *
+ *     REDIST_ALLTOALLW.  Build an MPI_Type_create_hindexed datatype
+ *         for the elements sent to, and received from, each process,
+ *         and make a single call to MPI_Alltoallw.  No copies in
+ *         user code, and nothing but the datatypes to allocate.
+ *     REDIST_ALLTOALLV.  Pack everything into one buffer, call
+ *         MPI_Alltoallv, and unpack.
+ *     REDIST_PAIRWISE.  In step k = 0, 1, ..., p-1, pack the data
+ *         for my_rank + k, exchange with MPI_Sendrecv, and unpack the
+ *         data from my_rank - k.  The buffers only need to hold one
+ *         process's data, and each process only has one message in
+ *         flight, which can help on networks that are swamped by an
+ *         all-to-all.
+ *
+ * Packing and unpacking rows is done with memcpy on runs of adjacent
+ *     columns.  Strided copies (the column-major unpack of a
+ *     transpose) go in REDIST_TILE x REDIST_TILE tiles, so that both
+ *     the reads and the writes stay in cache.
+ *
+ * See Chap 6, pp. 98 & ff in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+#include "redist.h"
+
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+#define MAX(a,b) ((a) > (b) ? (a) : (b))
+
+/* Copy one element.  The constant sizes let the compiler use */
+/*     a single load and store.                               */
+#define Copy_elem(dest,src,size) \
+    switch (size) { \
+        case 4:  memcpy(dest, src, 4); break; \
+        case 8:  memcpy(dest, src, 8); break; \
+        default: memcpy(dest, src, size); \
+    }
+
+static int  Build_list(DIM_LIST_T* list, int count, int my_coord,
+                int q, int block, int n, int to_q, int to_block);
+static void Free_list(DIM_LIST_T* list);
+static void Set_selection(SELECTION_T* sel, DIM_LIST_T* outer,
+                int outer_coord, int outer_stride, DIM_LIST_T* inner,
+                int inner_coord, int inner_stride);
+static int  Build_type(SELECTION_T* sel, MPI_Datatype base,
+                int elem_size, MPI_Datatype* type_ptr);
+static void Copy_selection(char* a, SELECTION_T* sel, char* buf,
+                int elem_size, int pack);
+
+/*****************************************************************/
+int Init_layout(
+        LAYOUT_T*  layout  /* out */,
+        int        kind    /* in  */,
+        int        m       /* in  */,
+        int        n       /* in  */,
+        int        mb      /* in  */,
+        int        nb      /* in  */,
+        MPI_Comm   comm    /* in  */) {
+    int p, my_rank;
+    int dimensions[2];
+
+    if ((kind < 0) || (kind >= LAYOUTS) || (m < 1) || (n < 1))
+        return -1;
+    if ((kind == BLOCK_CYCLIC) && ((mb < 1) || (nb < 1)))
+        return -1;
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &my_rank);
+
+    layout->kind = kind;
+    layout->m = m;
+    layout->n = n;
+    layout->row_block = layout->col_block = 0;
+    switch (kind) {
+        case ROW_BLOCK:
+            layout->grid_rows = p;
+            layout->grid_cols = 1;
+            break;
+        case COL_BLOCK:
+            layout->grid_rows = 1;
+            layout->grid_cols = p;
+            break;
+        default:  /* BLOCK_2D or BLOCK_CYCLIC */
+            dimensions[0] = dimensions[1] = 0;
+            MPI_Dims_create(p, 2, dimensions);
+            layout->grid_rows = dimensions[0];
+            layout->grid_cols = dimensions[1];
+            if (kind == BLOCK_CYCLIC) {
+                layout->row_block = mb;
+                layout->col_block = nb;
+            }
+    }
+    layout->my_row = my_rank / layout->grid_cols;
+    layout->my_col = my_rank % layout->grid_cols;
+    layout->local_rows = Dim_size(layout->my_row, layout->grid_rows,
+        layout->row_block, m);
+    layout->local_cols = Dim_size(layout->my_col, layout->grid_cols,
+        layout->col_block, n);
+    return 0;
+}  /* Init_layout */
+
+
+/*****************************************************************/
+int Dim_global(
+        int  local  /* in */,
+        int  coord  /* in */,
+        int  q      /* in */,
+        int  block  /* in */,
+        int  n      /* in */) {
+    if (block == 0)
+        return Block_low(coord, q, n) + local;
+    else
+        return (local/block)*block*q + coord*block + local % block;
+}  /* Dim_global */
+
+
+/*****************************************************************/
+int Dim_owner(
+        int  global  /* in */,
+        int  q       /* in */,
+        int  block   /* in */,
+        int  n       /* in */) {
+    if (block == 0)
+        return Block_owner(global, q, n);
+    else
+        return (global/block) % q;
+}  /* Dim_owner */
+
+
+/*****************************************************************/
+int Dim_size(
+        int  coord  /* in */,
+        int  q      /* in */,
+        int  block  /* in */,
+        int  n      /* in */) {
+    int blocks, size;
+
+    if (block == 0)
+        return Block_size(coord, q, n);
+
+    /* Every process gets blocks/q whole blocks.  The first     */
+    /*     blocks % q get one more, and the next one gets what's */
+    /*     left over.                                           */
+    blocks = n/block;
+    size = (blocks/q)*block;
+    if (coord < blocks % q)
+        size += block;
+    else if (coord == blocks % q)
+        size += n % block;
+    return size;
+}  /* Dim_size */
+
+
+/*****************************************************************/
+int Redist_plan(
+        REDIST_T*     plan       /* out */,
+        LAYOUT_T*     src        /* in  */,
+        LAYOUT_T*     dst        /* in  */,
+        int           transpose  /* in  */,
+        MPI_Datatype  base       /* in  */,
+        int           method     /* in  */,
+        MPI_Comm      comm       /* in  */) {
+    int       p, d, coord_row, coord_col;
+    int       max_send, max_recv, send_total, recv_total;
+    int       error;
+    MPI_Aint  lb, extent;
+
+    MPI_Comm_size(comm, &p);
+    if ((src->grid_rows*src->grid_cols != p) ||
+            (dst->grid_rows*dst->grid_cols != p))
+        return -1;
+    if (transpose && ((dst->m != src->n) || (dst->n != src->m)))
+        return -1;
+    if (!transpose && ((dst->m != src->m) || (dst->n != src->n)))
+        return -1;
+    if ((method < 0) || (method >= REDIST_METHODS))
+        return -1;
+
+    memset(plan, 0, sizeof(REDIST_T));
+    MPI_Comm_dup(comm, &(plan->comm));
+    MPI_Comm_rank(plan->comm, &(plan->my_rank));
+    plan->p = p;
+    plan->method = method;
+    plan->base = base;
+    MPI_Type_get_extent(base, &lb, &extent);
+    plan->elem_size = (int) extent;
+
+    /* My source rows go to the process rows of dst, or to the   */
+    /*     process columns when transposing.  Likewise for the   */
+    /*     columns, and for where my dst rows and cols come from. */
+    error = 0;
+    if (!transpose) {
+        error |= Build_list(&(plan->send_rows), src->local_rows,
+            src->my_row, src->grid_rows, src->row_block, src->m,
+            dst->grid_rows, dst->row_block);
+        error |= Build_list(&(plan->send_cols), src->local_cols,
+            src->my_col, src->grid_cols, src->col_block, src->n,
+            dst->grid_cols, dst->col_block);
+        error |= Build_list(&(plan->recv_rows), dst->local_rows,
+            dst->my_row, dst->grid_rows, dst->row_block, dst->m,
+            src->grid_rows, src->row_block);
+        error |= Build_list(&(plan->recv_cols), dst->local_cols,
+            dst->my_col, dst->grid_cols, dst->col_block, dst->n,
+            src->grid_cols, src->col_block);
+    } else {
+        error |= Build_list(&(plan->send_rows), src->local_rows,
+            src->my_row, src->grid_rows, src->row_block, src->m,
+            dst->grid_cols, dst->col_block);
+        error |= Build_list(&(plan->send_cols), src->local_cols,
+            src->my_col, src->grid_cols, src->col_block, src->n,
+            dst->grid_rows, dst->row_block);
+        error |= Build_list(&(plan->recv_rows), dst->local_rows,
+            dst->my_row, dst->grid_rows, dst->row_block, dst->m,
+            src->grid_cols, src->col_block);
+        error |= Build_list(&(plan->recv_cols), dst->local_cols,
+            dst->my_col, dst->grid_cols, dst->col_block, dst->n,
+            src->grid_rows, src->row_block);
+    }
+
+    plan->send_sel = (SELECTION_T*) malloc(p*sizeof(SELECTION_T));
+    plan->recv_sel = (SELECTION_T*) malloc(p*sizeof(SELECTION_T));
+    plan->send_counts = (int*) malloc(p*sizeof(int));
+    plan->send_displs = (int*) malloc(p*sizeof(int));
+    plan->recv_counts = (int*) malloc(p*sizeof(int));
+    plan->recv_displs = (int*) malloc(p*sizeof(int));
+    if (error || (plan->send_sel == (SELECTION_T*) NULL) ||
+            (plan->recv_sel == (SELECTION_T*) NULL) ||
+            (plan->send_counts == (int*) NULL) ||
+            (plan->send_displs == (int*) NULL) ||
+            (plan->recv_counts == (int*) NULL) ||
+            (plan->recv_displs == (int*) NULL)) {
+        Redist_free(plan);
+        return -1;
+    }
+
+    send_total = recv_total = max_send = max_recv = 0;
+    for (d = 0; d < p; d++) {
+        /* Process d as a destination */
+        coord_row = d / dst->grid_cols;
+        coord_col = d % dst->grid_cols;
+        if (!transpose)
+            Set_selection(&(plan->send_sel[d]),
+                &(plan->send_rows), coord_row, src->local_cols,
+                &(plan->send_cols), coord_col, 1);
+        else
+            Set_selection(&(plan->send_sel[d]),
+                &(plan->send_rows), coord_col, src->local_cols,
+                &(plan->send_cols), coord_row, 1);
+
+        /* Process d as a source.  When transposing, its rows are */
+        /*     my columns, so I receive by columns.               */
+        coord_row = d / src->grid_cols;
+        coord_col = d % src->grid_cols;
+        if (!transpose)
+            Set_selection(&(plan->recv_sel[d]),
+                &(plan->recv_rows), coord_row, dst->local_cols,
+                &(plan->recv_cols), coord_col, 1);
+        else
+            Set_selection(&(plan->recv_sel[d]),
+                &(plan->recv_cols), coord_row, 1,
+                &(plan->recv_rows), coord_col, dst->local_cols);
+
+        plan->send_counts[d] = plan->send_sel[d].outer_count*
+            plan->send_sel[d].inner_count;
+        plan->recv_counts[d] = plan->recv_sel[d].outer_count*
+            plan->recv_sel[d].inner_count;
+        plan->send_displs[d] = send_total;
+        plan->recv_displs[d] = recv_total;
+        send_total += plan->send_counts[d];
+        recv_total += plan->recv_counts[d];
+        max_send = MAX(max_send, plan->send_counts[d]);
+        max_recv = MAX(max_recv, plan->recv_counts[d]);
+    }
+
+    switch (method) {
+        case REDIST_ALLTOALLW:
+            plan->send_types =
+                (MPI_Datatype*) malloc(p*sizeof(MPI_Datatype));
+            plan->recv_types =
+                (MPI_Datatype*) malloc(p*sizeof(MPI_Datatype));
+            plan->ones = (int*) malloc(p*sizeof(int));
+            plan->zeros = (int*) malloc(p*sizeof(int));
+            if ((plan->send_types == (MPI_Datatype*) NULL) ||
+                    (plan->recv_types == (MPI_Datatype*) NULL) ||
+                    (plan->ones == (int*) NULL) ||
+                    (plan->zeros == (int*) NULL)) {
+                Redist_free(plan);
+                return -1;
+            }
+            for (d = 0; d < p; d++)
+                plan->send_types[d] = plan->recv_types[d] =
+                    MPI_DATATYPE_NULL;
+            for (d = 0; d < p; d++) {
+                plan->ones[d] = 1;
+                plan->zeros[d] = 0;
+                if (Build_type(&(plan->send_sel[d]), base,
+                        plan->elem_size, &(plan->send_types[d])) ||
+                    Build_type(&(plan->recv_sel[d]), base,
+                        plan->elem_size, &(plan->recv_types[d]))) {
+                    Redist_free(plan);
+                    return -1;
+                }
+            }
+            break;
+        case REDIST_ALLTOALLV:
+            plan->send_buf = (char*) malloc(
+                MAX(send_total, 1)*plan->elem_size);
+            plan->recv_buf = (char*) malloc(
+                MAX(recv_total, 1)*plan->elem_size);
+            break;
+        default:  /* REDIST_PAIRWISE */
+            plan->send_buf = (char*) malloc(
+                MAX(max_send, 1)*plan->elem_size);
+            plan->recv_buf = (char*) malloc(
+                MAX(max_recv, 1)*plan->elem_size);
+    }
+    if ((method != REDIST_ALLTOALLW) &&
+            ((plan->send_buf == (char*) NULL) ||
+             (plan->recv_buf == (char*) NULL))) {
+        Redist_free(plan);
+        return -1;
+    }
+
+    return 0;
+}  /* Redist_plan */
+
+
+/*****************************************************************/
+int Redistribute(
+        REDIST_T*  plan  /* in  */,
+        void*      a     /* in  */,
+        void*      b     /* out */) {
+    int         d, k, dest, source;
+    int         size = plan->elem_size;
+    MPI_Status  status;
+
+    switch (plan->method) {
+        case REDIST_ALLTOALLW:
+            MPI_Alltoallw(a, plan->ones, plan->zeros, plan->send_types,
+                b, plan->ones, plan->zeros, plan->recv_types,
+                plan->comm);
+            break;
+        case REDIST_ALLTOALLV:
+            for (d = 0; d < plan->p; d++)
+                Copy_selection((char*) a, &(plan->send_sel[d]),
+                    plan->send_buf + ((long) plan->send_displs[d])*size,
+                    size, 1);
+            MPI_Alltoallv(plan->send_buf, plan->send_counts,
+                plan->send_displs, plan->base, plan->recv_buf,
+                plan->recv_counts, plan->recv_displs, plan->base,
+                plan->comm);
+            for (d = 0; d < plan->p; d++)
+                Copy_selection((char*) b, &(plan->recv_sel[d]),
+                    plan->recv_buf + ((long) plan->recv_displs[d])*size,
+                    size, 0);
+            break;
+        default:  /* REDIST_PAIRWISE */
+            for (k = 0; k < plan->p; k++) {
+                dest = (plan->my_rank + k) % plan->p;
+                source = (plan->my_rank - k + plan->p) % plan->p;
+                Copy_selection((char*) a, &(plan->send_sel[dest]),
+                    plan->send_buf, size, 1);
+                if (k == 0) {
+                    /* Mine:  unpack straight from the send buffer */
+                    Copy_selection((char*) b, &(plan->recv_sel[source]),
+                        plan->send_buf, size, 0);
+                } else {
+                    MPI_Sendrecv(plan->send_buf, plan->send_counts[dest],
+                        plan->base, dest, 0, plan->recv_buf,
+                        plan->recv_counts[source], plan->base, source,
+                        0, plan->comm, &status);
+                    Copy_selection((char*) b, &(plan->recv_sel[source]),
+                        plan->recv_buf, size, 0);
+                }
+            }
+    }
+    return 0;
+}  /* Redistribute */
+
+
+/*****************************************************************/
+void Redist_free(
+        REDIST_T*  plan  /* in/out */) {
+    int d;
+
+    Free_list(&(plan->send_rows));
+    Free_list(&(plan->send_cols));
+    Free_list(&(plan->recv_rows));
+    Free_list(&(plan->recv_cols));
+    if (plan->send_types != (MPI_Datatype*) NULL)
+        for (d = 0; d < plan->p; d++)
+            if (plan->send_types[d] != MPI_DATATYPE_NULL)
+                MPI_Type_free(&(plan->send_types[d]));
+    if (plan->recv_types != (MPI_Datatype*) NULL)
+        for (d = 0; d < plan->p; d++)
+            if (plan->recv_types[d] != MPI_DATATYPE_NULL)
+                MPI_Type_free(&(plan->recv_types[d]));
+    free(plan->send_types);
+    free(plan->recv_types);
+    free(plan->ones);
+    free(plan->zeros);
+    free(plan->send_sel);
+    free(plan->recv_sel);
+    free(plan->send_counts);
+    free(plan->send_displs);
+    free(plan->recv_counts);
+    free(plan->recv_displs);
+    free(plan->send_buf);
+    free(plan->recv_buf);
+    if (plan->comm != MPI_COMM_NULL)
+        MPI_Comm_free(&(plan->comm));
+    memset(plan, 0, sizeof(REDIST_T));
+    plan->comm = MPI_COMM_NULL;
+}  /* Redist_free */
+
+
+/*****************************************************************/
+/* Sort my count local indices in one dimension by the coordinate */
+/*     of their owner in another distribution of the same n       */
+/*     indices over to_q processes.                               */
+static int Build_list(
+               DIM_LIST_T*  list      /* out */,
+               int          count     /* in  */,
+               int          my_coord  /* in  */,
+               int          q         /* in  */,
+               int          block     /* in  */,
+               int          n         /* in  */,
+               int          to_q      /* in  */,
+               int          to_block  /* in  */) {
+    int  i, c;
+    int* owner;
+    int* next;
+
+    list->q = to_q;
+    list->start = (int*) malloc((to_q + 1)*sizeof(int));
+    list->idx = (int*) malloc(MAX(count, 1)*sizeof(int));
+    owner = (int*) malloc(MAX(count, 1)*sizeof(int));
+    next = (int*) malloc(to_q*sizeof(int));
+    if ((list->start == (int*) NULL) || (list->idx == (int*) NULL) ||
+            (owner == (int*) NULL) || (next == (int*) NULL)) {
+        free(owner);
+        free(next);
+        return -1;
+    }
+
+    for (c = 0; c <= to_q; c++)
+        list->start[c] = 0;
+    for (i = 0; i < count; i++) {
+        owner[i] = Dim_owner(Dim_global(i, my_coord, q, block, n),
+            to_q, to_block, n);
+        list->start[owner[i] + 1]++;
+    }
+    for (c = 0; c < to_q; c++) {
+        list->start[c+1] += list->start[c];
+        next[c] = list->start[c];
+    }
+    for (i = 0; i < count; i++)
+        list->idx[next[owner[i]]++] = i;
+
+    free(owner);
+    free(next);
+    return 0;
+}  /* Build_list */
+
+
+/*****************************************************************/
+static void Free_list(
+               DIM_LIST_T*  list  /* in/out */) {
+    free(list->start);
+    free(list->idx);
+    list->start = list->idx = (int*) NULL;
+}  /* Free_list */
+
+
+/*****************************************************************/
+static void Set_selection(
+               SELECTION_T*  sel           /* out */,
+               DIM_LIST_T*   outer         /* in  */,
+               int           outer_coord   /* in  */,
+               int           outer_stride  /* in  */,
+               DIM_LIST_T*   inner         /* in  */,
+               int           inner_coord   /* in  */,
+               int           inner_stride  /* in  */) {
+    sel->outer = outer->idx + outer->start[outer_coord];
+    sel->outer_count = outer->start[outer_coord+1] -
+        outer->start[outer_coord];
+    sel->outer_stride = outer_stride;
+    sel->inner = inner->idx + inner->start[inner_coord];
+    sel->inner_count = inner->start[inner_coord+1] -
+        inner->start[inner_coord];
+    sel->inner_stride = inner_stride;
+}  /* Set_selection */
+
+
+/*****************************************************************/
+/* One outer index selects an MPI_Type_create_hindexed of the   */
+/*     inner indices, with runs of adjacent elements merged; the */
+/*     whole selection is an hindexed of these, with one block   */
+/*     at each outer index.  Empty selections give an empty     */
+/*     type, so every process can use a count of 1.             */
+static int Build_type(
+               SELECTION_T*   sel        /* in  */,
+               MPI_Datatype   base       /* in  */,
+               int            elem_size  /* in  */,
+               MPI_Datatype*  type_ptr   /* out */) {
+    int            i, runs;
+    int            max_count;
+    int*           block_lengths;
+    MPI_Aint*      displacements;
+    MPI_Datatype   inner_mpi_t;
+
+    max_count = MAX(MAX(sel->outer_count, sel->inner_count), 1);
+    block_lengths = (int*) malloc(max_count*sizeof(int));
+    displacements = (MPI_Aint*) malloc(max_count*sizeof(MPI_Aint));
+    if ((block_lengths == (int*) NULL) ||
+            (displacements == (MPI_Aint*) NULL)) {
+        free(block_lengths);
+        free(displacements);
+        return -1;
+    }
+
+    runs = 0;
+    for (i = 0; i < sel->inner_count; i++)
+        if ((runs > 0) && (sel->inner_stride == 1) &&
+                (sel->inner[i] == sel->inner[i-1] + 1)) {
+            block_lengths[runs-1]++;
+        } else {
+            block_lengths[runs] = 1;
+            displacements[runs] = ((MPI_Aint) sel->inner[i])*
+                sel->inner_stride*elem_size;
+            runs++;
+        }
+    MPI_Type_create_hindexed(runs, block_lengths, displacements, base,
+        &inner_mpi_t);
+
+    for (i = 0; i < sel->outer_count; i++) {
+        block_lengths[i] = 1;
+        displacements[i] = ((MPI_Aint) sel->outer[i])*
+            sel->outer_stride*elem_size;
+    }
+    MPI_Type_create_hindexed(sel->outer_count, block_lengths,
+        displacements, inner_mpi_t, type_ptr);
+    MPI_Type_commit(type_ptr);
+
+    MPI_Type_free(&inner_mpi_t);
+    free(block_lengths);
+    free(displacements);
+    return 0;
+}  /* Build_type */
+
+
+/*****************************************************************/
+/* Copy the selection from a into buf (pack = 1), or from buf into */
+/*     a (pack = 0).  buf holds the selection in order:  element   */
+/*     (o,i) is buf[o*inner_count + i].                            */
+static void Copy_selection(
+               char*         a          /* in/out */,
+               SELECTION_T*  sel        /* in     */,
+               char*         buf        /* in/out */,
+               int           elem_size  /* in     */,
+               int           pack       /* in     */) {
+    int   o, i, run;
+    int   o_tile, i_tile, o_end, i_end;
+    long  offset;
+    char* elem;
+    char* buf_elem;
+
+    if (sel->inner_stride == 1) {
+        /* Copy runs of adjacent elements of each row */
+        for (o = 0; o < sel->outer_count; o++) {
+            offset = ((long) sel->outer[o])*sel->outer_stride;
+            for (i = 0; i < sel->inner_count; i += run) {
+                for (run = 1; i + run < sel->inner_count; run++)
+                    if (sel->inner[i+run] != sel->inner[i] + run)
+                        break;
+                elem = a + (offset + sel->inner[i])*elem_size;
+                if (pack)
+                    memcpy(buf, elem, run*elem_size);
+                else
+                    memcpy(elem, buf, run*elem_size);
+                buf += run*elem_size;
+            }
+        }
+        return;
+    }
+
+    /* Strided:  go by tiles.  In a transpose the outer index runs */
+    /*     along rows of a, and buf is read with stride            */
+    /*     inner_count.                                            */
+    for (o_tile = 0; o_tile < sel->outer_count; o_tile += REDIST_TILE) {
+        o_end = MIN(o_tile + REDIST_TILE, sel->outer_count);
+        for (i_tile = 0; i_tile < sel->inner_count;
+                i_tile += REDIST_TILE) {
+            i_end = MIN(i_tile + REDIST_TILE, sel->inner_count);
+            for (i = i_tile; i < i_end; i++) {
+                offset = ((long) sel->inner[i])*sel->inner_stride;
+                for (o = o_tile; o < o_end; o++) {
+                    elem = a + (offset +
+                        ((long) sel->outer[o])*sel->outer_stride)*
+                        elem_size;
+                    buf_elem = buf +
+                        (((long) o)*sel->inner_count + i)*elem_size;
+                    if (pack) {
+                        Copy_elem(buf_elem, elem, elem_size);
+                    } else {
+                        Copy_elem(elem, buf_elem, elem_size);
+                    }
+                }
+            }
+        }
+    }
+}  /* Copy_selection */
@@ -0,0 +1,136 @@
+/* redist.h -- definitions and declarations for redist.c, moving a
+ *     distributed matrix from one layout to another, with or without
+ *     transposing it.
+ *
+ * See redist.c
+ */
+#ifndef REDIST_H
+#define REDIST_H
+
+#include "mpi.h"
+#include "block_dist.h"
+
+/* Layouts.  The processes form a grid_rows x grid_cols grid, and  */
+/*     process (i,j) has rank i*grid_cols + j, as in a row-major   */
+/*     MPI_Cart_create grid.                                       */
+#define ROW_BLOCK     0   /* p x 1 grid, block rows                 */
+#define COL_BLOCK     1   /* 1 x p grid, block columns              */
+#define BLOCK_2D      2   /* q x r grid, one block per process      */
+#define BLOCK_CYCLIC  3   /* q x r grid, mb x nb blocks dealt out   */
+                          /*     cyclically, as in ScaLAPACK        */
+#define LAYOUTS       4
+
+/* Side of the square tiles used when packing or unpacking strided */
+/*     data, e.g., for transposes                                  */
+#ifndef REDIST_TILE
+#define REDIST_TILE 32
+#endif
+
+/* Methods */
+#define REDIST_ALLTOALLW  0   /* One derived datatype per process:   */
+                              /*     no copies in user code          */
+#define REDIST_ALLTOALLV  1   /* Pack, MPI_Alltoallv, unpack         */
+#define REDIST_PAIRWISE   2   /* p - 1 steps of MPI_Sendrecv with    */
+                              /*     rank + k and rank - k.  Needs   */
+                              /*     buffers for only one process.   */
+#define REDIST_METHODS    3
+
+/* The piece of an m x n matrix assigned to one process.  The local */
+/*     entries are stored by rows, local_rows x local_cols.         */
+typedef struct {
+    int  kind;          /* ROW_BLOCK, etc.                         */
+    int  m;             /* Global number of rows                   */
+    int  n;             /* Global number of columns                */
+    int  grid_rows;
+    int  grid_cols;
+    int  row_block;     /* mb for BLOCK_CYCLIC, 0 = Block_low dist */
+    int  col_block;     /* nb for BLOCK_CYCLIC, 0 = Block_low dist */
+    int  my_row;        /* My coordinates in the grid              */
+    int  my_col;
+    int  local_rows;
+    int  local_cols;
+} LAYOUT_T;
+
+/* Global index of local row i or local column j */
+#define Global_row(L,i) \
+    Dim_global(i, (L)->my_row, (L)->grid_rows, (L)->row_block, (L)->m)
+#define Global_col(L,j) \
+    Dim_global(j, (L)->my_col, (L)->grid_cols, (L)->col_block, (L)->n)
+
+/* List of local indices in one dimension, sorted by the grid      */
+/*     coordinate of their owner in another layout.  The indices   */
+/*     going to coordinate c are idx[start[c]], ...,               */
+/*     idx[start[c+1]-1], in increasing order.                     */
+typedef struct {
+    int   q;
+    int*  start;
+    int*  idx;
+} DIM_LIST_T;
+
+/* Elements exchanged with one process:  outer_count x inner_count */
+/*     elements, in the order they're sent.  Element (o,i) is at   */
+/*     outer[o]*outer_stride + inner[i]*inner_stride in the local  */
+/*     array (in elements).                                        */
+typedef struct {
+    int   outer_count;
+    int*  outer;
+    int   outer_stride;
+    int   inner_count;
+    int*  inner;
+    int   inner_stride;
+} SELECTION_T;
+
+typedef struct {
+    MPI_Comm       comm;         /* Duplicate of the user's comm   */
+    int            p;
+    int            my_rank;
+    int            method;
+    MPI_Datatype   base;
+    int            elem_size;
+    DIM_LIST_T     send_rows;    /* My rows/cols of the source     */
+    DIM_LIST_T     send_cols;    /*     matrix, by destination     */
+    DIM_LIST_T     recv_rows;    /* My rows/cols of the dest       */
+    DIM_LIST_T     recv_cols;    /*     matrix, by source          */
+    SELECTION_T*   send_sel;     /* One for each process           */
+    SELECTION_T*   recv_sel;
+    int*           send_counts;  /* In elements of base            */
+    int*           send_displs;
+    int*           recv_counts;
+    int*           recv_displs;
+    MPI_Datatype*  send_types;   /* REDIST_ALLTOALLW only          */
+    MPI_Datatype*  recv_types;
+    int*           ones;         /* Counts and displacements for   */
+    int*           zeros;        /*     MPI_Alltoallw              */
+    char*          send_buf;     /* Pack buffers                   */
+    char*          recv_buf;
+} REDIST_T;
+
+/* Fill in a layout of an m x n matrix on comm.  mb and nb are only */
+/*     used by BLOCK_CYCLIC.  Returns 0, or -1 if the arguments     */
+/*     don't make sense.                                            */
+int  Init_layout(LAYOUT_T* layout, int kind, int m, int n, int mb,
+         int nb, MPI_Comm comm);
+
+/* One dimension of a layout:  n indices over q processes, by    */
+/*     Block_low if block is 0, else cyclically in blocks.  Dim_  */
+/*     global is the global index of local index local on the     */
+/*     process with grid coordinate coord.                        */
+int  Dim_global(int local, int coord, int q, int block, int n);
+int  Dim_owner(int global, int q, int block, int n);
+int  Dim_size(int coord, int q, int block, int n);
+
+/* Build a plan for moving a matrix stored with layout src to dst.  */
+/*     If transpose is nonzero, the dst matrix is the transpose of  */
+/*     the src matrix, so dst->m must be src->n and dst->n must be  */
+/*     src->m.  base is a predefined type.  Collective on comm.     */
+/*     Returns 0, or -1 if the layouts don't match.                 */
+int  Redist_plan(REDIST_T* plan, LAYOUT_T* src, LAYOUT_T* dst,
+         int transpose, MPI_Datatype base, int method, MPI_Comm comm);
+
+/* b = a, or a^T, with the plan's layouts.  a and b mustn't overlap. */
+/*     Collective.                                                    */
+int  Redistribute(REDIST_T* plan, void* a, void* b);
+
+void Redist_free(REDIST_T* plan);
+
+#endif
@@ -0,0 +1,190 @@
+/* redist_bench.c -- check and time redist.c for every pair of
+ *     layouts, with and without transposing.
+ *
+ * Input:
+ *     m, n: order of the matrix of doubles
+ *     mb, nb: block size for the block-cyclic layout
+ *     reps: number of redistributions of each kind
+ * Output:
+ *     For each source layout, destination layout, and transpose flag
+ *     (T), the mean time of one redistribution with each method,
+ *     the maximum over the processes.  If any method put a wrong
+ *     entry in the destination, the row ends with the number of
+ *     wrong entries, summed over the methods and processes.
+ *
+ * Notes:
+ *     1.  Entry (i,j) of the source matrix is i*n + j.
+ *     2.  Each plan is built and checked once, outside the timed
+ *         loop, and reused for the reps.
+ *
+ * See Chap 6, pp. 98 & ff in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+#include "redist.h"
+
+long   Wrong_entries(REDIST_T* plan, LAYOUT_T* src, LAYOUT_T* dst,
+           int transpose, double* A, double* B);
+double Time_redist(REDIST_T* plan, int reps, double* A, double* B);
+
+/********************************************************************/
+int main(int argc, char* argv[]) {
+    int           my_rank, p;
+    int           input[5];
+    int           m, n, mb, nb, reps;
+    int           src_kind, dst_kind, transpose, method;
+    long          wrong, total_wrong;
+    long          max_local;
+    double*       A;
+    double*       B;
+    double        elapsed, max_elapsed;
+    LAYOUT_T      layouts[2][LAYOUTS];   /* [transpose][kind] */
+    REDIST_T      plan;
+    static char*  layout_names[LAYOUTS] = {"row-block", "col-block",
+                      "2-D block", "blk-cyclic"};
+    static char*  method_names[REDIST_METHODS] = {"alltoallw",
+                      "alltoallv", "pairwise"};
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &p);
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+
+    if (my_rank == 0) {
+        printf("Enter m, n, mb, nb, reps\n");
+        scanf("%d %d %d %d %d", &input[0], &input[1], &input[2],
+            &input[3], &input[4]);
+    }
+    MPI_Bcast(input, 5, MPI_INT, 0, MPI_COMM_WORLD);
+    m = input[0];
+    n = input[1];
+    mb = input[2];
+    nb = input[3];
+    reps = (input[4] > 0 ? input[4] : 1);
+
+    /* layouts[0] hold the m x n matrix, layouts[1] its transpose */
+    max_local = 0;
+    for (src_kind = 0; src_kind < LAYOUTS; src_kind++) {
+        if (Init_layout(&layouts[0][src_kind], src_kind, m, n, mb, nb,
+                    MPI_COMM_WORLD) ||
+                Init_layout(&layouts[1][src_kind], src_kind, n, m, mb,
+                    nb, MPI_COMM_WORLD)) {
+            if (my_rank == 0)
+                fprintf(stderr, "Bad m, n, mb or nb\n");
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+        for (transpose = 0; transpose < 2; transpose++)
+            if (((long) layouts[transpose][src_kind].local_rows)*
+                    layouts[transpose][src_kind].local_cols > max_local)
+                max_local = ((long) layouts[transpose][src_kind].
+                    local_rows)*layouts[transpose][src_kind].local_cols;
+    }
+    A = (double*) malloc((max_local > 0 ? max_local : 1)*sizeof(double));
+    B = (double*) malloc((max_local > 0 ? max_local : 1)*sizeof(double));
+    if ((A == (double*) NULL) || (B == (double*) NULL)) {
+        fprintf(stderr, "Process %d > Can't allocate matrices\n",
+            my_rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    if (my_rank == 0) {
+        printf("%-10s    %-10s  T", "from", "to");
+        for (method = 0; method < REDIST_METHODS; method++)
+            printf(" %11s", method_names[method]);
+        printf("\n");
+    }
+    for (src_kind = 0; src_kind < LAYOUTS; src_kind++)
+        for (dst_kind = 0; dst_kind < LAYOUTS; dst_kind++)
+            for (transpose = 0; transpose < 2; transpose++) {
+                if (my_rank == 0)
+                    printf("%-10s -> %-10s  %c", layout_names[src_kind],
+                        layout_names[dst_kind], transpose ? 'T' : ' ');
+                wrong = 0;
+                for (method = 0; method < REDIST_METHODS; method++) {
+                    if (Redist_plan(&plan, &layouts[0][src_kind],
+                            &layouts[transpose][dst_kind], transpose,
+                            MPI_DOUBLE, method, MPI_COMM_WORLD)) {
+                        fprintf(stderr, "Process %d > Can't build plan\n",
+                            my_rank);
+                        MPI_Abort(MPI_COMM_WORLD, -1);
+                    }
+                    wrong += Wrong_entries(&plan, &layouts[0][src_kind],
+                        &layouts[transpose][dst_kind], transpose, A, B);
+                    elapsed = Time_redist(&plan, reps, A, B);
+                    Redist_free(&plan);
+                    MPI_Reduce(&elapsed, &max_elapsed, 1, MPI_DOUBLE,
+                        MPI_MAX, 0, MPI_COMM_WORLD);
+                    if (my_rank == 0)
+                        printf(" %11.3e", max_elapsed);
+                }
+                MPI_Reduce(&wrong, &total_wrong, 1, MPI_LONG, MPI_SUM, 0,
+                    MPI_COMM_WORLD);
+                if (my_rank == 0) {
+                    if (total_wrong > 0)
+                        printf("  %ld wrong", total_wrong);
+                    printf("\n");
+                }
+            }
+
+    free(A);
+    free(B);
+    MPI_Finalize();
+    return 0;
+}  /* main */
+
+
+/********************************************************************/
+/* Fill A with the source matrix, redistribute it into B with plan,
+ *     and return the number of my entries of B that are wrong.
+ */
+long Wrong_entries(
+         REDIST_T*  plan       /* in  */,
+         LAYOUT_T*  src        /* in  */,
+         LAYOUT_T*  dst        /* in  */,
+         int        transpose  /* in  */,
+         double*    A          /* out */,
+         double*    B          /* out */) {
+    int       i, j;
+    long      global_i, global_j;
+    long      wrong = 0;
+    double    expected;
+
+    for (i = 0; i < src->local_rows; i++)
+        for (j = 0; j < src->local_cols; j++)
+            A[i*src->local_cols + j] =
+                ((double) Global_row(src, i))*src->n + Global_col(src, j);
+    for (i = 0; i < dst->local_rows*dst->local_cols; i++)
+        B[i] = -1.0;
+
+    Redistribute(plan, A, B);
+    for (i = 0; i < dst->local_rows; i++)
+        for (j = 0; j < dst->local_cols; j++) {
+            global_i = Global_row(dst, i);
+            global_j = Global_col(dst, j);
+            if (transpose)
+                expected = ((double) global_j)*src->n + global_i;
+            else
+                expected = ((double) global_i)*src->n + global_j;
+            if (B[i*dst->local_cols + j] != expected)
+                wrong++;
+        }
+    return wrong;
+}  /* Wrong_entries */
+
+
+/********************************************************************/
+/* Mean time of reps redistributions with plan */
+double Time_redist(
+           REDIST_T*  plan  /* in  */,
+           int        reps  /* in  */,
+           double*    A     /* in  */,
+           double*    B     /* out */) {
+    int     rep;
+    double  start;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+    for (rep = 0; rep < reps; rep++)
+        Redistribute(plan, A, B);
+    return (MPI_Wtime() - start)/reps;
+}  /* Time_redist */
@@ -4,7 +4,10 @@
  * Input:  None
  * Output:  The column received by process 1
  *
- * Note:  This program should only be run with 2 processes
+ * Notes:
+ *     1.  This program should only be run with 2 processes
+ *     2.  See submat.c for a library that sends columns, blocks,
+ *         triangles and transposes of matrices of any size.
  *
  * See Chap 6., pp. 96 & ff in PPMPI
  */
@@ -4,7 +4,10 @@
  * Input: none
  * Output: The row received by process 1.
  *
- * Note:  This program should only be run with 2 processes
+ * Notes:
+ *     1.  This program should only be run with 2 processes
+ *     2.  See redist.c for transposing a whole distributed matrix,
+ *         and converting between block and block-cyclic layouts.
  *
  * See Chap 6., pp. 98 & ff in PPMPI
  */
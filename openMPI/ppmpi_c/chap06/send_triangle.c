@@ -4,7 +4,10 @@
  * Input:  None
  * Output:  The matrix received by process 1
  *
- * Note:  This program should only be run with 2 processes.
+ * Notes:
+ *     1.  This program should only be run with 2 processes.
+ *     2.  See submat.c for a library that caches the datatypes, and
+ *         chooses between them and MPI_Pack-style copying.
  *
  * See Chap 6, p. 98, in PPMPI.
  */
@@ -0,0 +1,228 @@
+/* sparse_dist.c -- distribute a random sparse matrix by blocks of rows,
+ *     rebalance it so that the processes have about the same number
+ *     of nonzeroes, and gather it back.
+ *
+ * Input:
+ *     rows, cols:  the order of the matrix
+ *     nonzeroes:  the number of nonzeroes
+ *     print_flag:  nonzero to print the matrix
+ * Output:
+ *     The number of rows and nonzeroes on each process, after the
+ *     scatter and after the rebalance, and whether the gathered
+ *     matrix is the same as the original.
+ *
+ * Notes:
+ *     1.  Process 0 generates the matrix in coordinate (COO) format
+ *         and converts it to CSR.  Most of the nonzeroes are in the
+ *         first rows, so a block distribution of the rows is badly
+ *         unbalanced.
+ *     2.  See sparse_mat.c for the packed row batches.
+ *
+ * See Chap. 6, pp. 104 & ff in PPMPI
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+#include "sparse_mat.h"
+
+#define IO_RANK 0
+
+void Get_input(int my_rank, int* rows_ptr, int* cols_ptr,
+         int* nonzeroes_ptr, int* print_flag_ptr);
+SPARSE_MAT_T* Generate_matrix(int rows, int cols, int nonzeroes);
+void Print_counts(char* title, SPARSE_MAT_T* local_A, int my_rank,
+         int p, MPI_Comm comm);
+void Print_matrix(SPARSE_MAT_T* A);
+int  Same_matrix(SPARSE_MAT_T* A, SPARSE_MAT_T* B);
+void Allocate_failed(int my_rank, char* name);
+
+int main(int argc, char* argv[]) {
+    int           p;
+    int           my_rank;
+    int           rows, cols, nonzeroes;
+    int           print_flag;
+    SPARSE_MAT_T* A = (SPARSE_MAT_T*) NULL;
+    SPARSE_MAT_T* local_A;
+    SPARSE_MAT_T* gathered_A;
+    int*          partition;
+    int           q;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &p);
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+
+    Get_input(my_rank, &rows, &cols, &nonzeroes, &print_flag);
+    if (my_rank == IO_RANK) {
+        A = Generate_matrix(rows, cols, nonzeroes);
+        if (A == (SPARSE_MAT_T*) NULL) Allocate_failed(my_rank, "A");
+        if (print_flag) Print_matrix(A);
+    }
+
+    partition = (int*) malloc((p+1)*sizeof(int));
+    for (q = 0; q <= p; q++)
+        partition[q] = Block_low(q, p, rows);
+    local_A = Scatter_rows(A, IO_RANK, partition, MPI_COMM_WORLD);
+    if (local_A == (SPARSE_MAT_T*) NULL)
+        Allocate_failed(my_rank, "local_A");
+    Print_counts("Block distribution", local_A, my_rank, p,
+        MPI_COMM_WORLD);
+
+    Balance_partition(local_A, partition, MPI_COMM_WORLD);
+    local_A = Redistribute(local_A, partition, MPI_COMM_WORLD);
+    if (local_A == (SPARSE_MAT_T*) NULL)
+        Allocate_failed(my_rank, "local_A");
+    Print_counts("Balanced distribution", local_A, my_rank, p,
+        MPI_COMM_WORLD);
+
+    gathered_A = Gather_rows(local_A, IO_RANK, MPI_COMM_WORLD);
+    if (my_rank == IO_RANK) {
+        if (gathered_A == (SPARSE_MAT_T*) NULL)
+            Allocate_failed(my_rank, "gathered_A");
+        if (Same_matrix(A, gathered_A))
+            printf("The gathered matrix is the same as the original\n");
+        else
+            printf("The gathered matrix is NOT the same as the original\n");
+        Free_sparse(&gathered_A);
+        Free_sparse(&A);
+    }
+
+    Free_sparse(&local_A);
+    free(partition);
+    MPI_Finalize();
+    return 0;
+}  /* main */
+
+
+/********************************************************************/
+void Get_input(
+         int   my_rank         /* in  */,
+         int*  rows_ptr        /* out */,
+         int*  cols_ptr        /* out */,
+         int*  nonzeroes_ptr   /* out */,
+         int*  print_flag_ptr  /* out */) {
+    int input[4];
+
+    if (my_rank == IO_RANK) {
+        printf("Enter rows, cols, nonzeroes, and print_flag\n");
+        scanf("%d %d %d %d", &input[0], &input[1], &input[2], &input[3]);
+    }
+    MPI_Bcast(input, 4, MPI_INT, IO_RANK, MPI_COMM_WORLD);
+    *rows_ptr = input[0];
+    *cols_ptr = input[1];
+    *nonzeroes_ptr = input[2];
+    *print_flag_ptr = input[3];
+}  /* Get_input */
+
+
+/********************************************************************/
+/* Row subscripts are rows*u*u for u uniform on [0,1), so row i gets
+ * nonzeroes in proportion to about 1/sqrt(i).
+ */
+SPARSE_MAT_T* Generate_matrix(
+         int  rows       /* in */,
+         int  cols       /* in */,
+         int  nonzeroes  /* in */) {
+    SPARSE_MAT_T* A;
+    int*          row_subscripts;
+    int*          column_subscripts;
+    float*        entries;
+    double        u;
+    int           k;
+
+    row_subscripts = (int*) malloc((nonzeroes + 1)*sizeof(int));
+    column_subscripts = (int*) malloc((nonzeroes + 1)*sizeof(int));
+    entries = (float*) malloc((nonzeroes + 1)*sizeof(float));
+    if ((row_subscripts == (int*) NULL) ||
+            (column_subscripts == (int*) NULL) ||
+            (entries == (float*) NULL))
+        return (SPARSE_MAT_T*) NULL;
+
+    srand(1);
+    for (k = 0; k < nonzeroes; k++) {
+        u = rand()/(RAND_MAX + 1.0);
+        row_subscripts[k] = (int) (rows*u*u);
+        column_subscripts[k] = rand() % cols;
+        entries[k] = (float) (k % 100);
+    }
+
+    A = Coo_to_csr(rows, cols, nonzeroes, row_subscripts,
+        column_subscripts, entries);
+    free(row_subscripts);
+    free(column_subscripts);
+    free(entries);
+    return A;
+}  /* Generate_matrix */
+
+
+/********************************************************************/
+void Print_counts(
+         char*          title    /* in */,
+         SPARSE_MAT_T*  local_A  /* in */,
+         int            my_rank  /* in */,
+         int            p        /* in */,
+         MPI_Comm       comm     /* in */) {
+    int  my_counts[3];
+    int* counts = (int*) NULL;
+    int  q;
+
+    my_counts[0] = local_A->first_row;
+    my_counts[1] = local_A->local_rows;
+    my_counts[2] = local_A->nonzeroes;
+    if (my_rank == IO_RANK)
+        counts = (int*) malloc(3*p*sizeof(int));
+    MPI_Gather(my_counts, 3, MPI_INT, counts, 3, MPI_INT, IO_RANK, comm);
+
+    if (my_rank == IO_RANK) {
+        printf("%s:\n", title);
+        for (q = 0; q < p; q++)
+            if (counts[3*q+1] == 0)
+                printf("    Process %d:  no rows\n", q);
+            else
+                printf("    Process %d:  rows %d-%d, %d nonzeroes\n", q,
+                    counts[3*q], counts[3*q] + counts[3*q+1] - 1,
+                    counts[3*q+2]);
+        free(counts);
+    }
+}  /* Print_counts */
+
+
+/********************************************************************/
+void Print_matrix(
+         SPARSE_MAT_T*  A  /* in */) {
+    int i, k;
+
+    for (i = 0; i < A->local_rows; i++) {
+        printf("%d:", A->first_row + i);
+        for (k = A->row_start[i]; k < A->row_start[i+1]; k++)
+            printf(" (%d, %4.1f)", A->column_subscripts[k], A->entries[k]);
+        printf("\n");
+    }
+}  /* Print_matrix */
+
+
+/********************************************************************/
+int Same_matrix(
+         SPARSE_MAT_T*  A  /* in */,
+         SPARSE_MAT_T*  B  /* in */) {
+    int i, k;
+
+    if ((A->rows != B->rows) || (A->cols != B->cols) ||
+            (A->nonzeroes != B->nonzeroes))
+        return 0;
+    for (i = 0; i <= A->rows; i++)
+        if (A->row_start[i] != B->row_start[i]) return 0;
+    for (k = 0; k < A->nonzeroes; k++)
+        if ((A->column_subscripts[k] != B->column_subscripts[k]) ||
+                (A->entries[k] != B->entries[k]))
+            return 0;
+    return 1;
+}  /* Same_matrix */
+
+
+/********************************************************************/
+void Allocate_failed(
+         int    my_rank  /* in */,
+         char*  name     /* in */) {
+    fprintf(stderr, "Process %d > Can't allocate %s\n", my_rank, name);
+    MPI_Abort(MPI_COMM_WORLD, -1);
+}  /* Allocate_failed */
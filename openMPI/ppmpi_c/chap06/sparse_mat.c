@@ -0,0 +1,522 @@
+/* sparse_mat.c -- functions for a sparse matrix that's distributed by
+ *     blocks of rows and stored in compressed sparse row format.
+ *
+ * Rows are moved between processes in packed batches.  A batch of
+ * count consecutive rows is packed as
+ *
+ *     count, first_row, nonzeroes, base  (4 ints)
+ *     the ends of the rows               (count ints)
+ *     the entries of the rows            (nonzeroes floats)
+ *     the column subscripts of the rows  (nonzeroes ints)
+ *
+ * The ends of the rows are the sender's row_start[first+1], ...,
+ * row_start[first+count], and base is its row_start[first].  So the
+ * receiver can read the header, allocate storage, and unpack the rest
+ * directly into its CSR arrays, shifting the ends by its own start.
+ * This is sparse_row.c's approach, but a message carries any number of
+ * rows.  The messages have no fixed size:  point-to-point receivers
+ * find the size with MPI_Probe and MPI_Get_count, and MPI_Alltoallv
+ * receivers get it from an MPI_Alltoall of the byte counts.
+ *
+ * The processes' blocks of rows must be in rank order:  process q's
+ * first row follows process q-1's last row.
+ *
+ * See Chap. 6, pp. 104 & ff in PPMPI
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+#include "sparse_mat.h"
+
+#define SCATTER_TAG 0
+#define GATHER_TAG  1
+#define HEADER_SIZE 4
+
+static void Peek_header(char* buffer, int size, int position,
+                int* count_ptr, int* first_ptr, int* nonzeroes_ptr,
+                MPI_Comm comm);
+
+
+/********************************************************************/
+SPARSE_MAT_T* Allocate_sparse(
+         int  rows        /* in */,
+         int  cols        /* in */,
+         int  first_row   /* in */,
+         int  local_rows  /* in */,
+         int  nonzeroes   /* in */) {
+    SPARSE_MAT_T* A;
+
+    A = (SPARSE_MAT_T*) malloc(sizeof(SPARSE_MAT_T));
+    if (A == (SPARSE_MAT_T*) NULL) return A;
+    A->rows = rows;
+    A->cols = cols;
+    A->first_row = first_row;
+    A->local_rows = local_rows;
+    A->nonzeroes = nonzeroes;
+    /* Add 1 so that malloc(0) isn't an error */
+    A->row_start = (int*) malloc((local_rows + 1)*sizeof(int));
+    A->column_subscripts = (int*) malloc((nonzeroes + 1)*sizeof(int));
+    A->entries = (float*) malloc((nonzeroes + 1)*sizeof(float));
+    if ((A->row_start == (int*) NULL) ||
+            (A->column_subscripts == (int*) NULL) ||
+            (A->entries == (float*) NULL)) {
+        Free_sparse(&A);
+        return A;
+    }
+    A->row_start[0] = 0;
+    return A;
+}  /* Allocate_sparse */
+
+
+/********************************************************************/
+void Free_sparse(
+         SPARSE_MAT_T**  A_ptr  /* in/out */) {
+    SPARSE_MAT_T* A = *A_ptr;
+
+    if (A == (SPARSE_MAT_T*) NULL) return;
+    free(A->row_start);
+    free(A->column_subscripts);
+    free(A->entries);
+    free(A);
+    *A_ptr = (SPARSE_MAT_T*) NULL;
+}  /* Free_sparse */
+
+
+/********************************************************************/
+/* Counting sort on the row subscripts.  Within a row the nonzeroes
+ * stay in the order they were given.
+ */
+SPARSE_MAT_T* Coo_to_csr(
+         int     rows               /* in */,
+         int     cols               /* in */,
+         int     nonzeroes          /* in */,
+         int*    row_subscripts     /* in */,
+         int*    column_subscripts  /* in */,
+         float*  entries            /* in */) {
+    SPARSE_MAT_T* A;
+    int*          next;
+    int           i, k;
+
+    A = Allocate_sparse(rows, cols, 0, rows, nonzeroes);
+    if (A == (SPARSE_MAT_T*) NULL) return A;
+    next = (int*) calloc(rows + 1, sizeof(int));
+    if (next == (int*) NULL) {
+        Free_sparse(&A);
+        return A;
+    }
+
+    for (k = 0; k < nonzeroes; k++)
+        next[row_subscripts[k] + 1]++;
+    for (i = 0; i < rows; i++)
+        next[i+1] += next[i];
+    for (i = 0; i <= rows; i++)
+        A->row_start[i] = next[i];
+
+    for (k = 0; k < nonzeroes; k++) {
+        i = next[row_subscripts[k]]++;
+        A->column_subscripts[i] = column_subscripts[k];
+        A->entries[i] = entries[k];
+    }
+
+    free(next);
+    return A;
+}  /* Coo_to_csr */
+
+
+/********************************************************************/
+int Pack_rows_size(
+         SPARSE_MAT_T*  A      /* in */,
+         int            first  /* in */,
+         int            count  /* in */,
+         MPI_Comm       comm   /* in */) {
+    int nonzeroes = A->row_start[first+count] - A->row_start[first];
+    int int_size, float_size, subscript_size;
+
+    MPI_Pack_size(HEADER_SIZE + count, MPI_INT, comm, &int_size);
+    MPI_Pack_size(nonzeroes, MPI_FLOAT, comm, &float_size);
+    MPI_Pack_size(nonzeroes, MPI_INT, comm, &subscript_size);
+    return int_size + float_size + subscript_size;
+}  /* Pack_rows_size */
+
+
+/********************************************************************/
+/* Pack local rows first, ..., first+count-1 of A into buffer,
+ * starting at *position_ptr.
+ */
+void Pack_rows(
+         SPARSE_MAT_T*  A             /* in     */,
+         int            first         /* in     */,
+         int            count         /* in     */,
+         char*          buffer        /* out    */,
+         int            size          /* in     */,
+         int*           position_ptr  /* in/out */,
+         MPI_Comm       comm          /* in     */) {
+    int header[HEADER_SIZE];
+    int start = A->row_start[first];
+
+    header[0] = count;
+    header[1] = A->first_row + first;
+    header[2] = A->row_start[first+count] - start;
+    header[3] = start;
+    MPI_Pack(header, HEADER_SIZE, MPI_INT, buffer, size,
+        position_ptr, comm);
+    MPI_Pack(A->row_start + first + 1, count, MPI_INT, buffer, size,
+        position_ptr, comm);
+    MPI_Pack(A->entries + start, header[2], MPI_FLOAT, buffer, size,
+        position_ptr, comm);
+    MPI_Pack(A->column_subscripts + start, header[2], MPI_INT, buffer,
+        size, position_ptr, comm);
+}  /* Pack_rows */
+
+
+/********************************************************************/
+/* Read the header of the batch at position without moving past it */
+static void Peek_header(
+         char*     buffer         /* in  */,
+         int       size           /* in  */,
+         int       position       /* in  */,
+         int*      count_ptr      /* out */,
+         int*      first_ptr      /* out */,
+         int*      nonzeroes_ptr  /* out */,
+         MPI_Comm  comm           /* in  */) {
+    int header[HEADER_SIZE];
+
+    MPI_Unpack(buffer, size, &position, header, HEADER_SIZE, MPI_INT,
+        comm);
+    *count_ptr = header[0];
+    *first_ptr = header[1];
+    *nonzeroes_ptr = header[2];
+}  /* Peek_header */
+
+
+/********************************************************************/
+/* The rows of the batch must be in A's block, and the rows of A
+ * that precede them must already have been filled in.
+ */
+int Unpack_rows(
+         char*          buffer        /* in     */,
+         int            size          /* in     */,
+         int*           position_ptr  /* in/out */,
+         SPARSE_MAT_T*  A             /* in/out */,
+         MPI_Comm       comm          /* in     */) {
+    int header[HEADER_SIZE];
+    int first, start, i;
+
+    MPI_Unpack(buffer, size, position_ptr, header, HEADER_SIZE, MPI_INT,
+        comm);
+    first = header[1] - A->first_row;
+    start = A->row_start[first];
+
+    /* Unpack the ends into row_start, then shift them */
+    MPI_Unpack(buffer, size, position_ptr, A->row_start + first + 1,
+        header[0], MPI_INT, comm);
+    for (i = first + 1; i <= first + header[0]; i++)
+        A->row_start[i] += start - header[3];
+
+    MPI_Unpack(buffer, size, position_ptr, A->entries + start,
+        header[2], MPI_FLOAT, comm);
+    MPI_Unpack(buffer, size, position_ptr, A->column_subscripts + start,
+        header[2], MPI_INT, comm);
+    return header[0];
+}  /* Unpack_rows */
+
+
+/********************************************************************/
+/* io_rank sends each process its block in a single message.  The
+ * receivers don't know how long it is, so they probe for it.
+ */
+SPARSE_MAT_T* Scatter_rows(
+         SPARSE_MAT_T*  A          /* in */,
+         int            io_rank    /* in */,
+         int*           partition  /* in */,
+         MPI_Comm       comm       /* in */) {
+    int           p, my_rank;
+    int           order[2];
+    SPARSE_MAT_T* local_A;
+    char*         buffer;
+    int           size, position, max_size;
+    int           count, first, nonzeroes;
+    int           q;
+    MPI_Status    status;
+
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &my_rank);
+
+    if (my_rank == io_rank) {
+        order[0] = A->rows;
+        order[1] = A->cols;
+    }
+    MPI_Bcast(order, 2, MPI_INT, io_rank, comm);
+
+    if (my_rank == io_rank) {
+        max_size = 0;
+        for (q = 0; q < p; q++) {
+            size = Pack_rows_size(A, partition[q],
+                partition[q+1] - partition[q], comm);
+            if (size > max_size) max_size = size;
+        }
+        buffer = (char*) malloc(max_size);
+        if (buffer == (char*) NULL) return (SPARSE_MAT_T*) NULL;
+        for (q = 0; q < p; q++) {
+            if (q == my_rank) continue;
+            position = 0;
+            Pack_rows(A, partition[q], partition[q+1] - partition[q],
+                buffer, max_size, &position, comm);
+            MPI_Send(buffer, position, MPI_PACKED, q, SCATTER_TAG,
+                comm);
+        }
+
+        /* Copy my own rows the same way */
+        position = 0;
+        Pack_rows(A, partition[my_rank],
+            partition[my_rank+1] - partition[my_rank],
+            buffer, max_size, &position, comm);
+        size = position;
+    } else {
+        MPI_Probe(io_rank, SCATTER_TAG, comm, &status);
+        MPI_Get_count(&status, MPI_PACKED, &size);
+        buffer = (char*) malloc(size);
+        if (buffer == (char*) NULL) return (SPARSE_MAT_T*) NULL;
+        MPI_Recv(buffer, size, MPI_PACKED, io_rank, SCATTER_TAG,
+            comm, &status);
+    }
+
+    Peek_header(buffer, size, 0, &count, &first, &nonzeroes, comm);
+    local_A = Allocate_sparse(order[0], order[1], first, count,
+        nonzeroes);
+    if (local_A != (SPARSE_MAT_T*) NULL) {
+        position = 0;
+        Unpack_rows(buffer, size, &position, local_A, comm);
+    }
+
+    free(buffer);
+    return local_A;
+}  /* Scatter_rows */
+
+
+/********************************************************************/
+/* Each process packs the rows that move to process q into one batch.
+ * The batches are exchanged with a single MPI_Alltoallv.  Since the
+ * old blocks are in rank order, the batches a process receives are
+ * in row order if it unpacks them in rank order.
+ */
+SPARSE_MAT_T* Redistribute(
+         SPARSE_MAT_T*  A              /* in/out */,
+         int*           new_partition  /* in     */,
+         MPI_Comm       comm           /* in     */) {
+    int           p, my_rank;
+    SPARSE_MAT_T* new_A;
+    int*          send_counts;
+    int*          send_displs;
+    int*          recv_counts;
+    int*          recv_displs;
+    char*         send_buffer;
+    char*         recv_buffer;
+    int           my_first = A->first_row;
+    int           my_last = A->first_row + A->local_rows;
+    int           first, last;
+    int           position, send_size, recv_size;
+    int           count, batch_first, nonzeroes, total;
+    int           q;
+
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &my_rank);
+
+    send_counts = (int*) malloc(4*p*sizeof(int));
+    if (send_counts == (int*) NULL) return (SPARSE_MAT_T*) NULL;
+    send_displs = send_counts + p;
+    recv_counts = send_displs + p;
+    recv_displs = recv_counts + p;
+
+    /* Upper bounds on the batch sizes */
+    send_size = 0;
+    for (q = 0; q < p; q++) {
+        first = (new_partition[q] > my_first) ?
+            new_partition[q] : my_first;
+        last = (new_partition[q+1] < my_last) ?
+            new_partition[q+1] : my_last;
+        send_displs[q] = send_size;
+        if (first < last)
+            send_size += Pack_rows_size(A, first - my_first,
+                last - first, comm);
+    }
+    send_buffer = (char*) malloc(send_size + 1);
+    if (send_buffer == (char*) NULL) {
+        free(send_counts);
+        return (SPARSE_MAT_T*) NULL;
+    }
+
+    /* Pack, and record the actual sizes */
+    for (q = 0; q < p; q++) {
+        first = (new_partition[q] > my_first) ?
+            new_partition[q] : my_first;
+        last = (new_partition[q+1] < my_last) ?
+            new_partition[q+1] : my_last;
+        position = send_displs[q];
+        if (first < last)
+            Pack_rows(A, first - my_first, last - first,
+                send_buffer, send_size, &position, comm);
+        send_counts[q] = position - send_displs[q];
+    }
+
+    MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, comm);
+    recv_size = 0;
+    for (q = 0; q < p; q++) {
+        recv_displs[q] = recv_size;
+        recv_size += recv_counts[q];
+    }
+    recv_buffer = (char*) malloc(recv_size + 1);
+    if (recv_buffer == (char*) NULL) {
+        free(send_buffer);
+        free(send_counts);
+        return (SPARSE_MAT_T*) NULL;
+    }
+    MPI_Alltoallv(send_buffer, send_counts, send_displs, MPI_PACKED,
+        recv_buffer, recv_counts, recv_displs, MPI_PACKED, comm);
+    free(send_buffer);
+
+    /* The headers tell us how much storage we need */
+    total = 0;
+    for (q = 0; q < p; q++)
+        if (recv_counts[q] > 0) {
+            Peek_header(recv_buffer, recv_size, recv_displs[q],
+                &count, &batch_first, &nonzeroes, comm);
+            total += nonzeroes;
+        }
+    new_A = Allocate_sparse(A->rows, A->cols, new_partition[my_rank],
+        new_partition[my_rank+1] - new_partition[my_rank], total);
+    if (new_A != (SPARSE_MAT_T*) NULL) {
+        for (q = 0; q < p; q++)
+            if (recv_counts[q] > 0) {
+                position = recv_displs[q];
+                Unpack_rows(recv_buffer, recv_size, &position, new_A,
+                    comm);
+            }
+        Free_sparse(&A);
+    }
+
+#   ifdef DEBUG
+    printf("Process %d > sent %d bytes, received %d bytes\n",
+        my_rank, send_displs[p-1] + send_counts[p-1], recv_size);
+    fflush(stdout);
+#   endif
+
+    free(recv_buffer);
+    free(send_counts);
+    return new_A;
+}  /* Redistribute */
+
+
+/********************************************************************/
+/* Row i gets weight (nonzeroes in row i) + 1, so that empty rows
+ * still count for something.  If W is the total weight, row i goes to
+ * process (weight of rows 0, ..., i-1)*p/W.
+ */
+void Balance_partition(
+         SPARSE_MAT_T*  A          /* in  */,
+         int*           partition  /* out */,
+         MPI_Comm       comm       /* in  */) {
+    int   p, my_rank;
+    long  my_weight, before, total;
+    int   i, q;
+
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &my_rank);
+
+    my_weight = (long) A->row_start[A->local_rows] + A->local_rows;
+    MPI_Exscan(&my_weight, &before, 1, MPI_LONG, MPI_SUM, comm);
+    if (my_rank == 0) before = 0;
+    MPI_Allreduce(&my_weight, &total, 1, MPI_LONG, MPI_SUM, comm);
+
+    /* partition[q] = the first row that goes to process q or later */
+    for (q = 0; q <= p; q++)
+        partition[q] = A->rows;
+    for (i = 0; i < A->local_rows; i++) {
+        q = (int) (before*p/total);
+        if (A->first_row + i < partition[q])
+            partition[q] = A->first_row + i;
+        before += A->row_start[i+1] - A->row_start[i] + 1;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, partition, p + 1, MPI_INT, MPI_MIN,
+        comm);
+    for (q = p - 1; q >= 0; q--)
+        if (partition[q+1] < partition[q])
+            partition[q] = partition[q+1];
+    partition[0] = 0;
+}  /* Balance_partition */
+
+
+/********************************************************************/
+/* Each process sends its whole block in one message, and io_rank
+ * probes for the messages in rank order.
+ */
+SPARSE_MAT_T* Gather_rows(
+         SPARSE_MAT_T*  A        /* in */,
+         int            io_rank  /* in */,
+         MPI_Comm       comm     /* in */) {
+    int           p, my_rank;
+    SPARSE_MAT_T* full_A;
+    char*         my_buffer;
+    char*         buffer = (char*) NULL;
+    char*         temp;
+    int           my_size, size, max_size = 0;
+    int           position;
+    int           total;
+    int           q;
+    MPI_Status    status;
+
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &my_rank);
+
+    MPI_Reduce(&(A->nonzeroes), &total, 1, MPI_INT, MPI_SUM, io_rank,
+        comm);
+
+    my_size = Pack_rows_size(A, 0, A->local_rows, comm);
+    my_buffer = (char*) malloc(my_size);
+    if (my_buffer == (char*) NULL) return (SPARSE_MAT_T*) NULL;
+    position = 0;
+    Pack_rows(A, 0, A->local_rows, my_buffer, my_size, &position, comm);
+    my_size = position;
+
+    if (my_rank != io_rank) {
+        MPI_Send(my_buffer, my_size, MPI_PACKED, io_rank, GATHER_TAG,
+            comm);
+        free(my_buffer);
+        return (SPARSE_MAT_T*) NULL;
+    }
+
+    full_A = Allocate_sparse(A->rows, A->cols, 0, A->rows, total);
+    if (full_A == (SPARSE_MAT_T*) NULL) {
+        free(my_buffer);
+        return full_A;
+    }
+    for (q = 0; q < p; q++) {
+        if (q == my_rank) {
+            temp = my_buffer;
+            size = my_size;
+        } else {
+            MPI_Probe(q, GATHER_TAG, comm, &status);
+            MPI_Get_count(&status, MPI_PACKED, &size);
+            if (size > max_size) {
+                temp = (char*) realloc(buffer, size);
+                if (temp == (char*) NULL) {
+                    free(buffer);
+                    free(my_buffer);
+                    Free_sparse(&full_A);
+                    return full_A;
+                }
+                buffer = temp;
+                max_size = size;
+            }
+            MPI_Recv(buffer, size, MPI_PACKED, q, GATHER_TAG, comm,
+                &status);
+            temp = buffer;
+        }
+        position = 0;
+        Unpack_rows(temp, size, &position, full_A, comm);
+    }
+
+    free(buffer);
+    free(my_buffer);
+    return full_A;
+}  /* Gather_rows */
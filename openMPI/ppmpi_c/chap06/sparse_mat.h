@@ -0,0 +1,74 @@
+/* sparse_mat.h -- definitions and declarations for a sparse matrix
+ *     that's distributed by blocks of rows and stored in compressed
+ *     sparse row (CSR) format.
+ *
+ * See sparse_mat.c
+ */
+#ifndef SPARSE_MAT_H
+#define SPARSE_MAT_H
+
+#include "mpi.h"
+#include "block_dist.h"
+
+/* Process q's rows are partition[q], ..., partition[q+1]-1.  So a   */
+/*     partition of n rows among p processes has p+1 entries, with   */
+/*     partition[0] = 0 and partition[p] = n.                        */
+
+/* Rows first_row, ..., first_row + local_rows - 1.  The nonzeroes of */
+/*     local row i are entries[row_start[i]], ...,                    */
+/*     entries[row_start[i+1]-1], and their columns are in            */
+/*     column_subscripts.  On a single process with first_row = 0 and */
+/*     local_rows = rows it's an ordinary CSR matrix.                 */
+typedef struct {
+    int     rows;               /* Global number of rows       */
+    int     cols;               /* Global number of columns    */
+    int     first_row;          /* Global number of local row 0 */
+    int     local_rows;
+    int     nonzeroes;          /* Local nonzeroes             */
+    int*    row_start;          /* local_rows + 1 entries      */
+    int*    column_subscripts;  /* nonzeroes entries           */
+    float*  entries;            /* nonzeroes entries           */
+} SPARSE_MAT_T;
+
+/* Returns NULL if malloc fails */
+SPARSE_MAT_T* Allocate_sparse(int rows, int cols, int first_row,
+                  int local_rows, int nonzeroes);
+void Free_sparse(SPARSE_MAT_T** A_ptr);
+
+/* Build a CSR matrix from nonzeroes triples (row, col, entry) in  */
+/*     any order.  Duplicates are kept.  Returns NULL if malloc    */
+/*     fails.  Not collective.                                     */
+SPARSE_MAT_T* Coo_to_csr(int rows, int cols, int nonzeroes,
+                  int* row_subscripts, int* column_subscripts,
+                  float* entries);
+
+/* Packed row batches:  Pack_rows_size is an upper bound on the     */
+/*     space Pack_rows needs for local rows first, ..., first+count-1 */
+int  Pack_rows_size(SPARSE_MAT_T* A, int first, int count,
+         MPI_Comm comm);
+void Pack_rows(SPARSE_MAT_T* A, int first, int count, char* buffer,
+         int size, int* position_ptr, MPI_Comm comm);
+/* Unpack a batch into A after the rows it already has.  A must have */
+/*     room for them.  Returns the number of rows unpacked.          */
+int  Unpack_rows(char* buffer, int size, int* position_ptr,
+         SPARSE_MAT_T* A, MPI_Comm comm);
+
+/* Collective.  A is only significant on io_rank, which keeps it.   */
+/*     Returns my block of rows in the partition, NULL on error.     */
+SPARSE_MAT_T* Scatter_rows(SPARSE_MAT_T* A, int io_rank,
+                  int* partition, MPI_Comm comm);
+
+/* Collective.  Returns the rows of A in new_partition.  A is freed */
+/*     if the call succeeds.                                        */
+SPARSE_MAT_T* Redistribute(SPARSE_MAT_T* A, int* new_partition,
+                  MPI_Comm comm);
+
+/* Collective.  A partition in which the processes get about the    */
+/*     same number of nonzeroes.                                     */
+void Balance_partition(SPARSE_MAT_T* A, int* partition, MPI_Comm comm);
+
+/* Collective.  Returns the whole matrix on io_rank, NULL elsewhere */
+/*     and on error.                                                 */
+SPARSE_MAT_T* Gather_rows(SPARSE_MAT_T* A, int io_rank, MPI_Comm comm);
+
+#endif
@@ -8,6 +8,9 @@
  * Notes:  
  *     1. This program should only be run with 2 processes.  
  *     2. Only the row of the matrix is created on both processes.
+ *     3. The buffer is sized with MPI_Pack_size on process 0, and with
+ *        MPI_Probe and MPI_Get_count on process 1, so the row can have
+ *        any number of nonzeroes.  See sparse_mat.c for batches of rows.
  *
  * See Chap. 6, pp. 104 & ff in PPMPI
  */
@@ -15,8 +18,6 @@
 #include <stdlib.h>
 #include "mpi.h"
 
-#define HUGE 100
-
 main(int argc, char* argv[]) {
     int         p;
     int         my_rank;
@@ -25,7 +26,9 @@ main(int argc, char* argv[]) {
     int         nonzeroes;
     int         position;
     int         row_number;
-    char        buffer[HUGE]; /* HUGE is a predefined constant */
+    char*       buffer = NULL;
+    int         size;
+    int         temp;
     MPI_Status  status;
     int         i;
 
@@ -38,6 +41,7 @@ main(int argc, char* argv[]) {
         /* Allocate storage for the row. */
         /* Initialize entries and column_subscripts */
         nonzeroes = 10;
+        row_number = 5;
         entries = (float*) malloc(nonzeroes*sizeof(float));
         column_subscripts = (int*) malloc(nonzeroes*sizeof(int));
         for (i = 0; i < nonzeroes; i++) {
@@ -45,36 +49,48 @@ main(int argc, char* argv[]) {
             column_subscripts[i] = 3*i;
         }
 
+        /* Find out how big the buffer must be */
+        MPI_Pack_size(2 + nonzeroes, MPI_INT, MPI_COMM_WORLD, &size);
+        MPI_Pack_size(nonzeroes, MPI_FLOAT, MPI_COMM_WORLD, &temp);
+        size += temp;
+        buffer = (char*) malloc(size);
+
         /* Now pack the data and send */
         position = 0;
-        MPI_Pack(&nonzeroes, 1, MPI_INT, buffer, HUGE,
+        MPI_Pack(&nonzeroes, 1, MPI_INT, buffer, size,
             &position, MPI_COMM_WORLD);
-        MPI_Pack(&row_number, 1, MPI_INT, buffer, HUGE,
+        MPI_Pack(&row_number, 1, MPI_INT, buffer, size,
             &position, MPI_COMM_WORLD);
         MPI_Pack(entries, nonzeroes, MPI_FLOAT, buffer,
-            HUGE, &position, MPI_COMM_WORLD);
+            size, &position, MPI_COMM_WORLD);
         MPI_Pack(column_subscripts, nonzeroes, MPI_INT,
-            buffer, HUGE, &position, MPI_COMM_WORLD);
+            buffer, size, &position, MPI_COMM_WORLD);
         MPI_Send(buffer, position, MPI_PACKED, 1, 0,
             MPI_COMM_WORLD);
     } else { /* my_rank == 1 */
-        MPI_Recv(buffer, HUGE, MPI_PACKED, 0, 0,
+        /* Find out how big the message is before receiving it */
+        MPI_Probe(0, 0, MPI_COMM_WORLD, &status);
+        MPI_Get_count(&status, MPI_PACKED, &size);
+        buffer = (char*) malloc(size);
+        MPI_Recv(buffer, size, MPI_PACKED, 0, 0,
             MPI_COMM_WORLD, &status);
         position = 0;
-        MPI_Unpack(buffer, HUGE, &position, &nonzeroes,
+        MPI_Unpack(buffer, size, &position, &nonzeroes,
             1, MPI_INT, MPI_COMM_WORLD);
-        MPI_Unpack(buffer, HUGE, &position, &row_number,
+        MPI_Unpack(buffer, size, &position, &row_number,
             1, MPI_INT, MPI_COMM_WORLD);
         /* Allocate storage for entries and column_subscripts */
         entries = (float *) malloc(nonzeroes*sizeof(float));
         column_subscripts = (int *) malloc(nonzeroes*sizeof(int));
-        MPI_Unpack(buffer,HUGE, &position, entries,
+        MPI_Unpack(buffer, size, &position, entries,
             nonzeroes, MPI_FLOAT, MPI_COMM_WORLD);
-        MPI_Unpack(buffer, HUGE, &position, column_subscripts,
+        MPI_Unpack(buffer, size, &position, column_subscripts,
             nonzeroes, MPI_INT, MPI_COMM_WORLD);
+        printf("Row %d\n", row_number);
         for (i = 0; i < nonzeroes; i++) 
             printf("%4.1f %2d\n", entries[i], column_subscripts[i]);
     }
 
+    free(buffer);
     MPI_Finalize();
 }  /* main */
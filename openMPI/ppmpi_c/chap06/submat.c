@@ -0,0 +1,539 @@
+/* submat.c -- send and receive rectangular, triangular, strided or
+ *     transposed regions of row-major arrays of any size.  Generalizes
+ *     send_col.c, send_triangle.c and send_col_to_row.c.
+ *
+ * A region is described by a SUBMAT_T (see submat.h).  There are two
+ *     ways to send it:
+ *
+ *     SUB_DATATYPE.  Build a derived datatype for the region, and let
+ *         MPI copy the data.  The datatypes are built with
+ *         MPI_Type_create_hvector and MPI_Type_create_hindexed, as
+ *         in send_col.c and send_triangle.c, from the base type
+ *         resized to the column stride.  Committing a datatype isn't
+ *         free, so the committed datatypes are kept in a cache of
+ *         SUBMAT_CACHE_SIZE shapes, and the least recently used one
+ *         is freed when it's full.
+ *     SUB_PACK.  Copy the region into a contiguous buffer, and send
+ *         it as an array of the base type.  The receiver copies it
+ *         out.  The copy loops use memcpy for contiguous runs.
+ *
+ *     Which is faster depends on the MPI implementation, the shape,
+ *     and the strides.  So with SUB_AUTO, the first time a shape is
+ *     sent (or received) the two methods are timed with sends to
+ *     the calling process on MPI_COMM_SELF, and the faster one is
+ *     kept in the cache entry.  The sender and the receiver choose
+ *     independently:  the type signature is the same either way.
+ *
+ * The base type should be a predefined type such as MPI_FLOAT or
+ *     MPI_DOUBLE.
+ *
+ * See Chap 6, pp. 96 & ff in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+#include "submat.h"
+
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+#define MAX(a,b) ((a) > (b) ? (a) : (b))
+
+/* Timed sends of each method when tuning */
+#ifndef TUNE_REPS
+#define TUNE_REPS 3
+#endif
+#define TUNE_TAG 0
+
+typedef struct {
+    SUBMAT_T      key;
+    MPI_Datatype  type;
+    int           elements;
+    int           method[2];   /* method[0] for receives, [1] sends */
+    long          last_use;
+} CACHE_ENTRY_T;
+
+static CACHE_ENTRY_T cache[SUBMAT_CACHE_SIZE];
+static int           cached = 0;
+static long          uses = 0;
+static int           current_method = SUB_AUTO;
+
+/* The pack buffer, and a second buffer used when tuning */
+static char*         pack_buf = (char*) NULL;
+static int           pack_size = 0;
+static char*         tune_buf = (char*) NULL;
+static int           tune_size = 0;
+
+static CACHE_ENTRY_T* Lookup(SUBMAT_T* region);
+static int   Same_shape(SUBMAT_T* r1, SUBMAT_T* r2);
+static int   Build_type(SUBMAT_T* region, MPI_Datatype* type_ptr);
+static int   Get_buffer(char** buf_ptr, int* size_ptr, int bytes);
+static char* Copy_run(char* array, int count, MPI_Aint stride,
+                 int elem_size, char* buf, int to_buffer);
+static void  Copy_region(char* a, SUBMAT_T* region, char* buf,
+                 int to_buffer);
+static int   Choose_method(char* a, CACHE_ENTRY_T* entry, int send);
+static double Time_method(char* a, CACHE_ENTRY_T* entry, int send,
+                 int method);
+
+/*****************************************************************/
+int Init_submat(
+        SUBMAT_T*     region      /* out */,
+        int           shape       /* in  */,
+        int           rows        /* in  */,
+        int           cols        /* in  */,
+        int           row_stride  /* in  */,
+        int           col_stride  /* in  */,
+        int           ld          /* in  */,
+        MPI_Datatype  base        /* in  */) {
+    int       size;
+    MPI_Aint  lb, extent;
+
+    if ((shape < SUB_RECT) || (shape > SUB_TRANSPOSE) || (rows < 0) ||
+            (cols < 0) || (row_stride < 1) || (col_stride < 1) ||
+            (ld < 1))
+        return -1;
+    if ((cols > 0) && ((cols - 1)*col_stride >= ld) && (rows > 1))
+        return -1;   /* Rows of the region would overlap */
+    MPI_Type_size(base, &size);
+    MPI_Type_get_extent(base, &lb, &extent);
+    if ((lb != 0) || (extent != size))
+        return -1;
+
+    region->shape = shape;
+    region->rows = rows;
+    region->cols = cols;
+    region->row_stride = row_stride;
+    region->col_stride = col_stride;
+    region->ld = ld;
+    region->base = base;
+    return 0;
+}  /* Init_submat */
+
+
+/*****************************************************************/
+int Submat_elements(
+        SUBMAT_T*  region  /* in */) {
+    int i, count = 0;
+
+    switch (region->shape) {
+        case SUB_UPPER:
+            for (i = 0; i < region->rows; i++)
+                count += MAX(region->cols - i, 0);
+            return count;
+        case SUB_LOWER:
+            for (i = 0; i < region->rows; i++)
+                count += MIN(i + 1, region->cols);
+            return count;
+        default:
+            return region->rows*region->cols;
+    }
+}  /* Submat_elements */
+
+
+/*****************************************************************/
+MPI_Datatype Submat_type(
+                 SUBMAT_T*  region  /* in */) {
+    CACHE_ENTRY_T* entry = Lookup(region);
+
+    if (entry == (CACHE_ENTRY_T*) NULL)
+        return MPI_DATATYPE_NULL;
+    return entry->type;
+}  /* Submat_type */
+
+
+/*****************************************************************/
+int Set_submat_method(
+        int  method  /* in */) {
+    int old = current_method;
+
+    current_method = method;
+    return old;
+}  /* Set_submat_method */
+
+
+/*****************************************************************/
+int Submat_method(
+        SUBMAT_T*  region  /* in */,
+        int        send    /* in */) {
+    CACHE_ENTRY_T* entry = Lookup(region);
+
+    if (entry == (CACHE_ENTRY_T*) NULL)
+        return SUB_AUTO;
+    return entry->method[send != 0];
+}  /* Submat_method */
+
+
+/*****************************************************************/
+int Submat_send(
+        void*      a       /* in */,
+        SUBMAT_T*  region  /* in */,
+        int        dest    /* in */,
+        int        tag     /* in */,
+        MPI_Comm   comm    /* in */) {
+    CACHE_ENTRY_T* entry;
+    int            elem_size;
+
+    entry = Lookup(region);
+    if (entry == (CACHE_ENTRY_T*) NULL)
+        return -1;
+
+    if (Choose_method((char*) a, entry, 1) == SUB_DATATYPE) {
+        MPI_Send(a, 1, entry->type, dest, tag, comm);
+    } else {
+        MPI_Type_size(region->base, &elem_size);
+        if (Get_buffer(&pack_buf, &pack_size,
+                entry->elements*elem_size) < 0)
+            return -1;
+        Copy_region((char*) a, region, pack_buf, 1);
+        MPI_Send(pack_buf, entry->elements, region->base, dest, tag,
+            comm);
+    }
+    return 0;
+}  /* Submat_send */
+
+
+/*****************************************************************/
+int Submat_recv(
+        void*        a       /* out */,
+        SUBMAT_T*    region  /* in  */,
+        int          source  /* in  */,
+        int          tag     /* in  */,
+        MPI_Comm     comm    /* in  */,
+        MPI_Status*  status  /* out */) {
+    CACHE_ENTRY_T* entry;
+    int            elem_size;
+
+    entry = Lookup(region);
+    if (entry == (CACHE_ENTRY_T*) NULL)
+        return -1;
+
+    if (Choose_method((char*) a, entry, 0) == SUB_DATATYPE) {
+        MPI_Recv(a, 1, entry->type, source, tag, comm, status);
+    } else {
+        MPI_Type_size(region->base, &elem_size);
+        if (Get_buffer(&pack_buf, &pack_size,
+                entry->elements*elem_size) < 0)
+            return -1;
+        MPI_Recv(pack_buf, entry->elements, region->base, source, tag,
+            comm, status);
+        Copy_region((char*) a, region, pack_buf, 0);
+    }
+    return 0;
+}  /* Submat_recv */
+
+
+/*****************************************************************/
+void Free_submat_cache(void) {
+    int i;
+
+    for (i = 0; i < cached; i++)
+        MPI_Type_free(&(cache[i].type));
+    cached = 0;
+    free(pack_buf);
+    free(tune_buf);
+    pack_buf = tune_buf = (char*) NULL;
+    pack_size = tune_size = 0;
+}  /* Free_submat_cache */
+
+
+/*****************************************************************/
+static int Same_shape(
+               SUBMAT_T*  r1  /* in */,
+               SUBMAT_T*  r2  /* in */) {
+    return (r1->shape == r2->shape) && (r1->rows == r2->rows) &&
+        (r1->cols == r2->cols) && (r1->row_stride == r2->row_stride) &&
+        (r1->col_stride == r2->col_stride) && (r1->ld == r2->ld) &&
+        (r1->base == r2->base);
+}  /* Same_shape */
+
+
+/*****************************************************************/
+/* Find region in the cache, or build its datatype and add it,  */
+/*     replacing the least recently used entry if the cache is  */
+/*     full.  Returns NULL if the datatype can't be built.      */
+static CACHE_ENTRY_T* Lookup(
+                          SUBMAT_T*  region  /* in */) {
+    int            i;
+    CACHE_ENTRY_T* entry;
+
+    for (i = 0; i < cached; i++)
+        if (Same_shape(&(cache[i].key), region)) {
+            cache[i].last_use = uses++;
+            return &cache[i];
+        }
+
+    if (cached < SUBMAT_CACHE_SIZE) {
+        entry = &cache[cached++];
+    } else {
+        entry = &cache[0];
+        for (i = 1; i < cached; i++)
+            if (cache[i].last_use < entry->last_use)
+                entry = &cache[i];
+        MPI_Type_free(&(entry->type));
+    }
+
+    if (Build_type(region, &(entry->type)) < 0) {
+        /* Drop the entry:  move the last one into its slot */
+        *entry = cache[--cached];
+        return (CACHE_ENTRY_T*) NULL;
+    }
+    entry->key = *region;
+    entry->elements = Submat_elements(region);
+    entry->method[0] = entry->method[1] = SUB_AUTO;
+    entry->last_use = uses++;
+    return entry;
+}  /* Lookup */
+
+
+/*****************************************************************/
+/* The datatypes are built from elem_mpi_t, the base type resized */
+/*     so that its extent is the distance between columns of the */
+/*     region.  So a run of count elem_mpi_t's is count elements  */
+/*     of a row of the region.                                    */
+static int Build_type(
+               SUBMAT_T*      region    /* in  */,
+               MPI_Datatype*  type_ptr  /* out */) {
+    MPI_Aint       lb, extent;
+    MPI_Aint       row_bytes, col_bytes;
+    MPI_Datatype   elem_mpi_t;
+    MPI_Datatype   column_mpi_t, temp_mpi_t;
+    int*           block_lengths;
+    MPI_Aint*      displacements;
+    int            i;
+
+    MPI_Type_get_extent(region->base, &lb, &extent);
+    row_bytes = ((MPI_Aint) region->row_stride)*region->ld*extent;
+    col_bytes = ((MPI_Aint) region->col_stride)*extent;
+    MPI_Type_create_resized(region->base, 0, col_bytes, &elem_mpi_t);
+
+    switch (region->shape) {
+        case SUB_RECT:
+            MPI_Type_create_hvector(region->rows, region->cols,
+                row_bytes, elem_mpi_t, type_ptr);
+            break;
+        case SUB_UPPER:
+        case SUB_LOWER:
+            block_lengths = (int*) malloc(
+                MAX(region->rows, 1)*sizeof(int));
+            displacements = (MPI_Aint*) malloc(
+                MAX(region->rows, 1)*sizeof(MPI_Aint));
+            if ((block_lengths == (int*) NULL) ||
+                    (displacements == (MPI_Aint*) NULL)) {
+                free(block_lengths);
+                free(displacements);
+                MPI_Type_free(&elem_mpi_t);
+                return -1;
+            }
+            for (i = 0; i < region->rows; i++)
+                if (region->shape == SUB_UPPER) {
+                    block_lengths[i] = MAX(region->cols - i, 0);
+                    displacements[i] = i*row_bytes + i*col_bytes;
+                } else {
+                    block_lengths[i] = MIN(i + 1, region->cols);
+                    displacements[i] = i*row_bytes;
+                }
+            MPI_Type_create_hindexed(region->rows, block_lengths,
+                displacements, elem_mpi_t, type_ptr);
+            free(block_lengths);
+            free(displacements);
+            break;
+        default:  /* SUB_TRANSPOSE */
+            /* One column of the region, with the extent of one */
+            /*     element, so successive columns are adjacent  */
+            MPI_Type_create_hvector(region->rows, 1, row_bytes,
+                region->base, &temp_mpi_t);
+            MPI_Type_create_resized(temp_mpi_t, 0, col_bytes,
+                &column_mpi_t);
+            MPI_Type_contiguous(region->cols, column_mpi_t, type_ptr);
+            MPI_Type_free(&temp_mpi_t);
+            MPI_Type_free(&column_mpi_t);
+            break;
+    }
+    MPI_Type_free(&elem_mpi_t);
+    MPI_Type_commit(type_ptr);
+    return 0;
+}  /* Build_type */
+
+
+/*****************************************************************/
+/* Make *buf_ptr at least bytes long */
+static int Get_buffer(
+               char**  buf_ptr   /* in/out */,
+               int*    size_ptr  /* in/out */,
+               int     bytes     /* in     */) {
+    char* temp;
+
+    if (bytes <= *size_ptr)
+        return 0;
+    temp = (char*) realloc(*buf_ptr, bytes);
+    if (temp == (char*) NULL)
+        return -1;
+    *buf_ptr = temp;
+    *size_ptr = bytes;
+    return 0;
+}  /* Get_buffer */
+
+
+/*****************************************************************/
+/* Copy count elements, stride bytes apart, between array and the */
+/*     contiguous buffer.  Returns the end of the buffer's part.   */
+/*     The fixed-size memcpy's are compiled to single loads and    */
+/*     stores.                                                     */
+static char* Copy_run(
+                 char*     array      /* in/out */,
+                 int       count      /* in     */,
+                 MPI_Aint  stride     /* in     */,
+                 int       elem_size  /* in     */,
+                 char*     buf        /* in/out */,
+                 int       to_buffer  /* in     */) {
+    int i;
+
+    if (stride == elem_size) {
+        if (to_buffer)
+            memcpy(buf, array, count*elem_size);
+        else
+            memcpy(array, buf, count*elem_size);
+    } else if (elem_size == 4) {
+        for (i = 0; i < count; i++)
+            if (to_buffer)
+                memcpy(buf + 4*i, array + i*stride, 4);
+            else
+                memcpy(array + i*stride, buf + 4*i, 4);
+    } else if (elem_size == 8) {
+        for (i = 0; i < count; i++)
+            if (to_buffer)
+                memcpy(buf + 8*i, array + i*stride, 8);
+            else
+                memcpy(array + i*stride, buf + 8*i, 8);
+    } else {
+        for (i = 0; i < count; i++)
+            if (to_buffer)
+                memcpy(buf + elem_size*i, array + i*stride, elem_size);
+            else
+                memcpy(array + i*stride, buf + elem_size*i, elem_size);
+    }
+    return buf + count*elem_size;
+}  /* Copy_run */
+
+
+/*****************************************************************/
+/* Copy the region between a and buf, in the order of its datatype */
+static void Copy_region(
+                char*      a          /* in/out */,
+                SUBMAT_T*  region     /* in     */,
+                char*      buf        /* in/out */,
+                int        to_buffer  /* in     */) {
+    int       i, j;
+    int       elem_size;
+    MPI_Aint  row_bytes, col_bytes;
+
+    MPI_Type_size(region->base, &elem_size);
+    row_bytes = ((MPI_Aint) region->row_stride)*region->ld*elem_size;
+    col_bytes = ((MPI_Aint) region->col_stride)*elem_size;
+
+    switch (region->shape) {
+        case SUB_RECT:
+            for (i = 0; i < region->rows; i++)
+                buf = Copy_run(a + i*row_bytes, region->cols, col_bytes,
+                    elem_size, buf, to_buffer);
+            break;
+        case SUB_UPPER:
+            for (i = 0; i < MIN(region->rows, region->cols); i++)
+                buf = Copy_run(a + i*row_bytes + i*col_bytes,
+                    region->cols - i, col_bytes, elem_size, buf,
+                    to_buffer);
+            break;
+        case SUB_LOWER:
+            for (i = 0; i < region->rows; i++)
+                buf = Copy_run(a + i*row_bytes, MIN(i + 1, region->cols),
+                    col_bytes, elem_size, buf, to_buffer);
+            break;
+        default:  /* SUB_TRANSPOSE */
+            for (j = 0; j < region->cols; j++)
+                buf = Copy_run(a + j*col_bytes, region->rows, row_bytes,
+                    elem_size, buf, to_buffer);
+            break;
+    }
+}  /* Copy_region */
+
+
+/*****************************************************************/
+/* Return the method for this send (send = 1) or receive (send = 0) */
+static int Choose_method(
+               char*           a      /* in/out */,
+               CACHE_ENTRY_T*  entry  /* in/out */,
+               int             send   /* in     */) {
+    double dt_time, pack_time;
+
+    if (current_method != SUB_AUTO)
+        return current_method;
+    if (entry->method[send] != SUB_AUTO)
+        return entry->method[send];
+
+    if (entry->elements == 0) {
+        entry->method[send] = SUB_DATATYPE;
+    } else {
+        dt_time = Time_method(a, entry, send, SUB_DATATYPE);
+        pack_time = Time_method(a, entry, send, SUB_PACK);
+        entry->method[send] =
+            (pack_time < dt_time ? SUB_PACK : SUB_DATATYPE);
+#       ifdef DEBUG
+        printf("Submat:  shape %d, %d x %d, %s, datatype %e, pack %e\n",
+            entry->key.shape, entry->key.rows, entry->key.cols,
+            send ? "send" : "recv", dt_time, pack_time);
+#       endif
+    }
+    return entry->method[send];
+}  /* Choose_method */
+
+
+/*****************************************************************/
+/* Shortest of TUNE_REPS sends of the region to myself, after a    */
+/*     warm up.  For a receive, the region is overwritten, but the */
+/*     receive that follows overwrites it again.                   */
+static double Time_method(
+                  char*           a       /* in/out */,
+                  CACHE_ENTRY_T*  entry   /* in     */,
+                  int             send    /* in     */,
+                  int             method  /* in     */) {
+    SUBMAT_T*   region = &(entry->key);
+    int         elem_size, bytes;
+    int         rep;
+    double      start, elapsed, best = 1.0e30;
+    MPI_Status  status;
+
+    MPI_Type_size(region->base, &elem_size);
+    bytes = entry->elements*elem_size;
+    if ((Get_buffer(&pack_buf, &pack_size, bytes) < 0) ||
+            (Get_buffer(&tune_buf, &tune_size, bytes) < 0))
+        return 0.0;   /* Datatype wins */
+
+    if (!send)
+        memset(tune_buf, 0, bytes);
+    for (rep = 0; rep <= TUNE_REPS; rep++) {
+        start = MPI_Wtime();
+        if (send && method == SUB_DATATYPE) {
+            MPI_Sendrecv(a, 1, entry->type, 0, TUNE_TAG,
+                tune_buf, entry->elements, region->base, 0, TUNE_TAG,
+                MPI_COMM_SELF, &status);
+        } else if (send) {
+            Copy_region(a, region, pack_buf, 1);
+            MPI_Sendrecv(pack_buf, entry->elements, region->base, 0,
+                TUNE_TAG, tune_buf, entry->elements, region->base, 0,
+                TUNE_TAG, MPI_COMM_SELF, &status);
+        } else if (method == SUB_DATATYPE) {
+            MPI_Sendrecv(tune_buf, entry->elements, region->base, 0,
+                TUNE_TAG, a, 1, entry->type, 0, TUNE_TAG,
+                MPI_COMM_SELF, &status);
+        } else {
+            MPI_Sendrecv(tune_buf, entry->elements, region->base, 0,
+                TUNE_TAG, pack_buf, entry->elements, region->base, 0,
+                TUNE_TAG, MPI_COMM_SELF, &status);
+            Copy_region(a, region, pack_buf, 0);
+        }
+        elapsed = MPI_Wtime() - start;
+        if (rep > 0 && elapsed < best)
+            best = elapsed;
+    }
+    return best;
+}  /* Time_method */
@@ -0,0 +1,80 @@
+/* submat.h -- definitions and declarations for submat.c, sending and
+ *     receiving regions of row-major arrays.
+ *
+ * See submat.c
+ */
+#ifndef SUBMAT_H
+#define SUBMAT_H
+
+#include "mpi.h"
+
+/* Shapes.  Element (i,j) of a region is element                 */
+/*     (i*row_stride, j*col_stride) of the array, counting from   */
+/*     the address passed to Submat_send, etc.                    */
+#define SUB_RECT       0   /* All (i,j), row by row                */
+#define SUB_UPPER      1   /* j >= i, row by row                   */
+#define SUB_LOWER      2   /* j <= i, row by row                   */
+#define SUB_TRANSPOSE  3   /* All (i,j), column by column.  Sending */
+                           /*     a rows x cols SUB_RECT into a     */
+                           /*     cols x rows SUB_TRANSPOSE region  */
+                           /*     transposes it.                    */
+
+/* Methods */
+#define SUB_AUTO      0    /* Time the other two the first time a  */
+                           /*     shape is used, and keep the      */
+                           /*     faster                           */
+#define SUB_DATATYPE  1    /* Derived datatype:  no copy in user   */
+                           /*     code                              */
+#define SUB_PACK      2    /* Copy into a contiguous buffer        */
+
+/* Maximum number of committed datatypes kept */
+#ifndef SUBMAT_CACHE_SIZE
+#define SUBMAT_CACHE_SIZE 32
+#endif
+
+typedef struct {
+    int           shape;
+    int           rows;         /* Order of the region            */
+    int           cols;
+    int           row_stride;   /* Rows of the array between      */
+                                /*     consecutive region rows    */
+    int           col_stride;   /* Same for columns                */
+    int           ld;           /* Columns in a row of the array   */
+    MPI_Datatype  base;         /* A predefined type, e.g.,        */
+                                /*     MPI_FLOAT                   */
+} SUBMAT_T;
+
+/* Fill in a region:  returns 0, or -1 if the arguments don't make */
+/*     sense.                                                      */
+int  Init_submat(SUBMAT_T* region, int shape, int rows, int cols,
+         int row_stride, int col_stride, int ld, MPI_Datatype base);
+
+/* Number of elements of base in the region */
+int  Submat_elements(SUBMAT_T* region);
+
+/* Committed datatype for the region, from the cache.  Don't free */
+/*     it.  Returns MPI_DATATYPE_NULL on error.                   */
+MPI_Datatype Submat_type(SUBMAT_T* region);
+
+/* All return 0 on success, negative on error.  The data are sent as */
+/*     Submat_elements(region) elements of region->base, so a region  */
+/*     can be received into any region with the same number of        */
+/*     elements, or into a contiguous buffer.                         */
+int  Submat_send(void* a, SUBMAT_T* region, int dest, int tag,
+         MPI_Comm comm);
+int  Submat_recv(void* a, SUBMAT_T* region, int source, int tag,
+         MPI_Comm comm, MPI_Status* status);
+
+/* Method used by Submat_send and Submat_recv.  The default is     */
+/*     SUB_AUTO.  Returns the old method.                            */
+int  Set_submat_method(int method);
+
+/* Method chosen for region:  SUB_DATATYPE or SUB_PACK, or SUB_AUTO */
+/*     if it hasn't been chosen yet.  send = 1 for sends, 0 for     */
+/*     receives.                                                    */
+int  Submat_method(SUBMAT_T* region, int send);
+
+/* Free the cached datatypes and the pack buffer */
+void Free_submat_cache(void);
+
+#endif
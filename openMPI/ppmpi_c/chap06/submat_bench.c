@@ -0,0 +1,206 @@
+/* submat_bench.c -- compare derived datatypes and explicit packing for
+ *     sending regions of a matrix with submat.c
+ *
+ * Input:
+ *     n: order of the matrix of doubles
+ *     reps: number of round trips for each region and method
+ * Output:
+ *     For each region, the mean time of a round trip between processes
+ *     0 and 1 with SUB_DATATYPE, SUB_PACK and SUB_AUTO, and the methods
+ *     SUB_AUTO chose on process 0 for sending and receiving.  ERROR
+ *     if process 1 gets the wrong data.
+ *
+ * Notes:
+ *     1.  Only processes 0 and 1 take part.
+ *     2.  In the transpose test, process 0 sends the whole matrix by
+ *         rows, and process 1 receives it by columns.  Then they
+ *         swap roles.
+ *
+ * See Chap 6, pp. 96 & ff in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+#include "submat.h"
+
+#define TESTS 7
+
+/* Region sent by process 0 and received by process 1 */
+typedef struct {
+    char* name;
+    int   first_row, first_col;    /* Start of region in matrix */
+    int   send_shape, recv_shape;
+    int   rows, cols;
+    int   row_stride, col_stride;
+} TEST_T;
+
+int In_region(TEST_T* t, int i, int j, int* src_i, int* src_j);
+
+/********************************************************************/
+int main(int argc, char* argv[]) {
+    int          my_rank, p;
+    int          n, reps, rep;
+    int          input[2];
+    int          test, method, i, j;
+    int          src_i, src_j;
+    int          ok, shape;
+    double*      A;
+    double*      start_ptr;
+    double       expected;
+    double       start, elapsed;
+    SUBMAT_T     region;
+    TEST_T       tests[TESTS];
+    TEST_T*      t;
+    MPI_Status   status;
+    MPI_Comm     pair_comm;
+    static char* method_names[3] = {"auto", "datatype", "pack"};
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &p);
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+    if (p < 2) {
+        fprintf(stderr, "Need at least 2 processes\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    if (my_rank == 0) {
+        printf("Enter n and reps\n");
+        scanf("%d %d", &input[0], &input[1]);
+    }
+    MPI_Bcast(input, 2, MPI_INT, 0, MPI_COMM_WORLD);
+    n = input[0];
+    reps = (input[1] > 0 ? input[1] : 1);
+
+    /* Processes 0 and 1 */
+    MPI_Comm_split(MPI_COMM_WORLD, (my_rank < 2 ? 0 : MPI_UNDEFINED),
+        my_rank, &pair_comm);
+    if (pair_comm == MPI_COMM_NULL) {
+        MPI_Finalize();
+        return 0;
+    }
+
+    tests[0] = (TEST_T) {"column",    0, 1, SUB_RECT, SUB_RECT,
+                    n, 1, 1, 1};
+    tests[1] = (TEST_T) {"row",       1, 0, SUB_RECT, SUB_RECT,
+                    1, n, 1, 1};
+    tests[2] = (TEST_T) {"block",     n/4, n/4, SUB_RECT, SUB_RECT,
+                    n/2, n/2, 1, 1};
+    tests[3] = (TEST_T) {"strided",   0, 0, SUB_RECT, SUB_RECT,
+                    n/2, n/2, 2, 2};
+    tests[4] = (TEST_T) {"upper",     0, 0, SUB_UPPER, SUB_UPPER,
+                    n, n, 1, 1};
+    tests[5] = (TEST_T) {"lower",     0, 0, SUB_LOWER, SUB_LOWER,
+                    n, n, 1, 1};
+    tests[6] = (TEST_T) {"transpose", 0, 0, SUB_RECT, SUB_TRANSPOSE,
+                    n, n, 1, 1};
+
+    A = (double*) malloc(n*n*sizeof(double));
+    if (A == (double*) NULL) {
+        fprintf(stderr, "Process %d > Can't allocate matrix\n", my_rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    if (my_rank == 0)
+        printf("%-10s %11s %11s %11s  %s\n", "region", "datatype", "pack",
+            "auto", "auto chose (send/recv)");
+    for (test = 0; test < TESTS; test++) {
+        t = &tests[test];
+        if (my_rank == 0)
+            printf("%-10s", t->name);
+        for (method = SUB_DATATYPE; method <= SUB_PACK + 1; method++) {
+            /* The last pass is SUB_AUTO */
+            Set_submat_method(method <= SUB_PACK ? method : SUB_AUTO);
+            shape = (my_rank == 0 ? t->send_shape : t->recv_shape);
+            Init_submat(&region, shape, t->rows, t->cols, t->row_stride,
+                t->col_stride, n, MPI_DOUBLE);
+            start_ptr = A + t->first_row*n + t->first_col;
+
+            /* Check one transfer */
+            for (i = 0; i < n; i++)
+                for (j = 0; j < n; j++)
+                    A[i*n + j] = (my_rank == 0 ? i*n + j : -1.0);
+            if (my_rank == 0) {
+                Submat_send(start_ptr, &region, 1, 0, pair_comm);
+                MPI_Recv(&ok, 1, MPI_INT, 1, 0, pair_comm, &status);
+            } else {
+                Submat_recv(start_ptr, &region, 0, 0, pair_comm,
+                    &status);
+                ok = 1;
+                for (i = 0; i < n; i++)
+                    for (j = 0; j < n; j++) {
+                        if (In_region(t, i, j, &src_i, &src_j))
+                            expected = src_i*n + src_j;
+                        else
+                            expected = -1.0;
+                        if (A[i*n + j] != expected) ok = 0;
+                    }
+                MPI_Send(&ok, 1, MPI_INT, 0, 0, pair_comm);
+            }
+
+            MPI_Barrier(pair_comm);
+            start = MPI_Wtime();
+            for (rep = 0; rep < reps; rep++)
+                if (my_rank == 0) {
+                    Submat_send(start_ptr, &region, 1, 0, pair_comm);
+                    Submat_recv(start_ptr, &region, 1, 0, pair_comm,
+                        &status);
+                } else {
+                    Submat_recv(start_ptr, &region, 0, 0, pair_comm,
+                        &status);
+                    Submat_send(start_ptr, &region, 0, 0, pair_comm);
+                }
+            elapsed = (MPI_Wtime() - start)/reps;
+            if (my_rank == 0) {
+                if (ok)
+                    printf(" %11.3e", elapsed);
+                else
+                    printf(" %11s", "ERROR");
+            }
+        }
+        if (my_rank == 0)
+            printf("  %s/%s\n", method_names[Submat_method(&region, 1)],
+                method_names[Submat_method(&region, 0)]);
+    }
+
+    free(A);
+    Free_submat_cache();
+    MPI_Comm_free(&pair_comm);
+    MPI_Finalize();
+    return 0;
+}  /* main */
+
+
+/********************************************************************/
+/* Is (i,j) in the region received by process 1?  If so, return  */
+/*     the element of process 0's matrix that it should hold.     */
+int In_region(
+        TEST_T*  t      /* in  */,
+        int      i      /* in  */,
+        int      j      /* in  */,
+        int*     src_i  /* out */,
+        int*     src_j  /* out */) {
+    int ri, rj;   /* Position in the region */
+
+    i -= t->first_row;
+    j -= t->first_col;
+    if ((i < 0) || (j < 0) || (i % t->row_stride) || (j % t->col_stride))
+        return 0;
+    ri = i/t->row_stride;
+    rj = j/t->col_stride;
+    if ((ri >= t->rows) || (rj >= t->cols))
+        return 0;
+    if ((t->recv_shape == SUB_UPPER) && (rj < ri))
+        return 0;
+    if ((t->recv_shape == SUB_LOWER) && (rj > ri))
+        return 0;
+
+    if (t->recv_shape == SUB_TRANSPOSE) {
+        /* Process 0's element (rj, ri) */
+        *src_i = t->first_row + rj*t->row_stride;
+        *src_j = t->first_col + ri*t->col_stride;
+    } else {
+        *src_i = t->first_row + i;
+        *src_j = t->first_col + j;
+    }
+    return 1;
+}  /* In_region */
@@ -0,0 +1,289 @@
+/* comm_factory.c -- build a Cartesian grid of processes, with the
+ *     communicators that programs in this chapter build by hand:
+ *     rows and columns (comm_split.c, top_fcns.c, Setup_grid in
+ *     fox.c), more generally lines and planes of a grid of any
+ *     dimension, and the processes on each node and the node leaders.
+ *
+ * Unlike top_fcns.c, p needn't be a perfect square:  the dimensions
+ *     that aren't specified are chosen by MPI_Dims_create, as in
+ *     Setup_grid in dist_gemm.c.
+ *
+ * Nodes are found with MPI_Comm_split_type(MPI_COMM_TYPE_SHARED).
+ *     Define EMULATE_NODE_SIZE=<s> to treat each block of s
+ *     consecutive ranks as a node instead, for testing on one
+ *     machine.
+ *
+ * Placement.  MPI_Cart_create is allowed to renumber the processes
+ *     when reorder is set, but many implementations don't, and a
+ *     row-major numbering of a grid puts most of the neighbors in
+ *     one dimension on other nodes.  So if reorder is set, and every
+ *     node has the same number, s, of processes, Topo_create looks
+ *     for a tile shape t[0] x t[1] x ... with product s, each t[d]
+ *     dividing dims[d], that cuts the fewest neighbor links:  a tile
+ *     cuts s/t[d] links across each face normal to dimension d.  The
+ *     grid is divided into tiles, node k gets the k-th tile in
+ *     row-major order, and the processes on a node fill its tile in
+ *     row-major order.  The new numbering is passed to
+ *     MPI_Comm_split as the key, and the grid is built from the
+ *     result with reorder = 0.  If the nodes differ in size, or no
+ *     tile fits, the grid is left to MPI_Cart_create with
+ *     reorder = 1.
+ *
+ * See Chap 7, pp. 116 & ff in PPMPI
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+#include "comm_factory.h"
+
+static void Search_tiles(int d, int ndims, int dims[], int remaining,
+                int s, int tile[], int best[], int* best_cost);
+static int  Grid_rank(int ndims, int dims[], int coords[]);
+
+/*****************************************************************/
+int Topo_create(
+        TOPO_T*   topo      /* out */,
+        MPI_Comm  comm      /* in  */,
+        int       ndims     /* in  */,
+        int       dims[]    /* in  */,
+        int       periods[] /* in  */,
+        int       reorder   /* in  */) {
+    int       p, my_rank;
+    int       d, product, unknown;
+    int       local[2], global[2];
+    int       leader_rank = 0;
+    int       best_cost;
+    int       new_rank;
+    int       tile_dims[TOPO_MAX_DIMS];
+    int       tile_coords[TOPO_MAX_DIMS];
+    int       coords[TOPO_MAX_DIMS];
+    int       remain[TOPO_MAX_DIMS];
+    int       k, r;
+    MPI_Comm  node_comm, leader_comm, temp_comm;
+
+    if ((ndims < 1) || (ndims > TOPO_MAX_DIMS))
+        return -1;
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &my_rank);
+
+    product = 1;
+    unknown = 0;
+    for (d = 0; d < ndims; d++) {
+        if (dims[d] < 0)
+            return -1;
+        if (dims[d] == 0)
+            unknown = 1;
+        else
+            product *= dims[d];
+        topo->dims[d] = dims[d];
+        topo->periods[d] = periods[d];
+    }
+    if ((p % product != 0) || (!unknown && (product != p)))
+        return -1;
+    if (unknown)
+        MPI_Dims_create(p, ndims, topo->dims);
+    topo->ndims = ndims;
+    topo->p = p;
+
+    /* Find the nodes.  Node k is the one whose leader has rank k */
+    /*     in leader_comm.                                         */
+#ifdef EMULATE_NODE_SIZE
+    MPI_Comm_split(comm, my_rank/EMULATE_NODE_SIZE, my_rank, &node_comm);
+#else
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, my_rank,
+        MPI_INFO_NULL, &node_comm);
+#endif
+    MPI_Comm_rank(node_comm, &(topo->node_rank));
+    MPI_Comm_size(node_comm, &(topo->node_size));
+    MPI_Comm_split(comm, (topo->node_rank == 0 ? 0 : MPI_UNDEFINED),
+        my_rank, &leader_comm);
+    if (topo->node_rank == 0) {
+        MPI_Comm_rank(leader_comm, &leader_rank);
+        MPI_Comm_free(&leader_comm);
+    }
+    MPI_Bcast(&leader_rank, 1, MPI_INT, 0, node_comm);
+    MPI_Comm_free(&node_comm);
+    topo->my_node = leader_rank;
+
+    /* Number of nodes, and are they all the same size? */
+    local[0] = topo->my_node + 1;
+    local[1] = topo->node_size;
+    MPI_Allreduce(local, global, 2, MPI_INT, MPI_MAX, comm);
+    topo->nodes = global[0];
+
+    topo->mapped = 0;
+    best_cost = -1;
+    if (reorder && (topo->nodes > 1) && (global[1]*topo->nodes == p))
+        Search_tiles(0, ndims, topo->dims, global[1], global[1],
+            tile_dims, topo->tile, &best_cost);
+    if (best_cost >= 0) {
+        /* My tile, and my place in it */
+        k = topo->my_node;
+        r = topo->node_rank;
+        for (d = ndims - 1; d >= 0; d--) {
+            tile_coords[d] = k % (topo->dims[d]/topo->tile[d]);
+            k /= topo->dims[d]/topo->tile[d];
+            coords[d] = tile_coords[d]*topo->tile[d] +
+                r % topo->tile[d];
+            r /= topo->tile[d];
+        }
+        new_rank = Grid_rank(ndims, topo->dims, coords);
+        MPI_Comm_split(comm, 0, new_rank, &temp_comm);
+        MPI_Cart_create(temp_comm, ndims, topo->dims, topo->periods, 0,
+            &(topo->comm));
+        MPI_Comm_free(&temp_comm);
+        topo->mapped = 1;
+    } else {
+        MPI_Cart_create(comm, ndims, topo->dims, topo->periods,
+            reorder, &(topo->comm));
+        for (d = 0; d < ndims; d++)
+            topo->tile[d] = 0;
+    }
+#   ifdef DEBUG
+    if (my_rank == 0) {
+        printf("Topo_create:  %d nodes, mapped = %d, tile =",
+            topo->nodes, topo->mapped);
+        for (d = 0; d < ndims; d++)
+            printf(" %d", topo->tile[d]);
+        printf("\n");
+        fflush(stdout);
+    }
+#   endif
+    MPI_Comm_rank(topo->comm, &(topo->my_rank));
+    MPI_Cart_coords(topo->comm, topo->my_rank, ndims, topo->coords);
+
+    /* Rebuild the node communicators so that the ranks are ranks */
+    /*     in the grid                                            */
+    MPI_Comm_split(topo->comm, topo->my_node, topo->my_rank,
+        &(topo->node_comm));
+    MPI_Comm_rank(topo->node_comm, &(topo->node_rank));
+    MPI_Comm_split(topo->comm, (topo->node_rank == 0 ? 0 : MPI_UNDEFINED),
+        topo->my_node, &(topo->leader_comm));
+    topo->node_of = (int*) malloc(p*sizeof(int));
+    if (topo->node_of == (int*) NULL) {
+        fprintf(stderr, "Process %d > Can't allocate node_of\n",
+            my_rank);
+        MPI_Abort(comm, -1);
+    }
+    MPI_Allgather(&(topo->my_node), 1, MPI_INT, topo->node_of, 1,
+        MPI_INT, topo->comm);
+
+    /* Lines and planes of the grid */
+    for (d = 0; d < ndims; d++) {
+        for (k = 0; k < ndims; k++)
+            remain[k] = (k == d);
+        MPI_Cart_sub(topo->comm, remain, &(topo->line_comm[d]));
+        if (ndims >= 3) {
+            for (k = 0; k < ndims; k++)
+                remain[k] = (k != d);
+            MPI_Cart_sub(topo->comm, remain, &(topo->plane_comm[d]));
+        } else {
+            topo->plane_comm[d] = MPI_COMM_NULL;
+        }
+    }
+    return 0;
+}  /* Topo_create */
+
+
+/*****************************************************************/
+void Topo_locality(
+        TOPO_T*  topo     /* in  */,
+        int*     on_node  /* out */,
+        int*     total    /* out */) {
+    int d, source, dest;
+    int local[2], global[2];
+
+    local[0] = local[1] = 0;
+    for (d = 0; d < topo->ndims; d++) {
+        MPI_Cart_shift(topo->comm, d, 1, &source, &dest);
+        if ((source != MPI_PROC_NULL) && (source != topo->my_rank)) {
+            local[1]++;
+            if (topo->node_of[source] == topo->my_node)
+                local[0]++;
+        }
+        /* In a periodic dimension of order 2, they're the same */
+        if ((dest != MPI_PROC_NULL) && (dest != topo->my_rank) &&
+                (dest != source)) {
+            local[1]++;
+            if (topo->node_of[dest] == topo->my_node)
+                local[0]++;
+        }
+    }
+    MPI_Allreduce(local, global, 2, MPI_INT, MPI_SUM, topo->comm);
+    *on_node = global[0];
+    *total = global[1];
+}  /* Topo_locality */
+
+
+/*****************************************************************/
+void Topo_free(
+        TOPO_T*  topo  /* in/out */) {
+    int d;
+
+    for (d = 0; d < topo->ndims; d++) {
+        MPI_Comm_free(&(topo->line_comm[d]));
+        if (topo->plane_comm[d] != MPI_COMM_NULL)
+            MPI_Comm_free(&(topo->plane_comm[d]));
+    }
+    if (topo->leader_comm != MPI_COMM_NULL)
+        MPI_Comm_free(&(topo->leader_comm));
+    MPI_Comm_free(&(topo->node_comm));
+    MPI_Comm_free(&(topo->comm));
+    free(topo->node_of);
+    topo->node_of = (int*) NULL;
+}  /* Topo_free */
+
+
+/*****************************************************************/
+/* Try every tile[d], ..., tile[ndims-1] with product remaining, */
+/*     each dividing the corresponding dims.  Keep the one that  */
+/*     cuts the fewest links in best, and its cost in best_cost  */
+/*     (-1 if none has been found).                              */
+static void Search_tiles(
+               int   d          /* in     */,
+               int   ndims      /* in     */,
+               int   dims[]     /* in     */,
+               int   remaining  /* in     */,
+               int   s          /* in     */,
+               int   tile[]     /* scratch */,
+               int   best[]     /* in/out */,
+               int*  best_cost  /* in/out */) {
+    int f, k, cost;
+
+    if (d == ndims - 1) {
+        if (dims[d] % remaining != 0)
+            return;
+        tile[d] = remaining;
+        cost = 0;
+        for (k = 0; k < ndims; k++)
+            if (dims[k] > tile[k])
+                cost += s/tile[k];
+        if ((*best_cost < 0) || (cost < *best_cost)) {
+            *best_cost = cost;
+            for (k = 0; k < ndims; k++)
+                best[k] = tile[k];
+        }
+        return;
+    }
+
+    for (f = 1; f <= remaining; f++)
+        if ((remaining % f == 0) && (dims[d] % f == 0)) {
+            tile[d] = f;
+            Search_tiles(d + 1, ndims, dims, remaining/f, s, tile, best,
+                best_cost);
+        }
+}  /* Search_tiles */
+
+
+/*****************************************************************/
+/* Row-major rank, as in MPI_Cart_rank */
+static int Grid_rank(
+               int  ndims     /* in */,
+               int  dims[]    /* in */,
+               int  coords[]  /* in */) {
+    int d, rank = 0;
+
+    for (d = 0; d < ndims; d++)
+        rank = rank*dims[d] + coords[d];
+    return rank;
+}  /* Grid_rank */
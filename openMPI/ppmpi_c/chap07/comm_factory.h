@@ -0,0 +1,63 @@
+/* comm_factory.h -- definitions and declarations for comm_factory.c,
+ *     building Cartesian grids and their sub-communicators with
+ *     knowledge of which processes share a node.
+ *
+ * See comm_factory.c
+ */
+#ifndef COMM_FACTORY_H
+#define COMM_FACTORY_H
+
+#include "mpi.h"
+
+#define TOPO_MAX_DIMS 8
+
+typedef struct {
+    MPI_Comm  comm;         /* Cartesian communicator for the grid  */
+    int       p;            /* Total number of processes            */
+    int       my_rank;      /* My rank in comm                      */
+    int       ndims;
+    int       dims[TOPO_MAX_DIMS];
+    int       periods[TOPO_MAX_DIMS];
+    int       coords[TOPO_MAX_DIMS];   /* My coordinates            */
+    int       mapped;       /* 1 if each node got a tile of the     */
+                            /*     grid, 0 if MPI placed the ranks  */
+    int       tile[TOPO_MAX_DIMS];     /* Shape of a node's tile    */
+    MPI_Comm  node_comm;    /* Processes on my node                 */
+    MPI_Comm  leader_comm;  /* Rank 0 of each node_comm, in node    */
+                            /*     order; MPI_COMM_NULL elsewhere   */
+    int       nodes;        /* Number of nodes                      */
+    int       my_node;
+    int       node_size;    /* Processes on my node                 */
+    int       node_rank;    /* My rank in node_comm                 */
+    int*      node_of;      /* node_of[r] = node of rank r in comm  */
+    MPI_Comm  line_comm[TOPO_MAX_DIMS];   /* line_comm[d]:  the     */
+                            /*     processes whose coordinates      */
+                            /*     differ from mine only in         */
+                            /*     dimension d.  Rank = coords[d].  */
+    MPI_Comm  plane_comm[TOPO_MAX_DIMS];  /* plane_comm[d]:  the    */
+                            /*     processes with my coordinate in  */
+                            /*     dimension d.  Only built if      */
+                            /*     ndims >= 3, MPI_COMM_NULL        */
+                            /*     otherwise.                       */
+} TOPO_T;
+
+/* In a 2-dimensional grid, process (i,j) is in row i, column j */
+#define Row_comm(T)  ((T)->line_comm[1])
+#define Col_comm(T)  ((T)->line_comm[0])
+
+/* Build an ndims-dimensional grid of all the processes in comm.   */
+/*     Entries of dims that are 0 are chosen by MPI_Dims_create.   */
+/*     If reorder is nonzero, ranks may be renumbered so that grid */
+/*     neighbors share a node.  Collective on comm.  Returns 0, or */
+/*     -1 if the dimensions don't fit the number of processes.     */
+int  Topo_create(TOPO_T* topo, MPI_Comm comm, int ndims, int dims[],
+         int periods[], int reorder);
+
+/* Count the pairs of grid neighbors, and the pairs on the same   */
+/*     node, over all the processes.  Each pair is counted twice. */
+/*     Collective.                                                */
+void Topo_locality(TOPO_T* topo, int* on_node, int* total);
+
+void Topo_free(TOPO_T* topo);
+
+#endif
@@ -0,0 +1,683 @@
+/* dist_gemm.c -- functions for multiplying matrices that are
+ *     distributed by blocks over a 2-dimensional grid of processes.
+ *
+ * Unlike fox.c, the grid needn't be square, the matrices needn't be
+ *     square, and the orders of the matrices needn't be divisible by
+ *     the order of the grid:  the blocks are assigned with Block_low
+ *     and Block_size (see dist_gemm.h), so their sizes differ by at
+ *     most 1.  The blocks are allocated on the heap.
+ *
+ * Two algorithms are provided.
+ *
+ *     SUMMA (any grid).  The inner dimension is divided into panels
+ *     of at most panel_width columns of A (rows of B) that don't cross
+ *     a block boundary.  For each panel, the process column that owns
+ *     it broadcasts its part of A across the process rows, and the
+ *     process row that owns it broadcasts its part of B down the
+ *     process columns.  Then every process adds the product of the
+ *     two panels to its block of C.  The broadcasts are nonblocking
+ *     and double buffered:  the broadcasts for panel s+1 are started
+ *     before the product for panel s is computed.
+ *
+ *     Cannon (square grids).  After an initial skew, process (i,j)
+ *     has blocks A(i,i+j) and B(i+j,j).  At each stage it multiplies
+ *     them, shifts its block of A one process left, and its block of
+ *     B one process up.  The shifts are nonblocking, and they use a
+ *     second pair of buffers, so the shift for stage s+1 overlaps the
+ *     product for stage s.
+ *
+ *     2.5D Cannon (c x q x q grids).  A and B are broadcast from
+ *     layer 0 to the other c-1 layers, each layer runs q/c of the
+ *     q stages of Cannon's algorithm, and the layers' partial
+ *     products are added on layer 0 with a reduce along the depth
+ *     dimension.  Each process sends about 1/sqrt(c) as many words
+ *     as it does in the 2D algorithms on the same number of
+ *     processes, at the cost of storing c copies of A and B.
+ *
+ * The local products are computed by Local_gemm, which works on
+ *     BLOCK_SIZE x BLOCK_SIZE blocks so that they stay in cache.
+ *
+ * See Chap 7, pp. 113 & ff and pp. 125 & ff in PPMPI
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+#include "dist_gemm.h"
+
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+
+static int  Panel_end(int kk, int panel_width, int k, GRID_INFO_T* grid);
+static void Start_panel(DIST_MATRIX_T* A, DIST_MATRIX_T* B, int kk,
+                int kb, float* a_panel, float* b_panel,
+                MPI_Request* requests, GRID_INFO_T* grid);
+static int  Check_orders(DIST_MATRIX_T* A, DIST_MATRIX_T* B,
+                DIST_MATRIX_T* C);
+static int  Cannon_stages(DIST_MATRIX_T* A, DIST_MATRIX_T* B,
+                DIST_MATRIX_T* C, int first, int stages,
+                GRID_INFO_T* grid);
+
+/*********************************************************/
+/* Build a rows x cols grid.  If rows or cols is 0, it's   */
+/*     chosen by MPI_Dims_create.                          */
+void Setup_grid(
+         GRID_INFO_T*  grid  /* out */,
+         int           rows  /* in  */,
+         int           cols  /* in  */) {
+    int dimensions[2];
+    int wrap_around[2];
+    int coordinates[2];
+    int free_coords[2];
+
+    /* Set up Global Grid Information */
+    MPI_Comm_size(MPI_COMM_WORLD, &(grid->p));
+
+    dimensions[0] = rows;
+    dimensions[1] = cols;
+    MPI_Dims_create(grid->p, 2, dimensions);
+    grid->rows = dimensions[0];
+    grid->cols = dimensions[1];
+    if (grid->rows == grid->cols)
+        grid->q = grid->rows;
+    else
+        grid->q = 0;
+
+    /* We want circular shifts in both dimensions for Cannon */
+    wrap_around[0] = wrap_around[1] = 1;
+    MPI_Cart_create(MPI_COMM_WORLD, 2, dimensions,
+        wrap_around, 1, &(grid->comm));
+    MPI_Comm_rank(grid->comm, &(grid->my_rank));
+    MPI_Cart_coords(grid->comm, grid->my_rank, 2,
+        coordinates);
+    grid->my_row = coordinates[0];
+    grid->my_col = coordinates[1];
+
+    /* Set up row communicators.  Rank in row_comm = my_col */
+    free_coords[0] = 0;
+    free_coords[1] = 1;
+    MPI_Cart_sub(grid->comm, free_coords,
+        &(grid->row_comm));
+
+    /* Set up column communicators.  Rank in col_comm = my_row */
+    free_coords[0] = 1;
+    free_coords[1] = 0;
+    MPI_Cart_sub(grid->comm, free_coords,
+        &(grid->col_comm));
+} /* Setup_grid */
+
+
+/*********************************************************/
+void Free_grid(
+         GRID_INFO_T*  grid  /* in/out */) {
+    MPI_Comm_free(&(grid->row_comm));
+    MPI_Comm_free(&(grid->col_comm));
+    MPI_Comm_free(&(grid->comm));
+}  /* Free_grid */
+
+
+/*********************************************************/
+/* Returns NULL if malloc fails */
+DIST_MATRIX_T* Allocate_dist_matrix(
+                   int           m     /* in */,
+                   int           n     /* in */,
+                   GRID_INFO_T*  grid  /* in */) {
+    DIST_MATRIX_T* temp;
+    int            size;
+
+    temp = (DIST_MATRIX_T*) malloc(sizeof(DIST_MATRIX_T));
+    if (temp == (DIST_MATRIX_T*) NULL)
+        return temp;
+
+    temp->m = m;
+    temp->n = n;
+    temp->local_m = Block_size(grid->my_row, grid->rows, m);
+    temp->local_n = Block_size(grid->my_col, grid->cols, n);
+    temp->first_row = Block_low(grid->my_row, grid->rows, m);
+    temp->first_col = Block_low(grid->my_col, grid->cols, n);
+
+    /* A process may have an empty block */
+    size = temp->local_m*temp->local_n;
+    temp->entries = (float*) malloc((size > 0 ? size : 1)*sizeof(float));
+    if (temp->entries == (float*) NULL) {
+        free(temp);
+        return (DIST_MATRIX_T*) NULL;
+    }
+    return temp;
+}  /* Allocate_dist_matrix */
+
+
+/*********************************************************/
+void Free_dist_matrix(
+         DIST_MATRIX_T** A_ptr  /* in/out */) {
+    free((*A_ptr)->entries);
+    free(*A_ptr);
+    *A_ptr = (DIST_MATRIX_T*) NULL;
+}  /* Free_dist_matrix */
+
+
+/*********************************************************/
+void Set_to_zero(
+         DIST_MATRIX_T*  A  /* out */) {
+
+    int i, j;
+
+    for (i = 0; i < Local_rows(A); i++)
+        for (j = 0; j < Local_cols(A); j++)
+            Entry(A,i,j) = 0.0;
+
+}  /* Set_to_zero */
+
+
+/*********************************************************/
+/* Read and distribute matrix:
+ *     foreach global row of the matrix,
+ *         foreach grid column
+ *             read the block of the row belonging to the
+ *             grid column on process 0, and send it to the
+ *             appropriate process.
+ */
+void Read_matrix(
+         char*           prompt  /* in  */,
+         DIST_MATRIX_T*  A       /* out */,
+         GRID_INFO_T*    grid    /* in  */) {
+
+    int        mat_row, mat_col;
+    int        grid_col;
+    int        dest;
+    int        coords[2];
+    int        count;
+    float*     temp;
+    MPI_Status status;
+
+    if (grid->my_rank == 0) {
+        temp = (float*) malloc((A->n/grid->cols + 1)*sizeof(float));
+        printf("%s\n", prompt);
+        fflush(stdout);
+        for (mat_row = 0;  mat_row < A->m; mat_row++) {
+            coords[0] = Block_owner(mat_row, grid->rows, A->m);
+            for (grid_col = 0; grid_col < grid->cols; grid_col++) {
+                coords[1] = grid_col;
+                count = Block_size(grid_col, grid->cols, A->n);
+                MPI_Cart_rank(grid->comm, coords, &dest);
+                if (dest == 0) {
+                    for (mat_col = 0; mat_col < count; mat_col++)
+                        scanf("%f", &Entry(A, mat_row, mat_col));
+                } else {
+                    for (mat_col = 0; mat_col < count; mat_col++)
+                        scanf("%f", temp + mat_col);
+                    MPI_Send(temp, count, MPI_FLOAT, dest, 0,
+                        grid->comm);
+                }
+            }
+        }
+        free(temp);
+    } else {
+        for (mat_row = 0; mat_row < Local_rows(A); mat_row++)
+            MPI_Recv(&Entry(A, mat_row, 0), Local_cols(A),
+                MPI_FLOAT, 0, 0, grid->comm, &status);
+    }
+
+}  /* Read_matrix */
+
+
+/*********************************************************/
+void Print_matrix(
+         char*           title  /* in  */,
+         DIST_MATRIX_T*  A      /* in  */,
+         GRID_INFO_T*    grid   /* in  */) {
+    int        mat_row, mat_col;
+    int        grid_col;
+    int        source;
+    int        coords[2];
+    int        count;
+    float*     temp;
+    MPI_Status status;
+
+    if (grid->my_rank == 0) {
+        temp = (float*) malloc((A->n/grid->cols + 1)*sizeof(float));
+        printf("%s\n", title);
+        for (mat_row = 0;  mat_row < A->m; mat_row++) {
+            coords[0] = Block_owner(mat_row, grid->rows, A->m);
+            for (grid_col = 0; grid_col < grid->cols; grid_col++) {
+                coords[1] = grid_col;
+                count = Block_size(grid_col, grid->cols, A->n);
+                MPI_Cart_rank(grid->comm, coords, &source);
+                if (source == 0) {
+                    for(mat_col = 0; mat_col < count; mat_col++)
+                        printf("%4.1f ", Entry(A, mat_row, mat_col));
+                } else {
+                    MPI_Recv(temp, count, MPI_FLOAT, source, 0,
+                        grid->comm, &status);
+                    for(mat_col = 0; mat_col < count; mat_col++)
+                        printf("%4.1f ", temp[mat_col]);
+                }
+            }
+            printf("\n");
+        }
+        free(temp);
+    } else {
+        for (mat_row = 0; mat_row < Local_rows(A); mat_row++)
+            MPI_Send(&Entry(A, mat_row, 0), Local_cols(A),
+                MPI_FLOAT, 0, 0, grid->comm);
+    }
+
+}  /* Print_matrix */
+
+
+/*********************************************************/
+/* C = C + A*B, where A is m x k, B is k x n, and C is m x n.
+ *     The matrices are stored by rows, and the distance between
+ *     the starts of consecutive rows is lda, ldb, and ldc, resp.
+ *     The loops are blocked so that a block of each matrix stays
+ *     in cache, and the innermost loop runs along rows of B and
+ *     C, so it has unit stride.
+ */
+void Local_gemm(
+         int     m    /* in     */,
+         int     n    /* in     */,
+         int     k    /* in     */,
+         float*  A    /* in     */,
+         int     lda  /* in     */,
+         float*  B    /* in     */,
+         int     ldb  /* in     */,
+         float*  C    /* in/out */,
+         int     ldc  /* in     */) {
+    int     ii, jj, kk;
+    int     i, j, l;
+    int     i_max, j_max, l_max;
+    float   a;
+    float*  b_row;
+    float*  c_row;
+
+    for (ii = 0; ii < m; ii += BLOCK_SIZE) {
+        i_max = MIN(ii + BLOCK_SIZE, m);
+        for (kk = 0; kk < k; kk += BLOCK_SIZE) {
+            l_max = MIN(kk + BLOCK_SIZE, k);
+            for (jj = 0; jj < n; jj += BLOCK_SIZE) {
+                j_max = MIN(jj + BLOCK_SIZE, n);
+                for (i = ii; i < i_max; i++) {
+                    c_row = C + i*ldc;
+                    for (l = kk; l < l_max; l++) {
+                        a = A[i*lda + l];
+                        b_row = B + l*ldb;
+                        for (j = jj; j < j_max; j++)
+                            c_row[j] += a*b_row[j];
+                    }
+                }
+            }
+        }
+    }
+}  /* Local_gemm */
+
+
+/*********************************************************/
+/* Return 0 if C = A*B makes sense, negative otherwise */
+static int Check_orders(
+               DIST_MATRIX_T*  A  /* in */,
+               DIST_MATRIX_T*  B  /* in */,
+               DIST_MATRIX_T*  C  /* in */) {
+
+    if ((A->n != B->m) || (C->m != A->m) || (C->n != B->n))
+        return -1;
+    else
+        return 0;
+}  /* Check_orders */
+
+
+/*********************************************************/
+/* A panel starting at column kk of A ends at the first of
+ *     kk + panel_width, the end of the block of columns of A
+ *     containing kk, and the end of the block of rows of B
+ *     containing kk.  So each panel is owned by a single
+ *     process column and a single process row.
+ */
+static int Panel_end(
+               int           kk           /* in */,
+               int           panel_width  /* in */,
+               int           k            /* in */,
+               GRID_INFO_T*  grid         /* in */) {
+    int end = kk + panel_width;
+    int a_end = Block_low(Block_owner(kk, grid->cols, k) + 1,
+                    grid->cols, k);
+    int b_end = Block_low(Block_owner(kk, grid->rows, k) + 1,
+                    grid->rows, k);
+
+    end = MIN(end, a_end);
+    return MIN(end, b_end);
+}  /* Panel_end */
+
+
+/*********************************************************/
+/* Start the broadcasts of the panel of A in columns kk, ...,
+ *     kk+kb-1 across the process rows, and the panel of B in
+ *     rows kk, ..., kk+kb-1 down the process columns.
+ */
+static void Start_panel(
+                DIST_MATRIX_T*  A         /* in  */,
+                DIST_MATRIX_T*  B         /* in  */,
+                int             kk        /* in  */,
+                int             kb        /* in  */,
+                float*          a_panel   /* out */,
+                float*          b_panel   /* out */,
+                MPI_Request*    requests  /* out */,
+                GRID_INFO_T*    grid      /* in  */) {
+    int root;
+    int i;
+
+    root = Block_owner(kk, grid->cols, A->n);
+    if (root == grid->my_col)
+        for (i = 0; i < Local_rows(A); i++)
+            memcpy(a_panel + i*kb, &Entry(A, i, kk - A->first_col),
+                kb*sizeof(float));
+    MPI_Ibcast(a_panel, Local_rows(A)*kb, MPI_FLOAT, root,
+        grid->row_comm, &requests[0]);
+
+    /* The rows of B in the panel are contiguous */
+    root = Block_owner(kk, grid->rows, B->m);
+    if (root == grid->my_row)
+        memcpy(b_panel, &Entry(B, kk - B->first_row, 0),
+            kb*Local_cols(B)*sizeof(float));
+    MPI_Ibcast(b_panel, kb*Local_cols(B), MPI_FLOAT, root,
+        grid->col_comm, &requests[1]);
+}  /* Start_panel */
+
+
+/*********************************************************/
+/* C = A*B using SUMMA.  Returns 0 if successful, negative
+ *     if the orders don't match or malloc fails.  Must be
+ *     called by every process in the grid.
+ */
+int Summa(
+        DIST_MATRIX_T*  A            /* in  */,
+        DIST_MATRIX_T*  B            /* in  */,
+        DIST_MATRIX_T*  C            /* out */,
+        int             panel_width  /* in  */,
+        GRID_INFO_T*    grid         /* in  */) {
+    float*       a_panel[2];   /* Double buffers for the */
+    float*       b_panel[2];   /*     panels             */
+    MPI_Request  requests[2][2];
+    int          k = A->n;
+    int          kk, kb;
+    int          next_kk;
+    int          cur = 0;
+    int          i;
+
+    if (Check_orders(A, B, C) < 0)
+        return -1;
+    if (panel_width < 1)
+        panel_width = PANEL_WIDTH;
+
+    for (i = 0; i < 2; i++) {
+        a_panel[i] = (float*) malloc((Local_rows(A)*panel_width + 1)*
+            sizeof(float));
+        b_panel[i] = (float*) malloc((panel_width*Local_cols(B) + 1)*
+            sizeof(float));
+    }
+    if ((a_panel[0] == (float*) NULL) || (b_panel[0] == (float*) NULL) ||
+            (a_panel[1] == (float*) NULL) || (b_panel[1] == (float*) NULL)) {
+        for (i = 0; i < 2; i++) {
+            free(a_panel[i]);
+            free(b_panel[i]);
+        }
+        return -1;
+    }
+
+    Set_to_zero(C);
+
+    if (k > 0)
+        Start_panel(A, B, 0, Panel_end(0, panel_width, k, grid),
+            a_panel[cur], b_panel[cur], requests[cur], grid);
+    for (kk = 0; kk < k; kk = next_kk) {
+        kb = Panel_end(kk, panel_width, k, grid) - kk;
+        next_kk = kk + kb;
+
+        /* Start communication for the next panel */
+        if (next_kk < k)
+            Start_panel(A, B, next_kk,
+                Panel_end(next_kk, panel_width, k, grid) - next_kk,
+                a_panel[1-cur], b_panel[1-cur], requests[1-cur], grid);
+
+        MPI_Waitall(2, requests[cur], MPI_STATUSES_IGNORE);
+        Local_gemm(Local_rows(C), Local_cols(C), kb, a_panel[cur], kb,
+            b_panel[cur], Local_cols(C), C->entries, Local_cols(C));
+        cur = 1 - cur;
+    }
+
+    for (i = 0; i < 2; i++) {
+        free(a_panel[i]);
+        free(b_panel[i]);
+    }
+    return 0;
+}  /* Summa */
+
+
+/*********************************************************/
+/* C = A*B using Cannon's algorithm.  Returns 0 if successful,
+ *     negative if the grid isn't square, the orders don't match
+ *     or malloc fails.  Must be called by every process in the
+ *     grid.
+ */
+int Cannon(
+        DIST_MATRIX_T*  A     /* in  */,
+        DIST_MATRIX_T*  B     /* in  */,
+        DIST_MATRIX_T*  C     /* out */,
+        GRID_INFO_T*    grid  /* in  */) {
+
+    if ((grid->q == 0) || (Check_orders(A, B, C) < 0))
+        return -1;
+    return Cannon_stages(A, B, C, 0, grid->q, grid);
+}  /* Cannon */
+
+
+/*********************************************************/
+/* Run stages first, first+1, ..., first+stages-1 of Cannon's
+ *     algorithm, and store the sum of their products in C.
+ *     Stage s multiplies A(i,i+j+s) and B(i+j+s,j), so the
+ *     skew moves A(i,i+j+first) and B(i+j+first,j) to
+ *     process (i,j).
+ */
+static int Cannon_stages(
+               DIST_MATRIX_T*  A       /* in  */,
+               DIST_MATRIX_T*  B       /* in  */,
+               DIST_MATRIX_T*  C       /* out */,
+               int             first   /* in  */,
+               int             stages  /* in  */,
+               GRID_INFO_T*    grid    /* in  */) {
+    float*       a_block[2];   /* Double buffers for the */
+    float*       b_block[2];   /*     blocks             */
+    MPI_Request  requests[4];
+    MPI_Status   status;
+    int          q = grid->q;
+    int          k = A->n;
+    int          max_kb;
+    int          kb, next_kb;
+    int          block;
+    int          stage;
+    int          left, right, up, down;
+    int          cur = 0;
+    int          i;
+
+    /* The largest block of the inner dimension */
+    max_kb = (k + q - 1)/q;
+    for (i = 0; i < 2; i++) {
+        a_block[i] = (float*) malloc((Local_rows(A)*max_kb + 1)*
+            sizeof(float));
+        b_block[i] = (float*) malloc((max_kb*Local_cols(B) + 1)*
+            sizeof(float));
+    }
+    if ((a_block[0] == (float*) NULL) || (b_block[0] == (float*) NULL) ||
+            (a_block[1] == (float*) NULL) || (b_block[1] == (float*) NULL)) {
+        for (i = 0; i < 2; i++) {
+            free(a_block[i]);
+            free(b_block[i]);
+        }
+        return -1;
+    }
+
+    Set_to_zero(C);
+
+    /* Skew:  process (i,j) gets A(i,i+j+first) and B(i+j+first,j) */
+    block = (grid->my_row + grid->my_col + first) % q;
+    kb = Block_size(block, q, k);
+    MPI_Sendrecv(A->entries, Local_rows(A)*Local_cols(A), MPI_FLOAT,
+        (grid->my_col - grid->my_row - first + 2*q) % q, 0,
+        a_block[cur], Local_rows(A)*kb, MPI_FLOAT, block, 0,
+        grid->row_comm, &status);
+    MPI_Sendrecv(B->entries, Local_rows(B)*Local_cols(B), MPI_FLOAT,
+        (grid->my_row - grid->my_col - first + 2*q) % q, 0,
+        b_block[cur], kb*Local_cols(B), MPI_FLOAT, block, 0,
+        grid->col_comm, &status);
+
+    left = (grid->my_col + q - 1) % q;
+    right = (grid->my_col + 1) % q;
+    up = (grid->my_row + q - 1) % q;
+    down = (grid->my_row + 1) % q;
+    for (stage = 0; stage < stages; stage++) {
+        kb = Block_size(block, q, k);
+
+        /* Shift for the next stage while we compute */
+        if (stage < stages - 1) {
+            next_kb = Block_size((block + 1) % q, q, k);
+            MPI_Irecv(a_block[1-cur], Local_rows(A)*next_kb, MPI_FLOAT,
+                right, 0, grid->row_comm, &requests[0]);
+            MPI_Irecv(b_block[1-cur], next_kb*Local_cols(B), MPI_FLOAT,
+                down, 0, grid->col_comm, &requests[1]);
+            MPI_Isend(a_block[cur], Local_rows(A)*kb, MPI_FLOAT,
+                left, 0, grid->row_comm, &requests[2]);
+            MPI_Isend(b_block[cur], kb*Local_cols(B), MPI_FLOAT,
+                up, 0, grid->col_comm, &requests[3]);
+        }
+
+        Local_gemm(Local_rows(C), Local_cols(C), kb, a_block[cur], kb,
+            b_block[cur], Local_cols(C), C->entries, Local_cols(C));
+
+        if (stage < stages - 1) {
+            MPI_Waitall(4, requests, MPI_STATUSES_IGNORE);
+            cur = 1 - cur;
+            block = (block + 1) % q;
+        }
+    }
+
+    for (i = 0; i < 2; i++) {
+        free(a_block[i]);
+        free(b_block[i]);
+    }
+    return 0;
+}  /* Cannon_stages */
+
+
+/*********************************************************/
+/* Build a c x q x q grid, where p = c*q*q.  Layer 0 is the
+ *     processes with ranks 0, 1, ..., q*q-1 in MPI_COMM_WORLD.
+ *     Returns 0 if successful, negative if p/c isn't a
+ *     perfect square.
+ */
+int Setup_grid_3d(
+        GRID_3D_T*  grid3  /* out */,
+        int         c      /* in  */) {
+    int dimensions[3];
+    int wrap_around[3];
+    int coordinates[3];
+    int free_coords[3];
+    int q;
+    GRID_INFO_T* grid = &(grid3->layer);
+
+    MPI_Comm_size(MPI_COMM_WORLD, &(grid3->p));
+    if ((c < 1) || (grid3->p % c != 0))
+        return -1;
+    for (q = 1; q*q < grid3->p/c; q++);
+    if (q*q != grid3->p/c)
+        return -1;
+    grid3->c = c;
+
+    dimensions[0] = c;
+    dimensions[1] = dimensions[2] = q;
+    wrap_around[0] = 0;
+    wrap_around[1] = wrap_around[2] = 1;
+    /* Don't reorder:  process 0 in layer 0 must be able to read */
+    MPI_Cart_create(MPI_COMM_WORLD, 3, dimensions,
+        wrap_around, 0, &(grid3->comm));
+    MPI_Comm_rank(grid3->comm, &(grid3->my_rank));
+    MPI_Cart_coords(grid3->comm, grid3->my_rank, 3, coordinates);
+    grid3->my_layer = coordinates[0];
+
+    /* Depth communicator.  Rank in depth_comm = my_layer */
+    free_coords[0] = 1;
+    free_coords[1] = free_coords[2] = 0;
+    MPI_Cart_sub(grid3->comm, free_coords, &(grid3->depth_comm));
+
+    /* My layer is an ordinary q x q grid */
+    free_coords[0] = 0;
+    free_coords[1] = free_coords[2] = 1;
+    MPI_Cart_sub(grid3->comm, free_coords, &(grid->comm));
+    grid->p = q*q;
+    grid->q = grid->rows = grid->cols = q;
+    MPI_Comm_rank(grid->comm, &(grid->my_rank));
+    grid->my_row = coordinates[1];
+    grid->my_col = coordinates[2];
+
+    free_coords[1] = 0;
+    free_coords[2] = 1;
+    MPI_Cart_sub(grid3->comm, free_coords, &(grid->row_comm));
+
+    free_coords[1] = 1;
+    free_coords[2] = 0;
+    MPI_Cart_sub(grid3->comm, free_coords, &(grid->col_comm));
+
+    return 0;
+}  /* Setup_grid_3d */
+
+
+/*********************************************************/
+void Free_grid_3d(
+         GRID_3D_T*  grid3  /* in/out */) {
+    Free_grid(&(grid3->layer));
+    MPI_Comm_free(&(grid3->depth_comm));
+    MPI_Comm_free(&(grid3->comm));
+}  /* Free_grid_3d */
+
+
+/*********************************************************/
+/* C = A*B using the 2.5D version of Cannon's algorithm.
+ *     The matrices are distributed over grid3->layer on
+ *     every layer, but A and B need only be correct on
+ *     layer 0, and C is only correct on layer 0.  Returns
+ *     0 if successful, negative if the orders don't match,
+ *     c > q, or malloc fails.  Must be called by every
+ *     process in grid3.
+ */
+int Cannon_25d(
+        DIST_MATRIX_T*  A      /* in  */,
+        DIST_MATRIX_T*  B      /* in  */,
+        DIST_MATRIX_T*  C      /* out */,
+        GRID_3D_T*      grid3  /* in  */) {
+    GRID_INFO_T* grid = &(grid3->layer);
+    int          c = grid3->c;
+    int          q = grid->q;
+    int          layer = grid3->my_layer;
+    int          error;
+
+    if ((c > q) || (Check_orders(A, B, C) < 0))
+        return -1;
+
+    /* Replicate A and B on every layer */
+    MPI_Bcast(A->entries, Local_rows(A)*Local_cols(A), MPI_FLOAT, 0,
+        grid3->depth_comm);
+    MPI_Bcast(B->entries, Local_rows(B)*Local_cols(B), MPI_FLOAT, 0,
+        grid3->depth_comm);
+
+    /* Each layer runs its share of the q stages */
+    error = Cannon_stages(A, B, C, Block_low(layer, c, q),
+                Block_size(layer, c, q), grid);
+    if (error < 0)
+        return error;
+
+    /* Sum the layers' contributions on layer 0 */
+    if (layer == 0)
+        MPI_Reduce(MPI_IN_PLACE, C->entries, Local_rows(C)*Local_cols(C),
+            MPI_FLOAT, MPI_SUM, 0, grid3->depth_comm);
+    else
+        MPI_Reduce(C->entries, (float*) NULL, Local_rows(C)*Local_cols(C),
+            MPI_FLOAT, MPI_SUM, 0, grid3->depth_comm);
+    return 0;
+}  /* Cannon_25d */
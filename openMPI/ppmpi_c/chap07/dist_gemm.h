@@ -0,0 +1,90 @@
+/* dist_gemm.h -- definitions and declarations for distributed matrix
+ *     multiplication on a 2-dimensional grid of processes.
+ *
+ * See dist_gemm.c
+ */
+#ifndef DIST_GEMM_H
+#define DIST_GEMM_H
+
+#include "mpi.h"
+#include "block_dist.h"
+
+typedef struct {
+    int       p;         /* Total number of processes    */
+    MPI_Comm  comm;      /* Communicator for entire grid */
+    MPI_Comm  row_comm;  /* Communicator for my row      */
+    MPI_Comm  col_comm;  /* Communicator for my col      */
+    int       q;         /* Order of grid, if it's square */
+                         /*     0 otherwise               */
+    int       rows;      /* Number of rows in the grid   */
+    int       cols;      /* Number of cols in the grid   */
+    int       my_row;    /* My row number                */
+    int       my_col;    /* My column number             */
+    int       my_rank;   /* My rank in the grid comm     */
+} GRID_INFO_T;
+
+/* A c x q x q grid:  c layers, each a q x q grid */
+typedef struct {
+    int          p;          /* Total number of processes    */
+    MPI_Comm     comm;       /* Communicator for entire grid */
+    MPI_Comm     depth_comm; /* Communicator for my (i,j)    */
+                             /*     across the layers        */
+    int          c;          /* Number of layers             */
+    int          my_layer;   /* My layer number              */
+    int          my_rank;    /* My rank in the grid comm     */
+    GRID_INFO_T  layer;      /* My layer                     */
+} GRID_3D_T;
+
+/* The block of an m x n matrix assigned to one process.  Process  */
+/*     (i,j) gets rows Block_low(i,rows,m), ..., Block_high(i,rows,m) */
+/*     and columns Block_low(j,cols,n), ..., Block_high(j,cols,n).  */
+/*     The entries are stored by rows.                               */
+typedef struct {
+    int     m;           /* Global number of rows        */
+    int     n;           /* Global number of columns     */
+    int     local_m;     /* Number of rows in my block   */
+    int     local_n;     /* Number of cols in my block   */
+    int     first_row;   /* Global index of my first row */
+    int     first_col;   /* Global index of my first col */
+    float*  entries;
+} DIST_MATRIX_T;
+
+#define Local_rows(A)  ((A)->local_m)
+#define Local_cols(A)  ((A)->local_n)
+#define Entry(A,i,j) (*(((A)->entries) + ((A)->local_n)*(i) + (j)))
+
+/* Order of the blocks used by Local_gemm */
+#ifndef BLOCK_SIZE
+#define BLOCK_SIZE 64
+#endif
+
+/* Default SUMMA panel width */
+#ifndef PANEL_WIDTH
+#define PANEL_WIDTH 64
+#endif
+
+#define SUMMA  0
+#define CANNON 1
+#define CANNON_25D 2
+
+void            Setup_grid(GRID_INFO_T* grid, int rows, int cols);
+void            Free_grid(GRID_INFO_T* grid);
+DIST_MATRIX_T*  Allocate_dist_matrix(int m, int n, GRID_INFO_T* grid);
+void            Free_dist_matrix(DIST_MATRIX_T** A_ptr);
+void            Set_to_zero(DIST_MATRIX_T* A);
+void            Read_matrix(char* prompt, DIST_MATRIX_T* A,
+                    GRID_INFO_T* grid);
+void            Print_matrix(char* title, DIST_MATRIX_T* A,
+                    GRID_INFO_T* grid);
+void            Local_gemm(int m, int n, int k, float* A, int lda,
+                    float* B, int ldb, float* C, int ldc);
+int             Summa(DIST_MATRIX_T* A, DIST_MATRIX_T* B,
+                    DIST_MATRIX_T* C, int panel_width, GRID_INFO_T* grid);
+int             Cannon(DIST_MATRIX_T* A, DIST_MATRIX_T* B,
+                    DIST_MATRIX_T* C, GRID_INFO_T* grid);
+int             Setup_grid_3d(GRID_3D_T* grid3, int c);
+void            Free_grid_3d(GRID_3D_T* grid3);
+int             Cannon_25d(DIST_MATRIX_T* A, DIST_MATRIX_T* B,
+                    DIST_MATRIX_T* C, GRID_3D_T* grid3);
+
+#endif
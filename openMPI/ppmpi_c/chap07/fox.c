@@ -11,6 +11,9 @@
  *     2.  The array member of the matrices is statically allocated
  *     3.  Assumes the global order of the matrices is evenly
  *         divisible by sqrt(p).
+ *     4.  See dist_gemm.c for SUMMA and Cannon, which don't have
+ *         these restrictions, and overlap communication with
+ *         computation.
  *
  * See Chap 7, pp. 113 & ff and pp. 125 & ff in PPMPI
  */
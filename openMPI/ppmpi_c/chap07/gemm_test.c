@@ -0,0 +1,211 @@
+/* gemm_test.c -- test and time the distributed matrix multiplication
+ *     functions in dist_gemm.c
+ *
+ * Input:
+ *     m, k, n: A is m x k, B is k x n
+ *     algorithm: 0 for SUMMA, 1 for Cannon, 2 for 2.5D Cannon
+ *     panel_width: SUMMA panel width (0 for the default)
+ *     rows, cols: order of the process grid (0 to let MPI choose)
+ *     layers: number of layers c for 2.5D Cannon.  p/c must be
+ *         a perfect square.
+ *     read_flag: 1 to read A and B, 0 to generate them
+ * Output:
+ *     Elapsed time for the multiplication, and the largest
+ *     error in C.  If the matrices are small, they're printed.
+ *
+ * Notes:
+ *     1.  The generated entries are small integers, so the
+ *         entries of C are computed exactly, and the error
+ *         should be 0.
+ *     2.  Cannon requires rows = cols.  For 2.5D Cannon, rows
+ *         and cols are ignored, and the grid is c x q x q.
+ *
+ * See Chap 7, pp. 113 & ff and pp. 125 & ff in PPMPI
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "mpi.h"
+#include "dist_gemm.h"
+
+#define PRINT_MAX 10
+#define TRUE 1
+
+#define A_entry(i,j) ((float) (((i) + 2*(j)) % 5 - 2))
+#define B_entry(i,j) ((float) ((3*(i) + (j)) % 7 - 3))
+
+void Generate(DIST_MATRIX_T* A, DIST_MATRIX_T* B);
+float Check(DIST_MATRIX_T* A, DIST_MATRIX_T* C, GRID_INFO_T* grid);
+
+/*********************************************************/
+int main(int argc, char* argv[]) {
+    int             my_rank;
+    GRID_INFO_T     grid_2d;
+    GRID_3D_T       grid3;
+    GRID_INFO_T*    grid;
+    DIST_MATRIX_T*  A;
+    DIST_MATRIX_T*  B;
+    DIST_MATRIX_T*  C;
+    int             input[9];
+    int             m, k, n;
+    int             algorithm;
+    int             panel_width;
+    int             read_flag;
+    int             layer_0;   /* Am I in the layer that has C? */
+    int             error;
+    double          start, elapsed, max_elapsed;
+    float           max_error;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+
+    if (my_rank == 0) {
+        printf("Enter m, k, n, algorithm (0 = SUMMA, 1 = Cannon, 2 = 2.5D),\n");
+        printf("    panel width, grid rows, grid cols, layers, read flag\n");
+        scanf("%d %d %d %d %d %d %d %d %d", &input[0], &input[1],
+            &input[2], &input[3], &input[4], &input[5], &input[6],
+            &input[7], &input[8]);
+    }
+    MPI_Bcast(input, 9, MPI_INT, 0, MPI_COMM_WORLD);
+    m = input[0];
+    k = input[1];
+    n = input[2];
+    algorithm = input[3];
+    panel_width = input[4];
+    read_flag = input[8];
+
+    if (algorithm == CANNON_25D) {
+        if (Setup_grid_3d(&grid3, input[7]) < 0) {
+            if (my_rank == 0)
+                fprintf(stderr, "p/layers must be a perfect square\n");
+            MPI_Finalize();
+            return 1;
+        }
+        grid = &(grid3.layer);
+        layer_0 = (grid3.my_layer == 0);
+        if (my_rank == 0)
+            printf("Grid is %d x %d x %d\n", grid3.c, grid->q, grid->q);
+    } else {
+        Setup_grid(&grid_2d, input[5], input[6]);
+        grid = &grid_2d;
+        layer_0 = TRUE;
+        if (my_rank == 0)
+            printf("Grid is %d x %d\n", grid->rows, grid->cols);
+    }
+
+    A = Allocate_dist_matrix(m, k, grid);
+    B = Allocate_dist_matrix(k, n, grid);
+    C = Allocate_dist_matrix(m, n, grid);
+    if ((A == (DIST_MATRIX_T*) NULL) || (B == (DIST_MATRIX_T*) NULL)
+            || (C == (DIST_MATRIX_T*) NULL)) {
+        fprintf(stderr, "Process %d > Can't allocate matrices\n",
+            my_rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    /* Only layer 0 has A and B, and only layer 0 gets C */
+    if (layer_0) {
+        if (read_flag) {
+            Read_matrix("Enter A", A, grid);
+            Read_matrix("Enter B", B, grid);
+        } else {
+            Generate(A, B);
+        }
+        if ((m <= PRINT_MAX) && (k <= PRINT_MAX) && (n <= PRINT_MAX)) {
+            Print_matrix("A =", A, grid);
+            Print_matrix("B =", B, grid);
+        }
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+    if (algorithm == CANNON_25D)
+        error = Cannon_25d(A, B, C, &grid3);
+    else if (algorithm == CANNON)
+        error = Cannon(A, B, C, grid);
+    else
+        error = Summa(A, B, C, panel_width, grid);
+    elapsed = MPI_Wtime() - start;
+    if (error < 0) {
+        if (my_rank == 0) {
+            fprintf(stderr, "Multiplication failed.  Cannon needs a square\n");
+            fprintf(stderr, "    grid, and 2.5D needs layers <= q\n");
+        }
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    MPI_Reduce(&elapsed, &max_elapsed, 1, MPI_DOUBLE, MPI_MAX, 0,
+        MPI_COMM_WORLD);
+
+    if (layer_0) {
+        if ((m <= PRINT_MAX) && (k <= PRINT_MAX) && (n <= PRINT_MAX))
+            Print_matrix("The product is", C, grid);
+        if (!read_flag) {
+            max_error = Check(A, C, grid);
+            if (my_rank == 0)
+                printf("Max error = %e\n", max_error);
+        }
+    }
+    if (my_rank == 0) {
+        printf("Elapsed time = %e seconds\n", max_elapsed);
+        if (max_elapsed > 0.0)
+            printf("Mflop/s = %f\n",
+                2.0*m*k*((double) n)/(max_elapsed*1.0e6));
+    }
+
+    Free_dist_matrix(&A);
+    Free_dist_matrix(&B);
+    Free_dist_matrix(&C);
+    if (algorithm == CANNON_25D)
+        Free_grid_3d(&grid3);
+    else
+        Free_grid(&grid_2d);
+
+    MPI_Finalize();
+    return 0;
+}  /* main */
+
+
+/*********************************************************/
+void Generate(
+         DIST_MATRIX_T*  A  /* out */,
+         DIST_MATRIX_T*  B  /* out */) {
+    int i, j;
+
+    for (i = 0; i < Local_rows(A); i++)
+        for (j = 0; j < Local_cols(A); j++)
+            Entry(A,i,j) = A_entry(A->first_row + i, A->first_col + j);
+    for (i = 0; i < Local_rows(B); i++)
+        for (j = 0; j < Local_cols(B); j++)
+            Entry(B,i,j) = B_entry(B->first_row + i, B->first_col + j);
+}  /* Generate */
+
+
+/*********************************************************/
+/* Compare each local entry of C with the dot product of  */
+/*     the generated row of A and column of B.  Returns   */
+/*     the largest error on process 0.                    */
+float Check(
+          DIST_MATRIX_T*  A     /* in */,
+          DIST_MATRIX_T*  C     /* in */,
+          GRID_INFO_T*    grid  /* in */) {
+    int    i, j, l;
+    int    row, col;
+    float  sum;
+    float  my_error = 0.0;
+    float  max_error;
+
+    for (i = 0; i < Local_rows(C); i++) {
+        row = C->first_row + i;
+        for (j = 0; j < Local_cols(C); j++) {
+            col = C->first_col + j;
+            sum = 0.0;
+            for (l = 0; l < A->n; l++)
+                sum += A_entry(row, l)*B_entry(l, col);
+            if (fabs(Entry(C,i,j) - sum) > my_error)
+                my_error = fabs(Entry(C,i,j) - sum);
+        }
+    }
+    MPI_Reduce(&my_error, &max_error, 1, MPI_FLOAT, MPI_MAX, 0,
+        grid->comm);
+    return max_error;
+}  /* Check */
@@ -17,7 +17,9 @@
  *     7.  Carry out a broadcast across each column communicator
  *     8.  Print results of broadcast
  *
- * Note: Assumes the number of processes, p, is a perfect square
+ * Note: Assumes the number of processes, p, is a perfect square.
+ *     See comm_factory.c for grids of any shape and dimension, that
+ *     keep neighbors on the same node.
  *
  * See Chap 7, pp. 121 & ff in PPMPI
  */
@@ -0,0 +1,148 @@
+/* topo_test.c -- test the communicators built by comm_factory.c, and
+ *     compare the placement of grid neighbors with and without
+ *     reordering.
+ *
+ * Input:
+ *     ndims: number of dimensions in the grid
+ *     dims: ndims orders, 0 to let MPI_Dims_create choose
+ *     periodic: 1 for wraparound in every dimension, 0 for none
+ * Output:
+ *     For reorder = 0 and reorder = 1, the grid, the tile given to
+ *     each node, the number of grid neighbors on the same node, and
+ *     whether the line, plane and node communicators are right.
+ *
+ * Notes:
+ *     1.  A line communicator is right if a broadcast of the root's
+ *         coordinates agrees with the receiver's except in the
+ *         line's dimension, and the rank in it is the coordinate.
+ *     2.  Compile with -DEMULATE_NODE_SIZE=<s> to test placement on
+ *         one machine.
+ *
+ * See Chap 7, pp. 121 & ff in PPMPI
+ */
+#include <stdio.h>
+#include "mpi.h"
+#include "comm_factory.h"
+
+int Check_comms(TOPO_T* topo);
+
+/********************************************************************/
+int main(int argc, char* argv[]) {
+    int     p, my_rank;
+    int     input[TOPO_MAX_DIMS + 2];
+    int     ndims, d, reorder;
+    int     dims[TOPO_MAX_DIMS];
+    int     periods[TOPO_MAX_DIMS];
+    int     on_node, total;
+    int     ok;
+    TOPO_T  topo;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &p);
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+
+    if (my_rank == 0) {
+        printf("Enter ndims, the dims (0 = any), and periodic (0 or 1)\n");
+        scanf("%d", &input[0]);
+        if ((input[0] < 1) || (input[0] > TOPO_MAX_DIMS))
+            input[0] = 2;
+        for (d = 1; d <= input[0] + 1; d++)
+            scanf("%d", &input[d]);
+    }
+    MPI_Bcast(input, TOPO_MAX_DIMS + 2, MPI_INT, 0, MPI_COMM_WORLD);
+    ndims = input[0];
+
+    for (reorder = 0; reorder < 2; reorder++) {
+        for (d = 0; d < ndims; d++) {
+            dims[d] = input[d+1];
+            periods[d] = input[ndims+1];
+        }
+        if (Topo_create(&topo, MPI_COMM_WORLD, ndims, dims, periods,
+                reorder)) {
+            if (my_rank == 0)
+                fprintf(stderr, "The dims don't fit %d processes\n", p);
+            MPI_Finalize();
+            return 0;
+        }
+
+        Topo_locality(&topo, &on_node, &total);
+        ok = Check_comms(&topo);
+        if (my_rank == 0) {
+            printf("reorder = %d:  grid", reorder);
+            for (d = 0; d < ndims; d++)
+                printf("%s%d", (d == 0 ? " " : " x "), topo.dims[d]);
+            printf(", %d nodes", topo.nodes);
+            if (topo.mapped) {
+                printf(", tile");
+                for (d = 0; d < ndims; d++)
+                    printf("%s%d", (d == 0 ? " " : " x "), topo.tile[d]);
+            }
+            printf("\n    %d of %d neighbors on the same node, ",
+                on_node, total);
+            printf("communicators %s\n", ok ? "ok" : "WRONG");
+        }
+        Topo_free(&topo);
+    }
+
+    MPI_Finalize();
+    return 0;
+}  /* main */
+
+
+/********************************************************************/
+/* Returns 1 on every process if the communicators are right */
+int Check_comms(
+        TOPO_T*  topo  /* in */) {
+    int d, k;
+    int ok = 1, all_ok;
+    int rank, size;
+    int root_coords[TOPO_MAX_DIMS];
+    int node[2], node_range[2];
+
+    for (d = 0; d < topo->ndims; d++) {
+        MPI_Comm_rank(topo->line_comm[d], &rank);
+        MPI_Comm_size(topo->line_comm[d], &size);
+        if ((rank != topo->coords[d]) || (size != topo->dims[d]))
+            ok = 0;
+        for (k = 0; k < topo->ndims; k++)
+            root_coords[k] = topo->coords[k];
+        MPI_Bcast(root_coords, topo->ndims, MPI_INT, 0,
+            topo->line_comm[d]);
+        for (k = 0; k < topo->ndims; k++)
+            if ((k != d) && (root_coords[k] != topo->coords[k]))
+                ok = 0;
+        if (root_coords[d] != 0)
+            ok = 0;
+
+        if (topo->plane_comm[d] != MPI_COMM_NULL) {
+            MPI_Comm_size(topo->plane_comm[d], &size);
+            if (size != topo->p/topo->dims[d])
+                ok = 0;
+            root_coords[d] = topo->coords[d];
+            MPI_Bcast(&root_coords[d], 1, MPI_INT, 0,
+                topo->plane_comm[d]);
+            if (root_coords[d] != topo->coords[d])
+                ok = 0;
+        }
+    }
+
+    /* Everyone in node_comm is on my node */
+    node[0] = topo->my_node;
+    node[1] = -topo->my_node;
+    MPI_Allreduce(node, node_range, 2, MPI_INT, MPI_MAX,
+        topo->node_comm);
+    if ((node_range[0] != topo->my_node) ||
+            (-node_range[1] != topo->my_node))
+        ok = 0;
+    MPI_Comm_size(topo->node_comm, &size);
+    if (size != topo->node_size)
+        ok = 0;
+    if (topo->node_rank == 0) {
+        MPI_Comm_rank(topo->leader_comm, &rank);
+        if (rank != topo->my_node)
+            ok = 0;
+    }
+
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, topo->comm);
+    return all_ok;
+}  /* Check_comms */
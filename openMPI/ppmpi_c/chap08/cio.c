@@ -21,6 +21,40 @@ void*        extra_arg;
 static int*  error_buf;
 static int   error_bufsiz = 0;
 
+/* Key identifying the output buffer of Clog_printf */
+int          LOG_KEY = MPI_KEYVAL_INVALID;
+
+/* Tags for LOG_UNORDERED flushes:  flush number e uses */
+/*     LOG_TAG + e % LOG_EPOCHS, so a process that's     */
+/*     already sending its next flush can't be mistaken  */
+/*     for one the I/O process is still waiting for.     */
+/*     Other messages on io_comm shouldn't use them.     */
+#define LOG_TAG     31744
+#define LOG_EPOCHS  1024
+
+typedef struct {
+    char*  buf;
+    int    count;       /* Chars in buf              */
+    int    capacity;    /* Size of buf               */
+    int    threshold;   /* LOG_FULL at this count    */
+    int    flags;
+    int    line_start;  /* Next char starts a line   */
+    int    my_rank;     /* In io_comm                */
+    int    epoch;       /* Number of flushes so far  */
+} LOG_T;
+
+/* Storage on the I/O process for Cprintf and Clog_flush */
+static int*   gather_counts = NULL;
+static int*   gather_displs = NULL;
+static int    gather_size = 0;
+static char*  gather_buf = NULL;
+static int    gather_bufsiz = 0;
+
+static void Get_gather_space(int io_p);
+static int  Set_displs(int io_p);
+static void Get_gather_buf(int size);
+static int  Log_append(LOG_T* log, char* chars, int count);
+
 /********************************************************/
 /* Attempt to identify a process in io_comm that can be
  *     used for I/O.
@@ -354,6 +388,9 @@ int Cscanf(
  *
  * Notes:
  *     1.  Title is significant only on root.
+ *     2.  The strings are collected with a single
+ *         MPI_Gatherv, rather than a receive from each
+ *         process.
  */
 int Cprintf(
         MPI_Comm  io_comm  /* in */,
@@ -365,7 +402,8 @@ int Cprintf(
     int         my_io_rank;
     int         io_p;
     int         root;
-    MPI_Status  status;
+    int         length;
+    int         total;
     va_list     args;
 
     if (Get_io_rank(io_comm, &root) == NO_IO_ATTR)
@@ -373,44 +411,408 @@ int Cprintf(
     MPI_Comm_rank(io_comm, &my_io_rank);
     MPI_Comm_size(io_comm, &io_p);
     
-    /* Send output data to io_process */
-    if (my_io_rank != root) {
-        /* Copy the output data into io_buf */
-        va_start(args, format);
-        vsprintf(io_buf, format, args);
-        va_end(args);
-
-        MPI_Send(io_buf, strlen(io_buf) + 1, MPI_CHAR, 
-            root, 0, io_comm);
-    } else { /* my_io_rank == root */
+    /* Copy the output data into io_buf */
+    va_start(args, format);
+    vsprintf(io_buf, format, args);
+    va_end(args);
+    length = strlen(io_buf) + 1;
+
+    if (my_io_rank == root)
+        Get_gather_space(io_p);
+    MPI_Gather(&length, 1, MPI_INT, gather_counts, 1, MPI_INT,
+        root, io_comm);
+    if (my_io_rank == root) {
+        total = Set_displs(io_p);
+        Get_gather_buf(total);
+    }
+    MPI_Gatherv(io_buf, length, MPI_CHAR, gather_buf, gather_counts,
+        gather_displs, MPI_CHAR, root, io_comm);
+
+    if (my_io_rank == root) {
         printf("%s\n",title);
+        for (q = 0; q < io_p; q++)
+            printf("Process %d > %s\n",q, gather_buf + gather_displs[q]);
+        printf("\n");
         fflush(stdout);
-        for (q = 0; q < root; q++) {
-            MPI_Recv(io_buf, BUFSIZ, MPI_CHAR, q,
-                0, io_comm, &status);
-            printf("Process %d > %s\n",q, io_buf);
-            fflush(stdout);
+    }
+
+    return 0;
+} /* Cprintf */
+
+
+/********************************************************/
+/* Make sure gather_counts and gather_displs have room
+ *     for io_p ints.  Only called on the I/O process.
+ */
+static void Get_gather_space(
+        int  io_p  /* in */) {
+
+    if (gather_size < io_p) {
+        free(gather_counts);
+        gather_counts = (int*) malloc(2*io_p*sizeof(int));
+        gather_displs = gather_counts + io_p;
+        gather_size = io_p;
+    }
+} /* Get_gather_space */
+
+
+/********************************************************/
+/* Displacements from the counts.  Returns the total */
+static int Set_displs(
+        int  io_p  /* in */) {
+
+    int q;
+
+    gather_displs[0] = 0;
+    for (q = 1; q < io_p; q++)
+        gather_displs[q] = gather_displs[q-1] + gather_counts[q-1];
+    return gather_displs[io_p-1] + gather_counts[io_p-1];
+} /* Set_displs */
+
+
+/********************************************************/
+/* Make sure gather_buf has room for size chars */
+static void Get_gather_buf(
+        int  size  /* in */) {
+
+    if (gather_bufsiz < size + 1) {
+        free(gather_buf);
+        gather_buf = (char*) malloc(size + 1);
+        gather_bufsiz = size + 1;
+    }
+} /* Get_gather_buf */
+
+
+/********************************************************/
+/* Attribute delete function for LOG_KEY.  Unflushed
+ *     output is lost.
+ */
+static int Log_delete(
+        MPI_Comm  comm       /* in */,
+        int       keyval     /* in */,
+        void*     attr_val   /* in */,
+        void*     extra      /* in */) {
+
+    LOG_T*  log = (LOG_T*) attr_val;
+
+    free(log->buf);
+    free(log);
+    return MPI_SUCCESS;
+} /* Log_delete */
+
+
+/********************************************************/
+/* Attach an output buffer to io_comm.  Clog_printf
+ *     returns LOG_FULL once bufsize chars are buffered,
+ *     but the buffer grows as needed, so no output is
+ *     lost if the caller doesn't flush right away.
+ *
+ * Return values:
+ *     1.  0:  buffer attached
+ *     2.  NO_IO_ATTR:  no rank cached with IO_KEY
+ *     3.  NO_LOG_MEM:  the buffer can't be allocated.
+ *         Nothing is attached.
+ *
+ * Notes:
+ *     1.  Collective, since Get_io_rank may be.  Only
+ *         the processes that ran out of memory get
+ *         NO_LOG_MEM, so pass the result to Cerror_test.
+ *     2.  The buffer isn't copied when io_comm is
+ *         duplicated.
+ */
+int Clog_open(
+        MPI_Comm  io_comm  /* in */,
+        int       bufsize  /* in */,
+        int       flags    /* in */) {
+
+    int     root;
+    LOG_T*  log;
+    void*   old_log;
+    int     flag;
+
+    if (Get_io_rank(io_comm, &root) == NO_IO_ATTR)
+        return NO_IO_ATTR;
+
+    if (LOG_KEY == MPI_KEYVAL_INVALID) {
+        MPI_Keyval_create(MPI_NULL_COPY_FN, Log_delete,
+            &LOG_KEY, extra_arg);
+    } else {
+        MPI_Attr_get(io_comm, LOG_KEY, &old_log, &flag);
+        if (flag != 0)
+            MPI_Attr_delete(io_comm, LOG_KEY);
+    }
+
+    if (bufsize <= 0)
+        bufsize = BUFSIZ;
+    log = (LOG_T*) malloc(sizeof(LOG_T));
+    if (log == (LOG_T*) NULL)
+        return NO_LOG_MEM;
+    log->capacity = bufsize + BUFSIZ;
+    log->buf = (char*) malloc(log->capacity);
+    if (log->buf == (char*) NULL) {
+        free(log);
+        return NO_LOG_MEM;
+    }
+    log->count = 0;
+    log->threshold = bufsize;
+    log->flags = flags;
+    log->line_start = 1;
+    log->epoch = 0;
+    MPI_Comm_rank(io_comm, &(log->my_rank));
+    MPI_Attr_put(io_comm, LOG_KEY, log);
+
+    return 0;
+} /* Clog_open */
+
+
+/********************************************************/
+/* Returns the buffer attached to io_comm, or NULL */
+static LOG_T* Get_log(
+        MPI_Comm  io_comm  /* in */) {
+
+    LOG_T*  log;
+    int     flag;
+
+    if (LOG_KEY == MPI_KEYVAL_INVALID)
+        return (LOG_T*) NULL;
+    MPI_Attr_get(io_comm, LOG_KEY, &log, &flag);
+    if (flag == 0)
+        return (LOG_T*) NULL;
+    return log;
+} /* Get_log */
+
+
+/********************************************************/
+/* Append count chars to the buffer, growing it if
+ *     necessary.  Leaves room for a '\n'.  Returns 0, or
+ *     NO_LOG_MEM if the buffer can't grow.  Then the
+ *     chars aren't added, and the buffer is unchanged.
+ */
+static int Log_append(
+        LOG_T*  log    /* in/out */,
+        char*   chars  /* in     */,
+        int     count  /* in     */) {
+
+    int    capacity;
+    char*  buf;
+
+    if (log->count + count + 1 > log->capacity) {
+        capacity = log->capacity;
+        while (log->count + count + 1 > capacity)
+            capacity *= 2;
+        buf = (char*) realloc(log->buf, capacity);
+        if (buf == (char*) NULL)
+            return NO_LOG_MEM;
+        log->buf = buf;
+        log->capacity = capacity;
+    }
+    memcpy(log->buf + log->count, chars, count);
+    log->count += count;
+    return 0;
+} /* Log_append */
+
+
+/********************************************************/
+/* Format the output and add it to the calling process's
+ *     buffer.  Not collective.
+ *
+ * Return values:
+ *     1.  0:  output buffered
+ *     2.  LOG_FULL:  output buffered, and the buffer
+ *         should be flushed
+ *     3.  NO_LOG_ATTR:  Clog_open hasn't been called
+ *     4.  NO_LOG_MEM:  the buffer can't grow.  Some or
+ *         all of the output is lost.
+ *
+ * Notes:
+ *     1.  Output from one call is truncated to BUFSIZ-1
+ *         chars.
+ */
+int Clog_printf(
+        MPI_Comm  io_comm  /* in */,
+        char*     format   /* in */,
+                  ...      /* in */) {
+
+    LOG_T*   log;
+    va_list  args;
+    char     prefix[32];
+    char*    line;
+    char*    newline;
+    int      length;
+
+    if ((log = Get_log(io_comm)) == (LOG_T*) NULL)
+        return NO_LOG_ATTR;
+
+    va_start(args, format);
+    vsnprintf(io_buf, BUFSIZ, format, args);
+    va_end(args);
+
+    if (log->flags & LOG_PREFIX) {
+        sprintf(prefix, "Process %d > ", log->my_rank);
+        line = io_buf;
+        while (*line != '\0') {
+            if (log->line_start &&
+                    (Log_append(log, prefix, strlen(prefix)) != 0))
+                return NO_LOG_MEM;
+            newline = strchr(line, '\n');
+            length = (newline == NULL) ? strlen(line) : newline - line + 1;
+            if (Log_append(log, line, length) != 0) {
+                /* Any prefix is in the buffer */
+                log->line_start = 0;
+                return NO_LOG_MEM;
+            }
+            log->line_start = (newline != NULL);
+            line += length;
         }
+    } else {
+        length = strlen(io_buf);
+        if (Log_append(log, io_buf, length) != 0)
+            return NO_LOG_MEM;
+        if (length > 0)
+            log->line_start = (io_buf[length-1] == '\n');
+    }
 
-        /* Copy the output data into io_buf */
-        va_start(args, format);
-        vsprintf(io_buf, format, args);
-        va_end(args);
-        printf("Process %d > %s\n",root, io_buf);
-        fflush(stdout);
+    if (log->count >= log->threshold)
+        return LOG_FULL;
+    return 0;
+} /* Clog_printf */
+
+
+/********************************************************/
+/* Print the buffered output of every process on the I/O
+ *     process, and empty the buffers.  By default the
+ *     buffers are collected with a single MPI_Gatherv and
+ *     printed in rank order.  With LOG_UNORDERED each
+ *     buffer is received and printed as soon as it
+ *     arrives, so the I/O process only needs room for
+ *     one buffer at a time.
+ *
+ * Return values:
+ *     1.  0:  output printed
+ *     2.  NO_IO_ATTR:  no rank cached with IO_KEY
+ *     3.  NO_LOG_ATTR:  Clog_open hasn't been called
+ *
+ * Notes:
+ *     1.  Collective.  Every process must have called
+ *         Clog_open with the same flags.
+ *     2.  An unfinished line is ended, so that the next
+ *         process's output starts on a new line.
+ */
+int Clog_flush(
+        MPI_Comm  io_comm  /* in */) {
+
+    LOG_T*      log;
+    int         root;
+    int         io_p;
+    int         total;
+    int         q, senders;
+    int         count;
+    int         tag;
+    MPI_Status  status;
+
+    if (Get_io_rank(io_comm, &root) == NO_IO_ATTR)
+        return NO_IO_ATTR;
+    if ((log = Get_log(io_comm)) == (LOG_T*) NULL)
+        return NO_LOG_ATTR;
+    MPI_Comm_size(io_comm, &io_p);
+    tag = LOG_TAG + log->epoch % LOG_EPOCHS;
+    log->epoch++;
+
+    if (!log->line_start) {
+        log->buf[log->count++] = '\n';
+        log->line_start = 1;
+    }
 
-        for (q = root+1; q < io_p; q++) {
-            MPI_Recv(io_buf, BUFSIZ, MPI_CHAR, q,
-                0, io_comm, &status);
-            printf("Process %d > %s\n",q, io_buf);
+    if (log->my_rank == root)
+        Get_gather_space(io_p);
+    MPI_Gather(&(log->count), 1, MPI_INT, gather_counts, 1, MPI_INT,
+        root, io_comm);
+
+    if (!(log->flags & LOG_UNORDERED)) {
+        if (log->my_rank == root) {
+            total = Set_displs(io_p);
+            Get_gather_buf(total);
+        }
+        MPI_Gatherv(log->buf, log->count, MPI_CHAR, gather_buf,
+            gather_counts, gather_displs, MPI_CHAR, root, io_comm);
+        if (log->my_rank == root) {
+            fwrite(gather_buf, 1, total, stdout);
             fflush(stdout);
         }
-        printf("\n");
+    } else if (log->my_rank != root) {
+        if (log->count > 0)
+            MPI_Send(log->buf, log->count, MPI_CHAR, root, tag,
+                io_comm);
+    } else {
+        fwrite(log->buf, 1, log->count, stdout);
+        senders = 0;
+        for (q = 0; q < io_p; q++)
+            if ((q != root) && (gather_counts[q] > 0)) senders++;
+        for (q = 0; q < senders; q++) {
+            MPI_Probe(MPI_ANY_SOURCE, tag, io_comm, &status);
+            MPI_Get_count(&status, MPI_CHAR, &count);
+            Get_gather_buf(count);
+            MPI_Recv(gather_buf, count, MPI_CHAR, status.MPI_SOURCE,
+                tag, io_comm, &status);
+            fwrite(gather_buf, 1, count, stdout);
+        }
         fflush(stdout);
     }
 
+    log->count = 0;
     return 0;
-} /* Cprintf */
+} /* Clog_flush */
+
+
+/********************************************************/
+/* Flush if any process's buffer is full.  A cheap call
+ *     for the sync points of a loop:  one MPI_Allreduce
+ *     of a single int unless there's output to print.
+ *
+ * Return values:
+ *     1.  0:  nothing printed
+ *     2.  LOG_FULL:  buffers flushed
+ *     3.  NO_IO_ATTR, NO_LOG_ATTR:  see Clog_flush
+ *
+ * Notes:
+ *     1.  Collective.
+ */
+int Clog_sync(
+        MPI_Comm  io_comm  /* in */) {
+
+    LOG_T*  log;
+    int     full;
+    int     any_full;
+    int     retval;
+
+    if ((log = Get_log(io_comm)) == (LOG_T*) NULL)
+        return NO_LOG_ATTR;
+
+    full = (log->count >= log->threshold);
+    MPI_Allreduce(&full, &any_full, 1, MPI_INT, MPI_LOR, io_comm);
+    if (any_full) {
+        if ((retval = Clog_flush(io_comm)) != 0)
+            return retval;
+        return LOG_FULL;
+    }
+    return 0;
+} /* Clog_sync */
+
+
+/********************************************************/
+/* Flush the buffers and detach them from io_comm.
+ *     Collective.  Return values as for Clog_flush.
+ */
+int Clog_close(
+        MPI_Comm  io_comm  /* in */) {
+
+    int retval;
+
+    if ((retval = Clog_flush(io_comm)) != 0)
+        return retval;
+    MPI_Attr_delete(io_comm, LOG_KEY);
+    return 0;
+} /* Clog_close */
 
 
 /********************************************************/
@@ -49,6 +49,38 @@ int Cprintf(
     char *format /* in */,
     ... /* in */);
 
+/* Buffered output.  Clog_printf appends to a buffer on the     */
+/*     calling process.  Clog_flush, which is collective, prints  */
+/*     every process's buffer on the I/O process.                 */
+#define LOG_PREFIX     1   /* Start each line with "Process q > " */
+#define LOG_UNORDERED  2   /* Print the buffers as they arrive,   */
+                           /*     instead of in rank order        */
+#define LOG_FULL       1   /* Clog_printf:  flush soon            */
+#define NO_LOG_ATTR   -2   /* Clog_open hasn't been called        */
+#define NO_LOG_MEM    -3   /* The buffer can't be allocated or    */
+                           /*     grown                           */
+
+extern int LOG_KEY;
+
+int Clog_open(
+    MPI_Comm io_comm /* in */,
+    int bufsize /* in */,
+    int flags /* in */);
+
+int Clog_printf(
+    MPI_Comm io_comm /* in */,
+    char *format /* in */,
+    ... /* in */);
+
+int Clog_flush(
+    MPI_Comm io_comm /* in */);
+
+int Clog_sync(
+    MPI_Comm io_comm /* in */);
+
+int Clog_close(
+    MPI_Comm io_comm /* in */);
+
 int Cerror_test(
     MPI_Comm io_comm /* in */,
     char *routine_name /* in */,
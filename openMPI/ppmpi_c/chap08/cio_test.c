@@ -91,6 +91,21 @@ main(int argc, char* argv[]) {
         ret_val = Cprintf(duped_comm, "duped_comm read:","%d %f %s", 
            ival, fval, sval);
     }
+    /* Buffered output:  in rank order, then as it arrives */
+    Cerror_test(io_comm_world, "Clog_open",
+        Clog_open(io_comm_world, 64, LOG_PREFIX));
+    for (ival = 0; ival <= my_rank; ival++)
+        if (Clog_printf(io_comm_world, "line %d of %d\n", ival, my_rank+1)
+                == LOG_FULL)
+            break;
+    Clog_printf(io_comm_world, "no newline");
+    Clog_sync(io_comm_world);
+    Clog_close(io_comm_world);
+    Cerror_test(io_comm_world, "Clog_open",
+        Clog_open(io_comm_world, 0, LOG_PREFIX | LOG_UNORDERED));
+    Clog_printf(io_comm_world, "unordered %d\n", my_rank);
+    Clog_close(io_comm_world);
+
     ret_val = Cerror_test(MPI_COMM_WORLD,"main MPI_COMM_WORLD",0);
     ret_val = Cerror_test(io_comm_world,"main io_comm_world",0);
     if (split_key == 0) {
@@ -1,26 +1,49 @@
 /* cyclic_io.c -- Functions for I/O of arrays using a cyclic distribution.
+ *     The arrays can also use a block or a block-cyclic distribution.
+ *
+ * The entries can be read from stdin by the I/O process and scattered,
+ * or read from a binary file with MPI-IO.  Each process's file view
+ * only contains its own entries, so the processes read their entries
+ * directly from the file, with a single collective call.
  *
  * See Chap 8, pp. 158 & ff in PPMPI
  */
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "mpi.h"
 #include "cio.h"
 #include "cyclic_io.h"
 
+static int Any_error(MPI_Comm comm, int error);
+
 
-/* 
- * Initialize all members except entries
+/*
+ * Initialize all members for a cyclic distribution
  */
 void Initialize_params(
          MPI_Comm*      comm   /* in  */,
          int            n      /* in  */,
          CYCLIC_ARRAY_T array  /* out */) {
 
+    Initialize_dist_params(comm, n, CYCLIC, array);
+}  /* Initialize_params */
+
+
+/********************************************************/
+/* Block b, b = Block_size(array), of the array goes to
+ *     process b % p.  local_entries is allocated and
+ *     set to 0, entries isn't allocated.
+ */
+void Initialize_dist_params(
+         MPI_Comm*      comm        /* in  */,
+         int            n           /* in  */,
+         int            block_size  /* in  */,
+         CYCLIC_ARRAY_T array       /* out */) {
+
     int   p;
     int   my_rank;
-    int   q;
-    int   quotient;
+    int   full_rounds;
     int   remainder;
 
     Comm_ptr(array) = comm;
@@ -33,25 +56,51 @@ void Initialize_params(
 
     Order(array) = n;
 
-    quotient = n/p;
-    remainder = n % p;
+    if (block_size == BLOCK)
+        block_size = (n + p - 1)/p;
+    if (block_size < 1)
+        block_size = 1;
+    Block_size(array) = block_size;
+    Stride(array) = p*block_size;
 
+    /* Each round gives every process one block */
+    full_rounds = n/Stride(array);
+    remainder = n % Stride(array);
     if (remainder == 0)
         Padded_size(array) = n;
     else
-        Padded_size(array) = p*(quotient+1);
-    if (my_rank < remainder) {
-        Local_size(array) = quotient+1;
-    } else {
-        Local_size(array) = quotient;
-    }
+        Padded_size(array) = Stride(array)*(full_rounds+1);
+
+    remainder -= my_rank*block_size;
+    if (remainder < 0)
+        remainder = 0;
+    else if (remainder > block_size)
+        remainder = block_size;
+    Local_size(array) = full_rounds*block_size + remainder;
 
-    Stride(array) = p;
+    Entries(array) = (float*) NULL;
+    Local_entries(array) = (float*) calloc(Padded_size(array)/p + 1,
+        sizeof(float));
 
-    Build_cyclic_type( &Type(array), Stride(array), 
+    Build_block_cyclic_type( &Type(array), block_size,
         Padded_size(array), p);
+    MPI_Type_create_resized(Type(array), 0,
+        Padded_size(array)*sizeof(float), &File_type(array));
+    MPI_Type_commit(&File_type(array));
 
-}  /* Initialize_params */
+}  /* Initialize_dist_params */
+
+
+/********************************************************/
+void Free_params(
+         CYCLIC_ARRAY_T array  /* in/out */) {
+
+    free(Entries(array));
+    free(Local_entries(array));
+    Entries(array) = Local_entries(array) = (float*) NULL;
+    MPI_Type_free(&Type(array));
+    MPI_Type_free(&File_type(array));
+}  /* Free_params */
 
 
 /********************************************************/
@@ -62,25 +111,39 @@ void Build_cyclic_type(
          int           p             /* in  */) {
 
     MPI_Datatype  vector_mpi_t;
-    int           blocksizes[2];
-    MPI_Aint      displacements[2];
-    MPI_Datatype  type_list[2];
 
     MPI_Type_vector(array_size/p, 1, stride, MPI_FLOAT,
         &vector_mpi_t);
 
-    blocksizes[0] = blocksizes[1] = 1;
-    displacements[0] = 0;
-    displacements[1] = sizeof(float);
-    type_list[0] = vector_mpi_t;
-    type_list[1] = MPI_UB;
-
-    MPI_Type_struct(2, blocksizes, displacements, type_list,
+    /* Process q's entries start at entry q */
+    MPI_Type_create_resized(vector_mpi_t, 0, sizeof(float),
         cyclic_mpi_t);
     MPI_Type_commit(cyclic_mpi_t);
+    MPI_Type_free(&vector_mpi_t);
 }  /* Build_cyclic_type */
 
 
+/********************************************************/
+/* With block_size = 1, this is the same as Build_cyclic_type */
+void Build_block_cyclic_type(
+         MPI_Datatype* cyclic_mpi_t  /* out */,
+         int           block_size    /* in  */,
+         int           array_size    /* in  */,
+         int           p             /* in  */) {
+
+    MPI_Datatype  vector_mpi_t;
+
+    MPI_Type_vector(array_size/(p*block_size), block_size,
+        p*block_size, MPI_FLOAT, &vector_mpi_t);
+
+    /* Process q's entries start at entry q*block_size */
+    MPI_Type_create_resized(vector_mpi_t, 0, block_size*sizeof(float),
+        cyclic_mpi_t);
+    MPI_Type_commit(cyclic_mpi_t);
+    MPI_Type_free(&vector_mpi_t);
+}  /* Build_block_cyclic_type */
+
+
 /********************************************************/
 void Print_params(
          CYCLIC_ARRAY_T array /* in */) {
@@ -91,6 +154,7 @@ void Print_params(
     Cprintf(Comm(array),"padded size = ", "%d", 
         Padded_size(array));
 
+    Cprintf(Comm(array),"block size","%d", Block_size(array));
     Cprintf(Comm(array),"my size","%d", Local_size(array)); 
     Cprintf(Comm(array),"stride","%d", Stride(array)); 
 
@@ -102,6 +166,8 @@ void Print_params(
  *    this is not the case, appropriate range of
  *    values from entries must be copied into 
  *    local_entries before call to MPI_Gather.
+ *
+ * Column q of the output is process q's local entries.
  */
 void Print_entries(
          char*          title  /* in */,
@@ -109,13 +175,16 @@ void Print_entries(
 
     int root;
     int q;
-    int quotient;
-    int remainder;
-    int i, j, k;
+    int b = Block_size(array);
+    int i, k;
     int send_size;
 
     Get_io_rank(Comm(array), &root);
 
+    if ((Comm_rank(array) == root) && (Entries(array) == (float*) NULL))
+        Entries(array) = (float*) malloc(Padded_size(array)*
+            sizeof(float));
+
     send_size = Padded_size(array)/Comm_size(array);
     MPI_Gather(Local_entries(array), send_size, MPI_FLOAT,
         Entries(array), 1, Type(array), root,
@@ -131,22 +200,18 @@ void Print_entries(
             printf("--------");
         printf("\n");
 
-        quotient = Order(array)/Comm_size(array);
-        remainder = Order(array) % Comm_size(array);
-        k = 0;
-        for (i = 0; i < quotient; i++) {
-            for (j = 0; j < Comm_size(array); j++) {
-                printf("%7.3f ",  Entry(array,k));
-                k++;
+        /* Local entry i of process q is global entry k */
+        for (i = 0; i < send_size; i++) {
+            /* Rows past the end are all padding */
+            if ((i/b)*Stride(array) + i % b >= Order(array))
+                continue;
+            for (q = 0; q < Comm_size(array); q++) {
+                k = (i/b)*Stride(array) + q*b + i % b;
+                if (k < Order(array))
+                    printf("%7.3f ",  Entry(array,k));
             }
             printf("\n");
-            fflush(stdout);
         }
-        for (j = 0; j < remainder; j++) {
-            printf("%7.3f ",  Entry(array,k));
-            k++;
-        }
-        printf("\n");
         fflush(stdout);
     }
 } /* Print_entries */
@@ -169,12 +234,15 @@ void Read_entries(
     Get_io_rank(Comm(array), &root);
 
     if (Comm_rank(array) == root) {
+        if (Entries(array) == (float*) NULL)
+            Entries(array) = (float*) malloc(Padded_size(array)*
+                sizeof(float));
         printf("%s\n",prompt);
         for (i = 0; i < Order(array); i++) {
             scanf("%f", &Entry(array,i));
         }
         /* Skip to end of line */
-        while ((c = getchar()) != '\n');
+        while ((c = getchar()) != '\n' && c != EOF);
         /* Fill padding with 0's */
         for (i = Order(array); i < Padded_size(array); i++)
             Entry(array,i) = 0.0;
@@ -187,3 +255,94 @@ void Read_entries(
         root, Comm(array));
 
 } /* Read_entries */
+
+
+/********************************************************/
+/* Returns the largest error code on any process, so
+ *     every process returns the same value.
+ */
+static int Any_error(
+         MPI_Comm  comm   /* in */,
+         int       error  /* in */) {
+
+    int max_error;
+
+    MPI_Allreduce(&error, &max_error, 1, MPI_INT, MPI_MAX, comm);
+    return max_error;
+}  /* Any_error */
+
+
+/********************************************************/
+/* Each process's view of the file starts at its first
+ *     entry and skips everybody else's, so it reads its
+ *     local entries in a single call.  Every process
+ *     reads Local_size(array) entries:  the padding
+ *     isn't in the file.
+ */
+int Read_file_entries(
+         char*          filename  /* in */,
+         CYCLIC_ARRAY_T  array     /* in */) {
+
+    MPI_File    fh;
+    MPI_Offset  disp;
+    MPI_Status  status;
+    int         count;
+    int         error;
+
+    error = MPI_File_open(Comm(array), filename, MPI_MODE_RDONLY,
+        MPI_INFO_NULL, &fh);
+    /* MPI_File_open fails on every process or on none */
+    if (error != MPI_SUCCESS) return error;
+
+    disp = ((MPI_Offset) Comm_rank(array))*Block_size(array)*
+        sizeof(float);
+    MPI_File_set_view(fh, disp, MPI_FLOAT, File_type(array), "native",
+        MPI_INFO_NULL);
+    error = MPI_File_read_all(fh, Local_entries(array),
+        Local_size(array), MPI_FLOAT, &status);
+    if (error == MPI_SUCCESS) {
+        MPI_Get_count(&status, MPI_FLOAT, &count);
+        if (count != Local_size(array)) error = MPI_ERR_IO;
+    }
+    MPI_File_close(&fh);
+
+    return Any_error(Comm(array), error);
+} /* Read_file_entries */
+
+
+/********************************************************/
+/* The file is truncated to Order(array) entries before
+ *     the processes write their local entries.
+ */
+int Write_file_entries(
+         char*          filename  /* in */,
+         CYCLIC_ARRAY_T  array     /* in */) {
+
+    MPI_File    fh;
+    MPI_Offset  disp;
+    MPI_Status  status;
+    int         error;
+
+    error = MPI_File_open(Comm(array), filename,
+        MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh);
+    /* MPI_File_open fails on every process or on none */
+    if (error != MPI_SUCCESS) return error;
+
+    /* So does MPI_File_set_size */
+    error = MPI_File_set_size(fh,
+        ((MPI_Offset) Order(array))*sizeof(float));
+    if (error != MPI_SUCCESS) {
+        MPI_File_close(&fh);
+        return error;
+    }
+
+    disp = ((MPI_Offset) Comm_rank(array))*Block_size(array)*
+        sizeof(float);
+    MPI_File_set_view(fh, disp, MPI_FLOAT, File_type(array), "native",
+        MPI_INFO_NULL);
+    error = MPI_File_write_all(fh, Local_entries(array),
+        Local_size(array), MPI_FLOAT, &status);
+    MPI_File_close(&fh);
+
+    return Any_error(Comm(array), error);
+} /* Write_file_entries */
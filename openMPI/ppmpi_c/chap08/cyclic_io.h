@@ -7,9 +7,10 @@
 #include "mpi.h"
 #include "cio.h"
 
-#define ENTRIES_MAX 1024
-#define LOCAL_ENTRIES_MAX 1024
-#define PROC_MAX 64
+/* Block sizes for the standard distributions.  Any */
+/*     other positive block size is block-cyclic.   */
+#define BLOCK   0    /* Block size = ceiling(n/p)   */
+#define CYCLIC  1
 
 typedef struct {
     MPI_Comm* comm;          /* Comm for collective ops */
@@ -25,51 +26,91 @@ typedef struct {
     int       global_order;  /* Global size of array    */
 #define Order(array)          ((array)->global_order)
 
-    int       padded_size;  /* Padded array size */
+    int       padded_size;  /* Padded array size:  a multiple */
+                            /* of p*block_size                */
 #define Padded_size(array)   ((array)->padded_size)
 
-    float     entries[ENTRIES_MAX];
-                            /* Elements of the array   */
+    int       block_size;   /* Entries in each block   */
+#define Block_size(array)    ((array)->block_size)
+
+    float*    entries;      /* Elements of the array.  Only  */
+                            /* allocated on the I/O process  */
+                            /* when text I/O needs them      */
 #define Entries(array)        ((array)->entries)
 #define Entry(array,i)        ((array)->entries[i])
 
-    float     local_entries[LOCAL_ENTRIES_MAX]; 
-                            /* Local elements of the array */
+    float*    local_entries;/* Local elements of the array:  */
+                            /* Padded_size/p of them         */
 #define Local_entries(array)  ((array)->local_entries)
 #define Local_entry(array,i)  ((array)->local_entries[i])
 
-    int       local_size;    /* = n/p or n/p + 1        */
+    int       local_size;    /* Number of local entries that */
+                             /* aren't padding               */
 #define Local_size(array)        ((array)->local_size)
 
-    int       stride;        /* Number of elements between two */
-                             /* successive local entries */
+    int       stride;        /* Number of elements between the */
+                             /* starts of two successive local */
+                             /* blocks = p*block_size          */
 #define Stride(array)         ((array)->stride)
 
     MPI_Datatype cyclic_mpi_t;
 #define Type(array)           ((array)->cyclic_mpi_t)
+
+    MPI_Datatype file_mpi_t;  /* Type(array) with extent of */
+                              /* the whole padded array      */
+#define File_type(array)      ((array)->file_mpi_t)
 } CYCLIC_ARRAY_STRUCT;
 
-typedef CYCLIC_ARRAY_STRUCT* CYCLIC_ARRAY_T; 
+typedef CYCLIC_ARRAY_STRUCT* CYCLIC_ARRAY_T;
 
+/* Cyclic distribution */
 void Initialize_params(
-         MPI_Comm*      comm   /* in  */, 
-         int            n      /* in  */, 
+         MPI_Comm*      comm   /* in  */,
+         int            n      /* in  */,
          CYCLIC_ARRAY_T  array  /* out */);
 
+/* Block (block_size = BLOCK), cyclic (block_size = CYCLIC), */
+/*     or block-cyclic distribution                          */
+void Initialize_dist_params(
+         MPI_Comm*      comm        /* in  */,
+         int            n           /* in  */,
+         int            block_size  /* in  */,
+         CYCLIC_ARRAY_T  array       /* out */);
+
+void Free_params(
+         CYCLIC_ARRAY_T  array  /* in/out */);
+
 void Build_cyclic_type(
          MPI_Datatype* cyclic_mpi_t  /* out */,
          int           stride        /* in  */,
          int           array_size    /* in  */,
          int           p             /* in  */);
- 
+
+void Build_block_cyclic_type(
+         MPI_Datatype* cyclic_mpi_t  /* out */,
+         int           block_size    /* in  */,
+         int           array_size    /* in  */,
+         int           p             /* in  */);
+
 void Print_params(
          CYCLIC_ARRAY_T  array  /* in */);
 
 void Print_entries(
          char*          title  /* in */,
-         CYCLIC_ARRAY_T  array  /* in */); 
+         CYCLIC_ARRAY_T  array  /* in */);
 
 void Read_entries(
          char*          prompt  /* in */,
          CYCLIC_ARRAY_T  array   /* in */);
+
+/* Binary files of Order(array) floats in native format.  Collective. */
+/*     Return 0 on success, or an MPI error code on every process if  */
+/*     any process fails.                                             */
+int Read_file_entries(
+         char*          filename  /* in */,
+         CYCLIC_ARRAY_T  array     /* in */);
+
+int Write_file_entries(
+         char*          filename  /* in */,
+         CYCLIC_ARRAY_T  array     /* in */);
 #endif
@@ -1,18 +1,27 @@
 /* sum.c -- add two vectors using cyclic distribution of arrays.  Program
  *     to illustrate use of cyclic_io functions.
  *
+ * Usage:  sum [block_size] [x_file y_file z_file]
+ *
  * Input: 
  *     n:  order of vectors
- *     x, y:  the vectors being added
+ *     x, y:  the vectors being added, from stdin or from the binary
+ *         files x_file and y_file
  *
  * Output:
- *     z: the sum vector
+ *     z: the sum vector, to stdout or to the binary file z_file
  *
- * Notes:  Compile with Makefile.sum
+ * Notes:
+ *     1. Compile with Makefile.sum
+ *     2. block_size 0 is a block distribution, 1 (the default) is
+ *        cyclic, and anything larger is block-cyclic.
+ *     3. The files contain n floats in native format.  See
+ *        Read_file_entries in cyclic_io.c.
  *
  * See Chap 8, pp. 170 & ff in PPMPI
  */
 #include <stdio.h>
+#include <stdlib.h>
 #include "mpi.h"
 
 /* Header file for the basic I/O functions */
@@ -26,6 +35,8 @@ main(int argc, char* argv[]) {
     CYCLIC_ARRAY_STRUCT  y;
     CYCLIC_ARRAY_STRUCT  z;
     int                  n;
+    int                  block_size = CYCLIC;
+    char**               files = NULL;
     MPI_Comm             io_comm;
     int                  i;
 
@@ -37,18 +48,29 @@ main(int argc, char* argv[]) {
             NO_IO_ATTR)
         MPI_Abort(MPI_COMM_WORLD, -1);
 
+    if ((argc == 2) || (argc == 5))
+        block_size = atoi(argv[1]);
+    if (argc >= 4)
+        files = argv + argc - 3;
+
     /* Get n */
     Cscanf(io_comm, "Enter the array order", "%d", &n);
 
     /* Initialize scalar members.  Calls  */
     /* function for building derived type */
-    Initialize_params(&io_comm, n, &x);
-    Initialize_params(&io_comm, n, &y);
-    Initialize_params(&io_comm, n, &z);
+    Initialize_dist_params(&io_comm, n, block_size, &x);
+    Initialize_dist_params(&io_comm, n, block_size, &y);
+    Initialize_dist_params(&io_comm, n, block_size, &z);
 
     /* Get vector elements */
-    Read_entries("Enter elements of x", &x);
-    Read_entries("Enter elements of y", &y);
+    if (files == NULL) {
+        Read_entries("Enter elements of x", &x);
+        Read_entries("Enter elements of y", &y);
+    } else if ((Read_file_entries(files[0], &x) != MPI_SUCCESS) ||
+               (Read_file_entries(files[1], &y) != MPI_SUCCESS)) {
+        Cprintf(io_comm, "", "%s", "Can't read x or y file");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
 
     /* Add local entries */
     for (i = 0; i < Local_size(&x); i++)
@@ -56,7 +78,15 @@ main(int argc, char* argv[]) {
             Local_entry(&x,i) + Local_entry(&y,i);
 
     /* Print z */
-    Print_entries("x + y =", &z);
+    if (files == NULL)
+        Print_entries("x + y =", &z);
+    else if (Write_file_entries(files[2], &z) != MPI_SUCCESS) {
+        Cprintf(io_comm, "", "%s", "Can't write z file");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
 
+    Free_params(&x);
+    Free_params(&y);
+    Free_params(&z);
     MPI_Finalize();
 }
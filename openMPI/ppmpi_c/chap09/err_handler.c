@@ -3,6 +3,10 @@
  * Input: none.
  * Output: Error message from each process.
  *
+ * Note:  Returning errors lets a program report them, but not recover
+ *     its work.  See chap10/checkpoint.c for writing checkpoints that
+ *     a long run can be restarted from.
+ *
  * See Chap 9, pp. 210 & ff in PPMPI.
  */
 
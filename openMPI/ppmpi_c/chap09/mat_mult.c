@@ -21,6 +21,10 @@
  *    2. Local matrices have the form
  *            [my_rank    my_rank+1]
  *            [my_rank+2  my_rank  ]
+ *    3. The messages can arrive in any order, and matrix
+ *       multiplication isn't commutative.  See repro_mat_mult.c
+ *       for a version that always forms the product in the same
+ *       order, and for reproducible matrix products.
  *
  * See Chap 9, pp. 188 & ff in PPMPI
  */
@@ -0,0 +1,293 @@
+/* repro.c -- sums, dot products and matrix products that give the
+ *     same bits for any number of processes and any order of the
+ *     additions.
+ *
+ * Floating point addition isn't associative, so an ordinary parallel
+ *     sum depends on how the terms are split among the processes and
+ *     on the order MPI_Reduce combines the partial sums in -- and the
+ *     MPI standard doesn't fix that order.  Here each sum is split
+ *     into REPRO_FOLDS bins with fixed boundaries (the 1-pass
+ *     "pre-rounding" method of Demmel and Nguyen):
+ *
+ *         1.  Find a bound M on the absolute values of the terms and
+ *             the number of terms n.  Both are the same on every
+ *             process, whatever p is.
+ *         2.  Bin f has a boundary sigma_f = 1.5*2^E_f, where E_0 is
+ *             about log2(M) + log2(n), and each E_f is 51 - log2(n)
+ *             less than the one before.  A term x is split as
+ *                 q = (sigma_f + x) - sigma_f,   x = x - q
+ *             So q is x rounded to a multiple of ulp(sigma_f), and
+ *             the rest goes on to the next bin.
+ *         3.  The q's in a bin are all multiples of the same power of
+ *             2, and there aren't enough of them to overflow 53 bits.
+ *             So every sum of them is exact, in any order.  In
+ *             particular MPI_SUM of the bins is exact, whatever tree
+ *             the MPI implementation uses.
+ *         4.  The result is the sum of the bins, added in a fixed
+ *             order, smallest first.  The bins are the same on every
+ *             run, so the roundings in this sum are too.
+ *
+ * The result isn't the exactly rounded sum, but with 3 bins it keeps
+ *     about 150 - 3*log2(n) bits below log2(M), which is much more
+ *     than the ordinary sum keeps.  The cost is a few flops per term
+ *     per bin, an extra reduction to find M, and REPRO_FOLDS times as
+ *     much data in the final reduction.
+ *
+ * The method needs IEEE double arithmetic:  it doesn't work on x87
+ *     with extended precision, or if the compiler is allowed to
+ *     reassociate (e.g., -ffast-math).  Terms must be smaller than
+ *     about 2^(1000 - log2(n)), and parts of terms below about 2^-1000
+ *     aren't binned.
+ *
+ * See Chap 9, pp. 188 & ff in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "mpi.h"
+#include "repro.h"
+
+/* Bins with smaller boundaries than 2^REPRO_MIN_EXP aren't used */
+#define REPRO_MIN_EXP (-1000)
+
+/*********************************************************************/
+void Repro_bins(
+         double  max_abs   /* in  */,
+         long    n         /* in  */,
+         double  sigma[]   /* out */) {
+    int  e, e_n, E, f;
+
+    if ((max_abs == 0.0) || (n <= 0)) {
+        /* All the terms are 0, and adding them is exact */
+        for (f = 0; f < REPRO_FOLDS; f++)
+            sigma[f] = 0.0;
+        return;
+    }
+
+    frexp(max_abs, &e);      /* max_abs < 2^e */
+    frexp((double) n, &e_n); /* n < 2^e_n     */
+    E = e + e_n + 1;
+    for (f = 0; f < REPRO_FOLDS; f++) {
+        /* sigma = 0 puts the rest of the term in the last bin */
+        sigma[f] = (E > REPRO_MIN_EXP) ? ldexp(1.5, E) : 0.0;
+        E = E - 51 + e_n;
+    }
+}  /* Repro_bins */
+
+
+/*********************************************************************/
+void Repro_deposit(
+         double  x        /* in     */,
+         double  sigma[]  /* in     */,
+         double  fold[]   /* in/out */) {
+    int     f;
+    double  q;
+
+    for (f = 0; f < REPRO_FOLDS; f++) {
+        q = (sigma[f] + x) - sigma[f];
+        fold[f] += q;
+        x -= q;
+    }
+}  /* Repro_deposit */
+
+
+/*********************************************************************/
+/* Smallest bin first */
+double Repro_result(
+           double  fold[]  /* in */) {
+    int     f;
+    double  sum = 0.0;
+
+    for (f = REPRO_FOLDS - 1; f >= 0; f--)
+        sum += fold[f];
+    return sum;
+}  /* Repro_result */
+
+
+/*********************************************************************/
+double Repro_sum(
+           double    x[]   /* in */,
+           int       n     /* in */,
+           MPI_Comm  comm  /* in */) {
+    int     i;
+    long    local_n = n;
+    long    total_n;
+    double  local_max = 0.0;
+    double  max;
+    double  sigma[REPRO_FOLDS];
+    double  fold[REPRO_FOLDS];
+    double  sum[REPRO_FOLDS];
+
+    for (i = 0; i < n; i++)
+        if (fabs(x[i]) > local_max)
+            local_max = fabs(x[i]);
+    MPI_Allreduce(&local_max, &max, 1, MPI_DOUBLE, MPI_MAX, comm);
+    MPI_Allreduce(&local_n, &total_n, 1, MPI_LONG, MPI_SUM, comm);
+
+    Repro_bins(max, total_n, sigma);
+    for (i = 0; i < REPRO_FOLDS; i++)
+        fold[i] = 0.0;
+    for (i = 0; i < n; i++)
+        Repro_deposit(x[i], sigma, fold);
+
+    /* Exact, so the order doesn't matter */
+    MPI_Allreduce(fold, sum, REPRO_FOLDS, MPI_DOUBLE, MPI_SUM, comm);
+    return Repro_result(sum);
+}  /* Repro_sum */
+
+
+/*********************************************************************/
+/* Same, with the terms x[i]*y[i] */
+double Repro_dot(
+           double    x[]   /* in */,
+           double    y[]   /* in */,
+           int       n     /* in */,
+           MPI_Comm  comm  /* in */) {
+    int     i;
+    long    local_n = n;
+    long    total_n;
+    double  local_max = 0.0;
+    double  max;
+    double  sigma[REPRO_FOLDS];
+    double  fold[REPRO_FOLDS];
+    double  sum[REPRO_FOLDS];
+
+    for (i = 0; i < n; i++)
+        if (fabs(x[i]*y[i]) > local_max)
+            local_max = fabs(x[i]*y[i]);
+    MPI_Allreduce(&local_max, &max, 1, MPI_DOUBLE, MPI_MAX, comm);
+    MPI_Allreduce(&local_n, &total_n, 1, MPI_LONG, MPI_SUM, comm);
+
+    Repro_bins(max, total_n, sigma);
+    for (i = 0; i < REPRO_FOLDS; i++)
+        fold[i] = 0.0;
+    for (i = 0; i < n; i++)
+        Repro_deposit(x[i]*y[i], sigma, fold);
+
+    MPI_Allreduce(fold, sum, REPRO_FOLDS, MPI_DOUBLE, MPI_SUM, comm);
+    return Repro_result(sum);
+}  /* Repro_dot */
+
+
+/*********************************************************************/
+/* REPRO_FAST:  each process computes its m x n partial product, and
+ *     MPI_Reduce adds them.  The result depends on p and on the order
+ *     of the reduction.
+ * REPRO_REPRODUCIBLE:  the bound for row i of C is
+ *     max_k |a_ik| * max_kj |b_kj|, which is the same on every process,
+ *     and each process bins its terms a_ik*b_kj.  MPI_Reduce adds the
+ *     REPRO_FOLDS planes of bins exactly.
+ */
+int Kdist_gemm(
+        double    A_local[]  /* in  */,
+        double    B_local[]  /* in  */,
+        double    C[]        /* out */,
+        int       m          /* in  */,
+        int       n          /* in  */,
+        int       local_k    /* in  */,
+        int       mode       /* in  */,
+        int       root       /* in  */,
+        MPI_Comm  comm       /* in  */) {
+    int      my_rank;
+    int      i, j, kk, f;
+    long     mn = ((long) m)*n;
+    long     local_k_l = local_k;
+    long     k;
+    double*  partial;
+    double*  bounds;
+    double*  sigma;
+    double*  s;
+    double*  c_row;
+    double*  b_row;
+    double   a, x, q, b_max;
+    double   fold[REPRO_FOLDS];
+
+    MPI_Comm_rank(comm, &my_rank);
+
+    if (mode == REPRO_FAST) {
+        partial = (double*) malloc((mn + 1)*sizeof(double));
+        if (partial == (double*) NULL) return -1;
+        for (i = 0; i < m; i++) {
+            c_row = partial + ((long) i)*n;
+            for (j = 0; j < n; j++)
+                c_row[j] = 0.0;
+            for (kk = 0; kk < local_k; kk++) {
+                a = A_local[((long) i)*local_k + kk];
+                b_row = B_local + ((long) kk)*n;
+                for (j = 0; j < n; j++)
+                    c_row[j] += a*b_row[j];
+            }
+        }
+        MPI_Reduce(partial, C, (int) mn, MPI_DOUBLE, MPI_SUM, root, comm);
+        free(partial);
+        return 0;
+    }
+
+    partial = (double*) calloc(REPRO_FOLDS*mn + 1, sizeof(double));
+    bounds = (double*) malloc((m + n + 1)*sizeof(double));
+    sigma = (double*) malloc((((long) m)*REPRO_FOLDS + 1)*sizeof(double));
+    if ((partial == (double*) NULL) || (bounds == (double*) NULL) ||
+            (sigma == (double*) NULL)) {
+        free(partial);
+        free(bounds);
+        free(sigma);
+        return -1;
+    }
+
+    /* Largest |a_ik| in each row of A, and |b_kj| in each column of B */
+    for (i = 0; i < m + n; i++)
+        bounds[i] = 0.0;
+    for (i = 0; i < m; i++)
+        for (kk = 0; kk < local_k; kk++)
+            if (fabs(A_local[((long) i)*local_k + kk]) > bounds[i])
+                bounds[i] = fabs(A_local[((long) i)*local_k + kk]);
+    for (kk = 0; kk < local_k; kk++)
+        for (j = 0; j < n; j++)
+            if (fabs(B_local[((long) kk)*n + j]) > bounds[m + j])
+                bounds[m + j] = fabs(B_local[((long) kk)*n + j]);
+    MPI_Allreduce(MPI_IN_PLACE, bounds, m + n, MPI_DOUBLE, MPI_MAX, comm);
+    MPI_Allreduce(&local_k_l, &k, 1, MPI_LONG, MPI_SUM, comm);
+
+    b_max = 0.0;
+    for (j = 0; j < n; j++)
+        if (bounds[m + j] > b_max)
+            b_max = bounds[m + j];
+    for (i = 0; i < m; i++)
+        Repro_bins(bounds[i]*b_max, k, sigma + ((long) i)*REPRO_FOLDS);
+
+    /* Bin f of c_ij is partial[f*mn + i*n + j] */
+    for (i = 0; i < m; i++) {
+        s = sigma + ((long) i)*REPRO_FOLDS;
+        c_row = partial + ((long) i)*n;
+        for (kk = 0; kk < local_k; kk++) {
+            a = A_local[((long) i)*local_k + kk];
+            b_row = B_local + ((long) kk)*n;
+            for (j = 0; j < n; j++) {
+                x = a*b_row[j];
+                for (f = 0; f < REPRO_FOLDS; f++) {
+                    q = (s[f] + x) - s[f];
+                    c_row[f*mn + j] += q;
+                    x -= q;
+                }
+            }
+        }
+    }
+
+    if (my_rank == root) {
+        MPI_Reduce(MPI_IN_PLACE, partial, (int) (REPRO_FOLDS*mn),
+            MPI_DOUBLE, MPI_SUM, root, comm);
+        for (i = 0; i < mn; i++) {
+            for (f = 0; f < REPRO_FOLDS; f++)
+                fold[f] = partial[f*mn + i];
+            C[i] = Repro_result(fold);
+        }
+    } else {
+        MPI_Reduce(partial, (double*) NULL, (int) (REPRO_FOLDS*mn),
+            MPI_DOUBLE, MPI_SUM, root, comm);
+    }
+
+    free(partial);
+    free(bounds);
+    free(sigma);
+    return 0;
+}  /* Kdist_gemm */
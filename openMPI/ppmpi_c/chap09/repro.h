@@ -0,0 +1,46 @@
+/* repro.h -- definitions and declarations for repro.c, sums, dot
+ *     products and matrix products whose results don't depend on the
+ *     number of processes or the order of the additions.
+ *
+ * See repro.c
+ */
+#ifndef REPRO_H
+#define REPRO_H
+
+#include "mpi.h"
+
+/* Number of bins each sum is split into.  Each one holds about */
+/*     52 - log2(n) bits of an n-term sum.                      */
+#ifndef REPRO_FOLDS
+#define REPRO_FOLDS 3
+#endif
+
+/* Modes for Kdist_gemm */
+#define REPRO_FAST          0   /* Ordinary sums and MPI_SUM         */
+#define REPRO_REPRODUCIBLE  1   /* Binned sums:  the same bits for   */
+                                /*     any p and any reduction order */
+
+/* Bin boundaries for a sum of at most n terms, each with absolute   */
+/*     value at most max_abs                                         */
+void   Repro_bins(double max_abs, long n, double sigma[]);
+
+/* Add x to the bins in fold[0], ..., fold[REPRO_FOLDS-1] */
+void   Repro_deposit(double x, double sigma[], double fold[]);
+
+/* The sum in the bins, added in a fixed order */
+double Repro_result(double fold[]);
+
+/* Sum or dot product of vectors distributed among the processes of */
+/*     comm.  Every process gets the result.  Collective.           */
+double Repro_sum(double x[], int n, MPI_Comm comm);
+double Repro_dot(double x[], double y[], int n, MPI_Comm comm);
+
+/* C = A*B, where A is m x k and B is k x n, and each process has a  */
+/*     block of local_k columns of A (A_local, m x local_k) and the  */
+/*     matching rows of B (B_local, local_k x n).  C (m x n) is only */
+/*     computed on root.  All stored by rows.  Collective.  Returns  */
+/*     0, or -1 if memory runs out.                                  */
+int    Kdist_gemm(double A_local[], double B_local[], double C[], int m,
+           int n, int local_k, int mode, int root, MPI_Comm comm);
+
+#endif
@@ -0,0 +1,343 @@
+/* repro_mat_mult.c -- deterministic versions of mat_mult.c:
+ *
+ *     1.  The product of the 2x2 matrices from mat_mult.c, one factor
+ *         from each process, formed with a fixed tree instead of in
+ *         the order the messages arrive.
+ *     2.  C = A*B with the inner dimension k distributed among the
+ *         processes, with the partial products added by MPI_Reduce
+ *         (fast) or by the binned sums in repro.c (reproducible).
+ *     3.  The sum of a vector x and the dot product of x and y, with
+ *         MPI_Allreduce (fast) and with Repro_sum and Repro_dot.
+ *
+ * Input:
+ *     m, k, n:  A is m x k, B is k x n
+ *     reps:  number of times to time each product
+ *
+ * Output:
+ *     The product of the 2x2 matrices.  For each mode of C = A*B, the
+ *     time per product, and a checksum of the bits of C.  Then the
+ *     largest difference between the two C's, relative to max |c_ij|.
+ *     The bits of the fast and the reproducible sum and dot product.
+ *
+ * Notes:
+ *     1.  Matrix multiplication isn't commutative, so the product in
+ *         mat_mult.c is wrong whenever the messages arrive out of
+ *         order.  Here process r receives from r + 2^s at step s, so
+ *         the product is always M_0 M_1 ... M_{p-1}, and it's
+ *         associated the same way on every run with the same p.
+ *     2.  A and B are generated from the global indices of their
+ *         entries, so they're the same for every p.  The entries have
+ *         both signs and magnitudes between 2^-20 and 2^20, so the
+ *         order of the additions matters.
+ *     3.  Process q has columns Block_low(q,p,k), ... of A and the
+ *         matching rows of B.  k needn't be divisible by p.  x and y
+ *         have k entries, generated like A and B and distributed like
+ *         the columns of A.
+ *     4.  The checksum of the fast C and the bits of the fast sum and
+ *         dot product usually change with p; the reproducible ones
+ *         don't.
+ *
+ * See Chap 9, pp. 188 & ff in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "mpi.h"
+#include "repro.h"
+#include "block_dist.h"
+
+#define MATRIX_ORDER 2
+#define ARRAY_ORDER 4
+
+#define Entry(mat,i,j) (mat[MATRIX_ORDER*(i) + (j)])
+
+void          Initialize(float my_matrix[], int my_rank);
+void          Tree_product(float product[], int my_rank, int p,
+                  MPI_Comm comm);
+void          Mult(float product[], float factor[]);
+void          Print_matrix(char* title, float matrix[]);
+double        Generate(long index, int which);
+double        Time_gemm(double A_local[], double B_local[], double C[],
+                  int m, int n, int local_k, int mode, int reps,
+                  int my_rank, MPI_Comm comm);
+unsigned long Checksum(double C[], long count);
+unsigned long long Bits(double x);
+
+/*********************************************************************/
+int main(int argc, char* argv[]) {
+    int      p;
+    int      my_rank;
+    float    product[ARRAY_ORDER];
+    int      dims[4];
+    int      m, k, n, reps;
+    int      local_k, first_k;
+    int      i, j, kk;
+    long     mn;
+    double*  A_local;
+    double*  B_local;
+    double*  C_fast;
+    double*  C_repro;
+    double*  x_local;
+    double*  y_local;
+    double   fast_time, repro_time;
+    double   max_c, max_diff;
+    double   local_sum, local_dot;
+    double   fast_sum, fast_dot, repro_sum, repro_dot;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &p);
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+
+    Initialize(product, my_rank);
+    Tree_product(product, my_rank, p, MPI_COMM_WORLD);
+    if (my_rank == 0)
+        Print_matrix("The product is", product);
+
+    if (my_rank == 0) {
+        printf("Enter m, k, n, and the number of reps\n");
+        scanf("%d %d %d %d", &dims[0], &dims[1], &dims[2], &dims[3]);
+    }
+    MPI_Bcast(dims, 4, MPI_INT, 0, MPI_COMM_WORLD);
+    m = dims[0];
+    k = dims[1];
+    n = dims[2];
+    reps = dims[3];
+    mn = ((long) m)*n;
+
+    first_k = Block_low(my_rank, p, k);
+    local_k = Block_size(my_rank, p, k);
+    A_local = (double*) malloc((((long) m)*local_k + 1)*sizeof(double));
+    B_local = (double*) malloc((((long) local_k)*n + 1)*sizeof(double));
+    C_fast = (double*) malloc((mn + 1)*sizeof(double));
+    C_repro = (double*) malloc((mn + 1)*sizeof(double));
+    x_local = (double*) malloc((local_k + 1)*sizeof(double));
+    y_local = (double*) malloc((local_k + 1)*sizeof(double));
+    if ((A_local == (double*) NULL) || (B_local == (double*) NULL) ||
+            (C_fast == (double*) NULL) || (C_repro == (double*) NULL) ||
+            (x_local == (double*) NULL) || (y_local == (double*) NULL)) {
+        fprintf(stderr, "Process %d > Can't allocate A, B, C, x or y\n",
+            my_rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    for (i = 0; i < m; i++)
+        for (kk = 0; kk < local_k; kk++)
+            A_local[((long) i)*local_k + kk] =
+                Generate(((long) i)*k + first_k + kk, 0);
+    for (kk = 0; kk < local_k; kk++)
+        for (j = 0; j < n; j++)
+            B_local[((long) kk)*n + j] =
+                Generate(((long) first_k + kk)*n + j, 1);
+    for (kk = 0; kk < local_k; kk++) {
+        x_local[kk] = Generate(first_k + kk, 0);
+        y_local[kk] = Generate(first_k + kk, 1);
+    }
+
+    fast_time = Time_gemm(A_local, B_local, C_fast, m, n, local_k,
+        REPRO_FAST, reps, my_rank, MPI_COMM_WORLD);
+    repro_time = Time_gemm(A_local, B_local, C_repro, m, n, local_k,
+        REPRO_REPRODUCIBLE, reps, my_rank, MPI_COMM_WORLD);
+
+    local_sum = local_dot = 0.0;
+    for (kk = 0; kk < local_k; kk++) {
+        local_sum += x_local[kk];
+        local_dot += x_local[kk]*y_local[kk];
+    }
+    MPI_Allreduce(&local_sum, &fast_sum, 1, MPI_DOUBLE, MPI_SUM,
+        MPI_COMM_WORLD);
+    MPI_Allreduce(&local_dot, &fast_dot, 1, MPI_DOUBLE, MPI_SUM,
+        MPI_COMM_WORLD);
+    repro_sum = Repro_sum(x_local, local_k, MPI_COMM_WORLD);
+    repro_dot = Repro_dot(x_local, y_local, local_k, MPI_COMM_WORLD);
+
+    if (my_rank == 0) {
+        max_c = max_diff = 0.0;
+        for (i = 0; i < mn; i++) {
+            if (fabs(C_repro[i]) > max_c)
+                max_c = fabs(C_repro[i]);
+            if (fabs(C_fast[i] - C_repro[i]) > max_diff)
+                max_diff = fabs(C_fast[i] - C_repro[i]);
+        }
+        printf("m = %d, k = %d, n = %d, p = %d, %d folds\n", m, k, n, p,
+            REPRO_FOLDS);
+        printf("%-13s %11s %10s\n", "mode", "time", "checksum");
+        printf("%-13s %11.3e   %08lx\n", "fast", fast_time,
+            Checksum(C_fast, mn));
+        printf("%-13s %11.3e   %08lx\n", "reproducible", repro_time,
+            Checksum(C_repro, mn));
+        printf("Overhead %.2fx, max |fast - reproducible|/max |c| = "
+            "%.3e\n", repro_time/fast_time,
+            (max_c > 0.0) ? max_diff/max_c : max_diff);
+        printf("%-13s %18s %18s\n", "mode", "bits of sum x",
+            "bits of x.y");
+        printf("%-13s   %016llx   %016llx\n", "fast", Bits(fast_sum),
+            Bits(fast_dot));
+        printf("%-13s   %016llx   %016llx\n", "reproducible",
+            Bits(repro_sum), Bits(repro_dot));
+    }
+
+    free(A_local);
+    free(B_local);
+    free(C_fast);
+    free(C_repro);
+    free(x_local);
+    free(y_local);
+    MPI_Finalize();
+    return 0;
+}  /* main */
+
+
+/*********************************************************************/
+/* As in mat_mult.c */
+void Initialize(
+         float  my_matrix[]  /* out */,
+         int    my_rank      /* in  */) {
+
+    my_matrix[0] = my_matrix[3] = (float) my_rank;
+    my_matrix[1] = (float) (my_rank + 1);
+    my_matrix[2] = (float) (my_rank + 2);
+}  /* Initialize */
+
+
+/*********************************************************************/
+/* On entry product is the process's factor.  On return the product
+ *     on process 0 is M_0 M_1 ... M_{p-1}.  At step s = 1, 2, 4, ...,
+ *     a process whose rank is a multiple of 2s receives the product
+ *     of the factors my_rank + s, ..., my_rank + 2s - 1 from
+ *     my_rank + s, and multiplies by it on the right.
+ */
+void Tree_product(
+         float     product[]  /* in/out */,
+         int       my_rank    /* in     */,
+         int       p          /* in     */,
+         MPI_Comm  comm       /* in     */) {
+    int         s;
+    float       temp[ARRAY_ORDER];
+    MPI_Status  status;
+
+    for (s = 1; s < p; s = 2*s) {
+        if (my_rank % (2*s) != 0) {
+            MPI_Send(product, ARRAY_ORDER, MPI_FLOAT, my_rank - s, 0,
+                comm);
+            return;
+        }
+        if (my_rank + s < p) {
+            MPI_Recv(temp, ARRAY_ORDER, MPI_FLOAT, my_rank + s, 0, comm,
+                &status);
+            Mult(product, temp);
+        }
+    }
+}  /* Tree_product */
+
+
+/*********************************************************************/
+/* As in mat_mult.c */
+void Mult(
+         float  product[]  /* in/out */,
+         float  factor[]   /* in     */) {
+    int    i, j, k;
+    float  temp[ARRAY_ORDER];
+
+    for (i = 0; i < MATRIX_ORDER; i++)
+        for (j = 0; j < MATRIX_ORDER; j++) {
+            Entry(temp,i,j) = 0.0;
+            for (k = 0; k < MATRIX_ORDER; k++)
+                Entry(temp,i,j) = Entry(temp,i,j) +
+                    Entry(product,i,k)*Entry(factor,k,j);
+        }
+
+    for (i = 0; i < ARRAY_ORDER; i++)
+        product[i] = temp[i];
+}  /* Mult */
+
+
+/*********************************************************************/
+void Print_matrix(
+         char*  title     /* in */,
+         float  matrix[]  /* in */) {
+    int i, j;
+
+    printf("%s\n", title);
+    for (i = 0; i < MATRIX_ORDER; i++) {
+        for (j = 0; j < MATRIX_ORDER; j++)
+            printf("%f ", Entry(matrix,i,j));
+        printf("\n");
+    }
+}  /* Print_matrix */
+
+
+/*********************************************************************/
+/* Entry index of A (which = 0) or B (which = 1), stored by rows.  A
+ *     32-bit hash of index gives the sign, mantissa and exponent.
+ */
+double Generate(
+           long  index  /* in */,
+           int   which  /* in */) {
+    unsigned long h;
+
+    h = ((unsigned long) (2*index + which)) & 0xffffffffUL;
+    h = ((h >> 16) ^ h)*0x45d9f3bUL & 0xffffffffUL;
+    h = ((h >> 16) ^ h)*0x45d9f3bUL & 0xffffffffUL;
+    h = (h >> 16) ^ h;
+    return ((h & 0xffff)/32768.0 - 1.0)*
+        ldexp(1.0, (int) ((h >> 16) % 41) - 20);
+}  /* Generate */
+
+
+/*********************************************************************/
+/* Slowest process's time per product */
+double Time_gemm(
+           double    A_local[]  /* in  */,
+           double    B_local[]  /* in  */,
+           double    C[]        /* out */,
+           int       m          /* in  */,
+           int       n          /* in  */,
+           int       local_k    /* in  */,
+           int       mode       /* in  */,
+           int       reps       /* in  */,
+           int       my_rank    /* in  */,
+           MPI_Comm  comm       /* in  */) {
+    int     rep;
+    double  start, elapsed, max_elapsed;
+
+    MPI_Barrier(comm);
+    start = MPI_Wtime();
+    for (rep = 0; rep < reps; rep++)
+        if (Kdist_gemm(A_local, B_local, C, m, n, local_k, mode, 0,
+                comm)) {
+            fprintf(stderr, "Process %d > Can't allocate work space\n",
+                my_rank);
+            MPI_Abort(comm, -1);
+        }
+    elapsed = (MPI_Wtime() - start)/reps;
+    MPI_Reduce(&elapsed, &max_elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+    return max_elapsed;
+}  /* Time_gemm */
+
+
+/*********************************************************************/
+/* FNV-1a hash of the bytes of C */
+unsigned long Checksum(
+                  double  C[]    /* in */,
+                  long    count  /* in */) {
+    unsigned char*  bytes = (unsigned char*) C;
+    unsigned long   hash = 2166136261UL;
+    long            i;
+
+    for (i = 0; i < count*((long) sizeof(double)); i++) {
+        hash ^= bytes[i];
+        hash = (hash*16777619UL) & 0xffffffffUL;
+    }
+    return hash;
+}  /* Checksum */
+
+
+/*********************************************************************/
+/* The bits of x, so that printing them doesn't round */
+unsigned long long Bits(
+                       double  x  /* in */) {
+    unsigned long long bits = 0;
+
+    memcpy(&bits, &x, sizeof(double));
+    return bits;
+}  /* Bits */
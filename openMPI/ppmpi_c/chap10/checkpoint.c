@@ -0,0 +1,385 @@
+/* checkpoint.c -- periodic checkpoints of the state of each process of
+ *     an iterative program, written in the background, and restart
+ *     from the newest checkpoint that every process finished.
+ *
+ * The library doesn't know what the state is:  the caller copies it
+ *     into the buffer returned by Ckpt_buffer (with memcpy, MPI_Pack,
+ *     etc.), and Ckpt_restore hands the same bytes back.  A typical
+ *     loop is
+ *
+ *         state = Ckpt_restore(&ckpt, &iter, &bytes);
+ *         if (Ckpt_accept(&ckpt, state != NULL && <state is usable>))
+ *             <unpack state>;
+ *         else
+ *             iter = 0;
+ *         while (!done) {
+ *             iter++;
+ *             <one iteration>
+ *             if (Ckpt_due(&ckpt, iter)) {
+ *                 <pack state into Ckpt_buffer(&ckpt)>
+ *                 Ckpt_commit(&ckpt, iter, bytes);
+ *             }
+ *         }
+ *         Ckpt_free(&ckpt, 1);
+ *
+ * Writes.  Ckpt_commit starts a nonblocking MPI-IO write
+ *     (MPI_File_iwrite_at, or MPI_File_iwrite_at_all into one shared
+ *     file), and returns.  There are two buffers:  while one is being
+ *     written the caller fills the other, so copying the state
+ *     overlaps the previous write.  Before starting a write,
+ *     Ckpt_commit waits for the previous one and calls MPI_File_sync.
+ *     So at most one write is ever in flight.
+ *
+ * Slots.  Checkpoint seq goes to slot seq % 2, so a crash during a
+ *     write can only damage the newer slot, and the older one is
+ *     complete.  Each process's state starts with a header holding
+ *     seq, the caller's iteration number, the size, a checksum of the
+ *     state, and the caller's tag for the problem.  Ckpt_restore reads
+ *     both slots, keeps the ones whose headers and checksums are good,
+ *     and picks the newest seq that's good on every process.  The
+ *     number of processes and the tag must be the same as when the
+ *     checkpoint was written.  If the caller can't use the state,
+ *     Ckpt_accept empties both slots, so an old checkpoint can never
+ *     look newer than the ones the new run writes.
+ *
+ * When.  A checkpoint is due every every_iters iterations, or when
+ *     every_secs seconds have passed since the last one.  The clocks
+ *     of the processes differ, so they vote with MPI_Iallreduce:  the
+ *     vote started in one call to Ckpt_due is read in the next, so the
+ *     processes agree without waiting for each other.
+ *
+ * See Chap 10, pp. 220 & ff in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "mpi.h"
+#include "checkpoint.h"
+
+static unsigned long Checksum(char* data, long bytes);
+static MPI_Offset    Offset(CKPT_T* ckpt);
+static int           Read_slot(CKPT_T* ckpt, int slot,
+                         CKPT_HEADER_T* header);
+static void          Slot_name(CKPT_T* ckpt, int slot, char* name);
+
+/*****************************************************************/
+int Ckpt_init(
+        CKPT_T*   ckpt         /* out */,
+        char*     prefix       /* in  */,
+        int       mode         /* in  */,
+        int       every_iters  /* in  */,
+        double    every_secs   /* in  */,
+        long      max_bytes    /* in  */,
+        long      tag          /* in  */,
+        MPI_Comm  comm         /* in  */) {
+    int   slot, error, all_error;
+    char  name[CKPT_NAME_MAX + 32];
+
+    if ((mode != CKPT_PER_RANK) && (mode != CKPT_SHARED_FILE))
+        return -1;
+    if ((strlen(prefix) >= CKPT_NAME_MAX) || (max_bytes < 0) ||
+            (max_bytes > INT_MAX - CKPT_HEADER_SIZE))
+        return -1;
+
+    memset(ckpt, 0, sizeof(CKPT_T));
+    MPI_Comm_dup(comm, &(ckpt->comm));
+    MPI_Comm_size(ckpt->comm, &(ckpt->p));
+    MPI_Comm_rank(ckpt->comm, &(ckpt->my_rank));
+    strcpy(ckpt->prefix, prefix);
+    ckpt->mode = mode;
+    ckpt->every_iters = every_iters;
+    ckpt->every_secs = every_secs;
+    ckpt->max_bytes = max_bytes;
+    ckpt->tag = tag;
+    ckpt->write_req = ckpt->due_req = MPI_REQUEST_NULL;
+    ckpt->found_seq = -1;
+    ckpt->last_time = MPI_Wtime();
+
+    error = 0;
+    for (slot = 0; slot < 2; slot++) {
+        ckpt->files[slot] = MPI_FILE_NULL;
+        ckpt->bufs[slot] = (char*) malloc(CKPT_HEADER_SIZE + max_bytes);
+        if (ckpt->bufs[slot] == (char*) NULL)
+            error = 1;
+        /* Files return errors by default */
+        Slot_name(ckpt, slot, name);
+        if (MPI_File_open(mode == CKPT_PER_RANK ? MPI_COMM_SELF :
+                    ckpt->comm, name, MPI_MODE_CREATE | MPI_MODE_RDWR,
+                    MPI_INFO_NULL, &(ckpt->files[slot])) != MPI_SUCCESS)
+            error = 1;
+    }
+
+    MPI_Allreduce(&error, &all_error, 1, MPI_INT, MPI_LOR, ckpt->comm);
+    if (all_error) {
+        if (ckpt->my_rank == 0)
+            fprintf(stderr, "Ckpt_init:  can't open %s files\n", prefix);
+        for (slot = 0; slot < 2; slot++) {
+            if (ckpt->files[slot] != MPI_FILE_NULL)
+                MPI_File_close(&(ckpt->files[slot]));
+            free(ckpt->bufs[slot]);
+        }
+        MPI_Comm_free(&(ckpt->comm));
+        return -1;
+    }
+    return 0;
+}  /* Ckpt_init */
+
+
+/*****************************************************************/
+char* Ckpt_restore(
+        CKPT_T*  ckpt       /* in/out */,
+        long*    iter_ptr   /* out    */,
+        long*    bytes_ptr  /* out    */) {
+    CKPT_HEADER_T  headers[2];
+    long           seqs[2];
+    long           newest, oldest, candidate;
+    int            slot, have, all_have, attempt;
+
+    ckpt->found_seq = -1;
+    for (slot = 0; slot < 2; slot++)
+        if (Read_slot(ckpt, slot, &headers[slot]))
+            seqs[slot] = headers[slot].seq;
+        else
+            seqs[slot] = -1;
+    newest = (seqs[0] > seqs[1] ? seqs[0] : seqs[1]);
+    oldest = (seqs[0] > seqs[1] ? seqs[1] : seqs[0]);
+
+    /* Try the newest checkpoint that might be complete everywhere, */
+    /*     and then the one before it                               */
+    for (attempt = 0; attempt < 2; attempt++) {
+        MPI_Allreduce(attempt == 0 ? &newest : &oldest, &candidate, 1,
+            MPI_LONG, MPI_MIN, ckpt->comm);
+        if (candidate < 0)
+            break;
+        have = ((seqs[0] == candidate) || (seqs[1] == candidate));
+        MPI_Allreduce(&have, &all_have, 1, MPI_INT, MPI_LAND,
+            ckpt->comm);
+        if (all_have) {
+            slot = (seqs[0] == candidate ? 0 : 1);
+            ckpt->found_seq = candidate;
+            ckpt->found_slot = slot;
+            *iter_ptr = headers[slot].iter;
+            *bytes_ptr = headers[slot].bytes;
+            return ckpt->bufs[slot] + CKPT_HEADER_SIZE;
+        }
+    }
+    return (char*) NULL;
+}  /* Ckpt_restore */
+
+
+/*****************************************************************/
+int Ckpt_accept(
+        CKPT_T*  ckpt  /* in/out */,
+        int      ok    /* in     */) {
+    int  all_ok, slot;
+
+    ok = (ok && (ckpt->found_seq >= 0));
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, ckpt->comm);
+    if (all_ok) {
+        ckpt->seq = ckpt->found_seq + 1;
+        ckpt->current = 1 - ckpt->found_slot;
+    } else {
+        /* Otherwise checkpoint 0 of this run would be older than */
+        /*     what's left in the other slot                      */
+        ckpt->seq = 0;
+        ckpt->current = 0;
+        for (slot = 0; slot < 2; slot++)
+            MPI_File_set_size(ckpt->files[slot], 0);
+    }
+    ckpt->found_seq = -1;
+    ckpt->last_time = MPI_Wtime();
+    return all_ok;
+}  /* Ckpt_accept */
+
+
+/*****************************************************************/
+int Ckpt_due(
+        CKPT_T*  ckpt  /* in/out */,
+        long     iter  /* in     */) {
+    int        due;
+    MPI_Status status;
+
+    due = ((ckpt->every_iters > 0) && (iter % ckpt->every_iters == 0));
+    if (ckpt->every_secs > 0.0) {
+        /* The last vote only counts if no checkpoint has been */
+        /*     taken since                                    */
+        if (ckpt->due_req != MPI_REQUEST_NULL) {
+            MPI_Wait(&(ckpt->due_req), &status);
+            if (ckpt->due_global && (ckpt->due_seq == ckpt->seq))
+                due = 1;
+        }
+        ckpt->due_local =
+            (MPI_Wtime() - ckpt->last_time >= ckpt->every_secs);
+        ckpt->due_seq = ckpt->seq;
+        MPI_Iallreduce(&(ckpt->due_local), &(ckpt->due_global), 1,
+            MPI_INT, MPI_LOR, ckpt->comm, &(ckpt->due_req));
+    }
+    return due;
+}  /* Ckpt_due */
+
+
+/*****************************************************************/
+char* Ckpt_buffer(
+        CKPT_T*  ckpt  /* in */) {
+    return ckpt->bufs[ckpt->current] + CKPT_HEADER_SIZE;
+}  /* Ckpt_buffer */
+
+
+/*****************************************************************/
+int Ckpt_commit(
+        CKPT_T*  ckpt   /* in/out */,
+        long     iter   /* in     */,
+        long     bytes  /* in     */) {
+    CKPT_HEADER_T  header;
+    char*          buf = ckpt->bufs[ckpt->current];
+    int            slot;
+    MPI_Status     status;
+
+    if ((bytes < 0) || (bytes > ckpt->max_bytes))
+        return -1;
+
+    memset(buf, 0, CKPT_HEADER_SIZE);
+    memset(&header, 0, sizeof(CKPT_HEADER_T));
+    header.magic = CKPT_MAGIC;
+    header.rank = ckpt->my_rank;
+    header.p = ckpt->p;
+    header.seq = ckpt->seq;
+    header.iter = iter;
+    header.bytes = bytes;
+    header.checksum = Checksum(buf + CKPT_HEADER_SIZE, bytes);
+    header.tag = ckpt->tag;
+    memcpy(buf, &header, sizeof(CKPT_HEADER_T));
+
+    /* Finish the last checkpoint before the next one can damage */
+    /*     anything                                              */
+    if (ckpt->write_req != MPI_REQUEST_NULL) {
+        MPI_Wait(&(ckpt->write_req), &status);
+        MPI_File_sync(ckpt->files[ckpt->write_slot]);
+    }
+
+    slot = ckpt->seq % 2;
+    if (ckpt->mode == CKPT_PER_RANK)
+        MPI_File_iwrite_at(ckpt->files[slot], 0, buf,
+            CKPT_HEADER_SIZE + bytes, MPI_BYTE, &(ckpt->write_req));
+    else
+        MPI_File_iwrite_at_all(ckpt->files[slot], Offset(ckpt), buf,
+            CKPT_HEADER_SIZE + bytes, MPI_BYTE, &(ckpt->write_req));
+    ckpt->write_slot = slot;
+    ckpt->seq++;
+    ckpt->last_time = MPI_Wtime();
+    ckpt->current = 1 - ckpt->current;
+    return 0;
+}  /* Ckpt_commit */
+
+
+/*****************************************************************/
+void Ckpt_free(
+        CKPT_T*  ckpt    /* in/out */,
+        int      remove  /* in     */) {
+    int         slot;
+    char        name[CKPT_NAME_MAX + 32];
+    MPI_Status  status;
+
+    if (ckpt->write_req != MPI_REQUEST_NULL) {
+        MPI_Wait(&(ckpt->write_req), &status);
+        MPI_File_sync(ckpt->files[ckpt->write_slot]);
+    }
+    if (ckpt->due_req != MPI_REQUEST_NULL)
+        MPI_Wait(&(ckpt->due_req), &status);
+
+    for (slot = 0; slot < 2; slot++) {
+        MPI_File_close(&(ckpt->files[slot]));
+        free(ckpt->bufs[slot]);
+        ckpt->bufs[slot] = (char*) NULL;
+    }
+    if (remove) {
+        MPI_Barrier(ckpt->comm);
+        for (slot = 0; slot < 2; slot++)
+            if ((ckpt->mode == CKPT_PER_RANK) || (ckpt->my_rank == 0)) {
+                Slot_name(ckpt, slot, name);
+                MPI_File_delete(name, MPI_INFO_NULL);
+            }
+    }
+    MPI_Comm_free(&(ckpt->comm));
+}  /* Ckpt_free */
+
+
+/*****************************************************************/
+/* FNV-1a, 8 bytes at a time */
+static unsigned long Checksum(
+               char*  data   /* in */,
+               long   bytes  /* in */) {
+    unsigned long sum = 14695981039346656037UL;
+    unsigned long word;
+    long          i;
+
+    for (i = 0; i + 8 <= bytes; i += 8) {
+        word = 0;
+        memcpy(&word, data + i, 8);
+        sum = (sum ^ word)*1099511628211UL;
+    }
+    for ( ; i < bytes; i++)
+        sum = (sum ^ (unsigned char) data[i])*1099511628211UL;
+    return sum;
+}  /* Checksum */
+
+
+/*****************************************************************/
+/* Where my header starts in a slot's file */
+static MPI_Offset Offset(
+               CKPT_T*  ckpt  /* in */) {
+    if (ckpt->mode == CKPT_PER_RANK)
+        return 0;
+    else
+        return ((MPI_Offset) ckpt->my_rank)*
+            (CKPT_HEADER_SIZE + ckpt->max_bytes);
+}  /* Offset */
+
+
+/*****************************************************************/
+/* Read a slot into bufs[slot].  Returns 1 if it holds a complete */
+/*     checkpoint written by this process, 0 otherwise.           */
+static int Read_slot(
+               CKPT_T*         ckpt    /* in  */,
+               int             slot    /* in  */,
+               CKPT_HEADER_T*  header  /* out */) {
+    int         count = 0;
+    int         length = CKPT_HEADER_SIZE + ckpt->max_bytes;
+    int         error;
+    MPI_Status  status;
+
+    if (ckpt->mode == CKPT_PER_RANK)
+        error = MPI_File_read_at(ckpt->files[slot], 0, ckpt->bufs[slot],
+            length, MPI_BYTE, &status);
+    else
+        error = MPI_File_read_at_all(ckpt->files[slot], Offset(ckpt),
+            ckpt->bufs[slot], length, MPI_BYTE, &status);
+    if (error != MPI_SUCCESS)
+        return 0;
+    MPI_Get_count(&status, MPI_BYTE, &count);
+    if (count < CKPT_HEADER_SIZE)
+        return 0;
+
+    memcpy(header, ckpt->bufs[slot], sizeof(CKPT_HEADER_T));
+    if ((header->magic != CKPT_MAGIC) || (header->rank != ckpt->my_rank)
+            || (header->p != ckpt->p) || (header->tag != ckpt->tag)
+            || (header->seq < 0)
+            || (header->bytes < 0) || (header->bytes > ckpt->max_bytes)
+            || (CKPT_HEADER_SIZE + header->bytes > count))
+        return 0;
+    return (Checksum(ckpt->bufs[slot] + CKPT_HEADER_SIZE, header->bytes)
+        == header->checksum);
+}  /* Read_slot */
+
+
+/*****************************************************************/
+static void Slot_name(
+               CKPT_T*  ckpt  /* in  */,
+               int      slot  /* in  */,
+               char*    name  /* out */) {
+    if (ckpt->mode == CKPT_PER_RANK)
+        sprintf(name, "%s.%d.%d", ckpt->prefix, ckpt->my_rank, slot);
+    else
+        sprintf(name, "%s.%d", ckpt->prefix, slot);
+}  /* Slot_name */
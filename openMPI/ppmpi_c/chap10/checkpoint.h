@@ -0,0 +1,108 @@
+/* checkpoint.h -- definitions and declarations for checkpoint.c,
+ *     asynchronous checkpoints of the state of each process, and
+ *     restart from the last complete checkpoint.
+ *
+ * See checkpoint.c
+ */
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "mpi.h"
+
+/* Modes */
+#define CKPT_PER_RANK     0   /* One file per process per slot       */
+#define CKPT_SHARED_FILE  1   /* One file per slot, written with     */
+                              /*     collective MPI-IO               */
+
+#define CKPT_NAME_MAX     256
+#define CKPT_MAGIC        0x434b5054   /* "CKPT" */
+
+/* Written before each process's state.  Padded to CKPT_HEADER_SIZE */
+/*     bytes.                                                       */
+typedef struct {
+    int            magic;
+    int            rank;
+    int            p;
+    int            pad;
+    long           seq;        /* Number of the checkpoint, from 0 */
+    long           iter;       /* Caller's iteration number        */
+    long           bytes;      /* Bytes of state that follow       */
+    unsigned long  checksum;   /* Of the state                     */
+    long           tag;        /* Caller's tag for the problem     */
+} CKPT_HEADER_T;
+
+#define CKPT_HEADER_SIZE  64
+
+typedef struct {
+    MPI_Comm     comm;          /* Duplicate of the user's comm     */
+    int          p;
+    int          my_rank;
+    int          mode;
+    char         prefix[CKPT_NAME_MAX];
+    int          every_iters;   /* 0 for no iteration limit         */
+    double       every_secs;    /* 0 for no time limit              */
+    long         max_bytes;     /* Largest state on any process     */
+    long         tag;           /* Identifies the problem           */
+    char*        bufs[2];       /* Header + state.  One is filled   */
+                                /*     while the other is written   */
+    int          current;       /* Buffer returned by Ckpt_buffer   */
+    MPI_File     files[2];      /* Checkpoint seq goes to slot      */
+                                /*     seq % 2                      */
+    MPI_Request  write_req;     /* Write in flight, or              */
+                                /*     MPI_REQUEST_NULL             */
+    int          write_slot;
+    long         seq;           /* Next checkpoint number           */
+    long         found_seq;     /* Found by Ckpt_restore, or -1     */
+    int          found_slot;
+    double       last_time;     /* When the last one was started    */
+    MPI_Request  due_req;       /* Agreement on the time limit      */
+    int          due_local;
+    int          due_global;
+    long         due_seq;       /* seq when due_req was started     */
+} CKPT_T;
+
+/* Open the checkpoint files prefix.<slot> (CKPT_SHARED_FILE) or     */
+/*     prefix.<rank>.<slot> (CKPT_PER_RANK).  A checkpoint is due     */
+/*     every every_iters iterations, or every_secs seconds after the  */
+/*     last one.  No process's state may be larger than max_bytes.    */
+/*     tag identifies the problem (e.g., its size):  a checkpoint     */
+/*     written with a different tag isn't restored.  Collective.      */
+/*     Returns 0, or -1 if the files can't be opened or memory runs   */
+/*     out.                                                           */
+int   Ckpt_init(CKPT_T* ckpt, char* prefix, int mode, int every_iters,
+          double every_secs, long max_bytes, long tag, MPI_Comm comm);
+
+/* Look for the newest checkpoint that's complete on every process.   */
+/*     Returns its state, *iter_ptr and *bytes_ptr, or NULL if there  */
+/*     isn't one.  The state is only valid until the next call to     */
+/*     Ckpt_buffer.  Doesn't change ckpt until Ckpt_accept is called. */
+/*     Collective.                                                    */
+char* Ckpt_restore(CKPT_T* ckpt, long* iter_ptr, long* bytes_ptr);
+
+/* Call after Ckpt_restore, with ok nonzero if this process can use   */
+/*     the state.  If every process can, the next checkpoint follows  */
+/*     the restored one, and it returns 1.  Otherwise the old         */
+/*     checkpoints are discarded, numbering starts again from 0, and  */
+/*     it returns 0.  Collective.                                     */
+int   Ckpt_accept(CKPT_T* ckpt, int ok);
+
+/* Is a checkpoint due after iteration iter?  The same answer on     */
+/*     every process.  Call it at the same iterations on every       */
+/*     process.  Collective.                                         */
+int   Ckpt_due(CKPT_T* ckpt, long iter);
+
+/* The buffer to put the state in:  max_bytes long.  It's not being  */
+/*     written, so filling it overlaps the last checkpoint's write.  */
+char* Ckpt_buffer(CKPT_T* ckpt);
+
+/* Start writing bytes bytes of state from Ckpt_buffer as the state */
+/*     after iteration iter.  Waits for the previous write first, so */
+/*     at most one slot is incomplete at any time.  Collective.     */
+int   Ckpt_commit(CKPT_T* ckpt, long iter, long bytes);
+
+/* Wait for the last write, close the files, and delete them if     */
+/*     remove is nonzero (e.g., after the solver has finished).     */
+/*     Collective.                                                  */
+void  Ckpt_free(CKPT_T* ckpt, int remove);
+
+#endif
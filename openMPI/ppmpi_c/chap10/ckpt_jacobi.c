@@ -0,0 +1,261 @@
+/* ckpt_jacobi.c -- Jacobi's method, as in parallel_jacobi.c, with
+ *     checkpoints written by checkpoint.c.  If it finds a complete
+ *     checkpoint from an earlier run, it continues from there.
+ *
+ * Input:
+ *     n:  order of system
+ *     tol:  convergence tolerance
+ *     max_iter:  maximum number of iterations
+ *     every_iters, every_secs:  how often to checkpoint (0 = never)
+ *     mode:  0 for a file per process, 1 for one shared file
+ *     stop_at:  if > 0, stop after this many iterations, as if the
+ *         job had run out of time
+ *
+ * Output:
+ *     Where the run started, and either where it stopped, or the
+ *     number of iterations, the run time, the maximum error in x,
+ *     and the number of checkpoints written.
+ *
+ * Notes:
+ *     1.  The system is generated as in shared_jacobi.c:  the
+ *         solution is all ones.
+ *     2.  The state of a process is its block of the newest x.
+ *         The checkpoint files are jacobi_ckpt.* in the current
+ *         directory, and they're deleted when the iteration
+ *         converges or reaches max_iter.  Their tag is n, so a run
+ *         with a different n starts from scratch.
+ *     3.  Since the iteration is deterministic, a run that's stopped
+ *         and restarted gives the same x as one that isn't.
+ *
+ * See Chap 10, pp. 220 & ff in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "mpi.h"
+#include "checkpoint.h"
+#include "block_dist.h"
+
+#define Swap(x,y) {float* temp; temp = x; x = y; y = temp;}
+
+#define CKPT_PREFIX "jacobi_ckpt"
+
+void  Generate_system(float A_local[], float b_local[], int n,
+          int first_row, int local_n);
+void  Jacobi_step(float A_local[], float x_old[], float x_local[],
+          float b_local[], int n, int first_row, int local_n);
+float Distance(float x[], float y[], int n);
+float Max_error(float x[], int n);
+
+/*********************************************************************/
+int main(int argc, char* argv[]) {
+    int      p;
+    int      my_rank;
+    int      n, max_iter, every_iters, mode, stop_at;
+    float    tol;
+    double   every_secs;
+    int      input[5];
+    float    real_input[2];
+    int      local_n, q;
+    int*     counts;
+    int*     displs;
+    float*   A_local;
+    float*   b_local;
+    float*   x_local;
+    float*   x_old;
+    float*   x_new;
+    char*    state;
+    long     iter_num, start_iter, bytes;
+    int      converged, stopped;
+    double   start, elapsed;
+    CKPT_T   ckpt;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &p);
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+
+    if (my_rank == 0) {
+        printf("Enter n, tolerance, max iterations, checkpoint every\n");
+        printf("    iterations and every seconds, mode, and stop_at\n");
+        scanf("%d %f %d %d %f %d %d", &input[0], &real_input[0],
+            &input[1], &input[2], &real_input[1], &input[3], &input[4]);
+    }
+    MPI_Bcast(input, 5, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(real_input, 2, MPI_FLOAT, 0, MPI_COMM_WORLD);
+    n = input[0];
+    max_iter = input[1];
+    every_iters = input[2];
+    mode = input[3];
+    stop_at = input[4];
+    tol = real_input[0];
+    every_secs = real_input[1];
+
+    counts = (int*) malloc(p*sizeof(int));
+    displs = (int*) malloc(p*sizeof(int));
+    for (q = 0; q < p; q++) {
+        counts[q] = Block_size(q, p, n);
+        displs[q] = Block_low(q, p, n);
+    }
+    local_n = counts[my_rank];
+    A_local = (float*) malloc(((long) local_n*n + 1)*sizeof(float));
+    b_local = (float*) malloc((local_n + 1)*sizeof(float));
+    x_local = (float*) malloc((local_n + 1)*sizeof(float));
+    x_old = (float*) malloc(n*sizeof(float));
+    x_new = (float*) malloc(n*sizeof(float));
+    if ((A_local == (float*) NULL) || (b_local == (float*) NULL) ||
+            (x_local == (float*) NULL) || (x_old == (float*) NULL) ||
+            (x_new == (float*) NULL)) {
+        fprintf(stderr, "Process %d > Can't allocate A, b or x\n",
+            my_rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    Generate_system(A_local, b_local, n, displs[my_rank], local_n);
+
+    if (Ckpt_init(&ckpt, CKPT_PREFIX, mode, every_iters, every_secs,
+            (long) (n/p + 1)*sizeof(float), (long) n, MPI_COMM_WORLD))
+        MPI_Abort(MPI_COMM_WORLD, -1);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+
+    /* Initialize x:  from the checkpoint, or from b */
+    state = Ckpt_restore(&ckpt, &start_iter, &bytes);
+    if (Ckpt_accept(&ckpt, (state != (char*) NULL) &&
+            (bytes == (long) (local_n*sizeof(float))))) {
+        memcpy(x_local, state, bytes);
+        MPI_Allgatherv(x_local, local_n, MPI_FLOAT, x_new, counts,
+            displs, MPI_FLOAT, MPI_COMM_WORLD);
+    } else {
+        start_iter = 0;
+        MPI_Allgatherv(b_local, local_n, MPI_FLOAT, x_new, counts,
+            displs, MPI_FLOAT, MPI_COMM_WORLD);
+    }
+    if (my_rank == 0) {
+        if (start_iter > 0)
+            printf("Restarted after iteration %ld\n", start_iter);
+        else
+            printf("Started from scratch\n");
+    }
+
+    iter_num = start_iter;
+    converged = stopped = 0;
+    while ((iter_num < max_iter) && !converged && !stopped) {
+        iter_num++;
+        Swap(x_old, x_new);
+        Jacobi_step(A_local, x_old, x_local, b_local, n,
+            displs[my_rank], local_n);
+        MPI_Allgatherv(x_local, local_n, MPI_FLOAT, x_new, counts,
+            displs, MPI_FLOAT, MPI_COMM_WORLD);
+        converged = (Distance(x_new, x_old, n) < tol);
+
+        /* The write goes on during the next iterations */
+        if (!converged && Ckpt_due(&ckpt, iter_num)) {
+            memcpy(Ckpt_buffer(&ckpt), x_local, local_n*sizeof(float));
+            Ckpt_commit(&ckpt, iter_num, local_n*sizeof(float));
+        }
+        if (iter_num == stop_at)
+            stopped = 1;
+    }
+    elapsed = MPI_Wtime() - start;
+
+    if (my_rank == 0) {
+        if (stopped && !converged)
+            printf("Stopped after iteration %ld, %ld checkpoints\n",
+                iter_num, ckpt.seq);
+        else
+            printf("%s after %ld iterations, time %.3e, max error "
+                "%.3e, %ld checkpoints\n", converged ? "Converged" :
+                "Failed to converge", iter_num, elapsed,
+                Max_error(x_new, n), ckpt.seq);
+    }
+    Ckpt_free(&ckpt, !stopped || converged);
+
+    free(A_local);
+    free(b_local);
+    free(x_local);
+    free(x_old);
+    free(x_new);
+    free(counts);
+    free(displs);
+    MPI_Finalize();
+    return 0;
+}  /* main */
+
+
+/*********************************************************************/
+void Generate_system(
+         float  A_local[]  /* out */,
+         float  b_local[]  /* out */,
+         int    n          /* in  */,
+         int    first_row  /* in  */,
+         int    local_n    /* in  */) {
+    int    i_local, i, j;
+    float  sum;
+    float* row;
+
+    for (i_local = 0; i_local < local_n; i_local++) {
+        i = first_row + i_local;
+        row = A_local + ((long) i_local)*n;
+        sum = 0.0;
+        for (j = 0; j < n; j++)
+            if (j != i) {
+                row[j] = 1.0/(1 + abs(i - j));
+                sum += row[j];
+            }
+        row[i] = (sum > 0.0 ? 2.0*sum : 1.0);
+        b_local[i_local] = row[i] + sum;
+    }
+}  /* Generate_system */
+
+
+/*********************************************************************/
+/* x_local = D^-1 (b_local - (A_local - D) x_old) */
+void Jacobi_step(
+         float  A_local[]  /* in  */,
+         float  x_old[]    /* in  */,
+         float  x_local[]  /* out */,
+         float  b_local[]  /* in  */,
+         int    n          /* in  */,
+         int    first_row  /* in  */,
+         int    local_n    /* in  */) {
+    int    i_local, i_global, j;
+    float  sum;
+    float* row;
+
+    for (i_local = 0; i_local < local_n; i_local++) {
+        i_global = first_row + i_local;
+        row = A_local + ((long) i_local)*n;
+        sum = b_local[i_local];
+        for (j = 0; j < i_global; j++)
+            sum -= row[j]*x_old[j];
+        for (j = i_global + 1; j < n; j++)
+            sum -= row[j]*x_old[j];
+        x_local[i_local] = sum/row[i_global];
+    }
+}  /* Jacobi_step */
+
+
+/*********************************************************************/
+float Distance(float x[], float y[], int n) {
+    int i;
+    float sum = 0.0;
+
+    for (i = 0; i < n; i++) {
+        sum = sum + (x[i] - y[i])*(x[i] - y[i]);
+    }
+    return sqrt(sum);
+} /* Distance */
+
+
+/*********************************************************************/
+/* Largest |x_i - 1| */
+float Max_error(float x[], int n) {
+    int   i;
+    float max = 0.0;
+
+    for (i = 0; i < n; i++)
+        if (fabs(x[i] - 1.0) > max)
+            max = fabs(x[i] - 1.0);
+    return max;
+}  /* Max_error */
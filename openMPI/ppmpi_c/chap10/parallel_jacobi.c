@@ -17,6 +17,11 @@
  *     1.  A should be strongly diagonally dominant in
  *         order to insure convergence.
  *     2.  A, x, and b are statically allocated.
+ *     3.  Every process stores the full x vectors.  See
+ *         shared_jacobi.c for a version that keeps one copy per
+ *         node in shared memory.
+ *     4.  See ckpt_jacobi.c for a version that writes checkpoints
+ *         and can be restarted.
  *
  * See Chap 10, pp. 220 & ff in PPMPI.
  */
@@ -0,0 +1,285 @@
+/* shared_buf.c -- keep one copy per node of data that every process
+ *     reads, such as the x vector in parallel_jacobi.c, instead of one
+ *     copy per process.
+ *
+ * The buffer is an MPI-3 shared memory window allocated by
+ *     MPI_Win_allocate_shared on the communicator of the processes on
+ *     a node:  the node leader (rank 0 on the node) allocates all of
+ *     it, and the others get its address with MPI_Win_shared_query.
+ *     So with c processes per node the buffer takes 1/c of the memory
+ *     of replicated copies, and the processes read it with ordinary
+ *     loads.
+ *
+ * Updating the buffer.  Every process holds a passive target epoch
+ *     (MPI_Win_lock_all) on the window from Shared_create to
+ *     Shared_free, and the processes on a node synchronize with
+ *
+ *         MPI_Win_sync;  MPI_Barrier on the node;  MPI_Win_sync
+ *
+ *     which makes stores before the barrier visible to loads after
+ *     it.  Shared_allgather is then
+ *
+ *         1.  Sync, so no one is still reading the old contents.
+ *         2.  Each process stores its block directly in the buffer.
+ *             This replaces the part of MPI_Allgather within a node.
+ *         3.  Sync.
+ *         4.  The leaders exchange their nodes' blocks with
+ *             MPI_Allgatherv on leader_comm.  If the processes on
+ *             each node have adjacent blocks (e.g., consecutive ranks
+ *             with a block distribution), this is done in place in
+ *             the shared buffer.  Otherwise the leaders pack and
+ *             unpack.
+ *         5.  Sync.
+ *
+ *     Shared_bcast is the same, with the root's data copied in step 2
+ *     and MPI_Bcast among the leaders in step 4.
+ *
+ * Nodes are found with MPI_Comm_split_type(MPI_COMM_TYPE_SHARED).
+ *     Define EMULATE_NODE_SIZE=<s> to treat each block of s
+ *     consecutive ranks as a node instead.  Also define
+ *     EMULATE_ROUND_ROBIN to deal the ranks out to the k = ceil(p/s)
+ *     nodes round-robin, so node j has ranks j, j + k, j + 2k, ...,
+ *     and the leaders must pack and unpack.  The processes in an
+ *     emulated node must still be able to share memory.
+ *
+ * See Chap 10, pp. 220 & ff in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+#include "shared_buf.h"
+
+static void Free_arrays(SHARED_BUF_T* buf);
+
+/*****************************************************************/
+int Shared_create(
+        SHARED_BUF_T*  buf     /* out */,
+        int            count   /* in  */,
+        MPI_Datatype   type    /* in  */,
+        int            counts[] /* in  */,
+        MPI_Comm       comm    /* in  */) {
+    int       q, k, prev;
+    int       total, node_total, error;
+    int       leader_rank = 0;
+    int       disp_unit;
+    MPI_Aint  lb, extent, size;
+
+    memset(buf, 0, sizeof(SHARED_BUF_T));
+    MPI_Comm_dup(comm, &(buf->comm));
+    MPI_Comm_size(buf->comm, &(buf->p));
+    MPI_Comm_rank(buf->comm, &(buf->my_rank));
+    buf->count = count;
+    buf->type = type;
+    MPI_Type_get_extent(type, &lb, &extent);
+    buf->elem_size = (int) extent;
+
+#if defined(EMULATE_NODE_SIZE) && defined(EMULATE_ROUND_ROBIN)
+    MPI_Comm_split(buf->comm, buf->my_rank %
+        ((buf->p + EMULATE_NODE_SIZE - 1)/EMULATE_NODE_SIZE),
+        buf->my_rank, &(buf->node_comm));
+#elif defined(EMULATE_NODE_SIZE)
+    MPI_Comm_split(buf->comm, buf->my_rank/EMULATE_NODE_SIZE,
+        buf->my_rank, &(buf->node_comm));
+#else
+    MPI_Comm_split_type(buf->comm, MPI_COMM_TYPE_SHARED, buf->my_rank,
+        MPI_INFO_NULL, &(buf->node_comm));
+#endif
+    MPI_Comm_rank(buf->node_comm, &(buf->node_rank));
+    MPI_Comm_size(buf->node_comm, &(buf->node_size));
+    MPI_Comm_split(buf->comm, (buf->node_rank == 0 ? 0 : MPI_UNDEFINED),
+        buf->my_rank, &(buf->leader_comm));
+    if (buf->node_rank == 0) {
+        MPI_Comm_rank(buf->leader_comm, &leader_rank);
+        MPI_Comm_size(buf->leader_comm, &(buf->nodes));
+    }
+    MPI_Bcast(&leader_rank, 1, MPI_INT, 0, buf->node_comm);
+    MPI_Bcast(&(buf->nodes), 1, MPI_INT, 0, buf->node_comm);
+    buf->my_node = leader_rank;
+
+    /* Which node is each process on? */
+    error = 0;
+    buf->node_of = (int*) malloc(buf->p*sizeof(int));
+    if (buf->node_of == (int*) NULL)
+        error = 1;
+    else
+        MPI_Allgather(&(buf->my_node), 1, MPI_INT, buf->node_of, 1,
+            MPI_INT, buf->comm);
+
+    /* Blocks of each process and each node */
+    if (!error && (counts != (int*) NULL)) {
+        buf->counts = (int*) malloc(buf->p*sizeof(int));
+        buf->displs = (int*) malloc(buf->p*sizeof(int));
+        buf->node_counts = (int*) malloc(buf->nodes*sizeof(int));
+        buf->node_displs = (int*) malloc(buf->nodes*sizeof(int));
+        if ((buf->counts == (int*) NULL) ||
+                (buf->displs == (int*) NULL) ||
+                (buf->node_counts == (int*) NULL) ||
+                (buf->node_displs == (int*) NULL)) {
+            error = 1;
+        } else {
+            total = 0;
+            for (q = 0; q < buf->p; q++) {
+                buf->counts[q] = counts[q];
+                buf->displs[q] = total;
+                total += counts[q];
+            }
+            if (total > count)
+                error = 1;
+
+            /* Node k's blocks are adjacent if each of its processes */
+            /*     starts where the previous one on k ended          */
+            buf->contiguous = 1;
+            for (k = 0; k < buf->nodes; k++)
+                buf->node_counts[k] = 0;
+            for (k = 0; k < buf->nodes; k++) {
+                prev = -1;
+                for (q = 0; q < buf->p; q++)
+                    if (buf->node_of[q] == k) {
+                        if (prev < 0)
+                            buf->node_displs[k] = buf->displs[q];
+                        else if (buf->displs[q] !=
+                                buf->displs[prev] + buf->counts[prev])
+                            buf->contiguous = 0;
+                        buf->node_counts[k] += buf->counts[q];
+                        prev = q;
+                    }
+            }
+            if (!buf->contiguous) {
+                /* Packed blocks are in node order */
+                node_total = 0;
+                for (k = 0; k < buf->nodes; k++) {
+                    buf->node_displs[k] = node_total;
+                    node_total += buf->node_counts[k];
+                }
+                if (buf->node_rank == 0) {
+                    buf->send_buf = (char*) malloc(
+                        (buf->node_counts[buf->my_node] + 1)*
+                        buf->elem_size);
+                    buf->recv_buf = (char*) malloc(
+                        (node_total + 1)*buf->elem_size);
+                    if ((buf->send_buf == (char*) NULL) ||
+                            (buf->recv_buf == (char*) NULL))
+                        error = 1;
+                }
+            }
+        }
+    }
+
+    /* The same on every process, so no one allocates a window */
+    /*     if anyone failed                                    */
+    MPI_Allreduce(MPI_IN_PLACE, &error, 1, MPI_INT, MPI_LOR, buf->comm);
+    if (error) {
+        Free_arrays(buf);
+        return -1;
+    }
+
+    size = (buf->node_rank == 0 ? ((MPI_Aint) count)*buf->elem_size : 0);
+    MPI_Win_allocate_shared(size, buf->elem_size, MPI_INFO_NULL,
+        buf->node_comm, &(buf->base), &(buf->win));
+    MPI_Win_shared_query(buf->win, 0, &size, &disp_unit, &(buf->base));
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, buf->win);
+    return 0;
+}  /* Shared_create */
+
+
+/*****************************************************************/
+void Shared_sync(
+        SHARED_BUF_T*  buf  /* in */) {
+    MPI_Win_sync(buf->win);
+    MPI_Barrier(buf->node_comm);
+    MPI_Win_sync(buf->win);
+}  /* Shared_sync */
+
+
+/*****************************************************************/
+void Shared_allgather(
+        SHARED_BUF_T*  buf    /* in/out */,
+        void*          local  /* in     */) {
+    char* base = (char*) buf->base;
+    int   size = buf->elem_size;
+    int   q, k, offset;
+
+    Shared_sync(buf);
+    memcpy(base + ((long) buf->displs[buf->my_rank])*size, local,
+        ((long) buf->counts[buf->my_rank])*size);
+    Shared_sync(buf);
+
+    if ((buf->node_rank == 0) && (buf->nodes > 1)) {
+        if (buf->contiguous) {
+            MPI_Allgatherv(MPI_IN_PLACE, 0, buf->type, base,
+                buf->node_counts, buf->node_displs, buf->type,
+                buf->leader_comm);
+        } else {
+            offset = 0;
+            for (q = 0; q < buf->p; q++)
+                if (buf->node_of[q] == buf->my_node) {
+                    memcpy(buf->send_buf + ((long) offset)*size,
+                        base + ((long) buf->displs[q])*size,
+                        ((long) buf->counts[q])*size);
+                    offset += buf->counts[q];
+                }
+            MPI_Allgatherv(buf->send_buf, offset, buf->type,
+                buf->recv_buf, buf->node_counts, buf->node_displs,
+                buf->type, buf->leader_comm);
+            for (k = 0; k < buf->nodes; k++) {
+                if (k == buf->my_node) continue;
+                offset = buf->node_displs[k];
+                for (q = 0; q < buf->p; q++)
+                    if (buf->node_of[q] == k) {
+                        memcpy(base + ((long) buf->displs[q])*size,
+                            buf->recv_buf + ((long) offset)*size,
+                            ((long) buf->counts[q])*size);
+                        offset += buf->counts[q];
+                    }
+            }
+        }
+    }
+    Shared_sync(buf);
+}  /* Shared_allgather */
+
+
+/*****************************************************************/
+void Shared_bcast(
+        SHARED_BUF_T*  buf   /* in/out */,
+        void*          data  /* in     */,
+        int            root  /* in     */) {
+    Shared_sync(buf);
+    if (buf->my_rank == root)
+        memcpy(buf->base, data, ((long) buf->count)*buf->elem_size);
+    Shared_sync(buf);
+    if ((buf->node_rank == 0) && (buf->nodes > 1))
+        MPI_Bcast(buf->base, buf->count, buf->type, buf->node_of[root],
+            buf->leader_comm);
+    Shared_sync(buf);
+}  /* Shared_bcast */
+
+
+/*****************************************************************/
+void Shared_free(
+        SHARED_BUF_T*  buf  /* in/out */) {
+    MPI_Win_unlock_all(buf->win);
+    MPI_Win_free(&(buf->win));
+    buf->base = NULL;
+    Free_arrays(buf);
+}  /* Shared_free */
+
+
+/*****************************************************************/
+static void Free_arrays(
+               SHARED_BUF_T*  buf  /* in/out */) {
+    free(buf->node_of);
+    free(buf->counts);
+    free(buf->displs);
+    free(buf->node_counts);
+    free(buf->node_displs);
+    free(buf->send_buf);
+    free(buf->recv_buf);
+    buf->node_of = buf->counts = buf->displs = (int*) NULL;
+    buf->node_counts = buf->node_displs = (int*) NULL;
+    buf->send_buf = buf->recv_buf = (char*) NULL;
+    if (buf->leader_comm != MPI_COMM_NULL)
+        MPI_Comm_free(&(buf->leader_comm));
+    MPI_Comm_free(&(buf->node_comm));
+    MPI_Comm_free(&(buf->comm));
+}  /* Free_arrays */
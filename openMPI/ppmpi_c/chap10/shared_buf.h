@@ -0,0 +1,66 @@
+/* shared_buf.h -- definitions and declarations for shared_buf.c, a
+ *     buffer with one copy per node, shared by the processes on the
+ *     node.
+ *
+ * See shared_buf.c
+ */
+#ifndef SHARED_BUF_H
+#define SHARED_BUF_H
+
+#include "mpi.h"
+
+typedef struct {
+    MPI_Comm      comm;         /* Duplicate of the user's comm      */
+    MPI_Comm      node_comm;    /* Processes on my node              */
+    MPI_Comm      leader_comm;  /* Rank 0 of each node_comm;         */
+                                /*     MPI_COMM_NULL elsewhere       */
+    int           p;
+    int           my_rank;      /* Rank in comm                      */
+    int           node_rank;    /* Rank in node_comm                 */
+    int           node_size;
+    int           nodes;
+    int           my_node;      /* Rank of my leader in leader_comm  */
+    int*          node_of;      /* node_of[q] = node of process q    */
+    MPI_Win       win;
+    void*         base;         /* The buffer:  the same address     */
+                                /*     range on every process of a   */
+                                /*     node is the same memory       */
+    int           count;        /* Elements in the buffer            */
+    MPI_Datatype  type;         /* A predefined type                 */
+    int           elem_size;
+    int*          counts;       /* Shared_allgather:  elements from  */
+    int*          displs;       /*     each process, in rank order   */
+    int           contiguous;   /* 1 if each node's blocks are       */
+                                /*     adjacent                      */
+    int*          node_counts;  /* Elements from each node           */
+    int*          node_displs;
+    char*         send_buf;     /* Leaders, if !contiguous           */
+    char*         recv_buf;
+} SHARED_BUF_T;
+
+#define Shared_base(buf)  ((buf)->base)
+
+/* Allocate a shared buffer of count elements of type on each node.  */
+/*     counts[q] is the number of elements contributed by process q  */
+/*     in Shared_allgather, or counts is NULL if Shared_allgather    */
+/*     won't be used.  Collective on comm.  Returns 0, or -1 if the  */
+/*     counts add up to more than count or memory runs out.          */
+int  Shared_create(SHARED_BUF_T* buf, int count, MPI_Datatype type,
+         int counts[], MPI_Comm comm);
+
+/* Replace the contents of the buffer on every node with the blocks */
+/*     local of the processes, in rank order.  Collective.           */
+void Shared_allgather(SHARED_BUF_T* buf, void* local);
+
+/* Replace the contents of the buffer on every node with the count  */
+/*     elements in data on process root.  data is only used on the  */
+/*     root.  Collective.                                           */
+void Shared_bcast(SHARED_BUF_T* buf, void* data, int root);
+
+/* Make changes by any process on the node visible to the others,   */
+/*     and wait for them.  Collective on the node.                  */
+void Shared_sync(SHARED_BUF_T* buf);
+
+void Shared_free(SHARED_BUF_T* buf);
+
+#endif
@@ -0,0 +1,328 @@
+/* shared_jacobi.c -- Jacobi's method, as in parallel_jacobi.c, with
+ *     the full x vectors kept once per node with shared_buf.c instead
+ *     of once per process.
+ *
+ * Input:
+ *     n:  order of system
+ *     tol:  convergence tolerance
+ *     max_iter:  maximum number of iterations
+ *
+ * Output:
+ *     For the version with replicated x (MPI_Allgatherv) and the
+ *     version with shared x (Shared_allgather):  the number of
+ *     iterations, the run time, the maximum error in x, and the
+ *     bytes used by the two full x vectors on each node.
+ *
+ * Notes:
+ *     1.  A and b are generated, not read:  a_ij = 1/(1 + |i - j|)
+ *         for i != j, the diagonal entries are twice the sum of the
+ *         other entries in their rows, and b = A*(1, 1, ..., 1)^T.
+ *         So the solution is all ones.
+ *     2.  A and b are distributed by block rows, and n needn't be
+ *         divisible by p.
+ *
+ * See Chap 10, pp. 220 & ff in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "mpi.h"
+#include "shared_buf.h"
+#include "block_dist.h"
+
+#define Swap(x,y) {float* temp; temp = x; x = y; y = temp;}
+#define Swap_buf(x,y) {SHARED_BUF_T* temp; temp = x; x = y; y = temp;}
+
+void  Generate_system(float A_local[], float b_local[], int n,
+          int first_row, int local_n);
+int   Jacobi_replicated(float A_local[], float x_local[],
+          float b_local[], int n, float tol, int max_iter, int counts[],
+          int displs[], int my_rank, float* error);
+int   Jacobi_shared(float A_local[], float x_local[], float b_local[],
+          int n, float tol, int max_iter, int counts[], int my_rank,
+          float* error, int* nodes);
+void  Jacobi_step(float A_local[], float x_old[], float x_local[],
+          float b_local[], int n, int first_row, int local_n);
+float Distance(float x[], float y[], int n);
+float Max_error(float x[], int n);
+
+/*********************************************************************/
+int main(int argc, char* argv[]) {
+    int      p;
+    int      my_rank;
+    int      n, max_iter;
+    float    tol;
+    int      local_n, q;
+    int      iters, nodes, node_size;
+    int*     counts;
+    int*     displs;
+    float*   A_local;
+    float*   b_local;
+    float*   x_local;
+    float    error;
+    double   start, elapsed;
+    MPI_Comm node_comm;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &p);
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+
+    if (my_rank == 0) {
+        printf("Enter n, tolerance, and max number of iterations\n");
+        scanf("%d %f %d", &n, &tol, &max_iter);
+    }
+    MPI_Bcast(&n, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&tol, 1, MPI_FLOAT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&max_iter, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    counts = (int*) malloc(p*sizeof(int));
+    displs = (int*) malloc(p*sizeof(int));
+    for (q = 0; q < p; q++) {
+        counts[q] = Block_size(q, p, n);
+        displs[q] = Block_low(q, p, n);
+    }
+    local_n = counts[my_rank];
+    A_local = (float*) malloc(((long) local_n*n + 1)*sizeof(float));
+    b_local = (float*) malloc((local_n + 1)*sizeof(float));
+    x_local = (float*) malloc((local_n + 1)*sizeof(float));
+    if ((A_local == (float*) NULL) || (b_local == (float*) NULL) ||
+            (x_local == (float*) NULL)) {
+        fprintf(stderr, "Process %d > Can't allocate A, b or x\n",
+            my_rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    Generate_system(A_local, b_local, n, displs[my_rank], local_n);
+
+    /* Largest number of processes on a node, for the replicated */
+    /*     memory use                                            */
+#   ifdef EMULATE_NODE_SIZE
+    MPI_Comm_split(MPI_COMM_WORLD, my_rank/EMULATE_NODE_SIZE, my_rank,
+        &node_comm);
+#   else
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, my_rank,
+        MPI_INFO_NULL, &node_comm);
+#   endif
+    MPI_Comm_size(node_comm, &q);
+    MPI_Allreduce(&q, &node_size, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Comm_free(&node_comm);
+
+    if (my_rank == 0)
+        printf("n = %d, %d processes, at most %d per node\n", n, p,
+            node_size);
+    if (my_rank == 0)
+        printf("%-10s %6s %11s %11s %14s\n", "x", "iters", "time",
+            "max error", "x bytes/node");
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+    iters = Jacobi_replicated(A_local, x_local, b_local, n, tol,
+        max_iter, counts, displs, my_rank, &error);
+    elapsed = MPI_Wtime() - start;
+    if (my_rank == 0)
+        printf("%-10s %6d %11.3e %11.3e %14ld\n", "replicated", iters,
+            elapsed, error, 2L*n*sizeof(float)*node_size);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+    iters = Jacobi_shared(A_local, x_local, b_local, n, tol, max_iter,
+        counts, my_rank, &error, &nodes);
+    elapsed = MPI_Wtime() - start;
+    if (my_rank == 0)
+        printf("%-10s %6d %11.3e %11.3e %14ld  (%d nodes)\n", "shared",
+            iters, elapsed, error, 2L*n*sizeof(float), nodes);
+
+    if ((my_rank == 0) && (iters > max_iter))
+        printf("Failed to converge in %d iterations\n", max_iter);
+
+    free(A_local);
+    free(b_local);
+    free(x_local);
+    free(counts);
+    free(displs);
+    MPI_Finalize();
+    return 0;
+}  /* main */
+
+
+/*********************************************************************/
+void Generate_system(
+         float  A_local[]  /* out */,
+         float  b_local[]  /* out */,
+         int    n          /* in  */,
+         int    first_row  /* in  */,
+         int    local_n    /* in  */) {
+    int    i_local, i, j;
+    float  sum;
+    float* row;
+
+    for (i_local = 0; i_local < local_n; i_local++) {
+        i = first_row + i_local;
+        row = A_local + ((long) i_local)*n;
+        sum = 0.0;
+        for (j = 0; j < n; j++)
+            if (j != i) {
+                row[j] = 1.0/(1 + abs(i - j));
+                sum += row[j];
+            }
+        row[i] = (sum > 0.0 ? 2.0*sum : 1.0);
+        b_local[i_local] = row[i] + sum;
+    }
+}  /* Generate_system */
+
+
+/*********************************************************************/
+/* Return the number of iterations, or max_iter + 1 if the iteration */
+/*     didn't converge.  Every process has both full vectors.        */
+int Jacobi_replicated(
+        float  A_local[]  /* in  */,
+        float  x_local[]  /* out */,
+        float  b_local[]  /* in  */,
+        int    n          /* in  */,
+        float  tol        /* in  */,
+        int    max_iter   /* in  */,
+        int    counts[]   /* in  */,
+        int    displs[]   /* in  */,
+        int    my_rank    /* in  */,
+        float* error      /* out */) {
+    int     iter_num;
+    float*  x_old;
+    float*  x_new;
+    float*  x_temp1;
+    float*  x_temp2;
+    int     converged;
+
+    x_temp1 = (float*) malloc(n*sizeof(float));
+    x_temp2 = (float*) malloc(n*sizeof(float));
+
+    /* Initialize x */
+    MPI_Allgatherv(b_local, counts[my_rank], MPI_FLOAT, x_temp1,
+        counts, displs, MPI_FLOAT, MPI_COMM_WORLD);
+    x_new = x_temp1;
+    x_old = x_temp2;
+
+    iter_num = 0;
+    do {
+        iter_num++;
+        Swap(x_old, x_new);
+        Jacobi_step(A_local, x_old, x_local, b_local, n,
+            displs[my_rank], counts[my_rank]);
+        MPI_Allgatherv(x_local, counts[my_rank], MPI_FLOAT, x_new,
+            counts, displs, MPI_FLOAT, MPI_COMM_WORLD);
+        converged = (Distance(x_new, x_old, n) < tol);
+    } while ((iter_num < max_iter) && !converged);
+
+    *error = Max_error(x_new, n);
+    free(x_temp1);
+    free(x_temp2);
+    return (converged ? iter_num : max_iter + 1);
+}  /* Jacobi_replicated */
+
+
+/*********************************************************************/
+/* Same, with the full vectors in shared buffers */
+int Jacobi_shared(
+        float  A_local[]  /* in  */,
+        float  x_local[]  /* out */,
+        float  b_local[]  /* in  */,
+        int    n          /* in  */,
+        float  tol        /* in  */,
+        int    max_iter   /* in  */,
+        int    counts[]   /* in  */,
+        int    my_rank    /* in  */,
+        float* error      /* out */,
+        int*   nodes      /* out */) {
+    int            iter_num;
+    int            first_row;
+    int            q;
+    int            converged;
+    SHARED_BUF_T   bufs[2];
+    SHARED_BUF_T*  x_old;
+    SHARED_BUF_T*  x_new;
+
+    if (Shared_create(&bufs[0], n, MPI_FLOAT, counts, MPI_COMM_WORLD) ||
+            Shared_create(&bufs[1], n, MPI_FLOAT, counts,
+                MPI_COMM_WORLD)) {
+        fprintf(stderr, "Process %d > Can't create shared buffers\n",
+            my_rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    *nodes = bufs[0].nodes;
+    first_row = 0;
+    for (q = 0; q < my_rank; q++)
+        first_row += counts[q];
+
+    /* Initialize x */
+    Shared_allgather(&bufs[0], b_local);
+    x_new = &bufs[0];
+    x_old = &bufs[1];
+
+    iter_num = 0;
+    do {
+        iter_num++;
+        /* Shared_allgather waits until everyone is done reading */
+        /*     x_new's old contents before it overwrites them     */
+        Swap_buf(x_old, x_new);
+        Jacobi_step(A_local, (float*) Shared_base(x_old), x_local,
+            b_local, n, first_row, counts[my_rank]);
+        Shared_allgather(x_new, x_local);
+        converged = (Distance((float*) Shared_base(x_new),
+            (float*) Shared_base(x_old), n) < tol);
+    } while ((iter_num < max_iter) && !converged);
+
+    *error = Max_error((float*) Shared_base(x_new), n);
+    Shared_free(&bufs[0]);
+    Shared_free(&bufs[1]);
+    return (converged ? iter_num : max_iter + 1);
+}  /* Jacobi_shared */
+
+
+/*********************************************************************/
+/* x_local = D^-1 (b_local - (A_local - D) x_old) */
+void Jacobi_step(
+         float  A_local[]  /* in  */,
+         float  x_old[]    /* in  */,
+         float  x_local[]  /* out */,
+         float  b_local[]  /* in  */,
+         int    n          /* in  */,
+         int    first_row  /* in  */,
+         int    local_n    /* in  */) {
+    int    i_local, i_global, j;
+    float  sum;
+    float* row;
+
+    for (i_local = 0; i_local < local_n; i_local++) {
+        i_global = first_row + i_local;
+        row = A_local + ((long) i_local)*n;
+        sum = b_local[i_local];
+        for (j = 0; j < i_global; j++)
+            sum -= row[j]*x_old[j];
+        for (j = i_global + 1; j < n; j++)
+            sum -= row[j]*x_old[j];
+        x_local[i_local] = sum/row[i_global];
+    }
+}  /* Jacobi_step */
+
+
+/*********************************************************************/
+float Distance(float x[], float y[], int n) {
+    int i;
+    float sum = 0.0;
+
+    for (i = 0; i < n; i++) {
+        sum = sum + (x[i] - y[i])*(x[i] - y[i]);
+    }
+    return sqrt(sum);
+} /* Distance */
+
+
+/*********************************************************************/
+/* Largest |x_i - 1| */
+float Max_error(float x[], int n) {
+    int   i;
+    float max = 0.0;
+
+    for (i = 0; i < n; i++)
+        if (fabs(x[i] - 1.0) > max)
+            max = fabs(x[i] - 1.0);
+    return max;
+}  /* Max_error */
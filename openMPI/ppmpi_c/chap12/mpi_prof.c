@@ -0,0 +1,2116 @@
+/* mpi_prof.c -- a profiling library built on MPI's profiling interface.
+ *     Generalizes ./send.c to the point-to-point, completion,
+ *     collective and one-sided calls.  Link it ahead of the MPI
+ *     library, e.g.,
+ *
+ *         mpicc -c -O2 mpi_prof.c
+ *         ar rcs libmpi_prof.a mpi_prof.o
+ *         mpicc -o prog prog.o -L. -lmpi_prof
+ *
+ *     The program needs no changes and no recompiling:  just relink.
+ *
+ * Input:
+ *     MPI_PROF_PREFIX:  environment variable giving the prefix of the
+ *         output files (default "mpi_prof")
+ *     MPI_Pcontrol(0) stops collecting, MPI_Pcontrol(1) restarts, and
+ *         MPI_Pcontrol(2) zeroes everything collected so far.
+ * Output (written by MPI_Finalize):
+ *     <prefix>.<rank>:  for each communicator and window used by the
+ *         process, and for each call, the number of calls, bytes,
+ *         seconds, and a histogram of message sizes; and the number
+ *         of messages and bytes exchanged with each peer.
+ *     <prefix>.summary:  for each call, the total calls and bytes,
+ *         and the min, mean and max over the processes of the time
+ *         spent in it, in decreasing order of mean time.
+ *     <prefix>.bytes, <prefix>.msgs:  the communication matrix.  Row
+ *         i, column j is the number of bytes (messages) that process
+ *         i sent to process j, by point-to-point or one-sided calls.
+ *         Ranks are ranks in MPI_COMM_WORLD.
+ *
+ * Notes:
+ *     1.  The bytes of a call are the bytes this process contributes:
+ *         the send buffer of sends and collectives, the data received
+ *         by MPI_Recv (from its status), and the origin buffer of
+ *         one-sided calls.  The histogram bucket for b > 0 bytes is
+ *         2^(k-1) <= b < 2^k.
+ *     2.  Requests carry no communicator, so the completion calls and
+ *         MPI_Start(all) are counted under the "requests" entry.  But
+ *         the requests of MPI_Irecv, MPI_Send_init and MPI_Recv_init
+ *         are kept in a table with their communicator, peer and size.
+ *         A persistent send is credited with its bytes and peer each
+ *         time it's started.  A receive is credited when a completion
+ *         call returns it, with the size and source in its status, so
+ *         MPI_ANY_SOURCE receives reach the right peer.  For these
+ *         three calls the histogram counts messages, not calls.
+ *     3.  Each communicator and window gets its counters the first
+ *         time it's used.  They're found through a cached attribute,
+ *         and the last one used is remembered, so the fast path is a
+ *         pointer compare and a few additions.  The counters are
+ *         per process and take no locks.  With MPI_THREAD_MULTIPLE,
+ *         calls could update them concurrently, so the library
+ *         turns itself off.
+ *     4.  Communication matrix rows are sent to process 0 one at a
+ *         time, so no process needs storage for the whole matrix.
+ *
+ * See Chap 12, pp. 271 & ff in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+
+/* The calls profiled */
+enum {
+    /* Point-to-point */
+    P_SEND, P_BSEND, P_SSEND, P_RSEND, P_ISEND, P_IBSEND, P_ISSEND,
+    P_IRSEND, P_RECV, P_IRECV, P_SENDRECV, P_SENDRECV_REPLACE, P_PROBE,
+    P_IPROBE, P_SEND_INIT, P_RECV_INIT, P_START, P_STARTALL,
+    /* Completion */
+    P_WAIT, P_WAITALL, P_WAITANY, P_WAITSOME, P_TEST, P_TESTALL,
+    P_TESTANY, P_TESTSOME, P_REQUEST_FREE,
+    /* Collectives */
+    P_BARRIER, P_BCAST, P_REDUCE, P_ALLREDUCE, P_GATHER, P_GATHERV,
+    P_SCATTER, P_SCATTERV, P_ALLGATHER, P_ALLGATHERV, P_ALLTOALL,
+    P_ALLTOALLV, P_ALLTOALLW, P_REDUCE_SCATTER, P_REDUCE_SCATTER_BLOCK, P_SCAN,
+    P_EXSCAN, P_IBARRIER, P_IBCAST, P_IREDUCE, P_IALLREDUCE, P_IGATHER,
+    P_ISCATTER, P_IALLGATHER, P_IALLTOALL,
+    /* One-sided */
+    P_WIN_CREATE, P_WIN_ALLOCATE, P_WIN_ALLOCATE_SHARED, P_WIN_FREE,
+    P_PUT, P_GET, P_ACCUMULATE, P_GET_ACCUMULATE, P_FETCH_AND_OP,
+    P_COMPARE_AND_SWAP, P_WIN_FENCE, P_WIN_LOCK, P_WIN_UNLOCK,
+    P_WIN_LOCK_ALL, P_WIN_UNLOCK_ALL, P_WIN_FLUSH, P_WIN_FLUSH_ALL,
+    P_WIN_POST, P_WIN_START, P_WIN_COMPLETE, P_WIN_WAIT,
+    CALL_COUNT
+};
+
+static char* call_names[CALL_COUNT] = {
+    "MPI_Send", "MPI_Bsend", "MPI_Ssend", "MPI_Rsend", "MPI_Isend",
+    "MPI_Ibsend", "MPI_Issend", "MPI_Irsend", "MPI_Recv", "MPI_Irecv",
+    "MPI_Sendrecv", "MPI_Sendrecv_replace", "MPI_Probe", "MPI_Iprobe",
+    "MPI_Send_init", "MPI_Recv_init", "MPI_Start", "MPI_Startall",
+    "MPI_Wait", "MPI_Waitall", "MPI_Waitany", "MPI_Waitsome", "MPI_Test",
+    "MPI_Testall", "MPI_Testany", "MPI_Testsome", "MPI_Request_free",
+    "MPI_Barrier", "MPI_Bcast", "MPI_Reduce", "MPI_Allreduce",
+    "MPI_Gather", "MPI_Gatherv", "MPI_Scatter", "MPI_Scatterv",
+    "MPI_Allgather", "MPI_Allgatherv", "MPI_Alltoall", "MPI_Alltoallv",
+    "MPI_Alltoallw",
+    "MPI_Reduce_scatter", "MPI_Reduce_scatter_block", "MPI_Scan",
+    "MPI_Exscan", "MPI_Ibarrier", "MPI_Ibcast", "MPI_Ireduce",
+    "MPI_Iallreduce", "MPI_Igather", "MPI_Iscatter", "MPI_Iallgather",
+    "MPI_Ialltoall",
+    "MPI_Win_create", "MPI_Win_allocate", "MPI_Win_allocate_shared",
+    "MPI_Win_free", "MPI_Put", "MPI_Get", "MPI_Accumulate",
+    "MPI_Get_accumulate", "MPI_Fetch_and_op", "MPI_Compare_and_swap",
+    "MPI_Win_fence", "MPI_Win_lock", "MPI_Win_unlock", "MPI_Win_lock_all",
+    "MPI_Win_unlock_all", "MPI_Win_flush", "MPI_Win_flush_all",
+    "MPI_Win_post", "MPI_Win_start", "MPI_Win_complete", "MPI_Win_wait"
+};
+
+#define HIST_BUCKETS 32     /* 0 bytes, then powers of 2 up to 2^30 */
+#define NAME_LEN     MPI_MAX_OBJECT_NAME
+
+/* Kinds of PROF_REC_T */
+#define REQUESTS     0
+#define COMM         1
+#define WINDOW       2
+
+/* Directions for Add_peer */
+#define OUT          0      /* Sent to the peer                 */
+#define IN           1      /* Received from the peer           */
+#define FETCH        2      /* Read from the peer by MPI_Get &c */
+
+/* Counters for one communicator or window */
+typedef struct {
+    int     id;                  /* Order of first use          */
+    int     kind;
+    char    name[NAME_LEN];
+    int     size;                /* Remote size for intercomms  */
+    int     freed;
+    int*    world_ranks;         /* MPI_COMM_WORLD rank of each */
+                                 /*     (remote) rank           */
+    double  calls[CALL_COUNT];
+    double  bytes[CALL_COUNT];
+    double  time[CALL_COUNT];
+    double  hist[CALL_COUNT][HIST_BUCKETS];
+    double* peers;               /* Messages out, bytes out,    */
+                                 /*     messages in, bytes in,  */
+                                 /*     for each rank           */
+} PROF_REC_T;
+
+/* A request of MPI_Irecv, MPI_Send_init or MPI_Recv_init */
+typedef struct {
+    MPI_Request  request;
+    PROF_REC_T*  rec;            /* Its communicator's counters */
+    int          call;
+    int          peer;           /* Of a persistent send        */
+    double       bytes;          /* Of a persistent send        */
+    int          active;         /* Started and not completed   */
+} REQ_REC_T;
+
+static int          prof_on = 0;
+static int          prof_disabled = 0;  /* By MPI_THREAD_MULTIPLE */
+static PROF_REC_T** recs = (PROF_REC_T**) NULL;
+static int          rec_count = 0;
+static int          rec_max = 0;
+static PROF_REC_T*  requests_rec;
+static REQ_REC_T*   req_recs = (REQ_REC_T*) NULL;
+static int          req_count = 0;
+static int          req_max = 0;
+
+/* Attribute keys and the last communicator and window used */
+static int          comm_key = MPI_KEYVAL_INVALID;
+static int          win_key = MPI_KEYVAL_INVALID;
+static MPI_Comm     last_comm = MPI_COMM_NULL;
+static PROF_REC_T*  last_comm_rec;
+static MPI_Win      last_win = MPI_WIN_NULL;
+static PROF_REC_T*  last_win_rec;
+
+/* Messages and bytes to (and fetched from) each process in */
+/*     MPI_COMM_WORLD, interleaved:  2*q = bytes, 2*q+1 = msgs */
+static int          world_size;
+static int          world_rank;
+static MPI_Group    world_group;
+static double*      world_out;
+static double*      world_fetched;
+static double       init_time;
+
+/* The library's own messages at MPI_Finalize go on a duplicate of */
+/*     MPI_COMM_WORLD, so they can't match the program's receives  */
+static MPI_Comm     prof_comm = MPI_COMM_NULL;
+
+/* Scratch copies of the requests and statuses for the completion */
+/*     calls.  They grow as needed, and are freed at MPI_Finalize.  */
+static MPI_Request* saved_reqs = (MPI_Request*) NULL;
+static MPI_Status*  saved_statuses = (MPI_Status*) NULL;
+static int          saved_max = 0;
+
+#define PROF_START  double prof_time = PMPI_Wtime()
+#define PROF_STOP   prof_time = PMPI_Wtime() - prof_time
+
+static void         Prof_init(int thread_level);
+static PROF_REC_T*  New_rec(int kind, char* name, MPI_Group group);
+static PROF_REC_T*  Comm_rec(MPI_Comm comm);
+static PROF_REC_T*  Win_rec(MPI_Win win);
+static int          Comm_delete(MPI_Comm comm, int keyval, void* attr,
+                        void* extra);
+static int          Win_delete(MPI_Win win, int keyval, void* attr,
+                        void* extra);
+static double       Bytes(int count, MPI_Datatype datatype);
+static double       Sum_bytes(const int counts[], MPI_Datatype datatype,
+                        MPI_Comm comm);
+static int          Bucket(double bytes);
+static void         Record(PROF_REC_T* rec, int call, double bytes,
+                        double time);
+static void         Add_peer(PROF_REC_T* rec, int peer, double bytes,
+                        int dir);
+static void         Comm_call(int call, MPI_Comm comm, double bytes,
+                        double time);
+static void         P2p_call(int call, MPI_Comm comm, int peer,
+                        double bytes, int dir, double time);
+static void         Win_call(int call, MPI_Win win, int peer,
+                        double bytes, int dir, double time);
+static void         Req_call(int call, double time);
+static PROF_REC_T*  Post_call(int call, MPI_Comm comm, double time);
+static void         Add_message(PROF_REC_T* rec, int call, int peer,
+                        double bytes, int dir);
+static void         Add_request(MPI_Request request, PROF_REC_T* rec,
+                        int call, int peer, double bytes, int active);
+static int          Find_request(MPI_Request request);
+static void         Started(MPI_Request request);
+static void         Completed(MPI_Request request, MPI_Status* status);
+static void         Forget(MPI_Request request);
+static MPI_Request* Save_requests(int count, MPI_Request requests[]);
+static MPI_Status*  Statuses(MPI_Status statuses[], MPI_Request* saved);
+static void         Zero_counters(void);
+static void         Write_process(char* prefix, double wall_time);
+static void         Write_summary(char* prefix, double wall_time);
+static void         Write_matrix(char* prefix);
+
+
+/*==================================================================*/
+/* Initialization, MPI_Pcontrol and MPI_Finalize                    */
+/*==================================================================*/
+int MPI_Init(int* argc, char*** argv) {
+    int rv;
+
+    rv = PMPI_Init(argc, argv);
+    Prof_init(MPI_THREAD_SINGLE);
+    return rv;
+}  /* MPI_Init */
+
+
+int MPI_Init_thread(int* argc, char*** argv, int required,
+        int* provided) {
+    int rv;
+
+    rv = PMPI_Init_thread(argc, argv, required, provided);
+    Prof_init(*provided);
+    return rv;
+}  /* MPI_Init_thread */
+
+
+/********************************************************************/
+static void Prof_init(
+         int  thread_level  /* in */) {
+
+    init_time = PMPI_Wtime();
+    PMPI_Comm_size(MPI_COMM_WORLD, &world_size);
+    PMPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+    PMPI_Comm_group(MPI_COMM_WORLD, &world_group);
+    PMPI_Comm_dup(MPI_COMM_WORLD, &prof_comm);
+    world_out = (double*) calloc(2*world_size, sizeof(double));
+    world_fetched = (double*) calloc(2*world_size, sizeof(double));
+
+    PMPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, Comm_delete,
+        &comm_key, NULL);
+    PMPI_Win_create_keyval(MPI_WIN_NULL_COPY_FN, Win_delete,
+        &win_key, NULL);
+    requests_rec = New_rec(REQUESTS, "requests", MPI_GROUP_EMPTY);
+
+    if (thread_level == MPI_THREAD_MULTIPLE) {
+        if (world_rank == 0)
+            fprintf(stderr, "mpi_prof:  MPI_THREAD_MULTIPLE, %s\n",
+                "profiling is off");
+        prof_disabled = 1;
+    }
+    prof_on = !prof_disabled;
+}  /* Prof_init */
+
+
+/********************************************************************/
+/* MPI_Pcontrol(1) can't turn on a library that MPI_THREAD_MULTIPLE
+ *     turned off.
+ */
+int MPI_Pcontrol(const int level, ...) {
+
+    if (level == 0)
+        prof_on = 0;
+    else if (level == 1)
+        prof_on = !prof_disabled;
+    else if (level == 2)
+        Zero_counters();
+    return MPI_SUCCESS;
+}  /* MPI_Pcontrol */
+
+
+/********************************************************************/
+int MPI_Finalize(void) {
+    char*  prefix;
+    double wall_time;
+    int    rv;
+
+    prof_on = 0;
+    wall_time = PMPI_Wtime() - init_time;
+    prefix = getenv("MPI_PROF_PREFIX");
+    if (prefix == (char*) NULL) prefix = "mpi_prof";
+
+    Write_process(prefix, wall_time);
+    Write_summary(prefix, wall_time);
+    Write_matrix(prefix);
+
+    /* The attribute delete functions run in PMPI_Finalize */
+    PMPI_Comm_free_keyval(&comm_key);
+    PMPI_Win_free_keyval(&win_key);
+    PMPI_Group_free(&world_group);
+    PMPI_Comm_free(&prof_comm);
+    rv = PMPI_Finalize();
+
+    for (; rec_count > 0; rec_count--) {
+        free(recs[rec_count-1]->world_ranks);
+        free(recs[rec_count-1]->peers);
+        free(recs[rec_count-1]);
+    }
+    free(recs);
+    free(req_recs);
+    req_count = req_max = 0;
+    free(saved_reqs);
+    free(saved_statuses);
+    saved_max = 0;
+    free(world_out);
+    free(world_fetched);
+    return rv;
+}  /* MPI_Finalize */
+
+
+/*==================================================================*/
+/* Counters                                                         */
+/*==================================================================*/
+static PROF_REC_T* New_rec(
+         int        kind   /* in */,
+         char*      name   /* in */,
+         MPI_Group  group  /* in */) {
+    PROF_REC_T* rec;
+    int*        ranks;
+    int         q;
+
+    if (rec_count == rec_max) {
+        rec_max = (rec_max == 0) ? 16 : 2*rec_max;
+        recs = (PROF_REC_T**) realloc(recs, rec_max*sizeof(PROF_REC_T*));
+    }
+    rec = (PROF_REC_T*) calloc(1, sizeof(PROF_REC_T));
+    recs[rec_count] = rec;
+    rec->id = rec_count++;
+    rec->kind = kind;
+    strncpy(rec->name, name, NAME_LEN - 1);
+
+    PMPI_Group_size(group, &rec->size);
+    ranks = (int*) malloc((rec->size + 1)*sizeof(int));
+    rec->world_ranks = (int*) malloc((rec->size + 1)*sizeof(int));
+    for (q = 0; q < rec->size; q++)
+        ranks[q] = q;
+    if (rec->size > 0)
+        PMPI_Group_translate_ranks(group, rec->size, ranks, world_group,
+            rec->world_ranks);
+    free(ranks);
+    rec->peers = (double*) calloc(4*rec->size + 1, sizeof(double));
+    return rec;
+}  /* New_rec */
+
+
+/********************************************************************/
+/* Counters are attached to the communicator the first time it's used.
+ *     For an intercommunicator the peers are in the remote group.
+ */
+static PROF_REC_T* Comm_rec(
+         MPI_Comm  comm  /* in */) {
+    PROF_REC_T* rec;
+    MPI_Group   group;
+    char        name[NAME_LEN];
+    int         len;
+    int         flag;
+
+    if (comm == last_comm) return last_comm_rec;
+
+    PMPI_Comm_get_attr(comm, comm_key, &rec, &flag);
+    if (!flag) {
+        PMPI_Comm_test_inter(comm, &flag);
+        if (flag)
+            PMPI_Comm_remote_group(comm, &group);
+        else
+            PMPI_Comm_group(comm, &group);
+        PMPI_Comm_get_name(comm, name, &len);
+        rec = New_rec(COMM, name, group);
+        PMPI_Group_free(&group);
+        PMPI_Comm_set_attr(comm, comm_key, rec);
+    }
+    last_comm = comm;
+    last_comm_rec = rec;
+    return rec;
+}  /* Comm_rec */
+
+
+/********************************************************************/
+static PROF_REC_T* Win_rec(
+         MPI_Win  win  /* in */) {
+    PROF_REC_T* rec;
+    MPI_Group   group;
+    char        name[NAME_LEN];
+    int         len;
+    int         flag;
+
+    if (win == last_win) return last_win_rec;
+
+    PMPI_Win_get_attr(win, win_key, &rec, &flag);
+    if (!flag) {
+        PMPI_Win_get_group(win, &group);
+        PMPI_Win_get_name(win, name, &len);
+        rec = New_rec(WINDOW, name, group);
+        PMPI_Group_free(&group);
+        PMPI_Win_set_attr(win, win_key, rec);
+    }
+    last_win = win;
+    last_win_rec = rec;
+    return rec;
+}  /* Win_rec */
+
+
+/********************************************************************/
+/* The counters outlive the communicator:  they're written at
+ *     MPI_Finalize.  But the handle may be reused.
+ */
+static int Comm_delete(
+         MPI_Comm  comm    /* in */,
+         int       keyval  /* in */,
+         void*     attr    /* in */,
+         void*     extra   /* in */) {
+
+    (void) keyval;
+    (void) extra;
+    ((PROF_REC_T*) attr)->freed = 1;
+    if (comm == last_comm) last_comm = MPI_COMM_NULL;
+    return MPI_SUCCESS;
+}  /* Comm_delete */
+
+
+/********************************************************************/
+static int Win_delete(
+         MPI_Win  win     /* in */,
+         int      keyval  /* in */,
+         void*    attr    /* in */,
+         void*    extra   /* in */) {
+
+    (void) keyval;
+    (void) extra;
+    ((PROF_REC_T*) attr)->freed = 1;
+    if (win == last_win) last_win = MPI_WIN_NULL;
+    return MPI_SUCCESS;
+}  /* Win_delete */
+
+
+/********************************************************************/
+static double Bytes(
+         int           count     /* in */,
+         MPI_Datatype  datatype  /* in */) {
+    int size;
+
+    if (count <= 0) return 0.0;
+    PMPI_Type_size(datatype, &size);
+    return ((double) count)*size;
+}  /* Bytes */
+
+
+/********************************************************************/
+/* Bytes in counts[0], ..., counts[p-1] elements of datatype */
+static double Sum_bytes(
+         const int     counts[]  /* in */,
+         MPI_Datatype  datatype  /* in */,
+         MPI_Comm      comm      /* in */) {
+    int    p;
+    int    q;
+    double sum = 0.0;
+
+    if (!prof_on) return 0.0;
+    PMPI_Comm_size(comm, &p);
+    for (q = 0; q < p; q++)
+        sum += counts[q];
+    return sum*Bytes(1, datatype);
+}  /* Sum_bytes */
+
+
+/********************************************************************/
+static int Bucket(
+         double  bytes  /* in */) {
+    int    b;
+    double bound = 1.0;
+
+    if (bytes < 1.0) return 0;
+    for (b = 1; (b < HIST_BUCKETS - 1) && (bytes >= 2.0*bound); b++)
+        bound *= 2.0;
+    return b;
+}  /* Bucket */
+
+
+/********************************************************************/
+static void Record(
+         PROF_REC_T*  rec    /* in/out */,
+         int          call   /* in     */,
+         double       bytes  /* in     */,
+         double       time   /* in     */) {
+
+    rec->calls[call] += 1.0;
+    rec->bytes[call] += bytes;
+    rec->time[call] += time;
+    rec->hist[call][Bucket(bytes)] += 1.0;
+}  /* Record */
+
+
+/********************************************************************/
+/* peer is a rank in rec's group.  MPI_PROC_NULL and MPI_ANY_SOURCE
+ *     are ignored.
+ */
+static void Add_peer(
+         PROF_REC_T*  rec    /* in/out */,
+         int          peer   /* in     */,
+         double       bytes  /* in     */,
+         int          dir    /* in     */) {
+    int q;
+
+    if ((peer < 0) || (peer >= rec->size)) return;
+    if (dir == OUT) {
+        rec->peers[4*peer] += 1.0;
+        rec->peers[4*peer+1] += bytes;
+    } else {
+        rec->peers[4*peer+2] += 1.0;
+        rec->peers[4*peer+3] += bytes;
+    }
+
+    q = rec->world_ranks[peer];
+    if (q == MPI_UNDEFINED) return;
+    if (dir == OUT) {
+        world_out[2*q] += bytes;
+        world_out[2*q+1] += 1.0;
+    } else if (dir == FETCH) {
+        world_fetched[2*q] += bytes;
+        world_fetched[2*q+1] += 1.0;
+    }
+}  /* Add_peer */
+
+
+/********************************************************************/
+static void Comm_call(
+         int       call   /* in */,
+         MPI_Comm  comm   /* in */,
+         double    bytes  /* in */,
+         double    time   /* in */) {
+
+    if (!prof_on || (comm == MPI_COMM_NULL)) return;
+    Record(Comm_rec(comm), call, bytes, time);
+}  /* Comm_call */
+
+
+/********************************************************************/
+static void P2p_call(
+         int       call   /* in */,
+         MPI_Comm  comm   /* in */,
+         int       peer   /* in */,
+         double    bytes  /* in */,
+         int       dir    /* in */,
+         double    time   /* in */) {
+    PROF_REC_T* rec;
+
+    if (!prof_on || (comm == MPI_COMM_NULL)) return;
+    rec = Comm_rec(comm);
+    Record(rec, call, bytes, time);
+    Add_peer(rec, peer, bytes, dir);
+}  /* P2p_call */
+
+
+/********************************************************************/
+static void Win_call(
+         int      call   /* in */,
+         MPI_Win  win    /* in */,
+         int      peer   /* in */,
+         double   bytes  /* in */,
+         int      dir    /* in */,
+         double   time   /* in */) {
+    PROF_REC_T* rec;
+
+    if (!prof_on || (win == MPI_WIN_NULL)) return;
+    rec = Win_rec(win);
+    Record(rec, call, bytes, time);
+    Add_peer(rec, peer, bytes, dir);
+}  /* Win_call */
+
+
+/********************************************************************/
+static void Req_call(
+         int     call  /* in */,
+         double  time  /* in */) {
+
+    if (!prof_on) return;
+    Record(requests_rec, call, 0.0, time);
+}  /* Req_call */
+
+
+/********************************************************************/
+/* A call whose bytes are credited later, by Add_message.  Returns the
+ *     communicator's counters, or NULL if the call isn't recorded.
+ */
+static PROF_REC_T* Post_call(
+         int       call   /* in */,
+         MPI_Comm  comm   /* in */,
+         double    time   /* in */) {
+    PROF_REC_T* rec;
+
+    if (!prof_on || (comm == MPI_COMM_NULL)) return (PROF_REC_T*) NULL;
+    rec = Comm_rec(comm);
+    rec->calls[call] += 1.0;
+    rec->time[call] += time;
+    return rec;
+}  /* Post_call */
+
+
+/********************************************************************/
+static void Add_message(
+         PROF_REC_T*  rec    /* in/out */,
+         int          call   /* in     */,
+         int          peer   /* in     */,
+         double       bytes  /* in     */,
+         int          dir    /* in     */) {
+
+    rec->bytes[call] += bytes;
+    rec->hist[call][Bucket(bytes)] += 1.0;
+    Add_peer(rec, peer, bytes, dir);
+}  /* Add_message */
+
+
+/*==================================================================*/
+/* The request table.  It's searched linearly:  it only holds the   */
+/*     receives in flight and the persistent requests, and when     */
+/*     it's empty the completion calls skip it.                     */
+/*==================================================================*/
+static void Add_request(
+         MPI_Request  request  /* in */,
+         PROF_REC_T*  rec      /* in */,
+         int          call     /* in */,
+         int          peer     /* in */,
+         double       bytes    /* in */,
+         int          active   /* in */) {
+    REQ_REC_T* new_recs;
+
+    if (req_count == req_max) {
+        new_recs = (REQ_REC_T*) realloc(req_recs,
+            ((req_max == 0) ? 16 : 2*req_max)*sizeof(REQ_REC_T));
+        if (new_recs == (REQ_REC_T*) NULL) return;
+        req_recs = new_recs;
+        req_max = (req_max == 0) ? 16 : 2*req_max;
+    }
+    req_recs[req_count].request = request;
+    req_recs[req_count].rec = rec;
+    req_recs[req_count].call = call;
+    req_recs[req_count].peer = peer;
+    req_recs[req_count].bytes = bytes;
+    req_recs[req_count].active = active;
+    req_count++;
+}  /* Add_request */
+
+
+/********************************************************************/
+static int Find_request(
+        MPI_Request  request  /* in */) {
+    int i;
+
+    if (request == MPI_REQUEST_NULL) return -1;
+    for (i = req_count - 1; i >= 0; i--)
+        if (req_recs[i].request == request) return i;
+    return -1;
+}  /* Find_request */
+
+
+/********************************************************************/
+/* A persistent send is credited when it's started */
+static void Started(
+         MPI_Request  request  /* in */) {
+    REQ_REC_T* r;
+    int        i;
+
+    if ((i = Find_request(request)) < 0) return;
+    r = &req_recs[i];
+    r->active = 1;
+    if (prof_on && (r->call == P_SEND_INIT))
+        Add_message(r->rec, r->call, r->peer, r->bytes, OUT);
+}  /* Started */
+
+
+/********************************************************************/
+/* request has completed with status.  A receive is credited now,
+ *     unless status is MPI_STATUS_IGNORE.  A nonblocking receive's
+ *     request is gone, so its entry goes too.
+ */
+static void Completed(
+         MPI_Request  request  /* in */,
+         MPI_Status*  status   /* in */) {
+    REQ_REC_T* r;
+    int        i;
+    int        bytes = 0;
+    int        cancelled = 0;
+
+    if ((req_count == 0) || ((i = Find_request(request)) < 0)) return;
+    r = &req_recs[i];
+    if (prof_on && r->active && (r->call != P_SEND_INIT) &&
+            (status != MPI_STATUS_IGNORE)) {
+        PMPI_Test_cancelled(status, &cancelled);
+        if (!cancelled) {
+            PMPI_Get_count(status, MPI_BYTE, &bytes);
+            Add_message(r->rec, r->call, status->MPI_SOURCE,
+                (double) bytes, IN);
+        }
+    }
+    r->active = 0;
+    if (r->call == P_IRECV)
+        req_recs[i] = req_recs[--req_count];
+}  /* Completed */
+
+
+/********************************************************************/
+static void Forget(
+         MPI_Request  request  /* in */) {
+    int i;
+
+    if ((i = Find_request(request)) >= 0)
+        req_recs[i] = req_recs[--req_count];
+}  /* Forget */
+
+
+/********************************************************************/
+/* Completed requests are set to MPI_REQUEST_NULL, so the completion
+ *     calls look them up in a copy, saved_reqs.  NULL if there's
+ *     nothing to look up, or the copy can't grow.  The completion
+ *     calls don't nest, so one copy is enough.
+ */
+static MPI_Request* Save_requests(
+         int          count       /* in */,
+         MPI_Request  requests[]  /* in */) {
+    MPI_Request* new_reqs;
+    MPI_Status*  new_statuses;
+    int          new_max;
+
+    if ((req_count == 0) || (count <= 0)) return (MPI_Request*) NULL;
+    if (count > saved_max) {
+        new_max = (count > 2*saved_max) ? count : 2*saved_max;
+        new_reqs = (MPI_Request*) realloc(saved_reqs,
+            new_max*sizeof(MPI_Request));
+        if (new_reqs == (MPI_Request*) NULL) return (MPI_Request*) NULL;
+        saved_reqs = new_reqs;
+        new_statuses = (MPI_Status*) realloc(saved_statuses,
+            new_max*sizeof(MPI_Status));
+        if (new_statuses == (MPI_Status*) NULL)
+            return (MPI_Request*) NULL;
+        saved_statuses = new_statuses;
+        saved_max = new_max;
+    }
+    memcpy(saved_reqs, requests, count*sizeof(MPI_Request));
+    return saved_reqs;
+}  /* Save_requests */
+
+
+/********************************************************************/
+/* The statuses to pass to MPI:  the caller's, or if the caller passed
+ *     MPI_STATUSES_IGNORE and there are saved requests to look up,
+ *     saved_statuses, which Save_requests made long enough.
+ */
+static MPI_Status* Statuses(
+         MPI_Status    statuses[]  /* in */,
+         MPI_Request*  saved       /* in */) {
+
+    if ((statuses != MPI_STATUSES_IGNORE) || (saved == (MPI_Request*) NULL))
+        return statuses;
+    return saved_statuses;
+}  /* Statuses */
+
+
+/********************************************************************/
+static void Zero_counters(void) {
+    PROF_REC_T* rec;
+    int         i;
+
+    for (i = 0; i < rec_count; i++) {
+        rec = recs[i];
+        memset(rec->calls, 0, CALL_COUNT*sizeof(double));
+        memset(rec->bytes, 0, CALL_COUNT*sizeof(double));
+        memset(rec->time, 0, CALL_COUNT*sizeof(double));
+        memset(rec->hist, 0, CALL_COUNT*HIST_BUCKETS*sizeof(double));
+        memset(rec->peers, 0, 4*rec->size*sizeof(double));
+    }
+    memset(world_out, 0, 2*world_size*sizeof(double));
+    memset(world_fetched, 0, 2*world_size*sizeof(double));
+}  /* Zero_counters */
+
+
+/*==================================================================*/
+/* Output                                                           */
+/*==================================================================*/
+static void Write_process(
+         char*   prefix     /* in */,
+         double  wall_time  /* in */) {
+    char        file_name[1024];
+    char        host[MPI_MAX_PROCESSOR_NAME];
+    FILE*       fp;
+    PROF_REC_T* rec;
+    double      mpi_time = 0.0;
+    int         len;
+    int         i, call, b, q;
+    static char* kinds[] = {"requests", "comm", "window"};
+
+    for (i = 0; i < rec_count; i++)
+        for (call = 0; call < CALL_COUNT; call++)
+            mpi_time += recs[i]->time[call];
+
+    sprintf(file_name, "%.1000s.%d", prefix, world_rank);
+    fp = fopen(file_name, "w");
+    if (fp == (FILE*) NULL) {
+        fprintf(stderr, "mpi_prof:  Process %d > Can't open %s\n",
+            world_rank, file_name);
+        return;
+    }
+    PMPI_Get_processor_name(host, &len);
+    fprintf(fp, "# Process %d of %d on %s\n", world_rank, world_size,
+        host);
+    fprintf(fp, "# %.6f seconds from MPI_Init to MPI_Finalize, "
+        "%.6f in MPI\n", wall_time, mpi_time);
+
+    fprintf(fp, "\n# Communicators and windows\nid,kind,name,size,freed\n");
+    for (i = 0; i < rec_count; i++) {
+        rec = recs[i];
+        fprintf(fp, "%d,%s,%s,%d,%d\n", rec->id, kinds[rec->kind],
+            rec->name, rec->size, rec->freed);
+    }
+
+    /* Histogram columns are labelled by the smallest size in the bucket */
+    fprintf(fp, "\n# Calls\nid,call,calls,bytes,seconds,0");
+    for (b = 1; b < HIST_BUCKETS; b++)
+        fprintf(fp, ",%.0f", (double) (1L << (b-1)));
+    fprintf(fp, "\n");
+    for (i = 0; i < rec_count; i++) {
+        rec = recs[i];
+        for (call = 0; call < CALL_COUNT; call++) {
+            if (rec->calls[call] == 0.0) continue;
+            fprintf(fp, "%d,%s,%.0f,%.0f,%.6f", rec->id, call_names[call],
+                rec->calls[call], rec->bytes[call], rec->time[call]);
+            for (b = 0; b < HIST_BUCKETS; b++)
+                fprintf(fp, ",%.0f", rec->hist[call][b]);
+            fprintf(fp, "\n");
+        }
+    }
+
+    fprintf(fp, "\n# Peers\n%s\n",
+        "id,peer,world_rank,msgs_out,bytes_out,msgs_in,bytes_in");
+    for (i = 0; i < rec_count; i++) {
+        rec = recs[i];
+        for (q = 0; q < rec->size; q++) {
+            if ((rec->peers[4*q] == 0.0) && (rec->peers[4*q+2] == 0.0))
+                continue;
+            fprintf(fp, "%d,%d,%d,%.0f,%.0f,%.0f,%.0f\n", rec->id, q,
+                rec->world_ranks[q], rec->peers[4*q], rec->peers[4*q+1],
+                rec->peers[4*q+2], rec->peers[4*q+3]);
+        }
+    }
+    fclose(fp);
+}  /* Write_process */
+
+
+/********************************************************************/
+/* Process 0 writes the totals for each call over all the
+ *     communicators and processes, most expensive first.
+ */
+static void Write_summary(
+         char*   prefix     /* in */,
+         double  wall_time  /* in */) {
+    double  local[3*CALL_COUNT+1];  /* calls, bytes, time, then wall */
+    double  sum[3*CALL_COUNT+1];
+    double  min_time[CALL_COUNT];
+    double  max_time[CALL_COUNT];
+    int     order[CALL_COUNT];
+    char    file_name[1024];
+    FILE*   fp;
+    double  mean;
+    int     i, call, j, t;
+
+    memset(local, 0, (3*CALL_COUNT+1)*sizeof(double));
+    for (i = 0; i < rec_count; i++)
+        for (call = 0; call < CALL_COUNT; call++) {
+            local[call] += recs[i]->calls[call];
+            local[CALL_COUNT+call] += recs[i]->bytes[call];
+            local[2*CALL_COUNT+call] += recs[i]->time[call];
+        }
+    local[3*CALL_COUNT] = wall_time;
+
+    PMPI_Reduce(local, sum, 3*CALL_COUNT+1, MPI_DOUBLE, MPI_SUM, 0,
+        prof_comm);
+    PMPI_Reduce(local + 2*CALL_COUNT, min_time, CALL_COUNT, MPI_DOUBLE,
+        MPI_MIN, 0, prof_comm);
+    PMPI_Reduce(local + 2*CALL_COUNT, max_time, CALL_COUNT, MPI_DOUBLE,
+        MPI_MAX, 0, prof_comm);
+    if (world_rank != 0) return;
+
+    /* Insertion sort on the total time */
+    for (call = 0; call < CALL_COUNT; call++) {
+        t = call;
+        for (j = call; (j > 0) &&
+                (sum[2*CALL_COUNT+order[j-1]] < sum[2*CALL_COUNT+t]); j--)
+            order[j] = order[j-1];
+        order[j] = t;
+    }
+
+    sprintf(file_name, "%.1000s.summary", prefix);
+    fp = fopen(file_name, "w");
+    if (fp == (FILE*) NULL) {
+        fprintf(stderr, "mpi_prof:  Can't open %s\n", file_name);
+        return;
+    }
+    mean = sum[3*CALL_COUNT]/world_size;
+    fprintf(fp, "# %d processes, mean %.6f seconds from MPI_Init to "
+        "MPI_Finalize\n", world_size, mean);
+    fprintf(fp, "call,calls,bytes,min_s,mean_s,max_s,pct_wall\n");
+    for (j = 0; j < CALL_COUNT; j++) {
+        call = order[j];
+        if (sum[call] == 0.0) continue;
+        fprintf(fp, "%s,%.0f,%.0f,%.6f,%.6f,%.6f,%.2f\n", call_names[call],
+            sum[call], sum[CALL_COUNT+call], min_time[call],
+            sum[2*CALL_COUNT+call]/world_size, max_time[call],
+            (mean > 0.0) ?
+                100.0*sum[2*CALL_COUNT+call]/world_size/mean : 0.0);
+    }
+    fclose(fp);
+}  /* Write_summary */
+
+
+/********************************************************************/
+/* A process's row of the matrix is what it sent, plus what the others
+ *     fetched from it.  The second comes from an all-to-all.
+ */
+static void Write_matrix(
+         char*  prefix  /* in */) {
+    double*    row;
+    double*    fetched_from_me;
+    char       file_name[1024];
+    FILE*      fp[2] = {(FILE*) NULL, (FILE*) NULL};
+    char*      suffix[2] = {"bytes", "msgs"};
+    int        q, j, k;
+
+    row = (double*) malloc(2*world_size*sizeof(double));
+    fetched_from_me = (double*) malloc(2*world_size*sizeof(double));
+    PMPI_Alltoall(world_fetched, 2, MPI_DOUBLE, fetched_from_me, 2,
+        MPI_DOUBLE, prof_comm);
+    for (j = 0; j < 2*world_size; j++)
+        row[j] = world_out[j] + fetched_from_me[j];
+
+    if (world_rank != 0) {
+        PMPI_Send(row, 2*world_size, MPI_DOUBLE, 0, 0, prof_comm);
+    } else {
+        for (k = 0; k < 2; k++) {
+            sprintf(file_name, "%.1000s.%s", prefix, suffix[k]);
+            fp[k] = fopen(file_name, "w");
+            if (fp[k] == (FILE*) NULL) {
+                fprintf(stderr, "mpi_prof:  Can't open %s\n", file_name);
+                continue;
+            }
+            fprintf(fp[k], "src\\dst");
+            for (j = 0; j < world_size; j++)
+                fprintf(fp[k], ",%d", j);
+            fprintf(fp[k], "\n");
+        }
+        for (q = 0; q < world_size; q++) {
+            if (q > 0)
+                PMPI_Recv(row, 2*world_size, MPI_DOUBLE, q, 0,
+                    prof_comm, MPI_STATUS_IGNORE);
+            for (k = 0; k < 2; k++) {
+                if (fp[k] == (FILE*) NULL) continue;
+                fprintf(fp[k], "%d", q);
+                for (j = 0; j < world_size; j++)
+                    fprintf(fp[k], ",%.0f", row[2*j+k]);
+                fprintf(fp[k], "\n");
+            }
+        }
+        for (k = 0; k < 2; k++)
+            if (fp[k] != (FILE*) NULL) fclose(fp[k]);
+    }
+    free(row);
+    free(fetched_from_me);
+}  /* Write_matrix */
+
+
+/*==================================================================*/
+/* Point-to-point                                                   */
+/*==================================================================*/
+int MPI_Send(const void* buf, int count, MPI_Datatype datatype,
+        int dest, int tag, MPI_Comm comm) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Send(buf, count, datatype, dest, tag, comm);
+    PROF_STOP;
+    P2p_call(P_SEND, comm, dest, Bytes(count, datatype), OUT, prof_time);
+    return rv;
+}  /* MPI_Send */
+
+
+int MPI_Bsend(const void* buf, int count, MPI_Datatype datatype,
+        int dest, int tag, MPI_Comm comm) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Bsend(buf, count, datatype, dest, tag, comm);
+    PROF_STOP;
+    P2p_call(P_BSEND, comm, dest, Bytes(count, datatype), OUT, prof_time);
+    return rv;
+}  /* MPI_Bsend */
+
+
+int MPI_Ssend(const void* buf, int count, MPI_Datatype datatype,
+        int dest, int tag, MPI_Comm comm) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Ssend(buf, count, datatype, dest, tag, comm);
+    PROF_STOP;
+    P2p_call(P_SSEND, comm, dest, Bytes(count, datatype), OUT, prof_time);
+    return rv;
+}  /* MPI_Ssend */
+
+
+int MPI_Rsend(const void* buf, int count, MPI_Datatype datatype,
+        int dest, int tag, MPI_Comm comm) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Rsend(buf, count, datatype, dest, tag, comm);
+    PROF_STOP;
+    P2p_call(P_RSEND, comm, dest, Bytes(count, datatype), OUT, prof_time);
+    return rv;
+}  /* MPI_Rsend */
+
+
+int MPI_Isend(const void* buf, int count, MPI_Datatype datatype,
+        int dest, int tag, MPI_Comm comm, MPI_Request* request) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Isend(buf, count, datatype, dest, tag, comm, request);
+    PROF_STOP;
+    P2p_call(P_ISEND, comm, dest, Bytes(count, datatype), OUT, prof_time);
+    return rv;
+}  /* MPI_Isend */
+
+
+int MPI_Ibsend(const void* buf, int count, MPI_Datatype datatype,
+        int dest, int tag, MPI_Comm comm, MPI_Request* request) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Ibsend(buf, count, datatype, dest, tag, comm, request);
+    PROF_STOP;
+    P2p_call(P_IBSEND, comm, dest, Bytes(count, datatype), OUT,
+        prof_time);
+    return rv;
+}  /* MPI_Ibsend */
+
+
+int MPI_Issend(const void* buf, int count, MPI_Datatype datatype,
+        int dest, int tag, MPI_Comm comm, MPI_Request* request) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Issend(buf, count, datatype, dest, tag, comm, request);
+    PROF_STOP;
+    P2p_call(P_ISSEND, comm, dest, Bytes(count, datatype), OUT,
+        prof_time);
+    return rv;
+}  /* MPI_Issend */
+
+
+int MPI_Irsend(const void* buf, int count, MPI_Datatype datatype,
+        int dest, int tag, MPI_Comm comm, MPI_Request* request) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Irsend(buf, count, datatype, dest, tag, comm, request);
+    PROF_STOP;
+    P2p_call(P_IRSEND, comm, dest, Bytes(count, datatype), OUT,
+        prof_time);
+    return rv;
+}  /* MPI_Irsend */
+
+
+int MPI_Recv(void* buf, int count, MPI_Datatype datatype, int source,
+        int tag, MPI_Comm comm, MPI_Status* status) {
+    MPI_Status my_status;
+    int        bytes = 0;
+    int        rv;
+    PROF_START;
+
+    if (status == MPI_STATUS_IGNORE) status = &my_status;
+    rv = PMPI_Recv(buf, count, datatype, source, tag, comm, status);
+    PROF_STOP;
+    if (prof_on && (rv == MPI_SUCCESS)) {
+        PMPI_Get_count(status, MPI_BYTE, &bytes);
+        P2p_call(P_RECV, comm, status->MPI_SOURCE, (double) bytes, IN,
+            prof_time);
+    }
+    return rv;
+}  /* MPI_Recv */
+
+
+int MPI_Irecv(void* buf, int count, MPI_Datatype datatype, int source,
+        int tag, MPI_Comm comm, MPI_Request* request) {
+    PROF_REC_T* rec;
+    int         rv;
+    PROF_START;
+
+    rv = PMPI_Irecv(buf, count, datatype, source, tag, comm, request);
+    PROF_STOP;
+    if (rv == MPI_SUCCESS) {
+        rec = Post_call(P_IRECV, comm, prof_time);
+        if (rec != (PROF_REC_T*) NULL)
+            Add_request(*request, rec, P_IRECV, source, 0.0, 1);
+    }
+    return rv;
+}  /* MPI_Irecv */
+
+
+int MPI_Sendrecv(const void* sendbuf, int sendcount,
+        MPI_Datatype sendtype, int dest, int sendtag, void* recvbuf,
+        int recvcount, MPI_Datatype recvtype, int source, int recvtag,
+        MPI_Comm comm, MPI_Status* status) {
+    MPI_Status my_status;
+    int        bytes = 0;
+    int        rv;
+    PROF_START;
+
+    if (status == MPI_STATUS_IGNORE) status = &my_status;
+    rv = PMPI_Sendrecv(sendbuf, sendcount, sendtype, dest, sendtag,
+        recvbuf, recvcount, recvtype, source, recvtag, comm, status);
+    PROF_STOP;
+    if (prof_on && (rv == MPI_SUCCESS)) {
+        P2p_call(P_SENDRECV, comm, dest, Bytes(sendcount, sendtype), OUT,
+            prof_time);
+        PMPI_Get_count(status, MPI_BYTE, &bytes);
+        Add_peer(Comm_rec(comm), status->MPI_SOURCE, (double) bytes, IN);
+    }
+    return rv;
+}  /* MPI_Sendrecv */
+
+
+int MPI_Sendrecv_replace(void* buf, int count, MPI_Datatype datatype,
+        int dest, int sendtag, int source, int recvtag, MPI_Comm comm,
+        MPI_Status* status) {
+    MPI_Status my_status;
+    double     bytes;
+    int        rv;
+    PROF_START;
+
+    if (status == MPI_STATUS_IGNORE) status = &my_status;
+    rv = PMPI_Sendrecv_replace(buf, count, datatype, dest, sendtag,
+        source, recvtag, comm, status);
+    PROF_STOP;
+    if (prof_on && (rv == MPI_SUCCESS)) {
+        bytes = Bytes(count, datatype);
+        P2p_call(P_SENDRECV_REPLACE, comm, dest, bytes, OUT, prof_time);
+        Add_peer(Comm_rec(comm), status->MPI_SOURCE, bytes, IN);
+    }
+    return rv;
+}  /* MPI_Sendrecv_replace */
+
+
+int MPI_Probe(int source, int tag, MPI_Comm comm, MPI_Status* status) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Probe(source, tag, comm, status);
+    PROF_STOP;
+    Comm_call(P_PROBE, comm, 0.0, prof_time);
+    return rv;
+}  /* MPI_Probe */
+
+
+int MPI_Iprobe(int source, int tag, MPI_Comm comm, int* flag,
+        MPI_Status* status) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Iprobe(source, tag, comm, flag, status);
+    PROF_STOP;
+    Comm_call(P_IPROBE, comm, 0.0, prof_time);
+    return rv;
+}  /* MPI_Iprobe */
+
+
+int MPI_Send_init(const void* buf, int count, MPI_Datatype datatype,
+        int dest, int tag, MPI_Comm comm, MPI_Request* request) {
+    PROF_REC_T* rec;
+    int         rv;
+    PROF_START;
+
+    rv = PMPI_Send_init(buf, count, datatype, dest, tag, comm, request);
+    PROF_STOP;
+    if (rv == MPI_SUCCESS) {
+        rec = Post_call(P_SEND_INIT, comm, prof_time);
+        if (rec != (PROF_REC_T*) NULL)
+            Add_request(*request, rec, P_SEND_INIT, dest,
+                Bytes(count, datatype), 0);
+    }
+    return rv;
+}  /* MPI_Send_init */
+
+
+int MPI_Recv_init(void* buf, int count, MPI_Datatype datatype,
+        int source, int tag, MPI_Comm comm, MPI_Request* request) {
+    PROF_REC_T* rec;
+    int         rv;
+    PROF_START;
+
+    rv = PMPI_Recv_init(buf, count, datatype, source, tag, comm,
+        request);
+    PROF_STOP;
+    if (rv == MPI_SUCCESS) {
+        rec = Post_call(P_RECV_INIT, comm, prof_time);
+        if (rec != (PROF_REC_T*) NULL)
+            Add_request(*request, rec, P_RECV_INIT, source, 0.0, 0);
+    }
+    return rv;
+}  /* MPI_Recv_init */
+
+
+int MPI_Start(MPI_Request* request) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Start(request);
+    PROF_STOP;
+    Req_call(P_START, prof_time);
+    if (rv == MPI_SUCCESS) Started(*request);
+    return rv;
+}  /* MPI_Start */
+
+
+int MPI_Startall(int count, MPI_Request array_of_requests[]) {
+    int rv;
+    int i;
+    PROF_START;
+
+    rv = PMPI_Startall(count, array_of_requests);
+    PROF_STOP;
+    Req_call(P_STARTALL, prof_time);
+    if (rv == MPI_SUCCESS)
+        for (i = 0; (i < count) && (req_count > 0); i++)
+            Started(array_of_requests[i]);
+    return rv;
+}  /* MPI_Startall */
+
+
+/*==================================================================*/
+/* Completion                                                       */
+/*==================================================================*/
+int MPI_Wait(MPI_Request* request, MPI_Status* status) {
+    MPI_Status  my_status;
+    MPI_Request saved = *request;
+    int         rv;
+    PROF_START;
+
+    if (status == MPI_STATUS_IGNORE) status = &my_status;
+    rv = PMPI_Wait(request, status);
+    PROF_STOP;
+    Req_call(P_WAIT, prof_time);
+    if (rv == MPI_SUCCESS) Completed(saved, status);
+    return rv;
+}  /* MPI_Wait */
+
+
+int MPI_Waitall(int count, MPI_Request array_of_requests[],
+        MPI_Status* array_of_statuses) {
+    MPI_Request* saved;
+    int          rv;
+    int          i;
+    PROF_START;
+
+    saved = Save_requests(count, array_of_requests);
+    array_of_statuses = Statuses(array_of_statuses, saved);
+    rv = PMPI_Waitall(count, array_of_requests, array_of_statuses);
+    PROF_STOP;
+    Req_call(P_WAITALL, prof_time);
+    if (saved != (MPI_Request*) NULL) {
+        for (i = 0; i < count; i++)
+            Completed(saved[i], ((rv != MPI_SUCCESS) ||
+                (array_of_statuses == MPI_STATUSES_IGNORE)) ?
+                MPI_STATUS_IGNORE : &array_of_statuses[i]);
+    }
+    return rv;
+}  /* MPI_Waitall */
+
+
+int MPI_Waitany(int count, MPI_Request array_of_requests[], int* index,
+        MPI_Status* status) {
+    MPI_Status   my_status;
+    MPI_Request* saved;
+    int          rv;
+    PROF_START;
+
+    saved = Save_requests(count, array_of_requests);
+    if (status == MPI_STATUS_IGNORE) status = &my_status;
+    rv = PMPI_Waitany(count, array_of_requests, index, status);
+    PROF_STOP;
+    Req_call(P_WAITANY, prof_time);
+    if (saved != (MPI_Request*) NULL) {
+        if ((rv == MPI_SUCCESS) && (*index != MPI_UNDEFINED))
+            Completed(saved[*index], status);
+    }
+    return rv;
+}  /* MPI_Waitany */
+
+
+int MPI_Waitsome(int incount, MPI_Request array_of_requests[],
+        int* outcount, int array_of_indices[],
+        MPI_Status array_of_statuses[]) {
+    MPI_Request* saved;
+    int          rv;
+    int          i;
+    PROF_START;
+
+    saved = Save_requests(incount, array_of_requests);
+    array_of_statuses = Statuses(array_of_statuses, saved);
+    rv = PMPI_Waitsome(incount, array_of_requests, outcount,
+        array_of_indices, array_of_statuses);
+    PROF_STOP;
+    Req_call(P_WAITSOME, prof_time);
+    if (saved != (MPI_Request*) NULL) {
+        if ((rv == MPI_SUCCESS) && (*outcount != MPI_UNDEFINED))
+            for (i = 0; i < *outcount; i++)
+                Completed(saved[array_of_indices[i]],
+                    (array_of_statuses == MPI_STATUSES_IGNORE) ?
+                    MPI_STATUS_IGNORE : &array_of_statuses[i]);
+    }
+    return rv;
+}  /* MPI_Waitsome */
+
+
+int MPI_Test(MPI_Request* request, int* flag, MPI_Status* status) {
+    MPI_Status  my_status;
+    MPI_Request saved = *request;
+    int         rv;
+    PROF_START;
+
+    if (status == MPI_STATUS_IGNORE) status = &my_status;
+    rv = PMPI_Test(request, flag, status);
+    PROF_STOP;
+    Req_call(P_TEST, prof_time);
+    if ((rv == MPI_SUCCESS) && *flag) Completed(saved, status);
+    return rv;
+}  /* MPI_Test */
+
+
+int MPI_Testall(int count, MPI_Request array_of_requests[], int* flag,
+        MPI_Status array_of_statuses[]) {
+    MPI_Request* saved;
+    int          rv;
+    int          i;
+    PROF_START;
+
+    saved = Save_requests(count, array_of_requests);
+    array_of_statuses = Statuses(array_of_statuses, saved);
+    rv = PMPI_Testall(count, array_of_requests, flag, array_of_statuses);
+    PROF_STOP;
+    Req_call(P_TESTALL, prof_time);
+    if (saved != (MPI_Request*) NULL) {
+        if ((rv == MPI_SUCCESS) && *flag)
+            for (i = 0; i < count; i++)
+                Completed(saved[i],
+                    (array_of_statuses == MPI_STATUSES_IGNORE) ?
+                    MPI_STATUS_IGNORE : &array_of_statuses[i]);
+    }
+    return rv;
+}  /* MPI_Testall */
+
+
+int MPI_Testany(int count, MPI_Request array_of_requests[], int* index,
+        int* flag, MPI_Status* status) {
+    MPI_Status   my_status;
+    MPI_Request* saved;
+    int          rv;
+    PROF_START;
+
+    saved = Save_requests(count, array_of_requests);
+    if (status == MPI_STATUS_IGNORE) status = &my_status;
+    rv = PMPI_Testany(count, array_of_requests, index, flag, status);
+    PROF_STOP;
+    Req_call(P_TESTANY, prof_time);
+    if (saved != (MPI_Request*) NULL) {
+        if ((rv == MPI_SUCCESS) && *flag && (*index != MPI_UNDEFINED))
+            Completed(saved[*index], status);
+    }
+    return rv;
+}  /* MPI_Testany */
+
+
+int MPI_Testsome(int incount, MPI_Request array_of_requests[],
+        int* outcount, int array_of_indices[],
+        MPI_Status array_of_statuses[]) {
+    MPI_Request* saved;
+    int          rv;
+    int          i;
+    PROF_START;
+
+    saved = Save_requests(incount, array_of_requests);
+    array_of_statuses = Statuses(array_of_statuses, saved);
+    rv = PMPI_Testsome(incount, array_of_requests, outcount,
+        array_of_indices, array_of_statuses);
+    PROF_STOP;
+    Req_call(P_TESTSOME, prof_time);
+    if (saved != (MPI_Request*) NULL) {
+        if ((rv == MPI_SUCCESS) && (*outcount != MPI_UNDEFINED))
+            for (i = 0; i < *outcount; i++)
+                Completed(saved[array_of_indices[i]],
+                    (array_of_statuses == MPI_STATUSES_IGNORE) ?
+                    MPI_STATUS_IGNORE : &array_of_statuses[i]);
+    }
+    return rv;
+}  /* MPI_Testsome */
+
+
+int MPI_Request_free(MPI_Request* request) {
+    MPI_Request saved = *request;
+    int         rv;
+    PROF_START;
+
+    rv = PMPI_Request_free(request);
+    PROF_STOP;
+    Req_call(P_REQUEST_FREE, prof_time);
+    if (rv == MPI_SUCCESS) Forget(saved);
+    return rv;
+}  /* MPI_Request_free */
+
+
+/*==================================================================*/
+/* Collectives.  With MPI_IN_PLACE the bytes are taken from the     */
+/*     receive arguments.                                           */
+/*==================================================================*/
+int MPI_Barrier(MPI_Comm comm) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Barrier(comm);
+    PROF_STOP;
+    Comm_call(P_BARRIER, comm, 0.0, prof_time);
+    return rv;
+}  /* MPI_Barrier */
+
+
+int MPI_Bcast(void* buffer, int count, MPI_Datatype datatype, int root,
+        MPI_Comm comm) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Bcast(buffer, count, datatype, root, comm);
+    PROF_STOP;
+    Comm_call(P_BCAST, comm, Bytes(count, datatype), prof_time);
+    return rv;
+}  /* MPI_Bcast */
+
+
+int MPI_Reduce(const void* sendbuf, void* recvbuf, int count,
+        MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Reduce(sendbuf, recvbuf, count, datatype, op, root, comm);
+    PROF_STOP;
+    Comm_call(P_REDUCE, comm, Bytes(count, datatype), prof_time);
+    return rv;
+}  /* MPI_Reduce */
+
+
+int MPI_Allreduce(const void* sendbuf, void* recvbuf, int count,
+        MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Allreduce(sendbuf, recvbuf, count, datatype, op, comm);
+    PROF_STOP;
+    Comm_call(P_ALLREDUCE, comm, Bytes(count, datatype), prof_time);
+    return rv;
+}  /* MPI_Allreduce */
+
+
+int MPI_Gather(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+        void* recvbuf, int recvcount, MPI_Datatype recvtype, int root,
+        MPI_Comm comm) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Gather(sendbuf, sendcount, sendtype, recvbuf, recvcount,
+        recvtype, root, comm);
+    PROF_STOP;
+    Comm_call(P_GATHER, comm, (sendbuf == MPI_IN_PLACE) ?
+        Bytes(recvcount, recvtype) : Bytes(sendcount, sendtype),
+        prof_time);
+    return rv;
+}  /* MPI_Gather */
+
+
+int MPI_Gatherv(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+        void* recvbuf, const int recvcounts[], const int displs[],
+        MPI_Datatype recvtype, int root, MPI_Comm comm) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Gatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts,
+        displs, recvtype, root, comm);
+    PROF_STOP;
+    Comm_call(P_GATHERV, comm, (sendbuf == MPI_IN_PLACE) ?
+        0.0 : Bytes(sendcount, sendtype), prof_time);
+    return rv;
+}  /* MPI_Gatherv */
+
+
+int MPI_Scatter(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+        void* recvbuf, int recvcount, MPI_Datatype recvtype, int root,
+        MPI_Comm comm) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Scatter(sendbuf, sendcount, sendtype, recvbuf, recvcount,
+        recvtype, root, comm);
+    PROF_STOP;
+    Comm_call(P_SCATTER, comm, (recvbuf == MPI_IN_PLACE) ?
+        Bytes(sendcount, sendtype) : Bytes(recvcount, recvtype),
+        prof_time);
+    return rv;
+}  /* MPI_Scatter */
+
+
+int MPI_Scatterv(const void* sendbuf, const int sendcounts[],
+        const int displs[], MPI_Datatype sendtype, void* recvbuf,
+        int recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Scatterv(sendbuf, sendcounts, displs, sendtype, recvbuf,
+        recvcount, recvtype, root, comm);
+    PROF_STOP;
+    Comm_call(P_SCATTERV, comm, (recvbuf == MPI_IN_PLACE) ?
+        0.0 : Bytes(recvcount, recvtype), prof_time);
+    return rv;
+}  /* MPI_Scatterv */
+
+
+int MPI_Allgather(const void* sendbuf, int sendcount,
+        MPI_Datatype sendtype, void* recvbuf, int recvcount,
+        MPI_Datatype recvtype, MPI_Comm comm) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Allgather(sendbuf, sendcount, sendtype, recvbuf, recvcount,
+        recvtype, comm);
+    PROF_STOP;
+    Comm_call(P_ALLGATHER, comm, (sendbuf == MPI_IN_PLACE) ?
+        Bytes(recvcount, recvtype) : Bytes(sendcount, sendtype),
+        prof_time);
+    return rv;
+}  /* MPI_Allgather */
+
+
+int MPI_Allgatherv(const void* sendbuf, int sendcount,
+        MPI_Datatype sendtype, void* recvbuf, const int recvcounts[],
+        const int displs[], MPI_Datatype recvtype, MPI_Comm comm) {
+    int rv;
+    int my_rank;
+    PROF_START;
+
+    rv = PMPI_Allgatherv(sendbuf, sendcount, sendtype, recvbuf,
+        recvcounts, displs, recvtype, comm);
+    PROF_STOP;
+    if (prof_on && (sendbuf == MPI_IN_PLACE)) {
+        PMPI_Comm_rank(comm, &my_rank);
+        Comm_call(P_ALLGATHERV, comm, Bytes(recvcounts[my_rank], recvtype),
+            prof_time);
+    } else {
+        Comm_call(P_ALLGATHERV, comm, Bytes(sendcount, sendtype),
+            prof_time);
+    }
+    return rv;
+}  /* MPI_Allgatherv */
+
+
+int MPI_Alltoall(const void* sendbuf, int sendcount,
+        MPI_Datatype sendtype, void* recvbuf, int recvcount,
+        MPI_Datatype recvtype, MPI_Comm comm) {
+    int rv;
+    int p;
+    PROF_START;
+
+    rv = PMPI_Alltoall(sendbuf, sendcount, sendtype, recvbuf, recvcount,
+        recvtype, comm);
+    PROF_STOP;
+    if (prof_on) {
+        PMPI_Comm_size(comm, &p);
+        Comm_call(P_ALLTOALL, comm, p*((sendbuf == MPI_IN_PLACE) ?
+            Bytes(recvcount, recvtype) : Bytes(sendcount, sendtype)),
+            prof_time);
+    }
+    return rv;
+}  /* MPI_Alltoall */
+
+
+int MPI_Alltoallv(const void* sendbuf, const int sendcounts[],
+        const int sdispls[], MPI_Datatype sendtype, void* recvbuf,
+        const int recvcounts[], const int rdispls[],
+        MPI_Datatype recvtype, MPI_Comm comm) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Alltoallv(sendbuf, sendcounts, sdispls, sendtype, recvbuf,
+        recvcounts, rdispls, recvtype, comm);
+    PROF_STOP;
+    Comm_call(P_ALLTOALLV, comm, (sendbuf == MPI_IN_PLACE) ?
+        Sum_bytes(recvcounts, recvtype, comm) :
+        Sum_bytes(sendcounts, sendtype, comm), prof_time);
+    return rv;
+}  /* MPI_Alltoallv */
+
+
+int MPI_Alltoallw(const void* sendbuf, const int sendcounts[],
+        const int sdispls[], const MPI_Datatype sendtypes[],
+        void* recvbuf, const int recvcounts[], const int rdispls[],
+        const MPI_Datatype recvtypes[], MPI_Comm comm) {
+    double bytes = 0.0;
+    int    rv;
+    int    p, q;
+    PROF_START;
+
+    rv = PMPI_Alltoallw(sendbuf, sendcounts, sdispls, sendtypes, recvbuf,
+        recvcounts, rdispls, recvtypes, comm);
+    PROF_STOP;
+    if (prof_on && (comm != MPI_COMM_NULL)) {
+        PMPI_Comm_size(comm, &p);
+        for (q = 0; q < p; q++)
+            bytes += (sendbuf == MPI_IN_PLACE) ?
+                Bytes(recvcounts[q], recvtypes[q]) :
+                Bytes(sendcounts[q], sendtypes[q]);
+        Comm_call(P_ALLTOALLW, comm, bytes, prof_time);
+    }
+    return rv;
+}  /* MPI_Alltoallw */
+
+
+int MPI_Reduce_scatter(const void* sendbuf, void* recvbuf,
+        const int recvcounts[], MPI_Datatype datatype, MPI_Op op,
+        MPI_Comm comm) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Reduce_scatter(sendbuf, recvbuf, recvcounts, datatype, op,
+        comm);
+    PROF_STOP;
+    Comm_call(P_REDUCE_SCATTER, comm,
+        Sum_bytes(recvcounts, datatype, comm), prof_time);
+    return rv;
+}  /* MPI_Reduce_scatter */
+
+
+int MPI_Reduce_scatter_block(const void* sendbuf, void* recvbuf,
+        int recvcount, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+    int rv;
+    int p;
+    PROF_START;
+
+    rv = PMPI_Reduce_scatter_block(sendbuf, recvbuf, recvcount, datatype,
+        op, comm);
+    PROF_STOP;
+    if (prof_on) {
+        PMPI_Comm_size(comm, &p);
+        Comm_call(P_REDUCE_SCATTER_BLOCK, comm,
+            p*Bytes(recvcount, datatype), prof_time);
+    }
+    return rv;
+}  /* MPI_Reduce_scatter_block */
+
+
+int MPI_Scan(const void* sendbuf, void* recvbuf, int count,
+        MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Scan(sendbuf, recvbuf, count, datatype, op, comm);
+    PROF_STOP;
+    Comm_call(P_SCAN, comm, Bytes(count, datatype), prof_time);
+    return rv;
+}  /* MPI_Scan */
+
+
+int MPI_Exscan(const void* sendbuf, void* recvbuf, int count,
+        MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Exscan(sendbuf, recvbuf, count, datatype, op, comm);
+    PROF_STOP;
+    Comm_call(P_EXSCAN, comm, Bytes(count, datatype), prof_time);
+    return rv;
+}  /* MPI_Exscan */
+
+
+/* Nonblocking collectives:  the time is the time to start the
+ *     operation.  The rest is in the completion calls.
+ */
+int MPI_Ibarrier(MPI_Comm comm, MPI_Request* request) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Ibarrier(comm, request);
+    PROF_STOP;
+    Comm_call(P_IBARRIER, comm, 0.0, prof_time);
+    return rv;
+}  /* MPI_Ibarrier */
+
+
+int MPI_Ibcast(void* buffer, int count, MPI_Datatype datatype, int root,
+        MPI_Comm comm, MPI_Request* request) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Ibcast(buffer, count, datatype, root, comm, request);
+    PROF_STOP;
+    Comm_call(P_IBCAST, comm, Bytes(count, datatype), prof_time);
+    return rv;
+}  /* MPI_Ibcast */
+
+
+int MPI_Ireduce(const void* sendbuf, void* recvbuf, int count,
+        MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm,
+        MPI_Request* request) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Ireduce(sendbuf, recvbuf, count, datatype, op, root, comm,
+        request);
+    PROF_STOP;
+    Comm_call(P_IREDUCE, comm, Bytes(count, datatype), prof_time);
+    return rv;
+}  /* MPI_Ireduce */
+
+
+int MPI_Iallreduce(const void* sendbuf, void* recvbuf, int count,
+        MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
+        MPI_Request* request) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Iallreduce(sendbuf, recvbuf, count, datatype, op, comm,
+        request);
+    PROF_STOP;
+    Comm_call(P_IALLREDUCE, comm, Bytes(count, datatype), prof_time);
+    return rv;
+}  /* MPI_Iallreduce */
+
+
+int MPI_Igather(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+        void* recvbuf, int recvcount, MPI_Datatype recvtype, int root,
+        MPI_Comm comm, MPI_Request* request) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Igather(sendbuf, sendcount, sendtype, recvbuf, recvcount,
+        recvtype, root, comm, request);
+    PROF_STOP;
+    Comm_call(P_IGATHER, comm, (sendbuf == MPI_IN_PLACE) ?
+        Bytes(recvcount, recvtype) : Bytes(sendcount, sendtype),
+        prof_time);
+    return rv;
+}  /* MPI_Igather */
+
+
+int MPI_Iscatter(const void* sendbuf, int sendcount,
+        MPI_Datatype sendtype, void* recvbuf, int recvcount,
+        MPI_Datatype recvtype, int root, MPI_Comm comm,
+        MPI_Request* request) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Iscatter(sendbuf, sendcount, sendtype, recvbuf, recvcount,
+        recvtype, root, comm, request);
+    PROF_STOP;
+    Comm_call(P_ISCATTER, comm, (recvbuf == MPI_IN_PLACE) ?
+        Bytes(sendcount, sendtype) : Bytes(recvcount, recvtype),
+        prof_time);
+    return rv;
+}  /* MPI_Iscatter */
+
+
+int MPI_Iallgather(const void* sendbuf, int sendcount,
+        MPI_Datatype sendtype, void* recvbuf, int recvcount,
+        MPI_Datatype recvtype, MPI_Comm comm, MPI_Request* request) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Iallgather(sendbuf, sendcount, sendtype, recvbuf,
+        recvcount, recvtype, comm, request);
+    PROF_STOP;
+    Comm_call(P_IALLGATHER, comm, (sendbuf == MPI_IN_PLACE) ?
+        Bytes(recvcount, recvtype) : Bytes(sendcount, sendtype),
+        prof_time);
+    return rv;
+}  /* MPI_Iallgather */
+
+
+int MPI_Ialltoall(const void* sendbuf, int sendcount,
+        MPI_Datatype sendtype, void* recvbuf, int recvcount,
+        MPI_Datatype recvtype, MPI_Comm comm, MPI_Request* request) {
+    int rv;
+    int p;
+    PROF_START;
+
+    rv = PMPI_Ialltoall(sendbuf, sendcount, sendtype, recvbuf, recvcount,
+        recvtype, comm, request);
+    PROF_STOP;
+    if (prof_on) {
+        PMPI_Comm_size(comm, &p);
+        Comm_call(P_IALLTOALL, comm, p*((sendbuf == MPI_IN_PLACE) ?
+            Bytes(recvcount, recvtype) : Bytes(sendcount, sendtype)),
+            prof_time);
+    }
+    return rv;
+}  /* MPI_Ialltoall */
+
+
+/*==================================================================*/
+/* One-sided.  The counters for a window are separate from the      */
+/*     counters for its communicator.                               */
+/*==================================================================*/
+int MPI_Win_create(void* base, MPI_Aint size, int disp_unit,
+        MPI_Info info, MPI_Comm comm, MPI_Win* win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Win_create(base, size, disp_unit, info, comm, win);
+    PROF_STOP;
+    if (rv == MPI_SUCCESS)
+        Win_call(P_WIN_CREATE, *win, MPI_PROC_NULL, (double) size, OUT,
+            prof_time);
+    return rv;
+}  /* MPI_Win_create */
+
+
+int MPI_Win_allocate(MPI_Aint size, int disp_unit, MPI_Info info,
+        MPI_Comm comm, void* baseptr, MPI_Win* win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Win_allocate(size, disp_unit, info, comm, baseptr, win);
+    PROF_STOP;
+    if (rv == MPI_SUCCESS)
+        Win_call(P_WIN_ALLOCATE, *win, MPI_PROC_NULL, (double) size, OUT,
+            prof_time);
+    return rv;
+}  /* MPI_Win_allocate */
+
+
+int MPI_Win_allocate_shared(MPI_Aint size, int disp_unit, MPI_Info info,
+        MPI_Comm comm, void* baseptr, MPI_Win* win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Win_allocate_shared(size, disp_unit, info, comm, baseptr,
+        win);
+    PROF_STOP;
+    if (rv == MPI_SUCCESS)
+        Win_call(P_WIN_ALLOCATE_SHARED, *win, MPI_PROC_NULL, (double) size,
+            OUT, prof_time);
+    return rv;
+}  /* MPI_Win_allocate_shared */
+
+
+int MPI_Win_free(MPI_Win* win) {
+    PROF_REC_T* rec = (PROF_REC_T*) NULL;
+    int         rv;
+    PROF_START;
+
+    if (prof_on) rec = Win_rec(*win);
+    rv = PMPI_Win_free(win);
+    PROF_STOP;
+    if (prof_on) Record(rec, P_WIN_FREE, 0.0, prof_time);
+    return rv;
+}  /* MPI_Win_free */
+
+
+int MPI_Put(const void* origin_addr, int origin_count,
+        MPI_Datatype origin_datatype, int target_rank, MPI_Aint target_disp,
+        int target_count, MPI_Datatype target_datatype, MPI_Win win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Put(origin_addr, origin_count, origin_datatype, target_rank,
+        target_disp, target_count, target_datatype, win);
+    PROF_STOP;
+    Win_call(P_PUT, win, target_rank, Bytes(origin_count, origin_datatype),
+        OUT, prof_time);
+    return rv;
+}  /* MPI_Put */
+
+
+int MPI_Get(void* origin_addr, int origin_count,
+        MPI_Datatype origin_datatype, int target_rank, MPI_Aint target_disp,
+        int target_count, MPI_Datatype target_datatype, MPI_Win win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Get(origin_addr, origin_count, origin_datatype, target_rank,
+        target_disp, target_count, target_datatype, win);
+    PROF_STOP;
+    Win_call(P_GET, win, target_rank, Bytes(origin_count, origin_datatype),
+        FETCH, prof_time);
+    return rv;
+}  /* MPI_Get */
+
+
+int MPI_Accumulate(const void* origin_addr, int origin_count,
+        MPI_Datatype origin_datatype, int target_rank, MPI_Aint target_disp,
+        int target_count, MPI_Datatype target_datatype, MPI_Op op,
+        MPI_Win win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Accumulate(origin_addr, origin_count, origin_datatype,
+        target_rank, target_disp, target_count, target_datatype, op, win);
+    PROF_STOP;
+    Win_call(P_ACCUMULATE, win, target_rank,
+        Bytes(origin_count, origin_datatype), OUT, prof_time);
+    return rv;
+}  /* MPI_Accumulate */
+
+
+int MPI_Get_accumulate(const void* origin_addr, int origin_count,
+        MPI_Datatype origin_datatype, void* result_addr, int result_count,
+        MPI_Datatype result_datatype, int target_rank, MPI_Aint target_disp,
+        int target_count, MPI_Datatype target_datatype, MPI_Op op,
+        MPI_Win win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Get_accumulate(origin_addr, origin_count, origin_datatype,
+        result_addr, result_count, result_datatype, target_rank,
+        target_disp, target_count, target_datatype, op, win);
+    PROF_STOP;
+    if (prof_on) {
+        Win_call(P_GET_ACCUMULATE, win, target_rank,
+            Bytes(origin_count, origin_datatype), OUT, prof_time);
+        Add_peer(Win_rec(win), target_rank,
+            Bytes(result_count, result_datatype), FETCH);
+    }
+    return rv;
+}  /* MPI_Get_accumulate */
+
+
+int MPI_Fetch_and_op(const void* origin_addr, void* result_addr,
+        MPI_Datatype datatype, int target_rank, MPI_Aint target_disp,
+        MPI_Op op, MPI_Win win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Fetch_and_op(origin_addr, result_addr, datatype,
+        target_rank, target_disp, op, win);
+    PROF_STOP;
+    if (prof_on) {
+        Win_call(P_FETCH_AND_OP, win, target_rank, Bytes(1, datatype), OUT,
+            prof_time);
+        Add_peer(Win_rec(win), target_rank, Bytes(1, datatype), FETCH);
+    }
+    return rv;
+}  /* MPI_Fetch_and_op */
+
+
+int MPI_Compare_and_swap(const void* origin_addr, const void* compare_addr,
+        void* result_addr, MPI_Datatype datatype, int target_rank,
+        MPI_Aint target_disp, MPI_Win win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Compare_and_swap(origin_addr, compare_addr, result_addr,
+        datatype, target_rank, target_disp, win);
+    PROF_STOP;
+    if (prof_on) {
+        Win_call(P_COMPARE_AND_SWAP, win, target_rank, Bytes(1, datatype),
+            OUT, prof_time);
+        Add_peer(Win_rec(win), target_rank, Bytes(1, datatype), FETCH);
+    }
+    return rv;
+}  /* MPI_Compare_and_swap */
+
+
+int MPI_Win_fence(int assert, MPI_Win win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Win_fence(assert, win);
+    PROF_STOP;
+    Win_call(P_WIN_FENCE, win, MPI_PROC_NULL, 0.0, OUT, prof_time);
+    return rv;
+}  /* MPI_Win_fence */
+
+
+int MPI_Win_lock(int lock_type, int rank, int assert, MPI_Win win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Win_lock(lock_type, rank, assert, win);
+    PROF_STOP;
+    Win_call(P_WIN_LOCK, win, MPI_PROC_NULL, 0.0, OUT, prof_time);
+    return rv;
+}  /* MPI_Win_lock */
+
+
+int MPI_Win_unlock(int rank, MPI_Win win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Win_unlock(rank, win);
+    PROF_STOP;
+    Win_call(P_WIN_UNLOCK, win, MPI_PROC_NULL, 0.0, OUT, prof_time);
+    return rv;
+}  /* MPI_Win_unlock */
+
+
+int MPI_Win_lock_all(int assert, MPI_Win win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Win_lock_all(assert, win);
+    PROF_STOP;
+    Win_call(P_WIN_LOCK_ALL, win, MPI_PROC_NULL, 0.0, OUT, prof_time);
+    return rv;
+}  /* MPI_Win_lock_all */
+
+
+int MPI_Win_unlock_all(MPI_Win win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Win_unlock_all(win);
+    PROF_STOP;
+    Win_call(P_WIN_UNLOCK_ALL, win, MPI_PROC_NULL, 0.0, OUT, prof_time);
+    return rv;
+}  /* MPI_Win_unlock_all */
+
+
+int MPI_Win_flush(int rank, MPI_Win win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Win_flush(rank, win);
+    PROF_STOP;
+    Win_call(P_WIN_FLUSH, win, MPI_PROC_NULL, 0.0, OUT, prof_time);
+    return rv;
+}  /* MPI_Win_flush */
+
+
+int MPI_Win_flush_all(MPI_Win win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Win_flush_all(win);
+    PROF_STOP;
+    Win_call(P_WIN_FLUSH_ALL, win, MPI_PROC_NULL, 0.0, OUT, prof_time);
+    return rv;
+}  /* MPI_Win_flush_all */
+
+
+int MPI_Win_post(MPI_Group group, int assert, MPI_Win win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Win_post(group, assert, win);
+    PROF_STOP;
+    Win_call(P_WIN_POST, win, MPI_PROC_NULL, 0.0, OUT, prof_time);
+    return rv;
+}  /* MPI_Win_post */
+
+
+int MPI_Win_start(MPI_Group group, int assert, MPI_Win win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Win_start(group, assert, win);
+    PROF_STOP;
+    Win_call(P_WIN_START, win, MPI_PROC_NULL, 0.0, OUT, prof_time);
+    return rv;
+}  /* MPI_Win_start */
+
+
+int MPI_Win_complete(MPI_Win win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Win_complete(win);
+    PROF_STOP;
+    Win_call(P_WIN_COMPLETE, win, MPI_PROC_NULL, 0.0, OUT, prof_time);
+    return rv;
+}  /* MPI_Win_complete */
+
+
+int MPI_Win_wait(MPI_Win win) {
+    int rv;
+    PROF_START;
+
+    rv = PMPI_Win_wait(win);
+    PROF_STOP;
+    Win_call(P_WIN_WAIT, win, MPI_PROC_NULL, 0.0, OUT, prof_time);
+    return rv;
+}  /* MPI_Win_wait */
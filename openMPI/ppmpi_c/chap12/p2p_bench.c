@@ -0,0 +1,739 @@
+/* p2p_bench.c -- point-to-point latency and bandwidth benchmarks
+ *
+ * Usage:  mpirun -np <p> p2p_bench [options]
+ *
+ *     -test latency|bw|bibw|all    (default all)
+ *     -mode blocking|nonblocking|persistent|sync|ready|buffered|all
+ *                                  (default all)
+ *     -min <bytes>, -max <bytes>   smallest and largest messages
+ *                                  (default 0 and 64M).  Sizes are
+ *                                  0 (if min is 0) and then min, 2*min,
+ *                                  4*min, ..., up to max.  A suffix of
+ *                                  K or M multiplies by 1024 or 1024^2
+ *     -iters <n>                   timed samples for each size (default
+ *                                  1000).  Fewer for messages larger
+ *                                  than LARGE_MSG bytes
+ *     -warmup <n>                  untimed samples first (default 10)
+ *     -window <n>                  messages in flight in the bandwidth
+ *                                  tests (default 64)
+ *     -window_mem <bytes>          receive buffer space for a window
+ *                                  (default 64M).  Limits the window
+ *                                  for large messages.  In buffered
+ *                                  mode the window, with
+ *                                  MPI_BSEND_OVERHEAD for each message,
+ *                                  must fit in window_mem bytes
+ *     -pairs first|all             time processes 0 and 1 only, or
+ *                                  every pair of processes, one pair
+ *                                  at a time (default first)
+ *
+ * Output:  CSV on stdout of process 0, one line for each pair of
+ *     processes, test, send mode, and message size.  Times are in
+ *     microseconds:
+ *         latency:  half the round trip time of a ping-pong
+ *         bw:       time per message for a window of messages from
+ *                   the first process to the second, followed by a
+ *                   zero-byte reply
+ *         bibw:     the same, with both processes sending at once
+ *     The columns are the minimum, the 50th, 90th and 99th percentiles,
+ *     the maximum and the mean of the samples.  MBps_p50 and MBps_max
+ *     are the bandwidths (10^6 bytes per second) at the median and the
+ *     minimum time.  For bibw they count the data in both directions.
+ *
+ * Notes:
+ *     1.  Sends use the mode given.  Receives are MPI_Recv in the
+ *         blocking, sync and buffered ping-pongs, and otherwise are
+ *         posted before the matching send starts, so ready mode sends
+ *         are correct.  Persistent requests are created outside the
+ *         timed loop.
+ *     2.  The buffer attached for MPI_Bsend holds two windows, with
+ *         the overhead for each message.  After each window in the
+ *         bandwidth tests the sender detaches and reattaches it,
+ *         which waits until the buffered messages have gone, so a
+ *         round never starts with the last round's data still in
+ *         the buffer.  The detach isn't timed.
+ *     3.  The host names let -pairs all show the topology:  pairs on
+ *         the same node against pairs on different nodes.
+ *     4.  This generalizes ping_pong.c, and the ring timings of
+ *         chap09/comm_time_7.c.  Compile with mpicc -o p2p_bench
+ *         p2p_bench.c
+ *
+ * See Chap 12, pp. 267 & ff. in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "mpi.h"
+
+/* Tests */
+#define TESTS    3
+#define LATENCY  0
+#define BW       1
+#define BIBW     2
+
+/* Send modes */
+#define MODES        6
+#define BLOCKING     0
+#define NONBLOCKING  1
+#define PERSISTENT   2
+#define SYNC         3
+#define READY        4
+#define BUFFERED     5
+
+#define LARGE_MSG  65536  /* Fewer samples for larger messages */
+#define MIN_ITERS  10
+#define DATA_TAG   0
+#define GO_TAG     1
+#define RESULT_TAG 2
+
+/* Statistics sent to process 0 */
+#define STATS    7
+#define MIN      0
+#define P50      1
+#define P90      2
+#define P99      3
+#define MAX      4
+#define MEAN     5
+#define SAMPLES  6
+
+typedef struct {
+    int   tests[TESTS];      /* Nonzero to run           */
+    int   modes[MODES];
+    int   min_size;          /* In bytes                 */
+    int   max_size;
+    int   iters;
+    int   warmup;
+    int   window;
+    int   window_mem;
+    int   all_pairs;
+} OPTIONS_T;
+
+char* test_names[] = {"latency", "bw", "bibw"};
+char* mode_names[] = {"blocking", "nonblocking", "persistent", "sync",
+                      "ready", "buffered"};
+
+/* Message buffers */
+char*  send_buf;
+char*  recv_buf;         /* window_mem bytes            */
+
+void Get_options(int argc, char* argv[], int my_rank, OPTIONS_T* opts);
+int  Parse_size(char* arg);
+int  Lookup(char* name, char* names[], int count, int* flags);
+void Usage(int my_rank, char* prog);
+int  Iterations(OPTIONS_T* opts, int size);
+int  Window(OPTIONS_T* opts, int size, int mode);
+void Pair_sync(int partner, MPI_Comm comm);
+void Send_msg(int mode, char* buf, int size, int dest, MPI_Comm comm);
+void Latency(int mode, int size, int count, int initiator,
+         int partner, MPI_Comm comm, double* samples);
+void Bandwidth(int mode, int size, int window, int count,
+         int initiator, int bidirectional, int partner, MPI_Comm comm,
+         double* samples);
+void Post_receives(int mode, int size, int window, int partner,
+         MPI_Comm comm, MPI_Request* recv_reqs);
+void Compute_stats(double* samples, int count, double* stats);
+int  Compare_doubles(const void* a, const void* b);
+void Print_row(int test, int mode, int rank_a, int rank_b,
+         char* host_a, char* host_b, int size, int window,
+         double* stats);
+
+int main(int argc, char* argv[]) {
+    int         p;
+    int         my_rank;
+    OPTIONS_T   opts;
+    MPI_Comm    comm;            /* For the benchmarks */
+    MPI_Comm    result_comm;     /* For the results    */
+    char        my_name[MPI_MAX_PROCESSOR_NAME];
+    char*       names = NULL;
+    int         length;
+    double*     samples;
+    double      stats[STATS];
+    char*       bsend_buf;
+    int         bsend_size;
+    int         a, b, test, mode, size;
+    int         count, warmup, window, partner;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &p);
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+    MPI_Comm_dup(MPI_COMM_WORLD, &comm);
+    MPI_Comm_dup(MPI_COMM_WORLD, &result_comm);
+
+    if (p < 2) {
+        if (my_rank == 0)
+            fprintf(stderr, "p2p_bench needs at least 2 processes\n");
+        MPI_Finalize();
+        exit(0);
+    }
+    Get_options(argc, argv, my_rank, &opts);
+
+    memset(my_name, 0, MPI_MAX_PROCESSOR_NAME);
+    MPI_Get_processor_name(my_name, &length);
+    if (my_rank == 0)
+        names = (char*) malloc(p*MPI_MAX_PROCESSOR_NAME);
+    MPI_Gather(my_name, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, names,
+        MPI_MAX_PROCESSOR_NAME, MPI_CHAR, 0, MPI_COMM_WORLD);
+
+    send_buf = (char*) malloc(opts.max_size + 1);
+    recv_buf = (char*) malloc(opts.window_mem + 1);
+    samples = (double*) malloc((opts.iters + opts.warmup)*sizeof(double));
+    bsend_size = 2*(opts.window_mem + (opts.window + 1)*MPI_BSEND_OVERHEAD);
+    bsend_buf = (char*) malloc(bsend_size);
+    if ((send_buf == NULL) || (recv_buf == NULL) || (samples == NULL)
+            || (bsend_buf == NULL)) {
+        fprintf(stderr, "Process %d > Can't allocate buffers\n", my_rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    memset(send_buf, my_rank % 128, opts.max_size + 1);
+    MPI_Buffer_attach(bsend_buf, bsend_size);
+
+    if (my_rank == 0) {
+        printf("# p2p_bench:  p = %d, MPI_Wtick = %e\n", p, MPI_Wtick());
+        printf("test,mode,rank_a,rank_b,host_a,host_b,bytes,samples,"
+               "window,min_us,p50_us,p90_us,p99_us,max_us,mean_us,"
+               "MBps_p50,MBps_max\n");
+        fflush(stdout);
+    }
+
+    /* Every process runs through the same loops, so process 0 */
+    /*     knows which result comes next                       */
+    for (a = 0; a < p - 1; a++)
+        for (b = a + 1; b < p; b++) {
+            if (!opts.all_pairs && ((a != 0) || (b != 1))) continue;
+            partner = (my_rank == a) ? b : a;
+            for (test = 0; test < TESTS; test++) {
+                if (!opts.tests[test]) continue;
+                for (mode = 0; mode < MODES; mode++) {
+                    if (!opts.modes[mode]) continue;
+                    size = opts.min_size;
+                    while (size <= opts.max_size) {
+                        count = Iterations(&opts, size);
+                        warmup = (opts.warmup < count) ?
+                            opts.warmup : count;
+                        window = (test == LATENCY) ? 1 :
+                            Window(&opts, size, mode);
+                        if ((my_rank == a) || (my_rank == b)) {
+                            if (test == LATENCY)
+                                Latency(mode, size, warmup + count,
+                                    my_rank == a, partner, comm,
+                                    samples);
+                            else
+                                Bandwidth(mode, size, window,
+                                    warmup + count,
+                                    my_rank == a, test == BIBW,
+                                    partner, comm, samples);
+                        }
+                        if (my_rank == a) {
+                            Compute_stats(samples + warmup, count,
+                                stats);
+                            if (a != 0)
+                                MPI_Send(stats, STATS, MPI_DOUBLE, 0,
+                                    RESULT_TAG, result_comm);
+                        }
+                        if (my_rank == 0) {
+                            if (a != 0)
+                                MPI_Recv(stats, STATS, MPI_DOUBLE, a,
+                                    RESULT_TAG, result_comm,
+                                    MPI_STATUS_IGNORE);
+                            Print_row(test, mode, a, b,
+                                names + a*MPI_MAX_PROCESSOR_NAME,
+                                names + b*MPI_MAX_PROCESSOR_NAME,
+                                size, window, stats);
+                        }
+                        size = (size == 0) ? 1 : 2*size;
+                    }
+                }
+            }
+            MPI_Barrier(comm);
+        }
+
+    MPI_Buffer_detach(&bsend_buf, &bsend_size);
+    free(bsend_buf);
+    free(send_buf);
+    free(recv_buf);
+    free(samples);
+    if (my_rank == 0) free(names);
+    MPI_Comm_free(&comm);
+    MPI_Comm_free(&result_comm);
+    MPI_Finalize();
+    return 0;
+}  /* main */
+
+
+/********************************************************/
+void Get_options(
+         int         argc     /* in  */,
+         char*       argv[]   /* in  */,
+         int         my_rank  /* in  */,
+         OPTIONS_T*  opts     /* out */) {
+    int i;
+    int ok = 1;
+
+    for (i = 0; i < TESTS; i++) opts->tests[i] = 1;
+    for (i = 0; i < MODES; i++) opts->modes[i] = 1;
+    opts->min_size = 0;
+    opts->max_size = 64*1024*1024;
+    opts->iters = 1000;
+    opts->warmup = 10;
+    opts->window = 64;
+    opts->window_mem = 64*1024*1024;
+    opts->all_pairs = 0;
+
+    for (i = 1; (i < argc) && ok; i++) {
+        if (i == argc - 1) {
+            ok = 0;
+        } else if (strcmp(argv[i], "-test") == 0) {
+            ok = Lookup(argv[++i], test_names, TESTS, opts->tests);
+        } else if (strcmp(argv[i], "-mode") == 0) {
+            ok = Lookup(argv[++i], mode_names, MODES, opts->modes);
+        } else if (strcmp(argv[i], "-min") == 0) {
+            opts->min_size = Parse_size(argv[++i]);
+        } else if (strcmp(argv[i], "-max") == 0) {
+            opts->max_size = Parse_size(argv[++i]);
+        } else if (strcmp(argv[i], "-iters") == 0) {
+            opts->iters = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-warmup") == 0) {
+            opts->warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-window") == 0) {
+            opts->window = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-window_mem") == 0) {
+            opts->window_mem = Parse_size(argv[++i]);
+        } else if (strcmp(argv[i], "-pairs") == 0) {
+            i++;
+            if (strcmp(argv[i], "all") == 0)
+                opts->all_pairs = 1;
+            else if (strcmp(argv[i], "first") != 0)
+                ok = 0;
+        } else {
+            ok = 0;
+        }
+    }
+
+    if ((opts->min_size < 0) || (opts->max_size < opts->min_size) ||
+            (opts->iters < 1) || (opts->warmup < 0) ||
+            (opts->window < 1))
+        ok = 0;
+    if (!ok) Usage(my_rank, argv[0]);
+    if (opts->window_mem < opts->max_size)
+        opts->window_mem = opts->max_size;
+    /* The buffer for MPI_Bsend holds two windows */
+    if (2*(opts->window_mem + (opts->window + 1L)*MPI_BSEND_OVERHEAD)
+            > INT_MAX) {
+        if (my_rank == 0)
+            fprintf(stderr, "-window_mem and -window are too large\n");
+        Usage(my_rank, argv[0]);
+    }
+}  /* Get_options */
+
+
+/********************************************************/
+/* A number, optionally followed by K or M */
+int Parse_size(
+         char*  arg  /* in */) {
+    char* end;
+    long  size;
+
+    size = strtol(arg, &end, 10);
+    if ((*end == 'K') || (*end == 'k'))
+        size *= 1024;
+    else if ((*end == 'M') || (*end == 'm'))
+        size *= 1024*1024;
+    if ((size < 0) || (size > 1024L*1024*1024))
+        return -1;
+    return (int) size;
+}  /* Parse_size */
+
+
+/********************************************************/
+/* Set flags[i] = 1 for names[i] == name, and the others */
+/*     to 0.  "all" sets all of them.  Returns 0 if name  */
+/*     isn't found.                                       */
+int Lookup(
+         char*  name     /* in  */,
+         char*  names[]  /* in  */,
+         int    count    /* in  */,
+         int*   flags    /* out */) {
+    int i;
+    int found = 0;
+
+    for (i = 0; i < count; i++) {
+        flags[i] = (strcmp(name, "all") == 0) ||
+                   (strcmp(name, names[i]) == 0);
+        if (flags[i]) found = 1;
+    }
+    return found;
+}  /* Lookup */
+
+
+/********************************************************/
+void Usage(
+         int    my_rank  /* in */,
+         char*  prog     /* in */) {
+
+    if (my_rank == 0) {
+        fprintf(stderr, "usage:  mpirun -np <p> %s\n", prog);
+        fprintf(stderr, "    [-test latency|bw|bibw|all]\n");
+        fprintf(stderr, "    [-mode blocking|nonblocking|persistent|"
+                        "sync|ready|buffered|all]\n");
+        fprintf(stderr, "    [-min <bytes>] [-max <bytes>] "
+                        "[-iters <n>] [-warmup <n>]\n");
+        fprintf(stderr, "    [-window <n>] [-window_mem <bytes>] "
+                        "[-pairs first|all]\n");
+    }
+    MPI_Finalize();
+    exit(0);
+}  /* Usage */
+
+
+/********************************************************/
+/* Samples for messages of size bytes:  large messages */
+/*     get fewer, so the total data stays about the    */
+/*     same as for LARGE_MSG bytes                     */
+int Iterations(
+         OPTIONS_T*  opts  /* in */,
+         int         size  /* in */) {
+    long count = opts->iters;
+
+    if (size > LARGE_MSG) {
+        count = count*LARGE_MSG/size;
+        if (count < MIN_ITERS) count = MIN_ITERS;
+        if (count > opts->iters) count = opts->iters;
+    }
+    return (int) count;
+}  /* Iterations */
+
+
+/********************************************************/
+/* Each message in a window gets its own receive buffer. */
+/*     A window of buffered sends, with the overhead for   */
+/*     each, must also fit in half the attached buffer.    */
+int Window(
+         OPTIONS_T*  opts  /* in */,
+         int         size  /* in */,
+         int         mode  /* in */) {
+    int  window = opts->window;
+    long per_msg = size;
+
+    if (mode == BUFFERED) per_msg += MPI_BSEND_OVERHEAD;
+    if ((per_msg > 0) && (opts->window_mem/per_msg < window))
+        window = (int) (opts->window_mem/per_msg);
+    if (window < 1) window = 1;
+    return window;
+}  /* Window */
+
+
+/********************************************************/
+/* A barrier for the two processes being timed.  The    */
+/*     others may be waiting in MPI_Barrier on comm.    */
+void Pair_sync(
+         int       partner  /* in */,
+         MPI_Comm  comm     /* in */) {
+
+    MPI_Sendrecv(NULL, 0, MPI_BYTE, partner, GO_TAG, NULL, 0, MPI_BYTE,
+        partner, GO_TAG, comm, MPI_STATUS_IGNORE);
+}  /* Pair_sync */
+
+
+/********************************************************/
+/* The blocking sends, in the given mode */
+void Send_msg(
+         int       mode  /* in */,
+         char*     buf   /* in */,
+         int       size  /* in */,
+         int       dest  /* in */,
+         MPI_Comm  comm  /* in */) {
+
+    switch (mode) {
+        case SYNC:
+            MPI_Ssend(buf, size, MPI_BYTE, dest, DATA_TAG, comm);
+            break;
+        case READY:
+            MPI_Rsend(buf, size, MPI_BYTE, dest, DATA_TAG, comm);
+            break;
+        case BUFFERED:
+            MPI_Bsend(buf, size, MPI_BYTE, dest, DATA_TAG, comm);
+            break;
+        default:
+            MPI_Send(buf, size, MPI_BYTE, dest, DATA_TAG, comm);
+    }
+}  /* Send_msg */
+
+
+/********************************************************/
+/* Ping-pong.  samples[i] = half the round trip time of */
+/*     ping-pong i, on the initiator.                   */
+void Latency(
+         int       mode       /* in  */,
+         int       size       /* in  */,
+         int       count      /* in  */,
+         int       initiator  /* in  */,
+         int       partner    /* in  */,
+         MPI_Comm  comm       /* in  */,
+         double*   samples    /* out */) {
+    MPI_Request  reqs[2];
+    double       start;
+    int          i;
+
+    if (mode == PERSISTENT) {
+        MPI_Recv_init(recv_buf, size, MPI_BYTE, partner, DATA_TAG, comm,
+            &reqs[0]);
+        MPI_Send_init(send_buf, size, MPI_BYTE, partner, DATA_TAG, comm,
+            &reqs[1]);
+    } else if (mode == READY) {
+        /* The responder's first receive is posted before the */
+        /*     initiator's first send                         */
+        if (!initiator)
+            MPI_Irecv(recv_buf, size, MPI_BYTE, partner, DATA_TAG, comm,
+                &reqs[0]);
+    }
+    Pair_sync(partner, comm);
+
+    for (i = 0; i < count; i++) {
+        if (initiator) {
+            start = MPI_Wtime();
+            switch (mode) {
+                case NONBLOCKING:
+                    MPI_Irecv(recv_buf, size, MPI_BYTE, partner,
+                        DATA_TAG, comm, &reqs[0]);
+                    MPI_Isend(send_buf, size, MPI_BYTE, partner,
+                        DATA_TAG, comm, &reqs[1]);
+                    MPI_Waitall(2, reqs, MPI_STATUSES_IGNORE);
+                    break;
+                case PERSISTENT:
+                    MPI_Startall(2, reqs);
+                    MPI_Waitall(2, reqs, MPI_STATUSES_IGNORE);
+                    break;
+                case READY:
+                    MPI_Irecv(recv_buf, size, MPI_BYTE, partner,
+                        DATA_TAG, comm, &reqs[0]);
+                    MPI_Rsend(send_buf, size, MPI_BYTE, partner,
+                        DATA_TAG, comm);
+                    MPI_Wait(&reqs[0], MPI_STATUS_IGNORE);
+                    break;
+                default:
+                    Send_msg(mode, send_buf, size, partner, comm);
+                    MPI_Recv(recv_buf, size, MPI_BYTE, partner,
+                        DATA_TAG, comm, MPI_STATUS_IGNORE);
+            }
+            samples[i] = (MPI_Wtime() - start)/2.0;
+        } else {
+            switch (mode) {
+                case NONBLOCKING:
+                    MPI_Irecv(recv_buf, size, MPI_BYTE, partner,
+                        DATA_TAG, comm, &reqs[0]);
+                    MPI_Wait(&reqs[0], MPI_STATUS_IGNORE);
+                    MPI_Isend(send_buf, size, MPI_BYTE, partner,
+                        DATA_TAG, comm, &reqs[1]);
+                    MPI_Wait(&reqs[1], MPI_STATUS_IGNORE);
+                    break;
+                case PERSISTENT:
+                    MPI_Start(&reqs[0]);
+                    MPI_Wait(&reqs[0], MPI_STATUS_IGNORE);
+                    MPI_Start(&reqs[1]);
+                    MPI_Wait(&reqs[1], MPI_STATUS_IGNORE);
+                    break;
+                case READY:
+                    /* Post the next receive before replying */
+                    MPI_Wait(&reqs[0], MPI_STATUS_IGNORE);
+                    if (i < count - 1)
+                        MPI_Irecv(recv_buf, size, MPI_BYTE, partner,
+                            DATA_TAG, comm, &reqs[0]);
+                    MPI_Rsend(send_buf, size, MPI_BYTE, partner,
+                        DATA_TAG, comm);
+                    break;
+                default:
+                    MPI_Recv(recv_buf, size, MPI_BYTE, partner,
+                        DATA_TAG, comm, MPI_STATUS_IGNORE);
+                    Send_msg(mode, send_buf, size, partner, comm);
+            }
+        }
+    }
+
+    if (mode == PERSISTENT) {
+        MPI_Request_free(&reqs[0]);
+        MPI_Request_free(&reqs[1]);
+    }
+}  /* Latency */
+
+
+/********************************************************/
+/* Post the receives for a window.  Message k goes to */
+/*     its own part of recv_buf.                      */
+void Post_receives(
+         int          mode       /* in  */,
+         int          size       /* in  */,
+         int          window     /* in  */,
+         int          partner    /* in  */,
+         MPI_Comm     comm       /* in  */,
+         MPI_Request* recv_reqs  /* out */) {
+    int k;
+
+    if (mode == PERSISTENT)
+        MPI_Startall(window, recv_reqs);
+    else
+        for (k = 0; k < window; k++)
+            MPI_Irecv(recv_buf + k*size, size, MPI_BYTE, partner,
+                DATA_TAG, comm, &recv_reqs[k]);
+}  /* Post_receives */
+
+
+/********************************************************/
+/* Windows of messages.  Each round the receiver posts   */
+/*     the receives for the window, and then sends the   */
+/*     sender a zero-byte "go" message.  The sender      */
+/*     times from the first send of the window until     */
+/*     the next go, which also says that the window has  */
+/*     arrived.  samples[i] = time per message.          */
+/* If bidirectional, both processes send and receive     */
+/*     windows at once.                                  */
+/* In buffered mode the sender waits for its buffered    */
+/*     messages to go after each round, untimed.         */
+void Bandwidth(
+         int       mode           /* in  */,
+         int       size           /* in  */,
+         int       window         /* in  */,
+         int       count          /* in  */,
+         int       initiator      /* in  */,
+         int       bidirectional  /* in  */,
+         int       partner        /* in  */,
+         MPI_Comm  comm           /* in  */,
+         double*   samples        /* out */) {
+    int          sender = initiator || bidirectional;
+    int          receiver = !initiator || bidirectional;
+    MPI_Request* send_reqs;
+    MPI_Request* recv_reqs;
+    double       start;
+    char*        bsend_buf;
+    int          bsend_size;
+    int          i, k;
+
+    send_reqs = (MPI_Request*) malloc(2*window*sizeof(MPI_Request));
+    recv_reqs = send_reqs + window;
+    if (mode == PERSISTENT)
+        for (k = 0; k < window; k++) {
+            if (sender)
+                MPI_Send_init(send_buf, size, MPI_BYTE, partner,
+                    DATA_TAG, comm, &send_reqs[k]);
+            if (receiver)
+                MPI_Recv_init(recv_buf + k*size, size, MPI_BYTE,
+                    partner, DATA_TAG, comm, &recv_reqs[k]);
+        }
+    Pair_sync(partner, comm);
+
+    if (receiver)
+        Post_receives(mode, size, window, partner, comm, recv_reqs);
+    if (bidirectional)
+        Pair_sync(partner, comm);
+    else if (receiver)
+        MPI_Send(NULL, 0, MPI_BYTE, partner, GO_TAG, comm);
+    else
+        MPI_Recv(NULL, 0, MPI_BYTE, partner, GO_TAG, comm,
+            MPI_STATUS_IGNORE);
+
+    for (i = 0; i < count; i++) {
+        start = MPI_Wtime();
+        if (sender) {
+            switch (mode) {
+                case NONBLOCKING:
+                    for (k = 0; k < window; k++)
+                        MPI_Isend(send_buf, size, MPI_BYTE, partner,
+                            DATA_TAG, comm, &send_reqs[k]);
+                    MPI_Waitall(window, send_reqs, MPI_STATUSES_IGNORE);
+                    break;
+                case PERSISTENT:
+                    MPI_Startall(window, send_reqs);
+                    MPI_Waitall(window, send_reqs, MPI_STATUSES_IGNORE);
+                    break;
+                default:
+                    for (k = 0; k < window; k++)
+                        Send_msg(mode, send_buf, size, partner, comm);
+            }
+        }
+        if (receiver) {
+            MPI_Waitall(window, recv_reqs, MPI_STATUSES_IGNORE);
+            if (i < count - 1)
+                Post_receives(mode, size, window, partner, comm,
+                    recv_reqs);
+        }
+        if (bidirectional)
+            Pair_sync(partner, comm);
+        else if (receiver)
+            MPI_Send(NULL, 0, MPI_BYTE, partner, GO_TAG, comm);
+        else
+            MPI_Recv(NULL, 0, MPI_BYTE, partner, GO_TAG, comm,
+                MPI_STATUS_IGNORE);
+        samples[i] = (MPI_Wtime() - start)/window;
+        if (sender && (mode == BUFFERED)) {
+            MPI_Buffer_detach(&bsend_buf, &bsend_size);
+            MPI_Buffer_attach(bsend_buf, bsend_size);
+        }
+    }
+
+    if (mode == PERSISTENT)
+        for (k = 0; k < window; k++) {
+            if (sender) MPI_Request_free(&send_reqs[k]);
+            if (receiver) MPI_Request_free(&recv_reqs[k]);
+        }
+    free(send_reqs);
+}  /* Bandwidth */
+
+
+/********************************************************/
+int Compare_doubles(const void* a, const void* b) {
+    double x = *((double*) a);
+    double y = *((double*) b);
+
+    if (x < y)
+        return -1;
+    else if (x > y)
+        return 1;
+    else
+        return 0;
+}  /* Compare_doubles */
+
+
+/********************************************************/
+/* Sorts the samples.  Percentiles use the nearest rank */
+void Compute_stats(
+         double*  samples  /* in/out */,
+         int      count    /* in     */,
+         double*  stats    /* out    */) {
+    double sum = 0.0;
+    int    i;
+
+    qsort(samples, count, sizeof(double), Compare_doubles);
+    for (i = 0; i < count; i++)
+        sum += samples[i];
+    stats[MIN] = samples[0];
+    stats[P50] = samples[(count*50 + 99)/100 - 1];
+    stats[P90] = samples[(count*90 + 99)/100 - 1];
+    stats[P99] = samples[(count*99 + 99)/100 - 1];
+    stats[MAX] = samples[count-1];
+    stats[MEAN] = sum/count;
+    stats[SAMPLES] = count;
+}  /* Compute_stats */
+
+
+/********************************************************/
+void Print_row(
+         int      test    /* in */,
+         int      mode    /* in */,
+         int      rank_a  /* in */,
+         int      rank_b  /* in */,
+         char*    host_a  /* in */,
+         char*    host_b  /* in */,
+         int      size    /* in */,
+         int      window  /* in */,
+         double*  stats   /* in */) {
+    double bytes = (test == BIBW) ? 2.0*size : (double) size;
+
+    printf("%s,%s,%d,%d,%s,%s,%d,%d,%d,", test_names[test],
+        mode_names[mode], rank_a, rank_b, host_a, host_b, size,
+        (int) stats[SAMPLES], window);
+    printf("%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,",
+        1.0e6*stats[MIN], 1.0e6*stats[P50], 1.0e6*stats[P90],
+        1.0e6*stats[P99], 1.0e6*stats[MAX], 1.0e6*stats[MEAN]);
+    printf("%.2f,%.2f\n", bytes/stats[P50]/1.0e6,
+        bytes/stats[MIN]/1.0e6);
+    fflush(stdout);
+}  /* Print_row */
@@ -0,0 +1,123 @@
+/* bound.c -- cost model and lower bounds for pruning the search.
+ *
+ * Feasible (see par_dfs.c) only expands a node if Lower_bound(node) is
+ *     less than the best solution known so far -- the incumbent.  The
+ *     bound is chosen when Setup_bound is called.  The bounds are
+ *
+ *     NO_BOUND:  0.  No interior node is pruned unless the incumbent
+ *         is 0, so every leaf is reached, but a leaf still only
+ *         replaces the incumbent if it's cheaper.  This is the only
+ *         bound that's valid for the original cost model.
+ *     PATH_BOUND:  the cost of the path from the root to the node.
+ *     PATH_DEPTH_BOUND:  the cost of the path from the root, plus
+ *         MIN_EDGE_COST for each level below the node.
+ *
+ *     The last two need the path cost model (compile with -DPATH_COST).
+ *     A program can install its own bound with Set_lower_bound.  The
+ *     bound must never exceed the cost of a leaf below the node, or
+ *     the minimum cost leaf may be pruned.
+ *
+ * See Chap 14, pp. 328 & ff, in PPMPI.
+ */
+#include <stdio.h>
+#include "node_stack.h"
+#include "solution.h"
+#include "bound.h"
+
+extern int max_depth;
+
+static COST_T No_bound(NODE_T node);
+#ifdef PATH_COST
+static COST_T Path_bound(NODE_T node);
+static COST_T Path_depth_bound(NODE_T node);
+#endif
+
+static char*  bound_name = "none";
+static COST_T (*bound)(NODE_T node) = No_bound;
+
+
+/*********************************************************************/
+void Setup_bound(
+         int  which  /* in */) {
+
+    switch (which) {
+#ifdef PATH_COST
+        case PATH_BOUND:
+            Set_lower_bound("path", Path_bound);
+            break;
+        case PATH_DEPTH_BOUND:
+            Set_lower_bound("path + depth", Path_depth_bound);
+            break;
+#endif
+        default:
+            Set_lower_bound("none", No_bound);
+    }
+}  /* Setup_bound */
+
+
+/*********************************************************************/
+void Set_lower_bound(
+         char*   name                  /* in */,
+         COST_T  (*new_bound)(NODE_T)  /* in */) {
+    bound_name = name;
+    bound = new_bound;
+}  /* Set_lower_bound */
+
+
+/*********************************************************************/
+char* Bound_name(void) {
+    return bound_name;
+}  /* Bound_name */
+
+
+/*********************************************************************/
+COST_T Lower_bound(
+           NODE_T  node  /* in */) {
+    return (*bound)(node);
+}  /* Lower_bound */
+
+
+/*********************************************************************/
+COST_T Leaf_cost(
+           NODE_T  node  /* in */) {
+#ifdef PATH_COST
+    return (COST_T) Path_cost(node);
+#else
+    return (COST_T) Seed(node);
+#endif
+}  /* Leaf_cost */
+
+
+/*********************************************************************/
+/* Called after Initialize_node */
+void Set_path_cost(
+         NODE_T  node    /* in/out */,
+         NODE_T  parent  /* in     */) {
+#ifdef PATH_COST
+    Path_cost(node) = Path_cost(parent) + Edge_cost(node);
+#endif
+}  /* Set_path_cost */
+
+
+/*********************************************************************/
+static COST_T No_bound(
+                  NODE_T  node  /* in */) {
+    return 0;
+}  /* No_bound */
+
+
+#ifdef PATH_COST
+/*********************************************************************/
+static COST_T Path_bound(
+                  NODE_T  node  /* in */) {
+    return (COST_T) Path_cost(node);
+}  /* Path_bound */
+
+
+/*********************************************************************/
+static COST_T Path_depth_bound(
+                  NODE_T  node  /* in */) {
+    return (COST_T) (Path_cost(node) + 
+        (max_depth - Depth(node))*MIN_EDGE_COST);
+}  /* Path_depth_bound */
+#endif
@@ -0,0 +1,49 @@
+/* bound.h
+ *
+ * Definitions and declarations for the cost model and the lower
+ *     bounds used to prune the search.
+ */
+#ifndef BOUND_H
+#define BOUND_H
+
+#include "node_stack.h"
+#include "solution.h"
+
+/* Lower bounds */
+#define NO_BOUND          0  /* 0:  only leaves are compared with the  */
+                             /*     incumbent                           */
+#define PATH_BOUND        1  /* cost of the path to the node           */
+#define PATH_DEPTH_BOUND  2  /* path cost + MIN_EDGE_COST per level    */
+                             /*     still to go                         */
+#define NUM_BOUNDS        3
+
+/* Compile with -DBOUND=<n> to change the default */
+#ifndef BOUND
+#define BOUND NO_BOUND
+#endif
+
+/* In the original cost model, the cost of a leaf is its seed, so  */
+/*     nothing is known about it until the leaf is reached.  Compile */
+/*     with -DPATH_COST to make the cost of a leaf the sum of the    */
+/*     costs of the edges on the path from the root.  The cost of    */
+/*     the edge to a node is 1 + Seed(node) % EDGE_COST_RANGE.       */
+#ifdef PATH_COST
+#ifndef EDGE_COST_RANGE
+#define EDGE_COST_RANGE 10
+#endif
+#define MIN_EDGE_COST  1
+#define Edge_cost(node) (MIN_EDGE_COST + Seed(node) % EDGE_COST_RANGE)
+#else
+#if BOUND != NO_BOUND
+#error "-DBOUND=<n> needs -DPATH_COST"
+#endif
+#endif
+
+void    Setup_bound(int which);
+void    Set_lower_bound(char* name, COST_T (*bound)(NODE_T node));
+char*   Bound_name(void);
+COST_T  Lower_bound(NODE_T node);
+COST_T  Leaf_cost(NODE_T node);
+void    Set_path_cost(NODE_T node, NODE_T parent);
+
+#endif
@@ -0,0 +1,114 @@
+/* deque.c -- Chase-Lev work-stealing deque.  Only the thread that
+ *     owns a deque pushes and pops, at the bottom.  Any other thread
+ *     may steal from the top.  The owner and a thief only contend
+ *     for the last packet, and the contention is resolved with a
+ *     single compare-and-swap on top.
+ *
+ * The deque doesn't grow:  Deque_push fails when it's full.  So a
+ *     slot can't be reused until top has moved past it, and a thief
+ *     that reads a slot that's being overwritten will fail its
+ *     compare-and-swap.
+ *
+ * The memory orders follow Le, Pop, Cohen and Zappa Nardelli,
+ *     "Correct and Efficient Work-Stealing for Weak Memory Models,"
+ *     PPoPP 2013.
+ */
+#include "deque.h"
+
+#define MASK (DEQUE_SIZE - 1)
+
+/*********************************************************************/
+void Initialize_deque(
+         DEQUE_T  deque  /* out */) {
+    int i;
+
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    for (i = 0; i < DEQUE_SIZE; i++)
+        atomic_init(&deque->slots[i], PACKET_NULL);
+}  /* Initialize_deque */
+
+
+/*********************************************************************/
+/* Owner only.  Return 0 if successful, negative if the deque is full */
+int Deque_push(
+        DEQUE_T   deque   /* in/out */,
+        PACKET_T  packet  /* in     */) {
+    long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+
+    if (b - t >= DEQUE_SIZE)
+        return -1;
+    atomic_store_explicit(&deque->slots[b & MASK], packet,
+        memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    return 0;
+}  /* Deque_push */
+
+
+/*********************************************************************/
+/* Owner only.  Return the most recently pushed packet, or       */
+/*     PACKET_NULL if the deque is empty                          */
+PACKET_T Deque_pop(
+             DEQUE_T  deque  /* in/out */) {
+    long      b = atomic_load_explicit(&deque->bottom,
+                      memory_order_relaxed) - 1;
+    long      t;
+    PACKET_T  packet;
+
+    atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (t > b) {
+        /* Empty */
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        return PACKET_NULL;
+    }
+
+    packet = atomic_load_explicit(&deque->slots[b & MASK],
+        memory_order_relaxed);
+    if (t == b) {
+        /* Last packet:  race the thieves for it */
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &t,
+                t + 1, memory_order_seq_cst, memory_order_relaxed))
+            packet = PACKET_NULL;
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    }
+    return packet;
+}  /* Deque_pop */
+
+
+/*********************************************************************/
+/* Any thread.  Return the oldest packet, or PACKET_NULL if the deque */
+/*     is empty or another thread took the packet first              */
+PACKET_T Deque_steal(
+             DEQUE_T  deque  /* in/out */) {
+    long      t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    long      b;
+    PACKET_T  packet;
+
+    atomic_thread_fence(memory_order_seq_cst);
+    b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (t >= b)
+        return PACKET_NULL;
+
+    packet = atomic_load_explicit(&deque->slots[t & MASK],
+        memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+            memory_order_seq_cst, memory_order_relaxed))
+        return PACKET_NULL;
+    return packet;
+}  /* Deque_steal */
+
+
+/*********************************************************************/
+/* Any thread.  Only a hint, unless called by the owner */
+long Deque_size(
+         DEQUE_T  deque  /* in */) {
+    long b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+
+    return (b > t ? b - t : 0);
+}  /* Deque_size */
@@ -0,0 +1,35 @@
+/* deque.h
+ *
+ * Definitions and declarations for the work-stealing deques used by
+ *     the threads of a process in hybrid (-DHYBRID) tree search.
+ */
+#ifndef DEQUE_H
+#define DEQUE_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+/* Number of packets a deque can hold.  Must be a power of 2. */
+#ifndef DEQUE_SIZE
+#define DEQUE_SIZE 16
+#endif
+
+/* A packet is a buffer of nodes built by Pack_nodes */
+typedef int* PACKET_T;
+#define PACKET_NULL ((PACKET_T) NULL)
+
+typedef struct {
+    atomic_long         top;     /* next packet to be stolen */
+    atomic_long         bottom;  /* next free slot           */
+    _Atomic(PACKET_T)   slots[DEQUE_SIZE];
+} DEQUE_STRUCT_T;
+
+typedef DEQUE_STRUCT_T* DEQUE_T;
+
+void      Initialize_deque(DEQUE_T deque);
+int       Deque_push(DEQUE_T deque, PACKET_T packet);
+PACKET_T  Deque_pop(DEQUE_T deque);
+PACKET_T  Deque_steal(DEQUE_T deque);
+long      Deque_size(DEQUE_T deque);
+
+#endif
@@ -0,0 +1,343 @@
+/* hybrid.c -- functions for hybrid MPI + OpenMP tree search.  Compile
+ *     with -DHYBRID and the compiler's OpenMP flag, and run one
+ *     process per node (or socket) with OMP_NUM_THREADS threads.
+ *
+ * Each thread searches its own stack, and has a Chase-Lev deque (see
+ *     deque.c) of packets of nodes it's willing to give away.  A
+ *     packet has the format built by Pack_nodes, so it carries the
+ *     paths of its nodes.  Whenever a thread's deque is empty, and
+ *     there are at least two nodes above cutoff_depth at the bottom of
+ *     its stack, it packs the nodes that Split would send to another
+ *     process, and pushes them onto its deque.  So a thread never has
+ *     to check for requests:  an idle thread just steals a packet.
+ *
+ * Thread 0 runs the usual loop (see Search in par_tree_search.c).  It
+ *     is the only thread that calls MPI.  When its stack is empty, it
+ *     takes work from the deques.  Only when every thread is idle does
+ *     Work_remains send requests to other processes.  Requests from
+ *     other processes are answered with work from thread 0's stack,
+ *     or, if it has none, from the deques.
+ *
+ * The other threads are idle when they can't find a packet.  An idle
+ *     thread never pushes, and its own deque was empty when it became
+ *     idle.  A thread that tries to steal stops being idle first.  So
+ *     if thread 0 is out of work and the other threads are all idle,
+ *     there's no work left on the process.
+ *
+ * See Chap 14, pp. 328 & ff., in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+#include "hybrid.h"
+
+#ifdef HYBRID
+
+#include <sched.h>
+#include <stdatomic.h>
+#include <omp.h>
+#include "deque.h"
+#include "solution.h"
+#include "par_tree_search.h"
+#include "par_dfs.h"
+#include "service_requests.h"
+#include "work_remains.h"
+#include "terminate.h"
+#include "trace.h"
+#ifdef STATS
+#include "stats.h"
+#endif
+
+extern int cutoff_depth;
+extern int my_rank;
+
+typedef struct {
+    DEQUE_STRUCT_T  deque;
+    STACK_T         stack;
+    int             nodes_expanded;
+    int             nodes_pruned;
+    int             steals;
+    char            pad[64];  /* Keep other threads' deques off */
+                              /*     this cache line            */
+} THREAD_T;
+
+static THREAD_T*  threads = (THREAD_T*) NULL;
+static int        num_threads = 1;
+static atomic_int idle_threads;   /* Idle threads other than 0 */
+static atomic_int search_done;
+
+static int  Splittable(STACK_T stack);
+static void Worker_search(THREAD_T* me, MPI_Comm comm);
+static void Thread_dfs(THREAD_T* me, MPI_Comm comm);
+
+/*********************************************************************/
+/* Must be called after Allocate_lists.  Return 0 if successful, */
+/*     negative otherwise                                        */
+int Setup_hybrid(void) {
+    int t;
+
+    /* Every thread must have work to steal from */
+    omp_set_dynamic(0);
+    num_threads = omp_get_max_threads();
+    threads = (THREAD_T*) malloc(num_threads*sizeof(THREAD_T));
+    if (threads == (THREAD_T*) NULL)
+        return -1;
+
+    Get_local_stack(&(threads[0].stack));
+    for (t = 0; t < num_threads; t++) {
+        Initialize_deque(&(threads[t].deque));
+        if ((t > 0) && (Allocate_stack(&(threads[t].stack)) < 0))
+            return -1;
+        threads[t].nodes_expanded = 0;
+        threads[t].nodes_pruned = 0;
+        threads[t].steals = 0;
+    }
+
+    return 0;
+}  /* Setup_hybrid */
+
+
+/*********************************************************************/
+void Free_hybrid(void) {
+    int t;
+
+    for (t = 1; t < num_threads; t++)
+        Free_stack(threads[t].stack);
+    free(threads);
+}  /* Free_hybrid */
+
+
+/*********************************************************************/
+int Num_threads(void) {
+    return num_threads;
+}  /* Num_threads */
+
+
+/*********************************************************************/
+/* Thread 0 runs Search, the others steal work until it's done */
+void Hybrid_search(
+         STACK_T   local_stack  /* in/out */,
+         MPI_Comm  comm         /* in     */) {
+#ifdef STATS
+    int t;
+#endif
+
+    atomic_store(&idle_threads, 0);
+    atomic_store(&search_done, FALSE);
+
+#pragma omp parallel num_threads(num_threads)
+    {
+        if (omp_get_thread_num() == 0) {
+            Search(local_stack, comm);
+            atomic_store(&search_done, TRUE);
+        } else {
+            Worker_search(&threads[omp_get_thread_num()], comm);
+        }
+    }
+
+#ifdef STATS
+    for (t = 0; t < num_threads; t++) {
+        stats.nodes_expanded += threads[t].nodes_expanded;
+        stats.nodes_pruned += threads[t].nodes_pruned;
+        stats.thread_steals += threads[t].steals;
+    }
+#endif
+}  /* Hybrid_search */
+
+
+/*********************************************************************/
+/* Threads other than 0 */
+static void Worker_search(
+                THREAD_T*  me    /* in/out */,
+                MPI_Comm   comm  /* in     */) {
+    int idle = FALSE;
+
+    Trace_begin(TR_THREAD_IDLE);
+    while (!atomic_load(&search_done)) {
+        if (Get_node_work(me->stack, &idle)) {
+            Trace_end(TR_THREAD_IDLE);
+            Trace_begin(TR_THREAD_DFS);
+            Thread_dfs(me, comm);
+            Trace_end(TR_THREAD_DFS);
+            Trace_begin(TR_THREAD_IDLE);
+        } else {
+            sched_yield();
+        }
+    }
+    Trace_end(TR_THREAD_IDLE);
+}  /* Worker_search */
+
+
+/*********************************************************************/
+/* Like Par_dfs, but runs until the stack is empty, and doesn't call */
+/*     MPI                                                           */
+static void Thread_dfs(
+                THREAD_T*  me    /* in/out */,
+                MPI_Comm   comm  /* in     */) {
+    STACK_T  stack = me->stack;
+    NODE_T   node;
+    COST_T   temp_solution;
+
+    while (!Empty(stack)) {
+        node = Pop(stack);
+#ifdef STATS
+        me->nodes_expanded++;
+#endif
+        if (Solution(node)) {
+            temp_solution = Evaluate(node);
+            if (temp_solution < Best_solution(comm))
+                Local_solution_update(temp_solution, node, stack);
+        } else if (Feasible(node, comm)) {
+            Expand(node, stack);
+            Share_work(stack);
+        } else {
+#ifdef STATS
+            me->nodes_pruned++;
+#endif
+        }
+    }  /* while */
+}  /* Thread_dfs */
+
+
+/*********************************************************************/
+/* Nodes above cutoff_depth are at the bottom of the stack, so only */
+/*     look at the bottom two                                       */
+static int Splittable(
+               STACK_T  stack  /* in */) {
+    NODE_T node;
+
+    if (Empty(stack))
+        return FALSE;
+    node = Bottom_node(stack);
+    if ((Depth(node) > cutoff_depth) || (node == Top(stack)))
+        return FALSE;
+    node = Next(stack, node);
+    if (Depth(node) > cutoff_depth)
+        return FALSE;
+    return TRUE;
+}  /* Splittable */
+
+
+/*********************************************************************/
+/* If the calling thread's deque is empty, move the nodes that Split */
+/*     would send from the bottom of stack to a new packet on the   */
+/*     deque                                                        */
+void Share_work(
+         STACK_T  stack  /* in/out */) {
+    DEQUE_T   deque = &(threads[omp_get_thread_num()].deque);
+    PACKET_T  packet;
+    int       node_count;
+    int       size;
+
+    if ((Deque_size(deque) > 0) || !Splittable(stack))
+        return;
+
+    node_count = Split_count(stack);
+    size = 2 + NODE_MEMBERS*node_count + 2*Path_used(stack);
+    packet = (PACKET_T) malloc(size*sizeof(int));
+    if (packet == PACKET_NULL)
+        return;   /* Keep the work */
+    Pack_nodes(Bottom_node(stack), node_count, stack, packet, size);
+    node_count = packet[0];
+
+    /* Once it's pushed, the packet may be stolen and freed */
+    if (Deque_push(deque, packet) < 0) {
+        free(packet);
+        return;
+    }
+    Remove_bottom(node_count, stack);
+}  /* Share_work */
+
+
+/*********************************************************************/
+/* Take a packet from the calling thread's own deque, or steal one   */
+/*     from another thread, and push its nodes onto stack.  For      */
+/*     threads other than 0, *idle_ptr says whether the thread is    */
+/*     counted as idle, and is updated.  Thread 0 passes NULL.       */
+/*     Returns TRUE if work was found.                               */
+int Get_node_work(
+        STACK_T  stack     /* in/out */,
+        int*     idle_ptr  /* in/out */) {
+    int        me = omp_get_thread_num();
+    int        counted_idle = ((idle_ptr != NULL) && *idle_ptr);
+    int        i;
+    int        victim;
+    PACKET_T   packet = PACKET_NULL;
+
+    /* An idle thread's own deque is empty */
+    if (!counted_idle)
+        packet = Deque_pop(&(threads[me].deque));
+
+    for (i = 1; (packet == PACKET_NULL) && (i < num_threads); i++) {
+        victim = (me + i) % num_threads;
+        if (Deque_size(&(threads[victim].deque)) == 0)
+            continue;
+        if (counted_idle) {
+            atomic_fetch_sub(&idle_threads, 1);
+            counted_idle = FALSE;
+        }
+        packet = Deque_steal(&(threads[victim].deque));
+#ifdef TRACE
+        if (packet != PACKET_NULL)
+            Trace_instant(TR_STEAL, victim);
+#endif
+#ifdef STATS
+        if (packet != PACKET_NULL)
+            threads[me].steals++;
+#endif
+    }
+
+    if (packet == PACKET_NULL) {
+        if ((idle_ptr != NULL) && !counted_idle) {
+            atomic_fetch_add(&idle_threads, 1);
+            counted_idle = TRUE;
+        }
+        if (idle_ptr != NULL) *idle_ptr = counted_idle;
+        return FALSE;
+    }
+
+    if (idle_ptr != NULL) *idle_ptr = FALSE;
+    if (Append_nodes(packet, 2 + 2*packet[1] + NODE_MEMBERS*packet[0],
+            stack) < 0) {
+        fprintf(stderr, "Process %d > Stack overflow in thread %d\n",
+            my_rank, me);
+        fprintf(stderr, "Quitting!\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    free(packet);
+    return TRUE;
+}  /* Get_node_work */
+
+
+/*********************************************************************/
+/* Called by Work_remains on thread 0 when its stack is empty.  Wait */
+/*     until work is found on this process, or every thread is idle. */
+/*     Returns TRUE if work was found, FALSE if the process is out   */
+/*     of work.                                                      */
+int Node_work_remains(
+        STACK_T   local_stack  /* in/out */,
+        MPI_Comm  comm         /* in     */) {
+
+    while (TRUE) {
+        if (Get_node_work(local_stack, NULL))
+            return TRUE;
+        if (atomic_load(&idle_threads) == num_threads - 1)
+            return FALSE;
+
+        /* The busy threads haven't shared anything yet */
+        Send_all_rejects(comm);
+        Term_progress(comm);
+        if (Replies_received(local_stack, comm) && !Empty(local_stack))
+            return TRUE;
+        sched_yield();
+    }
+}  /* Node_work_remains */
+
+#else  /* HYBRID */
+
+/*********************************************************************/
+int Num_threads(void) {
+    return 1;
+}  /* Num_threads */
+
+#endif /* HYBRID */
@@ -0,0 +1,20 @@
+/* hybrid.h
+ *
+ * Definitions and declarations for hybrid MPI + OpenMP tree search.
+ *     Compile with -DHYBRID, and the compiler's OpenMP flag.
+ */
+#ifndef HYBRID_H
+#define HYBRID_H
+
+#include "mpi.h"
+#include "node_stack.h"
+
+int   Setup_hybrid(void);
+void  Free_hybrid(void);
+int   Num_threads(void);
+void  Hybrid_search(STACK_T local_stack, MPI_Comm comm);
+void  Share_work(STACK_T stack);
+int   Get_node_work(STACK_T stack, int* idle_ptr);
+int   Node_work_remains(STACK_T local_stack, MPI_Comm comm);
+
+#endif
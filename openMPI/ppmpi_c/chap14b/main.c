@@ -14,11 +14,24 @@
  * Output:
  *     1. If STATS has been defined, statistics on the execution
  *        of the program.  See stats.c
+ *     2. If TRACE has been defined, a timeline of the search in
+ *        TRACE_FILE.  See trace.c
  *
  * Algorithm:
  *     1. Start up MPI and get input.
- *     2. Call various setup functions.
- *     3. Process 0:  initialize root of tree
+ *     2. Call various setup functions.  The victim selection policy
+ *        is chosen at compile time with -DVICTIM_POLICY=<n> (see
+ *        victim.h).  The lower bound used to prune the tree is chosen
+ *        with -DBOUND=<n> (see bound.h).  Every process can read
+ *        the best solution found so far from a window on process 0
+ *        (see solution.c).  If the program is compiled with -DHYBRID,
+ *        each process also starts OMP_NUM_THREADS threads (see
+ *        hybrid.c).  If the program is compiled with -DCHECKPOINT,
+ *        each process saves its best solution and, from time to time,
+ *        its stack as the search goes on, and a restarted search
+ *        starts with the saved solutions and stacks (see solution.c).
+ *     3. Process 0:  initialize root of tree, unless the stacks were
+ *        restored
  *     4. Call Par_tree_search
  *     5. Print stats
  *     6. Clean up message queues
@@ -49,6 +62,15 @@
 #include "service_requests.h"
 #include "terminate.h"
 #include "queue.h"
+#include "work_remains.h"
+#include "victim.h"
+#include "bound.h"
+#ifdef HYBRID
+#include "hybrid.h"
+#endif
+#ifdef TRACE
+#include "trace.h"
+#endif
 
 #ifdef STATS
 #include "stats.h"
@@ -71,19 +93,32 @@ int
 main(int argc, char* argv[]) {
     int       error;
     NODE_T    root;
+    STACK_T   stack;
+#ifdef HYBRID
+    int       provided;
 
+    /* Only thread 0 calls MPI */
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+#else
     MPI_Init(&argc, &argv);
+#endif
     MPI_Comm_size(MPI_COMM_WORLD, &p);
     MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
     MPI_Comm_dup(MPI_COMM_WORLD, &io_comm);
     Cache_io_rank(MPI_COMM_WORLD, io_comm);
 
+#ifdef HYBRID
+    Cerror_test(io_comm, "MPI_Init_thread", 
+        (provided < MPI_THREAD_FUNNELED ? -1 : 0));
+#endif
+
     Cscanf(io_comm,
         "Enter max depth, cutoff depth, max work, and max children",
         "%d %d %d %d", &max_depth, &cutoff_depth, &max_work,
         &max_children);
 
     Setup_term_detect();
+    Setup_bound(BOUND);
 
     error = Initialize_soln(max_depth);
     Cerror_test(io_comm, "Initialize_soln", error);
@@ -91,25 +126,64 @@ main(int argc, char* argv[]) {
     error = Allocate_lists(max_depth, max_children);
     Cerror_test(io_comm, "Allocate_lists", error);
 
-    error = Allocate_type_arrays(max_depth, max_children);
-    Cerror_test(io_comm, "Allocate_type_arrays", error);
+    error = Allocate_send_buffer(max_depth, max_children);
+    Cerror_test(io_comm, "Allocate_send_buffer", error);
+
+#ifdef HYBRID
+    error = Setup_hybrid();
+    Cerror_test(io_comm, "Setup_hybrid", error);
+#endif
+
+    Get_local_stack(&stack);
+    error = Allocate_reply_buffers(stack);
+    Cerror_test(io_comm, "Allocate_reply_buffers", error);
+
+    error = Setup_victim_select(VICTIM_POLICY, MPI_COMM_WORLD);
+    Cerror_test(io_comm, "Setup_victim_select", error);
 
-    if (my_rank == 0) {
+    error = Setup_incumbent(MPI_COMM_WORLD);
+    Cerror_test(io_comm, "Setup_incumbent", error);
+
+#ifdef CHECKPOINT
+    error = Setup_soln_ckpt(MPI_COMM_WORLD);
+    Cerror_test(io_comm, "Setup_soln_ckpt", error);
+#endif
+
+    if ((my_rank == 0) && !Search_restored()) {
         Get_root(&root);
     } else {
         root = NODE_NULL;
     }
+
+#ifdef TRACE
+    error = Trace_init(MPI_COMM_WORLD);
+    Cerror_test(io_comm, "Trace_init", error);
+#endif
    
     Par_tree_search(root, MPI_COMM_WORLD);
 
+#ifdef TRACE
+    Trace_finalize(TRACE_FILE, MPI_COMM_WORLD);
+#endif
+
 #ifdef STATS
     Print_stats(io_comm);
 #endif
 
     Clean_up_queues(MPI_COMM_WORLD);
 
+#ifdef HYBRID
+    Free_hybrid();
+#endif
+#ifdef CHECKPOINT
+    /* The search finished, so the saved solutions aren't needed */
+    Free_soln_ckpt(1);
+#endif
+    Free_incumbent();
+    Free_victim_select();
+    Free_reply_buffers();
     Free_lists();
-    Free_type_arrays();
+    Free_send_buffer();
     Free_soln();
 
     MPI_Finalize();
@@ -127,7 +201,10 @@ void Get_root(
     Depth(*root_ptr) = 0;
     Sibling_rank(*root_ptr) = 0;
     Seed(*root_ptr) = 1;
-    Size(*root_ptr) = Calc_size(*root_ptr);
+    Parent(*root_ptr) = NO_PARENT;
+#ifdef PATH_COST
+    Path_cost(*root_ptr) = 0;
+#endif
     Get_local_stack(&stack);
     Push(*root_ptr, stack);
     
@@ -1,6 +1,18 @@
 /* node_stack.c -- functions for manipulating tree nodes and the stack.  For
  *     use in parallel tree search.
  *
+ * A node is a fixed size record:  depth, sibling rank, seed and the
+ *     index of its parent in the stack's path arena.  The ancestor
+ *     list is recovered by following parent indices through the
+ *     arena, so a node takes NODE_MEMBERS ints no matter how deep
+ *     it is.
+ *
+ * Message format (built by Pack_nodes, read by Append_nodes):
+ *     node count, path entry count,
+ *     path entries (sibling rank, parent index in message),
+ *     nodes (depth, sibling rank, seed, parent index in message)
+ *     So an ancestor shared by several nodes is sent only once.
+ *
  * See Chap 14, pp. 328 & ff, in PPMPI for a discussion of parallel tree
  *     search.
  */
@@ -11,31 +23,31 @@
 
 static STACK_STRUCT_T local_stack_struct;
 STACK_T local_stack = &local_stack_struct;
-static NODE_T scratch_node;
+static int    dfs_size;  /* ints needed for a depth-first search */
+static int    path_size; /* entries needed for a depth-first search */
+
+/* Values in path_map while it's in use */
+#define UNMARKED -1
+#define MARKED   -2
 
 extern int max_depth;
 extern MPI_Comm io_comm;
 extern int my_rank;
 
-/*********************************************************************/
-void Set_stack_scalars(
-         int      count  /* in  */,
-         STACK_T  stack  /* out */) {
-    int  subtract;
-
-    In_use(stack) = count;
-    subtract = Stack_int(stack, count-1);
-    Top(stack) = &Stack_int(stack, count - subtract);
-}  /* Set_stack_scalars */
-
+static int  Allocate_stack_lists(STACK_T stack);
+static void Reset_top(STACK_T stack);
+static int  Make_room(int count, STACK_T stack);
+static int  Reserve_path(int count, NODE_T extra, STACK_T stack);
+static void Mark_path(NODE_T node, STACK_T stack);
+static void Compact_path(NODE_T extra, STACK_T stack);
 
 /*********************************************************************/
-/* Return index of stack element that precedes node.
+/* Return stack element that precedes node. */
 NODE_T Pred(
            STACK_T  stack  /* in */,
            NODE_T   node   /* in */) {
-    if (node > Stack_list(stack))
-        return node - (*(node-1));
+    if (node > Bottom_node(stack))
+        return node - NODE_MEMBERS;
     else
         return NODE_NULL;
 }  /* Pred */
@@ -45,55 +57,28 @@ void Copy_node(
          NODE_T  node1  /* in  */,
          NODE_T  node2  /* out */) {
     int   i;
-    int*  n2_ptr;
-    int*  n1_ptr;
-    int   size;
 
-    size = Size(node1);
-    for (i = 0, n2_ptr = node2, n1_ptr = node1; 
-         i < size; i++, n2_ptr++, n1_ptr++)
-        *n2_ptr = *n1_ptr;
+    for (i = 0; i < NODE_MEMBERS; i++)
+        node2[i] = node1[i];
 
 }  /* Copy_node */
 
 
-/*********************************************************************/
-NODE_T Copy_to_scratch(
-         NODE_T  node  /* in */) {
-    int   i;
-    int*  s_ptr;
-    int*  n_ptr;
-
-    for (i = 0, s_ptr = scratch_node, n_ptr = node; 
-         i < Size(node); i++, s_ptr++, n_ptr++)
-        *s_ptr = *n_ptr;
-
-    return scratch_node;
-} /* Copy_to_scratch */
-
-
 /*********************************************************************/
 /* Return 0 if successful, negative otherwise */
 int Allocate_lists(
         int  max_depth     /* in */,
         int  max_children  /* in */) {
-    int max_size;
 
-    max_size = (max_depth+1)*(NODE_MEMBERS-1);
-    max_size = max_size + max_depth*(max_depth+1)/2;
-    max_size = (max_children-1)*max_size;
-    max_size = max_size + (NODE_MEMBERS - 1) + max_depth;
-    Stack_list(local_stack) = (int*) malloc(max_size*sizeof(int));
-    scratch_node = (NODE_T) malloc(MAX_NODE_SIZE*sizeof(int));
+    /* At most max_children - 1 unexpanded siblings at each level */
+    dfs_size = (max_children-1)*(max_depth+1) + 2;
+    dfs_size = NODE_MEMBERS*dfs_size;
 
-    if ( (Stack_list(local_stack) == ((int*) NULL)) ||
-         (scratch_node == (NODE_T) NULL) ) 
-        return -1;
-    else
-        Max_size(local_stack) = max_size;
+    /* A single depth-first search needs max_depth entries */
+    path_size = 4*(max_depth+1);
 
-    Top(local_stack) = NODE_NULL;
-    In_use(local_stack) = 0;
+    if (Allocate_stack_lists(local_stack) < 0)
+        return -1;
 
 #ifdef DEBUG
 {
@@ -109,18 +94,76 @@ int Allocate_lists(
 }  /* Allocate_lists */
 
 
+/*********************************************************************/
+/* Allocate an empty stack and path arena, each large enough for a */
+/*     depth-first search.  Return 0 if successful, negative       */
+/*     otherwise                                                   */
+static int Allocate_stack_lists(
+               STACK_T  stack  /* out */) {
+    int e;
+
+    Stack_list(stack) = (int*) malloc(dfs_size*sizeof(int));
+    Path_max(stack) = path_size;
+    stack->path = (int*) malloc(2*Path_max(stack)*sizeof(int));
+    stack->path_map = (int*) malloc(Path_max(stack)*sizeof(int));
+
+    if ( (Stack_list(stack) == ((int*) NULL)) ||
+         (stack->path == (int*) NULL) ||
+         (stack->path_map == (int*) NULL) )
+        return -1;
+    else
+        Max_size(stack) = dfs_size;
+
+    for (e = 0; e < Path_max(stack); e++)
+        stack->path_map[e] = UNMARKED;
+    Path_used(stack) = 0;
+
+    Top(stack) = NODE_NULL;
+    In_use(stack) = 0;
+    Bottom(stack) = 0;
+
+    return 0;
+}  /* Allocate_stack_lists */
+
+
 /*********************************************************************/
 void Free_lists(void) {
     free(Stack_list(local_stack));
-    free(scratch_node);
+    free(local_stack->path);
+    free(local_stack->path_map);
 }  /* Free_lists */
 
 
+/*********************************************************************/
+/* Allocate another stack, the same size as local_stack -- used by  */
+/*     the threads in hybrid search.  Must be called after          */
+/*     Allocate_lists.  Return 0 if successful, negative otherwise  */
+int Allocate_stack(
+        STACK_T*  stack_ptr  /* out */) {
+
+    *stack_ptr = (STACK_T) malloc(sizeof(STACK_STRUCT_T));
+    if (*stack_ptr == (STACK_T) NULL)
+        return -1;
+    return Allocate_stack_lists(*stack_ptr);
+}  /* Allocate_stack */
+
+
+/*********************************************************************/
+void Free_stack(
+         STACK_T  stack  /* in/out */) {
+    free(Stack_list(stack));
+    free(stack->path);
+    free(stack->path_map);
+    free(stack);
+}  /* Free_stack */
+
+
 /*********************************************************************/
 int Allocate_root(
         NODE_T* root_ptr /* out */) {
     
     /* Top(comm_stack) == NODE_NULL */
+    Bottom(local_stack) = 0;
     Top(local_stack) = Stack_list(local_stack);
     
     *root_ptr = Top(local_stack);
@@ -135,6 +178,54 @@ void Get_local_stack(STACK_T* local_stack_ptr) {
 }  /* Get_local_stack */
 
 
+/*********************************************************************/
+static void Reset_top(
+                STACK_T  stack  /* in/out */) {
+    if (In_use(stack) == 0)
+        Top(stack) = NODE_NULL;
+    else
+        Top(stack) = &Stack_int(stack,
+            Bottom(stack) + In_use(stack) - NODE_MEMBERS);
+}  /* Reset_top */
+
+
+/*********************************************************************/
+/* Make sure there's room for count more ints above the top of the */
+/*     stack.  First slide the stack down to the start of          */
+/*     stack_list.  If that isn't enough, enlarge stack_list.      */
+/*     Since the stack may move, any NODE_T's referring to it      */
+/*     are invalid after the call.                                 */
+/*     Return 0 if successful, negative otherwise                  */
+static int Make_room(
+               int      count  /* in     */,
+               STACK_T  stack  /* in/out */) {
+    int   i;
+    int*  new_list;
+    int   new_size;
+
+    if (Bottom(stack) + In_use(stack) + count <= Max_size(stack))
+        return 0;
+
+    if (Bottom(stack) > 0) {
+        for (i = 0; i < In_use(stack); i++)
+            Stack_int(stack, i) = Stack_int(stack, Bottom(stack) + i);
+        Bottom(stack) = 0;
+    }
+
+    if (In_use(stack) + count > Max_size(stack)) {
+        new_size = In_use(stack) + count + dfs_size;
+        new_list = (int*) realloc(Stack_list(stack), new_size*sizeof(int));
+        if (new_list == (int*) NULL)
+            return -1;
+        Stack_list(stack) = new_list;
+        Max_size(stack) = new_size;
+    }
+
+    Reset_top(stack);
+    return 0;
+}  /* Make_room */
+
+
 /*********************************************************************/
 /* Returns 0 if successful, negative otherwise             */
 /* Doesn't change Top of stack or In_use -- Push does that */
@@ -143,8 +234,9 @@ int Allocate_node(
         NODE_T* node_ptr /* out    */) {
     
     if (Top(stack) == NODE_NULL) {
+        Bottom(stack) = 0;
         *node_ptr = Stack_list(stack);
-    } else if (In_use(stack) >= (Max_size(stack) - MAX_NODE_SIZE)) {
+    } else if (Make_room(NODE_MEMBERS, stack) < 0) {
         return -1;
     } else {
         *node_ptr = Next(stack,Top(stack));
@@ -155,28 +247,279 @@ int Allocate_node(
 }  /* Allocate_node */
 
 
+/*********************************************************************/
+/* Add an entry for parent to the path arena, and return its index. */
+/*     parent should be a copy of a node that has been popped:  if  */
+/*     the arena is compacted, its parent index is updated.         */
+/*     Returns negative if the arena can't be enlarged.             */
+int Extend_path(
+        NODE_T   parent  /* in/out */,
+        STACK_T  stack   /* in/out */) {
+    int  entry;
+
+    if (Reserve_path(1, parent, stack) < 0)
+        return -1;
+
+    entry = Path_used(stack);
+    Path_sibling(stack, entry) = Sibling_rank(parent);
+    Path_parent(stack, entry) = Parent(parent);
+    Path_used(stack)++;
+
+    return entry;
+}  /* Extend_path */
+
+
+/*********************************************************************/
+/* Make sure the path arena has room for count more entries.  extra */
+/*     is a node that isn't on the stack, but whose path should be  */
+/*     kept.  Return 0 if successful, negative otherwise            */
+static int Reserve_path(
+               int      count  /* in     */,
+               NODE_T   extra  /* in/out */,
+               STACK_T  stack  /* in/out */) {
+    int   new_max;
+    int*  new_path;
+    int*  new_map;
+    int   e;
+
+    if (Path_used(stack) + count <= Path_max(stack))
+        return 0;
+
+    Compact_path(extra, stack);
+
+    /* Enlarge if the arena is still more than half full */
+    if (2*(Path_used(stack) + count) > Path_max(stack)) {
+        new_max = 2*(Path_used(stack) + count);
+        new_path = (int*) realloc(stack->path, 2*new_max*sizeof(int));
+        if (new_path == (int*) NULL)
+            return -1;
+        stack->path = new_path;
+        new_map = (int*) realloc(stack->path_map, new_max*sizeof(int));
+        if (new_map == (int*) NULL)
+            return -1;
+        stack->path_map = new_map;
+        for (e = Path_max(stack); e < new_max; e++)
+            stack->path_map[e] = UNMARKED;
+        Path_max(stack) = new_max;
+    }
+
+    return 0;
+}  /* Reserve_path */
+
+
+/*********************************************************************/
+/* Mark the unmarked entries on the path from node to the root */
+static void Mark_path(
+                NODE_T   node   /* in     */,
+                STACK_T  stack  /* in/out */) {
+    int  e;
+
+    for (e = Parent(node); (e != NO_PARENT) &&
+            (stack->path_map[e] == UNMARKED); e = Path_parent(stack, e))
+        stack->path_map[e] = MARKED;
+}  /* Mark_path */
+
+
+/*********************************************************************/
+/* Discard the path entries that aren't on the path of a node on the */
+/*     stack or of extra.  Since a parent always precedes its        */
+/*     children, a single pass renumbers the entries.                */
+static void Compact_path(
+                NODE_T   extra  /* in/out */,
+                STACK_T  stack  /* in/out */) {
+    NODE_T  node;
+    int*    map = stack->path_map;
+    int     e;
+    int     new_used = 0;
+
+    for (node = Top(stack); node != NODE_NULL; node = Pred(stack, node))
+        Mark_path(node, stack);
+    if (extra != NODE_NULL)
+        Mark_path(extra, stack);
+
+    for (e = 0; e < Path_used(stack); e++)
+        if (map[e] == MARKED) {
+            Path_sibling(stack, new_used) = Path_sibling(stack, e);
+            if (Path_parent(stack, e) == NO_PARENT)
+                Path_parent(stack, new_used) = NO_PARENT;
+            else
+                Path_parent(stack, new_used) = map[Path_parent(stack, e)];
+            map[e] = new_used++;
+        }
+
+    for (node = Top(stack); node != NODE_NULL; node = Pred(stack, node))
+        if (Parent(node) != NO_PARENT)
+            Parent(node) = map[Parent(node)];
+    if ((extra != NODE_NULL) && (Parent(extra) != NO_PARENT))
+        Parent(extra) = map[Parent(extra)];
+
+    for (e = 0; e < Path_used(stack); e++)
+        map[e] = UNMARKED;
+    Path_used(stack) = new_used;
+
+}  /* Compact_path */
+
+
 /*********************************************************************/
 void Initialize_node(
         NODE_T  node          /* out */, 
         NODE_T  parent        /* in  */, 
+        int     parent_path   /* in  */,
         int     sibling_rank  /* in  */,
         int     seed          /* in  */) {
-    int  i;
 
     Depth(node) = Depth(parent) + 1;
     Sibling_rank(node) = sibling_rank;
     Seed(node) = seed;
-    for (i = 0; i < Depth(parent); i++)
-        Ancestor(node,i) = Ancestor(parent,i);
-    Ancestor(node,i) = Sibling_rank(parent);
-    Size(node) = Calc_size(node);
+    Parent(node) = parent_path;
     
 }  /* Initialize_node */
 
 
 /*********************************************************************/
-void Initialize_stack(NODE_T node, STACK_T* stack_ptr) {
-}  /* Initialize_stack */ 
+/* Store the sibling ranks of the Depth(node) ancestors of node, */
+/*     starting with the root, in ancestors                      */
+void Get_ancestors(
+         NODE_T   node       /* in  */,
+         STACK_T  stack      /* in  */,
+         int*     ancestors  /* out */) {
+    int  i;
+    int  e = Parent(node);
+
+    for (i = Depth(node) - 1; i >= 0; i--) {
+        ancestors[i] = Path_sibling(stack, e);
+        e = Path_parent(stack, e);
+    }
+}  /* Get_ancestors */
+
+
+/*********************************************************************/
+/* Pack count nodes, starting with first and moving toward the top   */
+/*     of the stack, into buffer, together with the path entries     */
+/*     they refer to.  Stops early rather than use more than         */
+/*     max_count ints.  The number of nodes packed is buffer[0].     */
+/*     Returns the number of ints used.                              */
+int Pack_nodes(
+        NODE_T   first      /* in  */,
+        int      count      /* in  */,
+        STACK_T  stack      /* in  */,
+        int*     buffer     /* out */,
+        int      max_count  /* in  */) {
+    int*    map = stack->path_map;
+    NODE_T  node;
+    int     nodes = 0;
+    int     entries = 0;
+    int     new_entries;
+    int     e;
+    int*    b_ptr;
+
+    /* Mark the path entries needed, as long as everything fits */
+    for (node = first; nodes < count; node = Next(stack, node)) {
+        new_entries = 0;
+        for (e = Parent(node); (e != NO_PARENT) && (map[e] == UNMARKED);
+                e = Path_parent(stack, e))
+            new_entries++;
+        if (2 + NODE_MEMBERS*(nodes+1) + 2*(entries+new_entries) >
+                max_count)
+            break;
+        Mark_path(node, stack);
+        entries += new_entries;
+        nodes++;
+    }
+
+    /* Number the marked entries in arena order, so parents */
+    /*     still precede their children                     */
+    buffer[0] = nodes;
+    buffer[1] = entries;
+    b_ptr = buffer + 2;
+    entries = 0;
+    for (e = 0; e < Path_used(stack); e++)
+        if (map[e] == MARKED) {
+            *b_ptr++ = Path_sibling(stack, e);
+            if (Path_parent(stack, e) == NO_PARENT)
+                *b_ptr++ = NO_PARENT;
+            else
+                *b_ptr++ = map[Path_parent(stack, e)];
+            map[e] = entries++;
+        }
+
+    for (node = first; node < first + NODE_MEMBERS*nodes;
+            node = Next(stack, node)) {
+        Copy_node(node, b_ptr);
+        if (Parent(node) != NO_PARENT)
+            Parent(b_ptr) = map[Parent(node)];
+        b_ptr += NODE_MEMBERS;
+    }
+
+    for (e = 0; e < Path_used(stack); e++)
+        map[e] = UNMARKED;
+
+    return b_ptr - buffer;
+}  /* Pack_nodes */
+
+
+/*********************************************************************/
+/* Push the nodes in buffer -- a message of count ints built by    */
+/*     Pack_nodes -- onto stack.  If necessary, the stack is       */
+/*     enlarged so that there's still room for a depth-first       */
+/*     search from its top.  Since the stack may move, any         */
+/*     NODE_T's referring to it are invalid after the call.        */
+/*     Return 0 if successful, negative otherwise                  */
+int Append_nodes(
+        int*     buffer  /* in     */,
+        int      count   /* in     */,
+        STACK_T  stack   /* in/out */) {
+    int     nodes = buffer[0];
+    int     entries = buffer[1];
+    int*    b_ptr = buffer + 2;
+    int     base;
+    int     i;
+    NODE_T  node;
+
+    if (count != 2 + 2*entries + NODE_MEMBERS*nodes)
+        return -1;
+    if (Reserve_path(entries, NODE_NULL, stack) < 0)
+        return -1;
+    if (Make_room(NODE_MEMBERS*nodes + dfs_size, stack) < 0)
+        return -1;
+
+    base = Path_used(stack);
+    for (i = 0; i < entries; i++, b_ptr += 2) {
+        Path_sibling(stack, base + i) = b_ptr[0];
+        if (b_ptr[1] == NO_PARENT)
+            Path_parent(stack, base + i) = NO_PARENT;
+        else
+            Path_parent(stack, base + i) = base + b_ptr[1];
+    }
+    Path_used(stack) += entries;
+
+    for (i = 0; i < nodes; i++, b_ptr += NODE_MEMBERS) {
+        if (Allocate_node(stack, &node) < 0)
+            return -1;
+        Copy_node(b_ptr, node);
+        if (Parent(node) != NO_PARENT)
+            Parent(node) = base + Parent(node);
+        Push(node, stack);
+    }
+
+    return 0;
+}  /* Append_nodes */
+
+
+/*********************************************************************/
+/* Remove count nodes from the bottom of the stack.  The path */
+/*     entries only they used are discarded the next time the */
+/*     arena is compacted.                                    */
+void Remove_bottom(
+         int      count  /* in     */,
+         STACK_T  stack  /* in/out */) {
+
+    Bottom(stack) = Bottom(stack) + NODE_MEMBERS*count;
+    In_use(stack) = In_use(stack) - NODE_MEMBERS*count;
+    if (In_use(stack) == 0)
+        Bottom(stack) = 0;
+    Reset_top(stack);
+}  /* Remove_bottom */
 
 
 /*********************************************************************/
@@ -239,17 +582,21 @@ void Print_node(
          NODE_T    node  /* in */, 
          STACK_T   stack /* in */,
          MPI_Comm  comm  /* in */) {
-    int i;
-    int my_rank;
+    int  i;
+    int  my_rank;
+    int* ancestors;
 
     MPI_Comm_rank(comm, &my_rank);
 
     printf("--------------------------------------------------------------\n");
-    printf("Process %d > Depth = %d, Sibling rank = %d, Seed = %d, Size = %d\n",
-        my_rank, Depth(node), Sibling_rank(node), Seed(node), Size(node));
+    printf("Process %d > Depth = %d, Sibling rank = %d, Seed = %d, Parent = %d\n",
+        my_rank, Depth(node), Sibling_rank(node), Seed(node), Parent(node));
     printf("Process %d > Ancestors = ", my_rank);
+    ancestors = (int*) malloc((Depth(node)+1)*sizeof(int));
+    Get_ancestors(node, stack, ancestors);
     for (i = 0; i < Depth(node); i++)
-        printf("%d ", Ancestor(node,i));
+        printf("%d ", ancestors[i]);
+    free(ancestors);
     printf("\n");
     fflush(stdout);
 }  /* Print_node */
@@ -288,7 +635,7 @@ void Print_stack_list(
 
     MPI_Comm_rank(comm, &my_rank);
     printf("Process %d > count = %d, Stack_list = ", my_rank, count);
-    for (i = 0, s_ptr = Stack_list(stack); i < count; i++, s_ptr++)
+    for (i = 0, s_ptr = Bottom_node(stack); i < count; i++, s_ptr++)
         printf("%d ", *s_ptr);
     printf("\n");
     fflush(stdout);
@@ -13,21 +13,23 @@
 typedef int* NODE_T;
 #define NODE_NULL  ((NODE_T) NULL)
 
-#define NODE_MEMBERS       5   /* includes depth, sibling_rank, cost, */
-                               /*    ancestors (1 member), size       */
+/* Every node has the same size.  Instead of storing the ancestor */
+/*     list, a node stores the index of its parent in the stack's */
+/*     path arena -- see below.                                   */
+#ifndef PATH_COST
+#define NODE_MEMBERS       4   /* depth, sibling_rank, seed, parent */
+#else
+#define NODE_MEMBERS       5   /* ..., cost of path from root -- see */
+                               /*     bound.h                        */
+#define Path_cost(node)    (*((node)+4))
+#endif
 #define Depth(node)        (*(node))
 #define Sibling_rank(node) (*((node)+1))
 #define Seed(node)         (*((node)+2))
-#define Ancestors(node)    ((node)+3)
-/* Number of ancestors = depth */
-#define Ancestor(node,i)   (*((node)+3+(i)))
-#define Size(node)         (*((node)+ NODE_MEMBERS + Depth(node) - 2))
-#define Calc_size(node)    (NODE_MEMBERS + Depth(node) - 1)
-
-extern int max_depth;
-#define MAX_NODE_SIZE (NODE_MEMBERS + max_depth - 1)
+#define Parent(node)       (*((node)+3))
+#define Size(node)         NODE_MEMBERS
 
-#define node_mpi_t MPI_INT
+#define NO_PARENT  -1          /* Parent of the root */
 
 /*
 #define MODULUS 65536
@@ -39,11 +41,24 @@ extern int max_depth;
 #define INCREMENT 1001
 #define My_rand(seed)  ((MULTIPLIER*(seed) + INCREMENT) % MODULUS)
 
+/* The stack is a contiguous list of nodes, stack_list[bottom], ..., */
+/*     stack_list[bottom + in_use - 1].  Nodes are pushed and popped */
+/*     at the top.  Split removes nodes from the bottom.             */
+/* The path arena stores one entry for each node that has been       */
+/*     expanded:  its sibling rank and the index of its own parent.  */
+/*     An entry's parent always has a smaller index than the entry.  */
+/*     Entries that are no longer referenced are discarded when the  */
+/*     arena fills.                                                   */
 typedef struct {
-    int     max_size;    /* size of stack_list    */
-    int     in_use;      /* number of ints in use */
-    NODE_T  stack_top;   
+    int     max_size;    /* size of stack_list       */
+    int     in_use;      /* number of ints in use    */
+    int     bottom;      /* index of first int in use */
+    NODE_T  stack_top;
     int*    stack_list;
+    int     path_max;    /* number of entries allocated for path */
+    int     path_used;   /* number of entries in use             */
+    int*    path;        /* 2 ints per entry                     */
+    int*    path_map;    /* scratch, 1 int per entry             */
 } STACK_STRUCT_T;
 
 typedef STACK_STRUCT_T* STACK_T;
@@ -51,28 +66,36 @@ typedef STACK_STRUCT_T* STACK_T;
 /*    in which case it's NULL                                   */
 #define Max_size(stack)    ((stack)->max_size)
 #define In_use(stack)      ((stack)->in_use)
+#define Bottom(stack)      ((stack)->bottom)
 #define Top(stack)         ((stack)->stack_top)
 #define Stack_list(stack)  ((stack)->stack_list)
 #define Stack_int(stack,i) (*(((stack)->stack_list) + (i)))
+#define Bottom_node(stack) (&Stack_int(stack, Bottom(stack)))
+
+#define Path_max(stack)      ((stack)->path_max)
+#define Path_used(stack)     ((stack)->path_used)
+#define Path_sibling(stack,e) (*(((stack)->path) + 2*(e)))
+#define Path_parent(stack,e)  (*(((stack)->path) + 2*(e) + 1))
+
+#define Next(stack,node)   ((node) + NODE_MEMBERS)
 
-#define Next(stack,node)   ((node) + Size(node))
-/*
-#define Pred(stack,node)   ((node) > Stack_list(stack) ? \
-                            ((node) - (*(node-1))) : \
-                            NODE_NULL)
-*/
-void    Set_stack_scalars(int count, STACK_T stack);
 NODE_T  Pred(STACK_T stack, NODE_T node);
-NODE_T  Copy_to_scratch(NODE_T node);
 void    Copy_node(NODE_T node1, NODE_T node2);
 int     Allocate_lists(int max_depth, int max_children);
 void    Free_lists(void);
+int     Allocate_stack(STACK_T* stack_ptr);
+void    Free_stack(STACK_T stack);
 int     Allocate_root(NODE_T* root_ptr);
 void    Get_local_stack(STACK_T* local_stack_ptr);
 int     Allocate_node(STACK_T stack, NODE_T* node_ptr);
-void    Initialize(NODE_T node, STACK_T* stack_ptr);
-void    Initialize_node(NODE_T node, NODE_T parent, 
+int     Extend_path(NODE_T parent, STACK_T stack);
+void    Initialize_node(NODE_T node, NODE_T parent, int parent_path,
             int sibling_rank, int seed);
+void    Get_ancestors(NODE_T node, STACK_T stack, int* ancestors);
+int     Pack_nodes(NODE_T first, int count, STACK_T stack, int* buffer,
+            int max_count);
+int     Append_nodes(int* buffer, int count, STACK_T stack);
+void    Remove_bottom(int count, STACK_T stack);
 int     Empty(STACK_T stack);
 NODE_T  Pop(STACK_T stack);
 void    Push(NODE_T node, STACK_T stack);
@@ -1,12 +1,17 @@
 /* par_dfs.c -- local depth-first search function.  Performs iterative
  *     depth-first search on tree until local_stack is exhausted or
- *     it has expanded max_work nodes.
+ *     it has expanded max_work nodes.  In hybrid search it also
+ *     shares work with the other threads -- see hybrid.c.
  *
  * See Chap 14, pp. 330 & ff., in PPMPI.
  */
 #include "par_dfs.h"
 #include "node_stack.h"
 #include "solution.h"
+#include "bound.h"
+#ifdef HYBRID
+#include "hybrid.h"
+#endif
 #ifdef STATS
 #include "stats.h"
 #endif
@@ -25,6 +30,14 @@ void Par_dfs(
     float   temp_solution;
 
 
+#ifdef HYBRID
+    /* Only thread 0 can publish what the other threads found */
+    Publish_solution();
+#endif
+
+    /* Get the best solution found by other processes */
+    Poll_incumbent();
+
     /* Search local subtree for a while */
     count = 0;
     while (!Empty(local_stack) && (count < max_work)) {
@@ -38,11 +51,18 @@ void Par_dfs(
         if (Solution(node)) {
             temp_solution = Evaluate(node);
             if (temp_solution < Best_solution(comm)) {
-                Local_solution_update(temp_solution, node);
-                Bcast_solution(comm);
+                Local_solution_update(temp_solution, node, local_stack);
+                Publish_solution();
             }
         } else if (Feasible(node, comm)) {
             Expand(node, local_stack);
+#ifdef HYBRID
+            Share_work(local_stack);
+#endif
+        } else {
+#ifdef STATS
+            Incr_stat(nodes_pruned);
+#endif
         }
         count++;
     }  /* while */
@@ -64,14 +84,21 @@ int Solution(
 COST_T Evaluate(
            NODE_T    node  /* in  */) {
     
-    return (COST_T) Seed(node);
+    return Leaf_cost(node);
 }  /* Evaluate */ 
 
 
 /********************************************************************/
-int Feasible(NODE_T node, MPI_Comm comm) {
-    return TRUE;
-} 
+/* A node is only worth expanding if the bound is better than the */
+/*     best solution found so far -- see bound.c                  */
+int Feasible(
+        NODE_T    node  /* in */, 
+        MPI_Comm  comm  /* in */) {
+    if (Lower_bound(node) < Best_solution(comm))
+        return TRUE;
+    else
+        return FALSE;
+}  /* Feasible */
 
 /********************************************************************/
 void Expand(
@@ -81,7 +108,8 @@ void Expand(
     int    num_children;
     int    i;
     NODE_T temp_node;
-    NODE_T temp_parent;
+    int    temp_parent[NODE_MEMBERS];
+    int    parent_path;
     int    local_seed;
     static int divisor = 0;
     int    quotient;
@@ -98,7 +126,15 @@ void Expand(
     if (num_children < min_children)
         num_children = min_children;
     
-    temp_parent = Copy_to_scratch(parent);
+    /* parent is no longer on the stack, and may be overwritten */
+    Copy_node(parent, temp_parent);
+    parent_path = Extend_path(temp_parent, local_stack);
+    if (parent_path < 0) {
+        fprintf(stderr, "Process %d > Can't extend path, Path_used(stack) = %d\n",
+            my_rank, Path_used(local_stack));
+        fprintf(stderr, "Quitting!\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
     local_seed = My_rand(local_seed + My_rand(Depth(parent)));   
     for (i = num_children - 1; i >= 0; i--) {
         error = Allocate_node(local_stack, &temp_node);
@@ -109,7 +145,9 @@ void Expand(
             MPI_Abort(MPI_COMM_WORLD, -1);
         }
         local_seed = My_rand(local_seed);
-        Initialize_node(temp_node, temp_parent, i, local_seed);
+        Initialize_node(temp_node, temp_parent, parent_path, i,
+            local_seed);
+        Set_path_cost(temp_node, temp_parent);
         Push(temp_node, local_stack);
     }
 
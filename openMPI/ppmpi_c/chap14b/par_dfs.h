@@ -12,7 +12,6 @@
 #define MAX(a,b) ((a) >= (b) ? (a) : (b))
 
 void    Par_dfs(STACK_T local_stack, MPI_Comm comm);
-void    Bcast_solution(MPI_Comm comm);
 int     Solution(NODE_T node);
 COST_T  Evaluate(NODE_T node);
 int     Feasible(NODE_T node, MPI_Comm comm);
@@ -9,6 +9,13 @@
  *
  * After exiting the loop, the global best solution is updated and
  * printed.
+ *
+ * If the program is compiled with -DCHECKPOINT, the loop also saves
+ * the stacks from time to time, and a restarted search that restored
+ * them doesn't generate the initial tree -- see solution.c.
+ *
+ * In hybrid search (-DHYBRID), thread 0 runs the loop, and the other
+ * threads take work from each other -- see hybrid.c.
  * 
  * See Chap 14, pp. 328 & ff., in PPMPI.
  */
@@ -28,6 +35,11 @@
 #include "service_requests.h"
 #include "work_remains.h"
 #include "terminate.h"
+#include "bound.h"
+#include "trace.h"
+#ifdef HYBRID
+#include "hybrid.h"
+#endif
 
 /* Global variables */
 extern int       max_children;
@@ -51,19 +63,41 @@ void Par_tree_search(
     MPI_Comm_rank(comm, &my_rank);
 
     /* Generate initial set of nodes, 1 per process */
-    if (my_rank == 0) {
-        Generate(root, &node_list, p, comm);
+    if (!Search_restored()) {
+        if (my_rank == 0) {
+            Generate(root, &node_list, p, comm);
+        }
+        Scatter(node_list, &node, comm);
     }
-    Scatter(node_list, &node, comm);
 
     Initialize(node, &local_stack);
 
+#ifdef HYBRID
+    Hybrid_search(local_stack, comm);
+#else
+    Search(local_stack, comm);
+#endif
+
+    /* Get global best solution */
+    Update_solution(comm);
+    Print_solution(io_comm);
+} /* Par_tree_search */
+
+
+/*********************************************************************/
+/* The main loop:  search until every process is out of work */
+void Search(
+        STACK_T   local_stack  /* in/out */,
+        MPI_Comm  comm         /* in     */) {
+
     do {
         /* Search for a while */
 #ifdef STATS
         Start_time(par_dfs_time);
 #endif
+        Trace_begin(TR_PAR_DFS);
         Par_dfs(local_stack, comm);
+        Trace_end(TR_PAR_DFS);
 #ifdef STATS
         Finish_time(par_dfs_time);
 #endif
@@ -72,21 +106,25 @@ void Par_tree_search(
 #ifdef STATS
         Start_time(svc_req_time);
 #endif
+        Trace_begin(TR_SVC_REQ);
         Service_requests(local_stack, comm);
+        Trace_end(TR_SVC_REQ);
 #ifdef STATS
         Finish_time(svc_req_time);
 #endif
 
+#if defined(CHECKPOINT) && !defined(HYBRID)
+        /* Save the stacks if process 0 has started a round */
+        Checkpoint_search(local_stack, comm);
+#endif
+
         /* If local_stack isn't empty, return.          */
         /* If local_stack is empty, send                */
         /* requests until either we get work, or we     */
         /* receive a message terminating program.       */       
     } while(Work_remains(local_stack, comm));
 
-    /* Get global best solution */
-    Update_solution(comm);
-    Print_solution(io_comm);
-} /* Par_tree_search */
+} /* Search */
 
 
 /*********************************************************************/
@@ -117,10 +155,15 @@ void Generate(
         if (Solution(node)) {
             temp_solution = Local_evaluate(node);
             if (temp_solution < Local_best_solution()) {
-                Local_solution_update(temp_solution, node);
+                Local_solution_update(temp_solution, node, local_stack);
+                Publish_solution();
             }
         } else if (Feasible(node, comm)) {
             PTS_expand(node, local_stack, &stack_size);
+        } else {
+#ifdef STATS
+            Incr_stat(nodes_pruned);
+#endif
         }
     }  /* while */
 
@@ -143,7 +186,7 @@ void Generate(
 COST_T Local_evaluate(
            NODE_T  node  /* in */) {
 
-    return ((COST_T) My_rand(Seed(node)));
+    return Leaf_cost(node);
 }  /* Local_evaluate */
 
 
@@ -157,7 +200,8 @@ void PTS_expand(
     int    num_children;
     int    i;
     NODE_T temp_node;
-    NODE_T temp_parent;
+    int    temp_parent[NODE_MEMBERS];
+    int    parent_path;
     int    local_seed;
     int    divisor;
     int    quotient;
@@ -174,7 +218,15 @@ void PTS_expand(
     if (num_children < min_children)
         num_children = min_children;
 
-    temp_parent = Copy_to_scratch(parent);
+    /* parent is no longer on the stack, and may be overwritten */
+    Copy_node(parent, temp_parent);
+    parent_path = Extend_path(temp_parent, local_stack);
+    if (parent_path < 0) {
+        fprintf(stderr, "Process %d > Can't extend path, Path_used(stack) = %d\n",
+            my_rank, Path_used(local_stack));
+        fprintf(stderr, "Quitting!\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
     local_seed = My_rand(local_seed + My_rand(Depth(parent)));
     for (i = num_children - 1; i >= 0; i--) {
         error = Allocate_node(local_stack, &temp_node);
@@ -185,7 +237,9 @@ void PTS_expand(
             MPI_Abort(MPI_COMM_WORLD, -1);
         }
         local_seed = My_rand(local_seed);
-        Initialize_node(temp_node, temp_parent, i, local_seed);
+        Initialize_node(temp_node, temp_parent, parent_path, i,
+            local_seed);
+        Set_path_cost(temp_node, temp_parent);
         Push(temp_node, local_stack);
         *stack_size_ptr = *stack_size_ptr + 1;
     }
@@ -195,7 +249,8 @@ void PTS_expand(
 
 
 /*********************************************************************/
-/* Process 0 scatters initial tree among processes */
+/* Process 0 scatters initial tree among processes.  Each node is   */
+/*     sent together with its path, using the format of Pack_nodes. */
 void Scatter(
          NODE_T*   node_list  /* in  */, 
          NODE_T*   node_ptr   /* out */, 
@@ -207,41 +262,54 @@ void Scatter(
     NODE_T     node;
     MPI_Status status;
     int        error;
+    int*       buffer;
+    int        buffer_size;
+    int        count;
 
     MPI_Comm_size(comm, &p);
     MPI_Comm_rank(comm, &my_rank);
 
+    /* A node's path has at most max_depth entries */
+    buffer_size = 2 + NODE_MEMBERS + 2*max_depth;
+    buffer = (int*) malloc(buffer_size*sizeof(int));
+    if (buffer == (int*) NULL) {
+        fprintf(stderr, "Process %d > Can't allocate scatter buffer\n",
+            my_rank);
+        fprintf(stderr, "Quitting!\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
     Get_local_stack(&local_stack);
     if (my_rank == 0) {
         /* Don't use MPI_Scatter because we will need an extra */
-        /*     buffer to avoid overwriting local_stack         */
+        /*     buffer for each process                         */
         for (q = p-1; q >= 1; q--) {
             node = Pop(local_stack);
-            MPI_Send(node, Calc_size(node), node_mpi_t, q,
-                0, comm);
+            count = Pack_nodes(node, 1, local_stack, buffer, buffer_size);
+            MPI_Send(buffer, count, MPI_INT, q, 0, comm);
         }
     } else {
-        error = Allocate_node(local_stack, node_ptr);
+        MPI_Recv(buffer, buffer_size, MPI_INT, 0, 0, comm, &status);
+        MPI_Get_count(&status, MPI_INT, &count);
+        error = Append_nodes(buffer, count, local_stack);
         if (error < 0) {
             fprintf(stderr,"Process %d > Stack overflow, In_use(stack) = %d, Max_size(stack) = %d\n",
                 my_rank, In_use(local_stack), Max_size(local_stack));
             fprintf(stderr, "Quitting!\n");
             MPI_Abort(MPI_COMM_WORLD, -1);
         }
-        MPI_Recv(*node_ptr, MAX_NODE_SIZE, node_mpi_t, 0, 0,
-            comm, &status);
+        *node_ptr = Top(local_stack);
     }
+    free(buffer);
         
 }  /* Scatter */
 
 
 /*********************************************************************/
+/* Scatter has already pushed each process' nodes */
 void Initialize(
          NODE_T    node       /* in  */, 
          STACK_T*  stack_ptr  /* out */) {
 
     Get_local_stack(stack_ptr);
-    if (my_rank != 0) {
-        Push(node, *stack_ptr);
-    }
 }  /* Initialize */
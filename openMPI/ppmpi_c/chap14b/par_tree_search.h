@@ -13,6 +13,7 @@
 #include "node_stack.h"
 
 void   Par_tree_search(NODE_T root, MPI_Comm comm);
+void   Search(STACK_T local_stack, MPI_Comm comm);
 void   Generate(NODE_T root, NODE_T** node_list, int p, MPI_Comm comm);
 void   Scatter(NODE_T* node_list, NODE_T* node_ptr, MPI_Comm comm);
 COST_T Local_evaluate(NODE_T node);
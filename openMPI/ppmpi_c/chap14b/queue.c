@@ -8,6 +8,7 @@
 #include "queue.h"
 #include "mpi.h"
 #include "node_stack.h"
+#include "trace.h"
 
 extern int my_rank;
 
@@ -54,13 +55,14 @@ int Work_requests_pending(
 
 
 /*********************************************************************/
-/* Only called when a message is pending */
+/* Only called when a message is pending.  The request contains the  */
+/*     maximum number of ints the requesting process can receive.   */
 int Get_dest(
-        MPI_Comm  comm  /* in */) {
-    int         node_request;
+        MPI_Comm  comm           /* in  */,
+        int*      max_count_ptr  /* out */) {
     MPI_Status  status;
 
-    MPI_Recv(&node_request, 1, MPI_INT, MPI_ANY_SOURCE, REQUEST_TAG,
+    MPI_Recv(max_count_ptr, 1, MPI_INT, MPI_ANY_SOURCE, REQUEST_TAG,
         comm, &status);
     return status.MPI_SOURCE;
 }  /* Get_dest */
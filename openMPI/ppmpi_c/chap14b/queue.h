@@ -12,6 +12,6 @@
 
 void Clean_up_queues(MPI_Comm comm);
 int  Work_requests_pending(MPI_Comm comm);
-int  Get_dest(MPI_Comm comm);
+int  Get_dest(MPI_Comm comm, int* max_count_ptr);
 
 #endif
@@ -3,11 +3,16 @@
  *
  * See Chap 14, p. 332, in PPMPI. 
  */
+#include <stdio.h>
 #include <stdlib.h>
 #include "service_requests.h"
 #include "queue.h"
 #include "terminate.h"
 #include "node_stack.h"
+#include "trace.h"
+#ifdef HYBRID
+#include "hybrid.h"
+#endif
 #ifdef STATS
 #include "stats.h"
 #endif
@@ -16,44 +21,33 @@ extern int my_rank;
 extern int cutoff_depth;
 extern MPI_Comm io_comm;
 
-MPI_Datatype send_stack_mpi_t;
-
-static int   allocated_size;
-static int*  block_lengths = (int*) NULL;
-static int*  displacements = (int*) NULL; 
-static NODE_T* node_list;
-static int   node_count;
+static int*  send_buffer = (int*) NULL;
+static int   send_buffer_size;
+static int   send_count;
 
 
 /*********************************************************************/
-/* Allocate arrays for use in constructing MPI derived datatypes. 
- *     Return negative if malloc fails, 0 otherwise 
+/* Allocate the buffer used for sending work.  Split enlarges it if
+ *     necessary.  Return negative if malloc fails, 0 otherwise 
  */
-int Allocate_type_arrays(
-        int  cutoff_depth  /* in */,
+int Allocate_send_buffer(
+        int  max_depth     /* in */,
         int  max_children  /* in */) {
 
-    allocated_size = cutoff_depth*(max_children - 1)/2;
+    send_buffer_size = 2 + (NODE_MEMBERS + 2)*(max_depth + 1)*max_children;
+    send_buffer = (int*) malloc(send_buffer_size*sizeof(int));
 
-    block_lengths = (int*) malloc(allocated_size*sizeof(int));
-    displacements = (int*) malloc(allocated_size*sizeof(int));
-    node_list     = (NODE_T*) malloc(allocated_size*sizeof(NODE_T));
-
-    if ( (block_lengths == (int*) NULL) ||
-         (displacements == (int*) NULL) ||
-         (node_list     == (NODE_T*) NULL) )
+    if (send_buffer == (int*) NULL)
         return -1;
     else
         return 0;
-}  /* Allocate_type_arrays */
+}  /* Allocate_send_buffer */
 
 
 /*********************************************************************/
-void Free_type_arrays(void) {
-    free(block_lengths);
-    free(displacements);
-    free(node_list);
-}  /* Free_type_arrays */
+void Free_send_buffer(void) {
+    free(send_buffer);
+}  /* Free_send_buffer */
     
 
 /*********************************************************************/
@@ -61,44 +55,49 @@ void Free_type_arrays(void) {
  *     processes have requested work.  If so, check local stack to 
  *     see whether there are any nodes above cutoff_depth.  If so, 
  *     send half of them to the requesting process.  If not, send
- *     a "reject" message.  The splitting of the stack is done using
- *     MPI_Type_indexed.  After the data has been sent.  The stack
- *     is "compressed".
+ *     a "reject" message.  The nodes sent are taken from the bottom
+ *     of the stack, so nothing needs to be moved.
  */
 void Service_requests(
          STACK_T   local_stack  /* in/out */,
          MPI_Comm  comm         /* in     */) {
-    STACK_T send_stack;
     int     destination;
+    int     max_count;
 
 #ifdef DEBUG
     printf("Process %d > In Service_requests\n", my_rank);
     fflush(stdout);
 #endif
 
+    Term_progress(comm);
     while (Work_requests_pending(comm)) {
 #ifdef DEBUG
         printf("Process %d > In Service_requests, queue not empty\n", my_rank);
         fflush(stdout);
 #endif
-        destination = Get_dest(comm);
+        destination = Get_dest(comm, &max_count);
 #ifdef DEBUG
         printf("Process %d > In Service_requests, dest = %d\n", 
                my_rank, destination);
         fflush(stdout);
 #endif
-        if (Nodes_available(local_stack)) {
+#ifdef HYBRID
+        /* Give away work that's waiting for the other threads */
+        if (!Nodes_available(local_stack))
+            Get_node_work(local_stack, NULL);
+#endif
+        if (Nodes_available(local_stack) && 
+                (Split(local_stack, max_count) > 0)) {
 #ifdef DEBUG
             printf("Process %d > In Service_requests, work available\n", 
                my_rank);
             fflush(stdout);
 #endif
-            Split(local_stack, &send_stack);
-            Send_work(destination, send_stack, comm);
+            Send_work(destination, comm);
 #ifdef DEBUG
             printf("Process %d > In Service_requests, work sent to %d\n", 
                my_rank, destination);
-            Print_stack("After compress", local_stack, comm);
+            Print_stack("After split", local_stack, comm);
             fflush(stdout);
 #endif
         } else {
@@ -137,98 +136,89 @@ int Nodes_available(
 
 
 /*********************************************************************/
-/* Split builds a derived datatype that picks out the nodes to be */
-/*     sent */
-void Split(
-         STACK_T   local_stack    /* in  */, 
-         STACK_T*  send_stack_ptr /* out */) {
-    int     index = 0;
+/* The nodes above cutoff_depth are closest to the bottom of the     */
+/*     stack, so the nodes given away are the bottom nodes of the    */
+/*     stack up to and including half of those above cutoff_depth.  */
+/*     Returns the number of nodes to be given away.                 */
+int Split_count(
+        STACK_T  local_stack  /* in */) {
     NODE_T  node;
-    int     odd = 0;
+    int     eligible = 0;
+    int     taken = 0;
+    int     node_count = 0;
+
+    for (node = Bottom_node(local_stack); 
+            (node != NODE_NULL) && (node <= Top(local_stack));
+            node = Next(local_stack, node))
+        if (Depth(node) <= cutoff_depth)
+            eligible++;
 
-    node = Stack_list(local_stack);
-    node_count = 0;
-    while ( (node != NODE_NULL) && (node <= Top(local_stack)) ) {
+    node = Bottom_node(local_stack);
+    while (taken < eligible/2) {
         if (Depth(node) <= cutoff_depth)
-            if (odd) {
-                block_lengths[node_count] = Size(node);
-                displacements[node_count] = index;
-                node_list[node_count] = node;
-                node_count++;
-                odd = 0;   /* skip the next one above cutoff */
-            } else {
-                odd = 1;   /* take the next one above cutoff */
-            }
-        index = index + Size(node);
+            taken++;
+        node_count++;
         node = Next(local_stack, node);
     }
 
-    MPI_Type_indexed(node_count, block_lengths, displacements, MPI_INT,
-        &send_stack_mpi_t);
-    MPI_Type_commit(&send_stack_mpi_t);
+    return node_count;
+}  /* Split_count */
 
-    Get_local_stack(send_stack_ptr);
+
+/*********************************************************************/
+/* Split packs the nodes to be sent into send_buffer, and removes    */
+/*     them from local_stack.  See Split_count for the nodes that    */
+/*     are sent.  At most max_count ints are packed.  Returns the    */
+/*     number of nodes packed.                                       */
+int Split(
+         STACK_T   local_stack    /* in/out */, 
+         int       max_count      /* in     */) {
+    int     node_count;
+    int     needed;
+
+    node_count = Split_count(local_stack);
+    needed = 2 + NODE_MEMBERS*node_count + 2*Path_used(local_stack);
+    if (needed > send_buffer_size) {
+        free(send_buffer);
+        send_buffer_size = needed;
+        send_buffer = (int*) malloc(send_buffer_size*sizeof(int));
+        if (send_buffer == (int*) NULL) {
+            fprintf(stderr, "Process %d > Can't allocate send buffer\n",
+                my_rank);
+            fprintf(stderr, "Quitting!\n");
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+    }
+
+    send_count = Pack_nodes(Bottom_node(local_stack), node_count,
+        local_stack, send_buffer, max_count);
+    node_count = send_buffer[0];
+    if (node_count > 0)
+        Remove_bottom(node_count, local_stack);
+
+    return node_count;
 
 }  /* Split */
 
 
 /*********************************************************************/
+/* Send the nodes packed by Split */
 void Send_work(
          int       destination  /* in */,
-         STACK_T   send_stack   /* in */, 
          MPI_Comm  comm         /* in */) {
 
-    MPI_Send(Stack_list(send_stack), 1, send_stack_mpi_t, destination,
+    /* The credit may have to be borrowed from process 0:  do it */
+    /*     before process 0 can be waiting for this work         */
+    Term_work_sent(destination, comm);
+    MPI_Send(send_buffer, send_count, MPI_INT, destination,
         WORK_TAG, comm);
-    MPI_Type_free(&send_stack_mpi_t);
-    Send_half_energy(destination, comm);
+    Trace_instant(TR_WORK_SENT, destination);
 #ifdef STATS
     Incr_stat(work_sent);
 #endif
-    Compress(send_stack);
 }  /* Send_work */
 
 
-/*********************************************************************/
-void Compress(
-         STACK_T  stack  /* in/out */) {
-    NODE_T compress_point;  /* In general, not a node, just a point */
-                            /*     in the stack                     */
-    NODE_T delete_node;
-    NODE_T save_node;
-    int    new_in_use;
-    int    i;
-
-#ifdef DEBUG
-    printf("Process %d > In Compress, raw stack_list = \n",my_rank);
-    Print_stack_list(In_use(stack), stack, io_comm);
-#endif
-
-    compress_point = node_list[0];
-    new_in_use = displacements[0];
-    
-    for (i = 0; i < node_count; i++) {
-        delete_node = node_list[i];
-        if (Next(stack, delete_node) <= Top(stack)) {
-            save_node = Next(stack, delete_node);
-            Copy_node(save_node, compress_point);
-            new_in_use = new_in_use + Size(compress_point);
-            compress_point = Next(stack, compress_point);
-        }
-    }
-
-    Top(stack) = Pred(stack, compress_point);
-    In_use(stack) = new_in_use;
-
-#ifdef DEBUG
-    printf("Process %d > After Compress, raw stack_list = \n",my_rank);
-    Print_stack_list(In_use(stack), stack, io_comm);
-    printf("Process %d > After Compress, Top(stack) = \n", my_rank);
-    Print_node(Top(stack), stack, io_comm);
-#endif
-}  /* Compress */
-
-
 /*********************************************************************/
 void Send_reject(
          int       destination  /* in */,
@@ -246,9 +236,10 @@ void Send_reject(
 void Send_all_rejects(
          MPI_Comm  comm) {
     int destination;
+    int max_count;
 
     while (Work_requests_pending(comm)) {
-        destination = Get_dest(comm);
+        destination = Get_dest(comm, &max_count);
         Send_reject(destination, comm);
     }
 }  /* Send_all_rejects */
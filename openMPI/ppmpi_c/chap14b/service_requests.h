@@ -9,13 +9,13 @@
 #include "mpi.h"
 
 /* Called in Service_requests */
-int   Allocate_type_arrays(int cutoff_depth, int max_children);
-void  Free_type_arrays(void);
+int   Allocate_send_buffer(int max_depth, int max_children);
+void  Free_send_buffer(void);
 void  Service_requests(STACK_T local_stack, MPI_Comm comm);
 int   Nodes_available(STACK_T local_stack);
-void  Split(STACK_T local_stack, STACK_T* send_stack_ptr);
-void  Send_work(int destination, STACK_T send_stack, MPI_Comm comm);
-void  Compress(STACK_T stack);
+int   Split_count(STACK_T local_stack);
+int   Split(STACK_T local_stack, int max_count);
+void  Send_work(int destination, MPI_Comm comm);
 void  Send_reject(int destination, MPI_Comm comm);
 void  Send_all_rejects(MPI_Comm comm);
 
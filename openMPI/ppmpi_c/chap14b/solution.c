@@ -1,6 +1,55 @@
 /* solution.c -- functions for keeping track of the best solution found
  *     so far -- for use in parallel tree search.
  *
+ * The cost of the best solution found by any process -- the incumbent
+ *     -- is kept in an MPI window on process 0.  A process that finds
+ *     a better solution stores its cost there with MPI_Accumulate and
+ *     MPI_MIN, and each call to Par_dfs reads it with MPI_Fetch_and_op.
+ *     So a process never waits for another, and the local copy of the
+ *     incumbent is at most one call to Par_dfs out of date.  The
+ *     path to the best solution is only sent at the end of the search
+ *     (see Update_solution).
+ *
+ * In hybrid search (-DHYBRID) every thread may update the solution,
+ *     so updates are made in a critical section, and the costs are
+ *     read and written atomically.  Only thread 0 calls MPI, so the
+ *     solutions found by the other threads are published the next
+ *     time it calls Par_dfs.
+ *
+ * If the program is compiled with -DCHECKPOINT, each process keeps its
+ *     best solution in the files SOLN_CKPT_PREFIX.<rank>.<slot>.  When
+ *     it finds a better one, Publish_solution starts an MPI-IO write
+ *     of it into the slot that wasn't written last, and doesn't wait
+ *     for it.  If the last write hasn't finished yet, the new solution
+ *     is written on a later call, so at most one write is in flight
+ *     and the other slot always holds a complete solution.  When the
+ *     program starts, Setup_soln_ckpt reads both slots, and a process
+ *     that finds a solution written by a run on the same tree starts
+ *     with it as its best solution.  So a restarted search prunes
+ *     with the old run's incumbent, and it only has to look for
+ *     better solutions.  The files are deleted when the search
+ *     finishes.
+ *
+ *     The local stacks are saved in rounds.  Every CKPT_INTERVAL
+ *     seconds (compile with -DCKPT_INTERVAL=<s>) process 0 tells the
+ *     other processes to start a round.  Nodes may be in flight
+ *     between processes during load balancing, so each process
+ *     stops sending requests for work, and rejects the requests it
+ *     receives, until every request on every process has been
+ *     answered.  Then every node is on some process' stack, and each
+ *     process writes its whole stack, packed as in Pack_nodes, with
+ *     its best solution into the next slot, and waits for the write.
+ *     A barrier ends the round.  Until then the other slot still
+ *     holds the stack from the last round, and later solutions are
+ *     written with the stack from the newest round.  So each process
+ *     always has a complete slot from the last round that every
+ *     process finished.  On restart the processes agree on the
+ *     newest round that all of them have saved, restore their stacks
+ *     from it, and skip the generation of the initial tree.  The
+ *     stacks are only restored if the number of processes is the
+ *     same.  In hybrid search (-DHYBRID) only the solutions are
+ *     saved:  the other threads' stacks aren't visible to MPI.
+ *
  * See Chap 14, pp. 328 & ff, in PPMPI for a discussion of parallel tree
  *     search.
  */
@@ -9,88 +58,612 @@
 #include "cio.h"
 #include "node_stack.h"
 #include "solution.h"
+#include "trace.h"
+#ifdef CHECKPOINT
+#include <stdlib.h>
+#include <string.h>
+#include "bound.h"
+#include "work_remains.h"
+#endif
 
 static int* best_solution;
-static int* temp_solution;
-static int* solution1;  
     /* first entry = cost, remaining entries, sibling */
     /* ranks on path from root to solution node       */
     /* Thus solution_size = 1 + max_depth + 1         */
-static int* solution2;
 static int  solution_size;
 
+static COST_T   incumbent = INFINITY;  /* best known on any process */
+static MPI_Win  incumbent_win = MPI_WIN_NULL;
+static COST_T*  global_incumbent;      /* only allocated on proc 0  */
+static COST_T   published = INFINITY;  /* last cost stored there    */
+
+static void Update_best(COST_T cost, NODE_T node, STACK_T stack);
+
 extern int max_depth;
 
+#ifdef CHECKPOINT
+#ifndef SOLN_CKPT_PREFIX
+#define SOLN_CKPT_PREFIX "tree_best"
+#endif
+#ifndef CKPT_INTERVAL
+#define CKPT_INTERVAL 60.0  /* seconds between saves of the stacks */
+#endif
+#define SOLN_CKPT_MAGIC   0x54524545  /* "TREE" */
+#define SOLN_CKPT_HEADER  7   /* magic, max_depth, max_children,     */
+                              /*     edge cost range, p, round, ints */
+                              /*     in the packed stack             */
+#define CKPT_TREE         4   /* header entries that fix the tree */
+#define CKPT_NPROCS       4
+#define CKPT_ROUND        5
+#define CKPT_STACK        6
+
+/* A slot holds the header, best_solution, the local stack from the */
+/*     last round, packed by Pack_nodes, and a checksum             */
+static MPI_File     ckpt_files[2] = {MPI_FILE_NULL, MPI_FILE_NULL};
+static int*         ckpt_bufs[2] = {(int*) NULL, (int*) NULL};
+static int          ckpt_max[2] = {0, 0};  /* ints allocated         */
+static int          ckpt_slot = 0;       /* next slot written       */
+static MPI_Request  ckpt_req = MPI_REQUEST_NULL;
+static COST_T       saved = INFINITY;    /* cost in the newest slot */
+static int*         stack_buf = (int*) NULL;
+static int          stack_max = 0;
+static int          stack_count = 0;     /* ints in stack_buf       */
+static int          ckpt_round = 0;      /* round of stack_buf, 0 = */
+                                         /*     no stack saved      */
+static int          next_round = 1;
+static int          restored = FALSE;
+static double       last_round_time;
+
+static void     Save_solution(void);
+static void     Save_search(STACK_T local_stack, MPI_Comm comm);
+static int      Fill_slot(int slot);
+static int      Read_slot(int slot);
+static int      Grow_slot(int slot, int size);
+static int      Grow_stack_buf(int size);
+static void     Slot_name(int slot, int my_rank, char* name);
+static void     Fill_header(int* buf);
+static unsigned Checksum(int* buf, int count);
+
+extern int max_children;
+extern int p;
+#endif
+
 /*********************************************************************/
-/* Check queue for new solutions.  Return best solution found */
-COST_T Best_solution(
-           MPI_Comm  comm  /* in */) {
-    MPI_Status  probe_status;
-    MPI_Status  recv_status;
-    int         done = FALSE;
-    int         message_pending;
-    int*        temp;
-
-    while (!done) {
-        MPI_Iprobe(MPI_ANY_SOURCE, SOLUTION_TAG, comm,
-            &message_pending, &probe_status);
-        if (message_pending) {
-            MPI_Recv(temp_solution, solution_size, MPI_INT,
-                probe_status.MPI_SOURCE, SOLUTION_TAG, comm,
-                &recv_status);
-            if (*temp_solution < *best_solution) {
-                temp = temp_solution;
-                temp_solution = best_solution;
-                best_solution = temp;
-            }
+/* Return 0 if successful, negative otherwise.  Must be called by */
+/*     every process in comm                                       */
+int Setup_incumbent(
+        MPI_Comm  comm  /* in */) {
+    int my_rank;
+
+    MPI_Comm_rank(comm, &my_rank);
+    if (MPI_Win_allocate((my_rank == 0 ? sizeof(COST_T) : 0),
+            sizeof(COST_T), MPI_INFO_NULL, comm, &global_incumbent,
+            &incumbent_win) != MPI_SUCCESS)
+        return -1;
+    if (my_rank == 0) *global_incumbent = INFINITY;
+    MPI_Win_lock_all(0, incumbent_win);
+    MPI_Barrier(comm);
+
+    return 0;
+}  /* Setup_incumbent */
+
+
+/*********************************************************************/
+void Free_incumbent(void) {
+
+    if (incumbent_win != MPI_WIN_NULL) {
+        MPI_Win_unlock_all(incumbent_win);
+        MPI_Win_free(&incumbent_win);
+    }
+}  /* Free_incumbent */
+
+
+/*********************************************************************/
+/* Get the global incumbent from process 0 */
+void Poll_incumbent(void) {
+    COST_T value;
+
+    MPI_Fetch_and_op(NULL, &value, cost_mpi_t, 0, 0, MPI_NO_OP,
+        incumbent_win);
+    MPI_Win_flush(0, incumbent_win);
+#ifdef HYBRID
+#pragma omp critical (solution)
+#endif
+    if (value < incumbent) {
+#ifdef HYBRID
+#pragma omp atomic write
+#endif
+        incumbent = value;
+    }
+}  /* Poll_incumbent */
+
+
+/*********************************************************************/
+/* Store the local best solution in the global incumbent, if it's */
+/*     better.  Nothing is sent if it hasn't changed.             */
+void Publish_solution(void) {
+    COST_T cost = Local_best_solution();
+
+#ifdef CHECKPOINT
+    Save_solution();
+#endif
+    if (cost >= published)
+        return;
+    MPI_Accumulate(&cost, 1, cost_mpi_t, 0, 0, 1, cost_mpi_t, MPI_MIN,
+        incumbent_win);
+    MPI_Win_flush(0, incumbent_win);
+    published = cost;
+}  /* Publish_solution */
+
+
+#ifdef CHECKPOINT
+/*********************************************************************/
+/* Open the files, and restore the best solution and the stack saved */
+/*     by an earlier run on the same tree, if there are any.  Call    */
+/*     after Initialize_soln, Allocate_lists and Setup_incumbent.     */
+/*     Return 0 if successful, negative otherwise.  Must be called by */
+/*     every process in comm.                                         */
+int Setup_soln_ckpt(
+        MPI_Comm  comm  /* in */) {
+    int      my_rank;
+    int      slot, best_slot = -1, round_slot = -1;
+    int      valid[2];
+    int      my_round = 0, round, max_round = 0, all_max;
+    int      found, all_found;
+    int      error = 0, all_error;
+    int*     buf;
+    char     name[256];
+    COST_T   cost = INFINITY, restored_cost;
+    STACK_T  local_stack;
+
+    MPI_Comm_rank(comm, &my_rank);
+    for (slot = 0; slot < 2; slot++) {
+        if (Grow_slot(slot, SOLN_CKPT_HEADER + solution_size + 1) < 0)
+            error = 1;
+        /* Files return errors by default */
+        Slot_name(slot, my_rank, name);
+        if (MPI_File_open(MPI_COMM_SELF, name,
+                MPI_MODE_CREATE | MPI_MODE_RDWR, MPI_INFO_NULL,
+                &ckpt_files[slot]) != MPI_SUCCESS)
+            error = 1;
+    }
+    MPI_Allreduce(&error, &all_error, 1, MPI_INT, MPI_LOR, comm);
+    if (all_error) {
+        Free_soln_ckpt(0);
+        return -1;
+    }
+
+    /* Any valid slot's solution can be used.  A stack can only be */
+    /*     used if every process has one from the same round.      */
+    for (slot = 0; slot < 2; slot++) {
+        valid[slot] = Read_slot(slot);
+        if (!valid[slot]) continue;
+        buf = ckpt_bufs[slot];
+        if (buf[SOLN_CKPT_HEADER] < cost) {
+            cost = buf[SOLN_CKPT_HEADER];
+            best_slot = slot;
+        }
+        if (buf[CKPT_ROUND] > max_round)
+            max_round = buf[CKPT_ROUND];
+        if ((buf[CKPT_NPROCS] == p) && (buf[CKPT_ROUND] > my_round))
+            my_round = buf[CKPT_ROUND];
+    }
+    MPI_Allreduce(&my_round, &round, 1, MPI_INT, MPI_MIN, comm);
+    for (slot = 0; slot < 2; slot++)
+        if ((round > 0) && valid[slot] &&
+                (ckpt_bufs[slot][CKPT_NPROCS] == p) &&
+                (ckpt_bufs[slot][CKPT_ROUND] == round))
+            round_slot = slot;
+    found = (round > 0) && (round_slot >= 0);
+    MPI_Allreduce(&found, &all_found, 1, MPI_INT, MPI_LAND, comm);
+
+    /* Later rounds are numbered above any round in the old files */
+    MPI_Allreduce(&max_round, &all_max, 1, MPI_INT, MPI_MAX, comm);
+    next_round = all_max + 1;
+
+    if (all_found) {
+        buf = ckpt_bufs[round_slot];
+        if (Grow_stack_buf(buf[CKPT_STACK]) < 0) {
+            error = 1;
         } else {
-            done = TRUE;
+            stack_count = buf[CKPT_STACK];
+            memcpy(stack_buf, buf + SOLN_CKPT_HEADER + solution_size,
+                stack_count*sizeof(int));
+            Get_local_stack(&local_stack);
+            if (Append_nodes(stack_buf, stack_count, local_stack) < 0)
+                error = 1;
         }
-    }  /* while */
+        MPI_Allreduce(&error, &all_error, 1, MPI_INT, MPI_LOR, comm);
+        if (all_error) {
+            Free_soln_ckpt(0);
+            return -1;
+        }
+        ckpt_round = round;
+        restored = TRUE;
+        ckpt_slot = 1 - round_slot;
+    } else if (best_slot >= 0) {
+        ckpt_slot = 1 - best_slot;
+    }
+
+    if (best_slot >= 0) {
+        memcpy(best_solution, ckpt_bufs[best_slot] + SOLN_CKPT_HEADER,
+            solution_size*sizeof(int));
+        incumbent = saved = cost;
+        Publish_solution();
+    }
+    last_round_time = MPI_Wtime();
+
+    MPI_Allreduce(&cost, &restored_cost, 1, cost_mpi_t, MPI_MIN, comm);
+    if ((my_rank == 0) && (restored_cost < INFINITY))
+        printf("Restarting with a solution of cost %d\n", restored_cost);
+    if ((my_rank == 0) && restored)
+        printf("Restarting from the stacks saved in round %d\n", round);
+    return 0;
+}  /* Setup_soln_ckpt */
+
+
+/*********************************************************************/
+/* TRUE if Setup_soln_ckpt restored the local stacks, so the initial */
+/*     tree shouldn't be generated                                   */
+int Search_restored(void) {
+    return restored;
+}  /* Search_restored */
+
+
+/*********************************************************************/
+/* Wait for the last write, close the files, and delete them if     */
+/*     remove is nonzero                                            */
+void Free_soln_ckpt(
+         int  remove  /* in */) {
+    int         slot;
+    int         my_rank;
+    char        name[256];
+    MPI_Status  status;
+
+    if (ckpt_req != MPI_REQUEST_NULL)
+        MPI_Wait(&ckpt_req, &status);
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+    for (slot = 0; slot < 2; slot++) {
+        if (ckpt_files[slot] != MPI_FILE_NULL) {
+            MPI_File_close(&ckpt_files[slot]);
+            if (remove) {
+                Slot_name(slot, my_rank, name);
+                MPI_File_delete(name, MPI_INFO_NULL);
+            }
+        }
+        free(ckpt_bufs[slot]);
+        ckpt_bufs[slot] = (int*) NULL;
+        ckpt_max[slot] = 0;
+    }
+    free(stack_buf);
+    stack_buf = (int*) NULL;
+    stack_max = stack_count = 0;
+}  /* Free_soln_ckpt */
+
+
+/*********************************************************************/
+/* Called by every process in the main loop, and by idle processes   */
+/*     while they look for work.  Every CKPT_INTERVAL seconds process */
+/*     0 tells the others to save their stacks.  Each process stops   */
+/*     asking for work, and waits until every request has been        */
+/*     answered (see Drain_requests).  Then no nodes are in flight,   */
+/*     and every process writes its stack and its best solution.     */
+void Checkpoint_search(
+         STACK_T   local_stack  /* in/out */,
+         MPI_Comm  comm         /* in     */) {
+    int         my_rank;
+    int         dest;
+    int         round;
+    int         round_started;
+    MPI_Status  status;
+
+    if (ckpt_files[0] == MPI_FILE_NULL)
+        return;
+    MPI_Comm_rank(comm, &my_rank);
+    if (my_rank == 0) {
+        if (MPI_Wtime() - last_round_time < CKPT_INTERVAL)
+            return;
+        for (dest = 1; dest < p; dest++)
+            MPI_Send(&next_round, 1, MPI_INT, dest, CKPT_TAG, comm);
+    } else {
+        MPI_Iprobe(0, CKPT_TAG, comm, &round_started, &status);
+        if (!round_started)
+            return;
+        MPI_Recv(&round, 1, MPI_INT, 0, CKPT_TAG, comm, &status);
+    }
+
+    Drain_requests(local_stack, comm);
+    Save_search(local_stack, comm);
+    last_round_time = MPI_Wtime();
+}  /* Checkpoint_search */
+
+
+/*********************************************************************/
+/* Write the whole local stack and the best solution into the next  */
+/*     slot, and wait for the write.  The round is only complete     */
+/*     when every process has written its slot:  until then, the     */
+/*     other slot must keep the last round.                          */
+static void Save_search(
+                STACK_T   local_stack  /* in */,
+                MPI_Comm  comm         /* in */) {
+    int         my_rank;
+    int         needed;
+    int         size;
+    MPI_Status  status;
+
+    MPI_Comm_rank(comm, &my_rank);
+
+    if (ckpt_req != MPI_REQUEST_NULL) {
+        MPI_Wait(&ckpt_req, &status);
+        MPI_File_sync(ckpt_files[1 - ckpt_slot]);
+    }
+
+    needed = 2 + In_use(local_stack) + 2*Path_used(local_stack);
+    if ((Grow_stack_buf(needed) < 0) ||
+            (Grow_slot(ckpt_slot,
+                SOLN_CKPT_HEADER + solution_size + needed + 1) < 0)) {
+        fprintf(stderr, "Process %d > Can't allocate checkpoint buffer\n",
+            my_rank);
+        fprintf(stderr, "Quitting!\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    stack_count = Pack_nodes(Bottom_node(local_stack),
+        In_use(local_stack)/NODE_MEMBERS, local_stack, stack_buf, needed);
+    ckpt_round = next_round;
+
+    size = Fill_slot(ckpt_slot);
+    MPI_File_write_at(ckpt_files[ckpt_slot], 0, ckpt_bufs[ckpt_slot],
+        size, MPI_INT, &status);
+    MPI_File_sync(ckpt_files[ckpt_slot]);
+    saved = ckpt_bufs[ckpt_slot][SOLN_CKPT_HEADER];
+    ckpt_slot = 1 - ckpt_slot;
+
+    MPI_Barrier(comm);
+    next_round++;
+}  /* Save_search */
 
-    return Local_best_solution();
+
+/*********************************************************************/
+/* Start writing the local best solution, if it's better than the   */
+/*     last one saved.  The stack from the last round is written     */
+/*     with it.  If the last write hasn't finished, try again on the */
+/*     next call.                                                    */
+static void Save_solution(void) {
+    int         done;
+    int         size;
+    MPI_Status  status;
+
+    if ((ckpt_files[0] == MPI_FILE_NULL) ||
+            (Local_best_solution() >= saved))
+        return;
+    if (ckpt_req != MPI_REQUEST_NULL) {
+        MPI_Test(&ckpt_req, &done, &status);
+        if (!done)
+            return;
+        MPI_File_sync(ckpt_files[1 - ckpt_slot]);
+    }
+    if (Grow_slot(ckpt_slot,
+            SOLN_CKPT_HEADER + solution_size + stack_count + 1) < 0)
+        return;
+
+    size = Fill_slot(ckpt_slot);
+    MPI_File_iwrite_at(ckpt_files[ckpt_slot], 0, ckpt_bufs[ckpt_slot],
+        size, MPI_INT, &ckpt_req);
+    saved = ckpt_bufs[ckpt_slot][SOLN_CKPT_HEADER];
+    ckpt_slot = 1 - ckpt_slot;
+}  /* Save_solution */
+
+
+/*********************************************************************/
+/* Copy the header, the best solution, and the stack from the last  */
+/*     round into ckpt_bufs[slot].  Return the number of ints used.  */
+static int Fill_slot(
+               int  slot  /* in */) {
+    int* buf = ckpt_bufs[slot];
+    int  size = SOLN_CKPT_HEADER + solution_size + stack_count + 1;
+
+    Fill_header(buf);
+    buf[CKPT_ROUND] = ckpt_round;
+    buf[CKPT_STACK] = stack_count;
+#ifdef HYBRID
+#pragma omp critical (solution)
+#endif
+    memcpy(buf + SOLN_CKPT_HEADER, best_solution,
+        solution_size*sizeof(int));
+    memcpy(buf + SOLN_CKPT_HEADER + solution_size, stack_buf,
+        stack_count*sizeof(int));
+    buf[size-1] = (int) Checksum(buf, size-1);
+    return size;
+}  /* Fill_slot */
+
+
+/*********************************************************************/
+/* Read a slot into ckpt_bufs[slot].  Return 1 if it holds a complete */
+/*     checkpoint for this tree, 0 otherwise.                         */
+static int Read_slot(
+               int  slot  /* in */) {
+    int         count = 0;
+    int         fixed = SOLN_CKPT_HEADER + solution_size;
+    int         header[SOLN_CKPT_HEADER];
+    int         size;
+    int*        buf;
+    MPI_Offset  file_size;
+    MPI_Status  status;
+
+    if (MPI_File_read_at(ckpt_files[slot], 0, ckpt_bufs[slot], fixed,
+            MPI_INT, &status) != MPI_SUCCESS)
+        return 0;
+    MPI_Get_count(&status, MPI_INT, &count);
+    if (count != fixed)
+        return 0;
+
+    Fill_header(header);
+    buf = ckpt_bufs[slot];
+    if ((memcmp(buf, header, CKPT_TREE*sizeof(int)) != 0) ||
+            (buf[CKPT_STACK] < 0))
+        return 0;
+    MPI_File_get_size(ckpt_files[slot], &file_size);
+    size = fixed + buf[CKPT_STACK] + 1;
+    if (size*((MPI_Offset) sizeof(int)) > file_size)
+        return 0;
+
+    if (Grow_slot(slot, size) < 0)
+        return 0;
+    buf = ckpt_bufs[slot];
+    if (MPI_File_read_at(ckpt_files[slot], fixed*sizeof(int),
+            buf + fixed, size - fixed, MPI_INT, &status) != MPI_SUCCESS)
+        return 0;
+    MPI_Get_count(&status, MPI_INT, &count);
+    if (count != size - fixed)
+        return 0;
+
+    return (buf[SOLN_CKPT_HEADER] < INFINITY) &&
+        ((unsigned) buf[size-1] == Checksum(buf, size-1));
+}  /* Read_slot */
+
+
+/*********************************************************************/
+/* Make ckpt_bufs[slot] hold at least size ints, keeping its       */
+/*     contents.  Return 0 if successful, negative otherwise.      */
+static int Grow_slot(
+               int  slot  /* in */,
+               int  size  /* in */) {
+    int* temp;
+
+    if (size <= ckpt_max[slot])
+        return 0;
+    temp = (int*) realloc(ckpt_bufs[slot], size*sizeof(int));
+    if (temp == (int*) NULL)
+        return -1;
+    ckpt_bufs[slot] = temp;
+    ckpt_max[slot] = size;
+    return 0;
+}  /* Grow_slot */
+
+
+/*********************************************************************/
+/* Make stack_buf hold at least size ints.  Its contents are lost.  */
+/*     Return 0 if successful, negative otherwise.                  */
+static int Grow_stack_buf(
+               int  size  /* in */) {
+
+    if (size <= stack_max)
+        return 0;
+    free(stack_buf);
+    stack_max = stack_count = 0;
+    stack_buf = (int*) malloc(size*sizeof(int));
+    if (stack_buf == (int*) NULL)
+        return -1;
+    stack_max = size;
+    return 0;
+}  /* Grow_stack_buf */
+
+
+/*********************************************************************/
+/* The parameters that determine the tree and its costs, and the    */
+/*     number of processes                                          */
+static void Fill_header(
+                int*  buf  /* out */) {
+    buf[0] = SOLN_CKPT_MAGIC;
+    buf[1] = max_depth;
+    buf[2] = max_children;
+#ifdef PATH_COST
+    buf[3] = EDGE_COST_RANGE;
+#else
+    buf[3] = 0;
+#endif
+    buf[CKPT_NPROCS] = p;
+}  /* Fill_header */
+
+
+/*********************************************************************/
+static void Slot_name(
+                int    slot     /* in  */,
+                int    my_rank  /* in  */,
+                char*  name     /* out */) {
+    sprintf(name, "%s.%d.%d", SOLN_CKPT_PREFIX, my_rank, slot);
+}  /* Slot_name */
+
+
+/*********************************************************************/
+/* FNV-1a */
+static unsigned Checksum(
+                    int*  buf    /* in */,
+                    int   count  /* in */) {
+    unsigned sum = 2166136261U;
+    int      i;
+
+    for (i = 0; i < count; i++)
+        sum = (sum ^ (unsigned) buf[i])*16777619U;
+    return sum;
+}  /* Checksum */
+#endif
+
+
+/*********************************************************************/
+/* Return best solution known on any process.  No communication:  */
+/*     see Poll_incumbent                                          */
+COST_T Best_solution(
+           MPI_Comm  comm  /* in */) {
+    COST_T value;
+
+#ifdef HYBRID
+#pragma omp atomic read
+#endif
+    value = incumbent;
+    return value;
 }  /* Best_solution */
 
 
 /*********************************************************************/
 COST_T Local_best_solution(void) { 
+    COST_T value;
 
-    return *best_solution;
+#ifdef HYBRID
+#pragma omp atomic read
+#endif
+    value = *best_solution;
+    return value;
 } /* Local_best_solution */
 
 /********************************************************************/ 
 void Local_solution_update(
-         COST_T  cost  /* in */,
-         NODE_T  node  /* in */) {
-    int   i;
-    int*  bs_ptr;
-    int*  a_ptr;
+         COST_T   cost   /* in */,
+         NODE_T   node   /* in */,
+         STACK_T  stack  /* in */) {
 
-    *best_solution = cost;
-    for (i = 0, bs_ptr = best_solution+1, a_ptr = Ancestors(node); 
-             i < max_depth; i++, bs_ptr++, a_ptr++)
-        *bs_ptr = *a_ptr;
-    *bs_ptr = Sibling_rank(node);
+#ifdef HYBRID
+#pragma omp critical (solution)
+#endif
+    Update_best(cost, node, stack);
 
 }  /* Local_solution_update */
 
 
 /********************************************************************/ 
-/* Assumes plenty of system buffering.  So beware! */
-void Bcast_solution(MPI_Comm comm){
-    int my_rank;
-    int p;
-    int q;
+/* Another thread may have found a better solution since the caller */
+/*     checked                                                      */
+static void Update_best(
+                COST_T   cost   /* in */,
+                NODE_T   node   /* in */,
+                STACK_T  stack  /* in */) {
+
+    if (cost >= *best_solution)
+        return;
+    Get_ancestors(node, stack, best_solution+1);
+    best_solution[Depth(node)+1] = Sibling_rank(node);
+#ifdef HYBRID
+#pragma omp atomic write
+#endif
+    *best_solution = cost;
+    if (cost < incumbent) {
+#ifdef HYBRID
+#pragma omp atomic write
+#endif
+        incumbent = cost;
+    }
+}  /* Update_best */
 
-    MPI_Comm_rank(comm, &my_rank);
-    MPI_Comm_size(comm, &p);
-    for (q = 0; q < my_rank; q++)
-        MPI_Send(best_solution, solution_size, MPI_INT, q,
-            SOLUTION_TAG, comm);
-    for (q = my_rank+1; q < p; q++)
-        MPI_Send(best_solution, solution_size, MPI_INT, q,
-            SOLUTION_TAG, comm);
-} /* Bcast_solution */
 
 /*********************************************************************/
 /* Return 0 if OK, -1 otherwise */
@@ -99,13 +672,10 @@ int Initialize_soln(
     int i;
 
     solution_size = max_depth+2;
-    solution1 = (int*) malloc(solution_size*sizeof(int));
-    solution2 = (int*) malloc(solution_size*sizeof(int));
-    if ((solution1 == (int*) NULL) || (solution2 == (int*) NULL))
+    best_solution = (int*) malloc(solution_size*sizeof(int));
+    if (best_solution == (int*) NULL)
         return -1;
  
-    best_solution = solution1;
-    temp_solution = solution2;
     best_solution[0] = INFINITY;  
 
     best_solution[1] = 0;        /* root is on best path */
@@ -119,7 +689,6 @@ int Initialize_soln(
 /*********************************************************************/
 void Free_soln(void) {
     free(best_solution);
-    free(temp_solution);
 }  /* Free_soln */
 
 
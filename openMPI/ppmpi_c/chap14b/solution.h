@@ -19,16 +19,26 @@ typedef struct {
 #define update_mpi_t MPI_2INT
 #define cost_mpi_t MPI_INT
 
-#define SOLUTION_TAG 100
-
 COST_T Best_solution(MPI_Comm comm);
 COST_T Local_best_solution(void);
-void   Local_solution_update(COST_T cost, NODE_T node);
-void   Bcast_solution(MPI_Comm comm);
+void   Local_solution_update(COST_T cost, NODE_T node, STACK_T stack);
+int    Setup_incumbent(MPI_Comm comm);
+void   Free_incumbent(void);
+void   Poll_incumbent(void);
+void   Publish_solution(void);
 int    Initialize_soln(int max_depth);
 void   Update_solution(MPI_Comm comm);
 void   Print_local_solution(MPI_Comm comm);
 void   Print_solution(MPI_Comm io_comm);
 void   Free_soln(void);
+#ifdef CHECKPOINT
+#define CKPT_TAG 6000   /* process 0 starts a round of stack saves */
+int    Setup_soln_ckpt(MPI_Comm comm);
+int    Search_restored(void);
+void   Checkpoint_search(STACK_T local_stack, MPI_Comm comm);
+void   Free_soln_ckpt(int remove);
+#else
+#define Search_restored() FALSE
+#endif
 
 #endif
@@ -11,8 +11,13 @@
 #include "mpi.h"
 #include <stdio.h>
 #include "cio.h"
+#include "victim.h"
+#include "work_remains.h"
+#include "terminate.h"
+#include "bound.h"
+#include "hybrid.h"
 
-STATS_T      stats = {0, 0, 0, 0, 0, 0.0, 0.0, 0.0};
+STATS_T      stats = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0.0, 0.0, 0.0};
 double       overhead_time;
 MPI_Datatype stats_mpi_t;
 
@@ -61,12 +66,20 @@ void Build_stats_mpi_t(void) {
     displacements[4] = address - start;
     MPI_Address(&(stats.work_recd), &address);
     displacements[5] = address - start;
-    MPI_Address(&(stats.par_dfs_time), &address);
+    MPI_Address(&(stats.remote_reqs_sent), &address);
     displacements[6] = address - start;
-    MPI_Address(&(stats.svc_req_time), &address);
+    MPI_Address(&(stats.remote_work_recd), &address);
     displacements[7] = address - start;
-    MPI_Address(&(stats.work_rem_time), &address);
+    MPI_Address(&(stats.nodes_pruned), &address);
     displacements[8] = address - start;
+    MPI_Address(&(stats.thread_steals), &address);
+    displacements[9] = address - start;
+    MPI_Address(&(stats.par_dfs_time), &address);
+    displacements[10] = address - start;
+    MPI_Address(&(stats.svc_req_time), &address);
+    displacements[11] = address - start;
+    MPI_Address(&(stats.work_rem_time), &address);
+    displacements[12] = address - start;
 
     MPI_Type_struct(MEMBERS, block_lengths, displacements, types,
         &stats_mpi_t);
@@ -83,6 +96,10 @@ void Set_stats_to_zero(
     stats->work_sent = 0;
     stats->rejects_recd = 0;
     stats->work_recd = 0;
+    stats->remote_reqs_sent = 0;
+    stats->remote_work_recd = 0;
+    stats->nodes_pruned = 0;
+    stats->thread_steals = 0;
     stats->par_dfs_time = 0.0;
     stats->svc_req_time = 0.0;
     stats->work_rem_time = 0.0;
@@ -99,6 +116,10 @@ void Update_totals(
     totals->work_sent += new->work_sent ;
     totals->rejects_recd += new->rejects_recd ;
     totals->work_recd += new->work_recd ;
+    totals->remote_reqs_sent += new->remote_reqs_sent ;
+    totals->remote_work_recd += new->remote_work_recd ;
+    totals->nodes_pruned += new->nodes_pruned ;
+    totals->thread_steals += new->thread_steals ;
     if (totals->par_dfs_time < new->par_dfs_time)
         totals->par_dfs_time = new->par_dfs_time;
     if (totals->svc_req_time < new->svc_req_time)
@@ -112,9 +133,14 @@ void Update_totals(
 void Print_title(void) {
 printf("                Performance Statistics\n");
 printf("     (Totals are sums for counts and maxima for times)\n");
-printf("      Nodes  Reqs  Rejs  Work  Rejs  Work    DFS     Svc     Wk_rm\n");
-printf("Proc   Exp   Sent  Sent  Sent  Recd  Recd    Time    Time     Time\n");
-printf("----  -----  ----  ----  ----  ----  ----    ----    ----    -----\n");
+printf("     Victim selection = %s, max outstanding requests = %d\n",
+    Victim_policy_name(), MAX_OUTSTANDING);
+printf("     Termination detection = %s, lower bound = %s\n", 
+    Term_detect_name(), Bound_name());
+printf("     Threads per process = %d\n", Num_threads());
+printf("      Nodes  Nodes  Reqs  Rejs  Work  Rejs  Work  Rmt   Rmt   Thrd    DFS     Svc     Wk_rm\n");
+printf("Proc   Exp   Prnd   Sent  Sent  Sent  Recd  Recd  Reqs  Work  Stls    Time    Time     Time\n");
+printf("----  -----  -----  ----  ----  ----  ----  ----  ----  ----  ----    ----    ----    -----\n");
 }  /* Print_title */
 
 
@@ -128,10 +154,12 @@ void Print_ind_stats(
     else
         printf(" %2d    ", rank);
 
-    printf("%3d    %2d    %2d    %2d    %2d    %2d   ",
-        stats->nodes_expanded, stats->requests_sent,
+    printf("%3d    %3d    %2d    %2d    %2d    %2d    %2d    %2d    %2d    %2d   ",
+        stats->nodes_expanded, stats->nodes_pruned, stats->requests_sent,
         stats->rejects_sent, stats->work_sent,
-        stats->rejects_recd, stats->work_recd);
+        stats->rejects_recd, stats->work_recd,
+        stats->remote_reqs_sent, stats->remote_work_recd,
+        stats->thread_steals);
     printf("%7.2e %7.2e %7.2e\n",
         stats->par_dfs_time, stats->svc_req_time,
         stats->work_rem_time);
@@ -7,8 +7,8 @@
 
 #define MAX_TESTS 100
 
-#define MEMBERS 9
-#define INT_MEMBERS 6
+#define MEMBERS 13
+#define INT_MEMBERS 10
 #define DOUBLE_MEMBERS 3
 
 typedef struct {
@@ -18,6 +18,12 @@ typedef struct {
     int       work_sent;
     int       rejects_recd;
     int       work_recd;
+    int       remote_reqs_sent;  /* Requests sent to other nodes */
+    int       remote_work_recd;  /* Work received from other nodes */
+    int       nodes_pruned;      /* Popped nodes not expanded because */
+                                 /*     of the bound                  */
+    int       thread_steals;     /* Work taken from another thread's */
+                                 /*     deque -- see hybrid.c        */
     double    par_dfs_time;
     double    svc_req_time;
     double    work_rem_time;
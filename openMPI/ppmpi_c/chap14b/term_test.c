@@ -0,0 +1,189 @@
+/* term_test.c -- stress test for the termination detection functions
+ *     in terminate.c.
+ *
+ * Compile with Makefile.term.  Add -DTERM_SAFRA to CFLAGS to test the
+ *     Dijkstra-Safra token ring instead of credit.
+ *
+ * Input:
+ *     1. total_work:  number of units of work.  Process p-1 starts
+ *        with all of it.
+ *     2. split_interval:  a busy process gives away some of its work
+ *        every split_interval units
+ *     3. split_size:  the number of units given away.  If it's 0, half
+ *        the remaining work is given away.
+ *
+ * Output:
+ *     The number of units of work done, the number of times work was
+ *     split, and whether termination was detected correctly.
+ *
+ * Algorithm:
+ *     Each process does its work one unit at a time.  Every
+ *     split_interval units, it sends split_size units (or half of what's
+ *     left) to a randomly chosen process.  So work keeps moving to
+ *     processes that may already be idle.  Idle processes call
+ *     Search_complete until it returns TRUE.  Then the total number of
+ *     units done is compared with total_work:  if termination was
+ *     detected before all the work was done, some units will be missing
+ *     or still in the message queues.
+ *
+ *     For example, with input "4000000 1 0" on 4 processes, work is
+ *     split about 4 million times.  With input "2000000 1 1", process
+ *     p-1 gives away one unit at a time about a million times.  The
+ *     other processes go idle after each unit, so it never gets any
+ *     credit back, and has to borrow every 62 splits.
+ *
+ * See Chap 14, pp. 334 & ff., in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+#include "cio.h"
+#include "node_stack.h"
+#include "terminate.h"
+
+#define WORK_TAG 20
+
+/* Global variables -- used by terminate.c */
+MPI_Comm  io_comm;
+int       p;
+int       my_rank;
+
+long Receive_work(MPI_Comm comm);
+void Split_work(long* work_ptr, int split_size, long* splits_ptr, 
+         MPI_Comm comm);
+
+/*********************************************************************/
+int main(int argc, char* argv[]) {
+    int         total_work;
+    int         split_interval;
+    int         split_size;
+    long        work;
+    long        done = 0;
+    long        splits = 0;
+    long        totals[2];
+    long        counts[2];
+    int         complete = FALSE;
+    int         pending;
+    int         error = 0;
+    int         total_error;
+    MPI_Status  status;
+    double      start, finish;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &p);
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+    MPI_Comm_dup(MPI_COMM_WORLD, &io_comm);
+    Cache_io_rank(MPI_COMM_WORLD, io_comm);
+
+    Cscanf(io_comm, "Enter total work, split interval and split size", 
+        "%d %d %d", &total_work, &split_interval, &split_size);
+    if (split_interval < 1) split_interval = 1;
+
+    Setup_term_detect();
+    srand(my_rank + 1);
+    if (my_rank == p-1)
+        work = total_work;
+    else
+        work = 0;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+    while (!complete) {
+        /* Busy */
+        while (work > 0) {
+            work--;
+            done++;
+            if ((p > 1) && (work > 0) && (done % split_interval == 0))
+                Split_work(&work, split_size, &splits, MPI_COMM_WORLD);
+            work += Receive_work(MPI_COMM_WORLD);
+            Term_progress(MPI_COMM_WORLD);
+        }
+
+        /* Idle */
+        Term_idle(MPI_COMM_WORLD);
+        while ((work == 0) && !complete) {
+            work = Receive_work(MPI_COMM_WORLD);
+            if (work == 0)
+                complete = Search_complete(MPI_COMM_WORLD);
+        }
+    }
+    finish = MPI_Wtime();
+
+    /* Nothing should be left */
+    MPI_Barrier(MPI_COMM_WORLD);
+    MPI_Iprobe(MPI_ANY_SOURCE, WORK_TAG, MPI_COMM_WORLD, &pending,
+        &status);
+    if (pending || (work != 0)) {
+        printf("Process %d > Work left after termination!\n", my_rank);
+        error = 1;
+    }
+
+    counts[0] = done;
+    counts[1] = splits;
+    MPI_Reduce(counts, totals, 2, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&error, &total_error, 1, MPI_INT, MPI_MAX, 0,
+        MPI_COMM_WORLD);
+    if (my_rank == 0) {
+        printf("Termination detection = %s\n", Term_detect_name());
+        printf("Work done = %ld, expected = %ld, splits = %ld\n",
+            totals[0], (long) total_work, totals[1]);
+        if ((totals[0] == total_work) && !total_error)
+            printf("Termination detected correctly\n");
+        else
+            printf("Termination detected too early!\n");
+        printf("Elapsed time = %e seconds\n", finish - start);
+    }
+
+    MPI_Finalize();
+    return 0;
+}  /* main */
+
+
+/*********************************************************************/
+/* Send split_size units, or half the remaining work, to a random */
+/*     process.  Assumes *work_ptr > 0                              */
+void Split_work(
+         long*     work_ptr    /* in/out */,
+         int       split_size  /* in     */,
+         long*     splits_ptr  /* in/out */,
+         MPI_Comm  comm        /* in     */) {
+    long  amount;
+    int   dest;
+
+    if (split_size > 0)
+        amount = split_size;
+    else
+        amount = *work_ptr/2;
+    if (amount > *work_ptr) amount = *work_ptr;
+    if (amount == 0) amount = 1;
+    while ((dest = rand() % p) == my_rank);
+
+    Term_work_sent(dest, comm);
+    MPI_Send(&amount, 1, MPI_LONG, dest, WORK_TAG, comm);
+    *work_ptr -= amount;
+    (*splits_ptr)++;
+}  /* Split_work */
+
+
+/*********************************************************************/
+/* Return the amount of work received */
+long Receive_work(
+         MPI_Comm  comm  /* in */) {
+    long        total = 0;
+    long        work;
+    int         msg_pending;
+    MPI_Status  status;
+
+    do {
+        MPI_Iprobe(MPI_ANY_SOURCE, WORK_TAG, comm, &msg_pending,
+            &status);
+        if (msg_pending) {
+            MPI_Recv(&work, 1, MPI_LONG, status.MPI_SOURCE, WORK_TAG,
+                comm, &status);
+            Term_work_recd(status.MPI_SOURCE, comm);
+            total += work;
+        }
+    } while (msg_pending);
+
+    return total;
+}  /* Receive_work */
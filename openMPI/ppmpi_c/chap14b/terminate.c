@@ -1,29 +1,40 @@
 /* terminate.c -- functions for determining whether every process has
  *     exhausted its stack.
  *
- * Here's the basic idea.  At the start of the program, process 0 has
- * one unit of some indestructible quantity -- I called it energy.
- * When the data is distributed, the energy is divided into p
- * equal parts and also distributed among the processes.  So each
- * process has 1/p of the energy.  (I don't actually send the energy
- * out initially, since every process knows it will get 1/p units of
- * energy, each can just set its energy to 1/p).  Whenever
- * a process exhausts its local stack, it sends whatever energy
- * it has to process 0.  Whenever a process satisfies a request
- * for work, it splits its energy in two equal pieces, keeping half
- * for itself and sending half to the process receiving the work.
- * Each process keeps track of its available energy in "my_energy".
- * Process 0, also keeps track of returned energy in "returned_energy."
- * Since energy is never destroyed, the sum of all energy on all the
- * processes will always be 1.  When process 0 finds that
- * "returned_energy" is 1, no process (including itself) will have
- * any work left, and it can broadcast a termination message to all
- * processes.  The only catch here is that floating point
- * arithmetic isn't exact.  So there are functions for
- * rational arithmetic:  a fraction a/b is represented as a pair of
- * longs (a,b).  Dividing by 2 changes (a,b) to (a,2b).  Adding
- * (a,b) + (c,d) = (ad + bc,bd).  This can still cause problems,
- * but there are no security checks.  Future work, no doubt.
+ * There are two algorithms.  The default is credit (or weight throwing).
+ * At the start of the program, process 0 has INITIAL_CREDIT units of
+ * some indestructible quantity -- originally I called it energy.
+ * When the data is distributed, the credit is divided into p nearly
+ * equal parts and also distributed among the processes.  (I don't
+ * actually send the credit out initially, since every process can
+ * compute its share).  Whenever a process exhausts its local stack, it
+ * sends whatever credit it has to process 0.  Whenever a process
+ * satisfies a request for work, it splits its credit in two, keeping
+ * half for itself and sending half to the process receiving the work.
+ * Process 0 keeps track of the credit that hasn't been returned in
+ * "outstanding."  Since credit is never destroyed, when process 0 finds
+ * that "outstanding" is 0, no process (including itself) will have any
+ * work left, and it can broadcast a termination message to all
+ * processes.
+ *
+ * The original version used rational numbers for the energy, and the
+ * denominators could overflow after many splits.  Credit is a 64-bit
+ * integer, so all the arithmetic is exact.  A process that has only one
+ * unit of credit left borrows CREDIT_LOAN units:  process 0 adds the
+ * loan to "outstanding."  The borrowing process uses MPI_Ssend, so
+ * process 0 has recorded the loan before any of it can be returned.
+ *
+ * Compile with -DTERM_SAFRA to use the Dijkstra-Safra token ring
+ * instead.  Each process counts the work messages it has sent minus
+ * those it has received, and turns black when it receives work.
+ * When process 0 is idle, it sends a white token with count 0 to
+ * process p-1.  An idle process adds its count to the token, blackens
+ * it if the process is black, passes it to the next lower rank, and
+ * turns white.  (A busy process just leaves the token in the message
+ * queue.)  When the token gets back to process 0, the search is complete
+ * if the token and process 0 are white, and the total count is 0.
+ * Otherwise process 0 sends another token.  Nothing is sent when work
+ * is split, and process 0 only receives one message per round.
  *
  * See Chap 14, pp. 334 & ff, in PPMPI.
  */
@@ -32,231 +43,288 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "terminate.h"
+#include "trace.h"
 
-MPI_Datatype rational_mpi_t;
 extern int p;
 extern int my_rank;
 
-static DIVISOR_T divs;
-static int prime_list[MAX_PRIMES] = 
-    {2,3,5,7,11,13,17,19,23,29,31,37,41,43,47,53,59,61,67,71,73,79,83,89,97};
-
-static RATIONAL_T ONE = {1,1};
-static RATIONAL_T my_energy; 
-static RATIONAL_T returned_energy = {0,1};  /* significant only on proc 0 */
+static void Send_complete(MPI_Comm comm);
+static int  Complete_received(MPI_Comm comm);
 
+#ifndef TERM_SAFRA
 
+static CREDIT_T my_credit;
+static CREDIT_T outstanding;   /* significant only on proc 0 */
 
-/*********************************************************************/
-void Print_divisors(void) {
-    int i;
-    printf("Process %d > Divisors of %d are ", my_rank, 2*p);
-    for (i = 0; i < Num_divisors(divs); i++)
-        printf("%d ", Divisor(divs,i));
-    printf("\n");
-}  /* Print_divisors */
-
+static void Borrow_credit(MPI_Comm comm);
+static void Receive_returned_credit(MPI_Comm comm);
 
 /*********************************************************************/
 void Setup_term_detect(void) {
+    CREDIT_T share = INITIAL_CREDIT/p;
 
-    Find_divisors(2*p);  /* Use 2*p to force inclusion of 2 in list */
-                         /*     of divisors                         */
-    my_energy.numerator = 1;
-    my_energy.denominator = p;
+    /* Process 0 gets whatever is left over */
+    if (my_rank == 0) {
+        my_credit = INITIAL_CREDIT - (p-1)*share;
+        outstanding = INITIAL_CREDIT;
+    } else {
+        my_credit = share;
+    }
+}  /* Setup_term_detect */
 
-    Build_rational_mpi_t();
 
+/*********************************************************************/
+char* Term_detect_name(void) {
+    return "credit";
+}  /* Term_detect_name */
 
-}  /* Setup_term_detect */
-        
 
 /*********************************************************************/
-void Build_rational_mpi_t(void) {
-    int           count = 2;
-    int           block_lengths[2];
-    MPI_Datatype  types[2];
-    MPI_Aint      displacements[2];
-    MPI_Aint      start;
-    MPI_Aint      address;
+/* Process 0 records loans itself.  Other processes wait until    */
+/*     process 0 has received the loan -- see Term_progress.       */
+static void Borrow_credit(
+                MPI_Comm  comm  /* in */) {
+    CREDIT_T loan = CREDIT_LOAN;
+
+    if (my_rank == 0)
+        outstanding += loan;
+    else
+        MPI_Ssend(&loan, 1, credit_mpi_t, 0, BORROW_TAG, comm);
+    my_credit += loan;
+}  /* Borrow_credit */
 
-    block_lengths[0] = block_lengths[1] = 1;
-    types[0] = types[1] = MPI_LONG;
 
-    MPI_Address(&my_energy, &start);
-    MPI_Address(&(my_energy.numerator), &address);
-    displacements[0] = address - start;
-    MPI_Address(&(my_energy.denominator), &address);
-    displacements[1] = address - start;
+/*********************************************************************/
+/* Must be called before the work is sent */
+void Term_work_sent(
+         int       destination  /* in */,
+         MPI_Comm  comm         /* in */) {
+    CREDIT_T half;
+
+    if (my_credit < 2)
+        Borrow_credit(comm);
+    half = my_credit/2;
+    my_credit -= half;
 
-    MPI_Type_struct(count, block_lengths, displacements, types,
-        &rational_mpi_t);
-    MPI_Type_commit(&rational_mpi_t);
-}  /* Build_rational_mpi_t */
+    MPI_Send(&half, 1, credit_mpi_t, destination, CREDIT_TAG, comm);
+}  /* Term_work_sent */
 
 
 /*********************************************************************/
-void Find_divisors(int x) {
-    int quotient = x;
-    int remainder;
-    int prime_indx = 0;
-    int divisor_indx = 0;
-    int prime;
-
-    while(quotient != 1) {
-        prime = prime_list[prime_indx];
-        remainder = quotient % prime;
-        if (remainder == 0) {
-            Divisor(divs,divisor_indx) = prime;
-            divisor_indx++;
-            do {
-                quotient = quotient/prime;
-                remainder = quotient % prime;
-            } while (remainder == 0);
-        }
-        prime_indx++;
-        if ((quotient != 1) && (prime_indx >= MAX_PRIMES)) {
-            Print_divisors();
-            fprintf(stderr, "x = %d has too many distinct divisors\n", x);
-            fprintf(stderr, "Increase the size of prime_list\n");
-            exit(-1);
-        }
-    }
+void Term_work_recd(
+         int       source  /* in */,
+         MPI_Comm  comm    /* in */) {
+     MPI_Status  status;
+     CREDIT_T    credit;
 
-    Num_divisors(divs) = divisor_indx;
-        
-} /* Find_divisors */
+     /* A process with several outstanding requests may receive */
+     /*     work (and credit) from more than one of them         */
+     MPI_Recv(&credit, 1, credit_mpi_t, source, CREDIT_TAG, comm,
+         &status);
+     my_credit += credit;
+}  /* Term_work_recd */
 
 
 /*********************************************************************/
-void Reduce(RATIONAL_T* y) {
-    int   i;
-    int   divisor;
-
-    for (i = 0; i < Num_divisors(divs); i++) {
-        divisor = Divisor(divs,i);
-        while (((Numerator(y) % divisor) == 0) && 
-               (Denominator(y) % divisor) == 0) {
-            Numerator(y) = Numerator(y)/divisor;
-            Denominator(y) = Denominator(y)/divisor;
-        }           
-    }
-}  /* Reduce */
+void Term_idle(
+         MPI_Comm  comm  /* in */) {
+
+    if (my_credit == 0)
+        return;
+    if (my_rank == 0)
+        outstanding -= my_credit;
+    else
+        MPI_Send(&my_credit, 1, credit_mpi_t, 0, RETURN_CREDIT_TAG, comm);
+    my_credit = 0;
+
+}  /* Term_idle */
 
 
 /*********************************************************************/
-/* Add x = x + y */
-void Add(RATIONAL_T* x, RATIONAL_T* y) {
+static void Receive_returned_credit(
+                MPI_Comm  comm  /* in */) {
+    int         done = FALSE;
+    int         msg_pending;
+    CREDIT_T    credit;
+    MPI_Status  status;
 
-    Numerator(x) = Denominator(y)*Numerator(x) + Denominator(x)*Numerator(y);
-    Denominator(x) = Denominator(x)*Denominator(y);
-    Reduce(x);
-}  /* Add */
+    while (!done) {
+        MPI_Iprobe(MPI_ANY_SOURCE, BORROW_TAG, comm, &msg_pending,
+            &status);
+        if (msg_pending) {
+            MPI_Recv(&credit, 1, credit_mpi_t, status.MPI_SOURCE,
+                BORROW_TAG, comm, &status);
+            outstanding += credit;
+            continue;
+        }
+        MPI_Iprobe(MPI_ANY_SOURCE, RETURN_CREDIT_TAG, comm, &msg_pending,
+            &status);
+        if (msg_pending) {
+            MPI_Recv(&credit, 1, credit_mpi_t, status.MPI_SOURCE,
+                RETURN_CREDIT_TAG, comm, &status);
+            outstanding -= credit;
+        } else {
+            done = TRUE;
+        }
+    }  /* while */
+}  /* Receive_returned_credit */
 
 
 /*********************************************************************/
-void Divide_by_2(
-         RATIONAL_T*  x  /* in/out */) {
+/* Process 0 must receive loans while it's busy, since the borrowing */
+/*     process is blocked until it does                              */
+void Term_progress(
+         MPI_Comm  comm  /* in */) {
 
-    if ((Numerator(x) % 2) == 0)
-        Numerator(x) = Numerator(x)/2;
-    else
-        Denominator(x) = 2*Denominator(x);
-}  /* Divide_by_2 */
+    if (my_rank == 0)
+        Receive_returned_credit(comm);
+}  /* Term_progress */
 
 
 /*********************************************************************/
-int Equal(RATIONAL_T* x, RATIONAL_T* y) {
+int Search_complete(
+        MPI_Comm  comm  /* in */) {
 
-    if ( Numerator(x)*Denominator(y) == 
-             Numerator(y)*Denominator(x) )
-        return TRUE;
-    else
-        return FALSE;
-}  /* Equal */
+    if (my_rank == 0) {
+        Receive_returned_credit(comm);
+        if (outstanding == 0) {
+            Send_complete(comm);
+            return TRUE;
+        } else {
+            return FALSE;
+        }
+    } else {
+        return Complete_received(comm);
+    }
+
+}  /* Search_complete */
+
+#else /* TERM_SAFRA */
 
+static long my_count = 0;      /* work messages sent - received */
+static int  my_color = WHITE;
+static int  token_out = FALSE; /* significant only on proc 0    */
 
 /*********************************************************************/
-void Send_half_energy(
-         int       destination  /* in */,
-         MPI_Comm  comm         /* in */) {
+void Setup_term_detect(void) {
+    my_count = 0;
+    my_color = WHITE;
+    token_out = FALSE;
+}  /* Setup_term_detect */
 
-    Divide_by_2(&my_energy);
 
-    MPI_Send(&my_energy, 1, rational_mpi_t, destination,
-        HALF_ENERGY_TAG, comm);
-}  /* Send_half_energy */
+/*********************************************************************/
+char* Term_detect_name(void) {
+    return "Safra";
+}  /* Term_detect_name */
 
 
 /*********************************************************************/
-void Recv_half_energy(
-         int       source  /* in  */,
-         MPI_Comm  comm    /* out */) {
-     MPI_Status  status;
-     
-     MPI_Recv(&my_energy, 1, rational_mpi_t, source,
-         HALF_ENERGY_TAG, comm, &status);
-}  /* Recv_half_energy */
+void Term_work_sent(
+         int       destination  /* in */,
+         MPI_Comm  comm         /* in */) {
+    my_count++;
+}  /* Term_work_sent */
 
 
 /*********************************************************************/
-void Return_energy(MPI_Comm comm) {
-
-    MPI_Send(&my_energy, 1, rational_mpi_t, 0, RETURN_ENERGY_TAG, comm);
-    
-}  /* Return_energy */
+void Term_work_recd(
+         int       source  /* in */,
+         MPI_Comm  comm    /* in */) {
+    my_count--;
+    my_color = BLACK;
+}  /* Term_work_recd */
 
 
 /*********************************************************************/
-void Receive_returned_energy(
+void Term_idle(
          MPI_Comm  comm  /* in */) {
-    int         done = FALSE;
-    int         source;
-    int         energy_returned;
-    RATIONAL_T  energy;
-    MPI_Status  status;
+}  /* Term_idle */
 
-    while (!done) {
-        MPI_Iprobe(MPI_ANY_SOURCE, RETURN_ENERGY_TAG, comm,
-            &energy_returned, &status);
-        if (energy_returned) {
-            source = status.MPI_SOURCE;
-            MPI_Recv(&energy, 1, rational_mpi_t, source, 
-                RETURN_ENERGY_TAG, comm, &status);
-            Add(&returned_energy, &energy);
-        } else {
-            done = TRUE;
-        }
-    }  /* while */
-}  /* Receive_returned_energy */
+
+/*********************************************************************/
+void Term_progress(
+         MPI_Comm  comm  /* in */) {
+}  /* Term_progress */
 
 
 /*********************************************************************/
+/* Only called by idle processes, so the token can be passed on */
 int Search_complete(
         MPI_Comm  comm  /* in */) {
-    int         dest;
-    int         x = 0;
-    int         completed;
+    long        token[TOKEN_MEMBERS];
+    int         token_arrived;
     MPI_Status  status;
-    
+
     if (my_rank == 0) {
-        Receive_returned_energy(comm);
-        if (Equal(&returned_energy, &ONE)) {
-            for (dest = 1; dest < p; dest++) {
-                MPI_Send(&x, 1, MPI_INT, dest, COMPLETE_TAG, comm);
-            }
+        if (p == 1) {
+            Send_complete(comm);
             return TRUE;
-        } else {
-            return FALSE;
         }
-    } else { /* my_rank != 0 */
-        MPI_Iprobe(0, COMPLETE_TAG, comm, &completed, &status);
-        if (completed) {
-            MPI_Recv( &x, 1, MPI_INT, 0, COMPLETE_TAG, comm, &status);
-            return TRUE;
-        } else {
-            return FALSE;
+        if (token_out) {
+            MPI_Iprobe(1, TOKEN_TAG, comm, &token_arrived, &status);
+            if (!token_arrived)
+                return FALSE;
+            MPI_Recv(token, TOKEN_MEMBERS, MPI_LONG, 1, TOKEN_TAG, comm,
+                &status);
+            token_out = FALSE;
+            if ((Token_color(token) == WHITE) && (my_color == WHITE) &&
+                (Token_count(token) + my_count == 0)) {
+                Send_complete(comm);
+                return TRUE;
+            }
+        }
+        /* Start a new round */
+        Token_count(token) = 0;
+        Token_color(token) = WHITE;
+        my_color = WHITE;
+        MPI_Send(token, TOKEN_MEMBERS, MPI_LONG, p-1, TOKEN_TAG, comm);
+        token_out = TRUE;
+        return FALSE;
+    } else {
+        MPI_Iprobe((my_rank + 1) % p, TOKEN_TAG, comm, &token_arrived,
+            &status);
+        if (token_arrived) {
+            MPI_Recv(token, TOKEN_MEMBERS, MPI_LONG, (my_rank + 1) % p,
+                TOKEN_TAG, comm, &status);
+            Token_count(token) += my_count;
+            if (my_color == BLACK)
+                Token_color(token) = BLACK;
+            MPI_Send(token, TOKEN_MEMBERS, MPI_LONG, my_rank - 1,
+                TOKEN_TAG, comm);
+            my_color = WHITE;
         }
+        return Complete_received(comm);
     }
 
 }  /* Search_complete */
+
+#endif /* TERM_SAFRA */
+
+
+/*********************************************************************/
+static void Send_complete(
+                MPI_Comm  comm  /* in */) {
+    int  dest;
+    int  x = 0;
+
+    for (dest = 1; dest < p; dest++)
+        MPI_Send(&x, 1, MPI_INT, dest, COMPLETE_TAG, comm);
+}  /* Send_complete */
+
+
+/*********************************************************************/
+static int Complete_received(
+               MPI_Comm  comm  /* in */) {
+    int         x;
+    int         completed;
+    MPI_Status  status;
+
+    MPI_Iprobe(0, COMPLETE_TAG, comm, &completed, &status);
+    if (completed) {
+        MPI_Recv(&x, 1, MPI_INT, 0, COMPLETE_TAG, comm, &status);
+        return TRUE;
+    } else {
+        return FALSE;
+    }
+}  /* Complete_received */
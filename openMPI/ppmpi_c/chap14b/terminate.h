@@ -7,44 +7,42 @@
 
 #include "mpi.h"
 
-#define RETURN_ENERGY_TAG 1000
-#define HALF_ENERGY_TAG   2000
+#define RETURN_CREDIT_TAG 1000
+#define CREDIT_TAG        2000
 #define COMPLETE_TAG      3000
+#define BORROW_TAG        4000
+#define TOKEN_TAG         5000
 
-/* Number of primes stored in prime_list */
-/*     Currently number of primes < 100  */
-#define MAX_PRIMES 25
+/* Compile with -DTERM_SAFRA to use the Dijkstra-Safra token ring */
+/*     instead of credit (weight throwing)                        */
+#ifndef TERM_SAFRA
 
-typedef struct {
-    int   num_divisors;
-#define Num_divisors(divs) ((divs).num_divisors)
-    int   divisor_list[MAX_PRIMES];
-#define Divisor_list(divs) ((divs).divisor_list)
-#define Divisor(divs, i)   (*(((divs).divisor_list)+i))
-} DIVISOR_T;
+#include <stdint.h>
 
-typedef struct{
-    long numerator;
-#define Numerator(y) ((y)->numerator)
-    long denominator;
-#define Denominator(y) ((y)->denominator)
-} RATIONAL_T;
+/* Credit is a 64-bit integer:  the total of all credit is  */
+/*     INITIAL_CREDIT plus whatever has been borrowed        */
+typedef uint64_t CREDIT_T;
+#define credit_mpi_t   MPI_UINT64_T
+#define INITIAL_CREDIT (((CREDIT_T) 1) << 62)
+#define CREDIT_LOAN    (((CREDIT_T) 1) << 40)
 
-extern MPI_Datatype rational_mpi_t;
+#else
+
+/* The token carries a message count and a color */
+#define WHITE 0
+#define BLACK 1
+#define TOKEN_MEMBERS 2
+#define Token_count(token) ((token)[0])
+#define Token_color(token) ((token)[1])
+
+#endif
 
-void  Print_divisors(void);
 void  Setup_term_detect(void);
-void  Build_rational_mpi_t(void);
-void  Find_divisors(int x);
-void  Reduce(RATIONAL_T* y);
-void  Add(RATIONAL_T* x, RATIONAL_T* y);
-void  Divide_by_2(RATIONAL_T* x);
-int   Equal(RATIONAL_T* x, RATIONAL_T* y);
-
-void  Return_energy(MPI_Comm comm);
-void  Send_half_energy(int destination, MPI_Comm comm);
-void  Recv_half_energy(int source, MPI_Comm comm);
-void  Receive_returned_energy(MPI_Comm comm);
+char* Term_detect_name(void);
+void  Term_idle(MPI_Comm comm);
+void  Term_work_sent(int destination, MPI_Comm comm);
+void  Term_work_recd(int source, MPI_Comm comm);
+void  Term_progress(MPI_Comm comm);
 int   Search_complete(MPI_Comm comm);
 
 #endif
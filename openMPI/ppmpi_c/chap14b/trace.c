@@ -0,0 +1,693 @@
+/* trace.c -- timeline of the events in parallel tree search, written
+ *     in the Chrome trace format.  Load the file in Perfetto
+ *     (ui.perfetto.dev) or chrome://tracing.  Compile with -DTRACE.
+ *
+ * Each thread records its events in its own ring buffer of
+ *     TRACE_EVENTS events (compile with -DTRACE_EVENTS=<n>), so
+ *     recording takes no locks.  When a buffer is full, the oldest
+ *     events are overwritten.  Trace_begin pushes a time on a
+ *     per-thread stack, and Trace_end records the whole interval as
+ *     a single event, so an overwritten event never leaves half an
+ *     interval behind.  Timestamps come from CLOCK_MONOTONIC.
+ *
+ * The events are the phases of the main loop (see Search in
+ *     par_tree_search.c), the time a process spends idle waiting for
+ *     work, the requests, work and rejects it sends and receives,
+ *     and, in hybrid search, the search and idle time of the other
+ *     threads and the packets they steal.  Two more sources can be
+ *     compiled in:
+ *
+ *     -DTRACE_MPI:  wrappers for the blocking MPI calls the program
+ *         makes.  trace.h renames the calls to Trace_MPI_Send, &c.,
+ *         in the files that include it, and the wrappers call the
+ *         MPI_ functions.  So they don't use MPI's profiling
+ *         interface, and a profiling library, e.g.,
+ *         chap12/mpi_prof.c, can still be linked.  The calls in
+ *         cio.c and stats.c aren't traced.
+ *     -DTRACE_OMPT:  (with -DHYBRID) OpenMP parallel regions and
+ *         implicit tasks, reported by the OMPT tool interface.  Needs
+ *         a runtime that supports OMPT, e.g., LLVM's libomp.
+ *
+ * Clocks on different nodes aren't synchronized.  Trace_init and
+ *     Trace_finalize each estimate the offset of every process's
+ *     clock from process 0's with a ping-pong, keeping the exchange
+ *     with the shortest round trip.  Timestamps are corrected by
+ *     interpolating linearly between the two offsets, which also
+ *     corrects for drift.  Trace_finalize sends the events to
+ *     process 0 one process at a time, and process 0 writes them.
+ *     Times are in microseconds from process 0's call to Trace_init.
+ *
+ * See Chap 14, pp. 328 & ff., in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "mpi.h"
+#define TRACE_WRAPPERS  /* Don't rename the MPI calls in this file */
+#include "trace.h"
+
+#ifdef TRACE
+
+#ifdef HYBRID
+#include <omp.h>
+#endif
+
+#ifndef TRACE_EVENTS
+#define TRACE_EVENTS  65536
+#endif
+#define TRACE_DEPTH   16      /* Maximum nesting of Trace_begin     */
+#define SYNC_PINGS    10      /* Ping-pongs per clock offset        */
+#define SYNC_TAG      32000
+#define EVENT_TAG     32001
+#define EVENT_DOUBLES 5       /* Start, duration, event, arg, thread */
+
+typedef struct {
+    double  start;
+    double  duration;       /* Negative for an instant          */
+    int     event;
+    int     arg;
+} EVENT_T;
+
+typedef struct {
+    EVENT_T*  events;       /* Ring of TRACE_EVENTS events      */
+    long      recorded;     /* Including the ones overwritten   */
+    double    open_start[TRACE_DEPTH];
+    int       open_event[TRACE_DEPTH];
+    int       depth;
+    char      pad[64];      /* Keep other threads' buffers off  */
+                            /*     this cache line              */
+} TRACE_BUF_T;
+
+static struct {
+    char* name;
+    char* category;
+    char* arg_name;
+} event_info[TR_EVENTS] = {
+    {"Par_dfs",            "search", "arg"},
+    {"Service_requests",   "search", "arg"},
+    {"Work_remains",       "search", "arg"},
+    {"idle",               "search", "arg"},
+    {"Thread_dfs",         "thread", "arg"},
+    {"thread idle",        "thread", "arg"},
+    {"request sent",       "work",   "to"},
+    {"work sent",          "work",   "to"},
+    {"work received",      "work",   "from"},
+    {"reject received",    "work",   "from"},
+    {"steal",              "thread", "victim"},
+    {"MPI_Send",           "mpi",    "peer"},
+    {"MPI_Ssend",          "mpi",    "peer"},
+    {"MPI_Recv",           "mpi",    "peer"},
+    {"MPI_Wait",           "mpi",    "arg"},
+    {"MPI_Barrier",        "mpi",    "arg"},
+    {"MPI_Bcast",          "mpi",    "root"},
+    {"MPI_Reduce",         "mpi",    "root"},
+    {"MPI_Allreduce",      "mpi",    "arg"},
+    {"MPI_Fetch_and_op",   "mpi",    "target"},
+    {"MPI_Accumulate",     "mpi",    "target"},
+    {"MPI_Win_flush",      "mpi",    "target"},
+    {"parallel",           "omp",    "arg"},
+    {"implicit task",      "omp",    "arg"}
+};
+
+static TRACE_BUF_T* buffers = (TRACE_BUF_T*) NULL;
+static int          num_buffers = 0;
+static int          trace_on = 0;
+
+/* Clock correction:  process 0's clock is about */
+/*     my clock + offset[i] at my time sync_time[i] */
+static double       sync_time[2];
+static double       offset[2];
+static double       origin;      /* Process 0's time at Trace_init */
+
+static double Now(void);
+static int    Thread(void);
+static void   Begin(int thread, int event);
+static void   End(int thread, int arg);
+static void   Record(int thread, double start, double duration,
+                  int event, int arg);
+static double Clock_offset(MPI_Comm comm);
+static double Corrected(double t);
+static int    Get_events(double** events_ptr, long* dropped_ptr);
+static void   Write_events(FILE* fp, int rank, double* events,
+                  int count, int* first_ptr);
+
+
+/*********************************************************************/
+/* Call after MPI_Init, outside any parallel region.  Returns 0 if   */
+/*     successful, negative otherwise                               */
+int Trace_init(
+        MPI_Comm  comm  /* in */) {
+    int t;
+
+#ifdef HYBRID
+    num_buffers = omp_get_max_threads();
+#else
+    num_buffers = 1;
+#endif
+    buffers = (TRACE_BUF_T*) malloc(num_buffers*sizeof(TRACE_BUF_T));
+    if (buffers == (TRACE_BUF_T*) NULL)
+        return -1;
+    for (t = 0; t < num_buffers; t++) {
+        buffers[t].events =
+            (EVENT_T*) malloc(TRACE_EVENTS*sizeof(EVENT_T));
+        if (buffers[t].events == (EVENT_T*) NULL)
+            return -1;
+        buffers[t].recorded = 0;
+        buffers[t].depth = 0;
+    }
+
+    offset[0] = Clock_offset(comm);
+    sync_time[0] = Now();
+    origin = sync_time[0] + offset[0];
+    PMPI_Bcast(&origin, 1, MPI_DOUBLE, 0, comm);
+    trace_on = 1;
+    return 0;
+}  /* Trace_init */
+
+
+/*********************************************************************/
+/* Collective on comm.  Process 0 writes file_name. */
+void Trace_finalize(
+        char*     file_name  /* in */,
+        MPI_Comm  comm       /* in */) {
+    int         p;
+    int         my_rank;
+    int         q, t;
+    double*     events;
+    int         count;
+    long        dropped;
+    long        total_dropped;
+    FILE*       fp = (FILE*) NULL;
+    int         first = 1;
+    MPI_Status  status;
+
+    trace_on = 0;
+    offset[1] = Clock_offset(comm);
+    sync_time[1] = Now();
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &my_rank);
+
+    count = Get_events(&events, &dropped);
+    PMPI_Reduce(&dropped, &total_dropped, 1, MPI_LONG, MPI_SUM, 0, comm);
+
+    if (my_rank == 0) {
+        fp = fopen(file_name, "w");
+        if (fp == (FILE*) NULL)
+            fprintf(stderr, "Process 0 > Can't open %s\n", file_name);
+        else
+            fprintf(fp, "{\"traceEvents\":[\n");
+    }
+
+    /* Process 0 tells the others when to send, so they */
+    /*     don't all send at once                       */
+    for (q = 0; q < p; q++) {
+        if (my_rank == 0) {
+            if (q > 0) {
+                free(events);
+                PMPI_Send(&q, 1, MPI_INT, q, EVENT_TAG, comm);
+                PMPI_Probe(q, EVENT_TAG, comm, &status);
+                PMPI_Get_count(&status, MPI_DOUBLE, &count);
+                events = (double*) malloc((count + 1)*sizeof(double));
+                PMPI_Recv(events, count, MPI_DOUBLE, q, EVENT_TAG, comm,
+                    &status);
+                count = count/EVENT_DOUBLES;
+            }
+            if (fp != (FILE*) NULL)
+                Write_events(fp, q, events, count, &first);
+        } else if (my_rank == q) {
+            PMPI_Recv(&t, 1, MPI_INT, 0, EVENT_TAG, comm, &status);
+            PMPI_Send(events, EVENT_DOUBLES*count, MPI_DOUBLE, 0,
+                EVENT_TAG, comm);
+        }
+    }
+
+    if (fp != (FILE*) NULL) {
+        fprintf(fp, "\n],\n\"displayTimeUnit\":\"ms\",\n");
+        fprintf(fp, "\"otherData\":{\"dropped_events\":%ld}}\n",
+            total_dropped);
+        fclose(fp);
+        if (total_dropped > 0)
+            fprintf(stderr, "Trace:  %ld events were overwritten.  %s\n",
+                total_dropped, "Recompile with a larger TRACE_EVENTS");
+    }
+
+    free(events);
+    for (t = 0; t < num_buffers; t++)
+        free(buffers[t].events);
+    free(buffers);
+    buffers = (TRACE_BUF_T*) NULL;
+}  /* Trace_finalize */
+
+
+/*********************************************************************/
+void Trace_begin_event(
+         int  event  /* in */) {
+    Begin(Thread(), event);
+}  /* Trace_begin_event */
+
+
+/*********************************************************************/
+/* Ends the most recent interval begun by the calling thread, which */
+/*     should be event                                              */
+void Trace_end_event(
+         int  event  /* in */) {
+    End(Thread(), NO_ARG);
+}  /* Trace_end_event */
+
+
+/*********************************************************************/
+void Trace_instant_event(
+         int  event  /* in */,
+         int  arg    /* in */) {
+    if (trace_on)
+        Record(Thread(), Now(), -1.0, event, arg);
+}  /* Trace_instant_event */
+
+
+/*********************************************************************/
+static double Now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1.0e-9*ts.tv_nsec;
+}  /* Now */
+
+
+/*********************************************************************/
+static int Thread(void) {
+#ifdef HYBRID
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}  /* Thread */
+
+
+/*********************************************************************/
+static void Begin(
+         int  thread  /* in */,
+         int  event   /* in */) {
+    TRACE_BUF_T* buf;
+
+    if (!trace_on || (thread >= num_buffers)) return;
+    buf = &buffers[thread];
+    if (buf->depth < TRACE_DEPTH) {
+        buf->open_event[buf->depth] = event;
+        buf->open_start[buf->depth] = Now();
+    }
+    buf->depth++;
+}  /* Begin */
+
+
+/*********************************************************************/
+static void End(
+         int  thread  /* in */,
+         int  arg     /* in */) {
+    TRACE_BUF_T* buf;
+
+    if (!trace_on || (thread >= num_buffers)) return;
+    buf = &buffers[thread];
+    if (buf->depth == 0) return;
+    buf->depth--;
+    if (buf->depth < TRACE_DEPTH)
+        Record(thread, buf->open_start[buf->depth],
+            Now() - buf->open_start[buf->depth],
+            buf->open_event[buf->depth], arg);
+}  /* End */
+
+
+/*********************************************************************/
+static void Record(
+         int     thread    /* in */,
+         double  start     /* in */,
+         double  duration  /* in */,
+         int     event     /* in */,
+         int     arg       /* in */) {
+    TRACE_BUF_T* buf;
+    EVENT_T*     e;
+
+    if (thread >= num_buffers) return;
+    buf = &buffers[thread];
+    e = &(buf->events[buf->recorded % TRACE_EVENTS]);
+    e->start = start;
+    e->duration = duration;
+    e->event = event;
+    e->arg = arg;
+    buf->recorded++;
+}  /* Record */
+
+
+/*********************************************************************/
+/* Returns process 0's clock minus the calling process's clock.      */
+/*     Process 0 sends its time to each process in turn.  The other  */
+/*     process replies with its time, and process 0 takes its own    */
+/*     time at the middle of the round trip as the time the reply    */
+/*     was sent.  Uses PMPI, so profiling libraries don't see it.   */
+static double Clock_offset(
+         MPI_Comm  comm  /* in */) {
+    int         p;
+    int         my_rank;
+    int         q, i;
+    double      t0, t1, tq;
+    double      rtt, best_rtt;
+    double      q_offset;
+    double      my_offset = 0.0;
+    MPI_Status  status;
+
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &my_rank);
+
+    if (my_rank == 0) {
+        for (q = 1; q < p; q++) {
+            best_rtt = -1.0;
+            q_offset = 0.0;
+            for (i = 0; i < SYNC_PINGS; i++) {
+                t0 = Now();
+                PMPI_Send(&t0, 1, MPI_DOUBLE, q, SYNC_TAG, comm);
+                PMPI_Recv(&tq, 1, MPI_DOUBLE, q, SYNC_TAG, comm, &status);
+                t1 = Now();
+                rtt = t1 - t0;
+                if ((best_rtt < 0.0) || (rtt < best_rtt)) {
+                    best_rtt = rtt;
+                    q_offset = (t0 + t1)/2.0 - tq;
+                }
+            }
+            PMPI_Send(&q_offset, 1, MPI_DOUBLE, q, SYNC_TAG, comm);
+        }
+    } else {
+        for (i = 0; i < SYNC_PINGS; i++) {
+            PMPI_Recv(&t0, 1, MPI_DOUBLE, 0, SYNC_TAG, comm, &status);
+            tq = Now();
+            PMPI_Send(&tq, 1, MPI_DOUBLE, 0, SYNC_TAG, comm);
+        }
+        PMPI_Recv(&my_offset, 1, MPI_DOUBLE, 0, SYNC_TAG, comm, &status);
+    }
+    return my_offset;
+}  /* Clock_offset */
+
+
+/*********************************************************************/
+/* Convert t to process 0's clock */
+static double Corrected(
+         double  t  /* in */) {
+    double slope = 0.0;
+
+    if (sync_time[1] > sync_time[0])
+        slope = (offset[1] - offset[0])/(sync_time[1] - sync_time[0]);
+    return t + offset[0] + slope*(t - sync_time[0]);
+}  /* Corrected */
+
+
+/*********************************************************************/
+/* Copy the events in the buffers, oldest first, into an array of    */
+/*     EVENT_DOUBLES doubles per event, with times in microseconds   */
+/*     on process 0's clock.  Returns the number of events.          */
+static int Get_events(
+         double**  events_ptr   /* out */,
+         long*     dropped_ptr  /* out */) {
+    double*      events;
+    TRACE_BUF_T* buf;
+    EVENT_T*     e;
+    long         first, i;
+    int          count = 0;
+    int          t;
+    double       start;
+
+    *dropped_ptr = 0;
+    for (t = 0; t < num_buffers; t++) {
+        if (buffers[t].recorded > TRACE_EVENTS) {
+            count += TRACE_EVENTS;
+            *dropped_ptr += buffers[t].recorded - TRACE_EVENTS;
+        } else {
+            count += buffers[t].recorded;
+        }
+    }
+
+    events = (double*) malloc((EVENT_DOUBLES*count + 1)*sizeof(double));
+    count = 0;
+    for (t = 0; t < num_buffers; t++) {
+        buf = &buffers[t];
+        first = (buf->recorded > TRACE_EVENTS) ?
+            buf->recorded - TRACE_EVENTS : 0;
+        for (i = first; i < buf->recorded; i++) {
+            e = &(buf->events[i % TRACE_EVENTS]);
+            start = Corrected(e->start);
+            events[EVENT_DOUBLES*count] = 1.0e6*(start - origin);
+            events[EVENT_DOUBLES*count+1] = (e->duration < 0.0) ? -1.0 :
+                1.0e6*(Corrected(e->start + e->duration) - start);
+            events[EVENT_DOUBLES*count+2] = e->event;
+            events[EVENT_DOUBLES*count+3] = e->arg;
+            events[EVENT_DOUBLES*count+4] = t;
+            count++;
+        }
+    }
+
+    *events_ptr = events;
+    return count;
+}  /* Get_events */
+
+
+/*********************************************************************/
+/* Process rank is pid rank, and thread t is tid t */
+static void Write_events(
+         FILE*    fp         /* in     */,
+         int      rank       /* in     */,
+         double*  events     /* in     */,
+         int      count      /* in     */,
+         int*     first_ptr  /* in/out */) {
+    int     i;
+    int     tid;
+    int     max_tid = 0;
+    int     event;
+    int     arg;
+    double* e;
+
+    for (i = 0; i < count; i++)
+        if (events[EVENT_DOUBLES*i+4] > max_tid)
+            max_tid = (int) events[EVENT_DOUBLES*i+4];
+
+    fprintf(fp, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+        "\"args\":{\"name\":\"Process %d\"}}", *first_ptr ? "" : ",\n",
+        rank, rank);
+    *first_ptr = 0;
+    for (tid = 0; tid <= max_tid; tid++)
+        fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,"
+            "\"tid\":%d,\"args\":{\"name\":\"Thread %d\"}}", rank, tid, tid);
+
+    for (i = 0; i < count; i++) {
+        e = events + EVENT_DOUBLES*i;
+        event = (int) e[2];
+        arg = (int) e[3];
+        fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"pid\":%d,"
+            "\"tid\":%d,\"ts\":%.3f,", event_info[event].name,
+            event_info[event].category, rank, (int) e[4], e[0]);
+        if (e[1] < 0.0)
+            fprintf(fp, "\"ph\":\"i\",\"s\":\"t\"");
+        else
+            fprintf(fp, "\"ph\":\"X\",\"dur\":%.3f", e[1]);
+        if (arg != NO_ARG)
+            fprintf(fp, ",\"args\":{\"%s\":%d}", event_info[event].arg_name,
+                arg);
+        fprintf(fp, "}");
+    }
+}  /* Write_events */
+
+
+#ifdef TRACE_MPI
+/*********************************************************************/
+/* Wrappers for the blocking MPI calls.  Only thread 0 calls MPI.    */
+/*     The calls inside them are the real MPI_ functions:  see       */
+/*     trace.h.                                                      */
+/*********************************************************************/
+int Trace_MPI_Send(const void* buf, int count, MPI_Datatype datatype,
+        int dest, int tag, MPI_Comm comm) {
+    int rv;
+
+    Begin(Thread(), TR_MPI_SEND);
+    rv = MPI_Send(buf, count, datatype, dest, tag, comm);
+    End(Thread(), dest);
+    return rv;
+}  /* Trace_MPI_Send */
+
+
+int Trace_MPI_Ssend(const void* buf, int count, MPI_Datatype datatype,
+        int dest, int tag, MPI_Comm comm) {
+    int rv;
+
+    Begin(Thread(), TR_MPI_SSEND);
+    rv = MPI_Ssend(buf, count, datatype, dest, tag, comm);
+    End(Thread(), dest);
+    return rv;
+}  /* Trace_MPI_Ssend */
+
+
+int Trace_MPI_Recv(void* buf, int count, MPI_Datatype datatype, int source,
+        int tag, MPI_Comm comm, MPI_Status* status) {
+    MPI_Status my_status;
+    int        rv;
+
+    if (status == MPI_STATUS_IGNORE) status = &my_status;
+    Begin(Thread(), TR_MPI_RECV);
+    rv = MPI_Recv(buf, count, datatype, source, tag, comm, status);
+    End(Thread(), status->MPI_SOURCE);
+    return rv;
+}  /* Trace_MPI_Recv */
+
+
+int Trace_MPI_Wait(MPI_Request* request, MPI_Status* status) {
+    int rv;
+
+    Begin(Thread(), TR_MPI_WAIT);
+    rv = MPI_Wait(request, status);
+    End(Thread(), NO_ARG);
+    return rv;
+}  /* Trace_MPI_Wait */
+
+
+int Trace_MPI_Barrier(MPI_Comm comm) {
+    int rv;
+
+    Begin(Thread(), TR_MPI_BARRIER);
+    rv = MPI_Barrier(comm);
+    End(Thread(), NO_ARG);
+    return rv;
+}  /* Trace_MPI_Barrier */
+
+
+int Trace_MPI_Bcast(void* buffer, int count, MPI_Datatype datatype, int root,
+        MPI_Comm comm) {
+    int rv;
+
+    Begin(Thread(), TR_MPI_BCAST);
+    rv = MPI_Bcast(buffer, count, datatype, root, comm);
+    End(Thread(), root);
+    return rv;
+}  /* Trace_MPI_Bcast */
+
+
+int Trace_MPI_Reduce(const void* sendbuf, void* recvbuf, int count,
+        MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm) {
+    int rv;
+
+    Begin(Thread(), TR_MPI_REDUCE);
+    rv = MPI_Reduce(sendbuf, recvbuf, count, datatype, op, root, comm);
+    End(Thread(), root);
+    return rv;
+}  /* Trace_MPI_Reduce */
+
+
+int Trace_MPI_Allreduce(const void* sendbuf, void* recvbuf, int count,
+        MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+    int rv;
+
+    Begin(Thread(), TR_MPI_ALLREDUCE);
+    rv = MPI_Allreduce(sendbuf, recvbuf, count, datatype, op, comm);
+    End(Thread(), NO_ARG);
+    return rv;
+}  /* Trace_MPI_Allreduce */
+
+
+int Trace_MPI_Fetch_and_op(const void* origin_addr, void* result_addr,
+        MPI_Datatype datatype, int target_rank, MPI_Aint target_disp,
+        MPI_Op op, MPI_Win win) {
+    int rv;
+
+    Begin(Thread(), TR_MPI_FETCH_AND_OP);
+    rv = MPI_Fetch_and_op(origin_addr, result_addr, datatype,
+        target_rank, target_disp, op, win);
+    End(Thread(), target_rank);
+    return rv;
+}  /* Trace_MPI_Fetch_and_op */
+
+
+int Trace_MPI_Accumulate(const void* origin_addr, int origin_count,
+        MPI_Datatype origin_datatype, int target_rank, MPI_Aint target_disp,
+        int target_count, MPI_Datatype target_datatype, MPI_Op op,
+        MPI_Win win) {
+    int rv;
+
+    Begin(Thread(), TR_MPI_ACCUMULATE);
+    rv = MPI_Accumulate(origin_addr, origin_count, origin_datatype,
+        target_rank, target_disp, target_count, target_datatype, op, win);
+    End(Thread(), target_rank);
+    return rv;
+}  /* Trace_MPI_Accumulate */
+
+
+int Trace_MPI_Win_flush(int rank, MPI_Win win) {
+    int rv;
+
+    Begin(Thread(), TR_MPI_WIN_FLUSH);
+    rv = MPI_Win_flush(rank, win);
+    End(Thread(), rank);
+    return rv;
+}  /* Trace_MPI_Win_flush */
+#endif  /* TRACE_MPI */
+
+
+#if defined(TRACE_OMPT) && defined(HYBRID)
+/*********************************************************************/
+/* OMPT callbacks.  The runtime calls ompt_start_tool when it starts */
+/*     up, which may be before Trace_init:  Begin and End ignore     */
+/*     events until then.                                            */
+/*********************************************************************/
+#include <omp-tools.h>
+
+static void On_parallel_begin(ompt_data_t* encountering_task_data,
+        const ompt_frame_t* encountering_task_frame,
+        ompt_data_t* parallel_data, unsigned int requested_parallelism,
+        int flags, const void* codeptr_ra) {
+    Begin(Thread(), TR_OMP_PARALLEL);
+}  /* On_parallel_begin */
+
+
+static void On_parallel_end(ompt_data_t* parallel_data,
+        ompt_data_t* encountering_task_data, int flags,
+        const void* codeptr_ra) {
+    End(Thread(), NO_ARG);
+}  /* On_parallel_end */
+
+
+/* index is the thread's number in the team */
+static void On_implicit_task(ompt_scope_endpoint_t endpoint,
+        ompt_data_t* parallel_data, ompt_data_t* task_data,
+        unsigned int actual_parallelism, unsigned int index, int flags) {
+
+    if (flags & ompt_task_initial) return;
+    if (endpoint == ompt_scope_begin)
+        Begin((int) index, TR_OMP_IMPLICIT);
+    else
+        End((int) index, NO_ARG);
+}  /* On_implicit_task */
+
+
+static int Ompt_initialize(ompt_function_lookup_t lookup,
+        int initial_device_num, ompt_data_t* tool_data) {
+    ompt_set_callback_t set_callback;
+
+    set_callback = (ompt_set_callback_t) lookup("ompt_set_callback");
+    if (set_callback == NULL) return 0;
+    set_callback(ompt_callback_parallel_begin,
+        (ompt_callback_t) On_parallel_begin);
+    set_callback(ompt_callback_parallel_end,
+        (ompt_callback_t) On_parallel_end);
+    set_callback(ompt_callback_implicit_task,
+        (ompt_callback_t) On_implicit_task);
+    return 1;
+}  /* Ompt_initialize */
+
+
+static void Ompt_finalize(ompt_data_t* tool_data) {
+}  /* Ompt_finalize */
+
+
+ompt_start_tool_result_t* ompt_start_tool(unsigned int omp_version,
+        const char* runtime_version) {
+    static ompt_start_tool_result_t result =
+        {Ompt_initialize, Ompt_finalize, {0}};
+
+    return &result;
+}  /* ompt_start_tool */
+#endif  /* TRACE_OMPT && HYBRID */
+
+#endif  /* TRACE */
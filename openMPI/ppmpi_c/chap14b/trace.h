@@ -0,0 +1,102 @@
+/* trace.h -- definitions and declarations for trace.c
+ *
+ * If the program isn't compiled with -DTRACE, the macros are empty,
+ *     so the calls can be left in the source.
+ */
+#ifndef TRACE_H
+#define TRACE_H
+#include "mpi.h"
+
+/* Events */
+#define TR_PAR_DFS           0   /* Phases of the main loop         */
+#define TR_SVC_REQ           1
+#define TR_WORK_REM          2
+#define TR_IDLE              3   /* Waiting for work from another   */
+                                 /*     process                     */
+#define TR_THREAD_DFS        4   /* Hybrid search, other threads    */
+#define TR_THREAD_IDLE       5
+#define TR_REQ_SENT          6   /* Instants:  the arg is the peer  */
+#define TR_WORK_SENT         7
+#define TR_WORK_RECD         8
+#define TR_REJECT_RECD       9
+#define TR_STEAL            10   /* The arg is the victim thread    */
+#define TR_MPI_SEND         11   /* MPI calls, with -DTRACE_MPI     */
+#define TR_MPI_SSEND        12
+#define TR_MPI_RECV         13
+#define TR_MPI_WAIT         14
+#define TR_MPI_BARRIER      15
+#define TR_MPI_BCAST        16
+#define TR_MPI_REDUCE       17
+#define TR_MPI_ALLREDUCE    18
+#define TR_MPI_FETCH_AND_OP 19
+#define TR_MPI_ACCUMULATE   20
+#define TR_MPI_WIN_FLUSH    21
+#define TR_OMP_PARALLEL     22   /* OpenMP, with -DTRACE_OMPT       */
+#define TR_OMP_IMPLICIT     23
+#define TR_EVENTS           24
+
+#define NO_ARG              -1
+
+#ifndef TRACE_FILE
+#define TRACE_FILE "tree_trace.json"
+#endif
+
+#ifdef TRACE
+#define Trace_begin(event)        {Trace_begin_event(event);}
+#define Trace_end(event)          {Trace_end_event(event);}
+#define Trace_instant(event, arg) {Trace_instant_event(event, arg);}
+#else
+#define Trace_begin(event)
+#define Trace_end(event)
+#define Trace_instant(event, arg)
+#endif
+
+int  Trace_init(MPI_Comm comm);
+void Trace_finalize(char* file_name, MPI_Comm comm);
+void Trace_begin_event(int event);
+void Trace_end_event(int event);
+void Trace_instant_event(int event, int arg);
+
+/* With -DTRACE_MPI, the blocking MPI calls in the files that include */
+/*     this header go through the wrappers in trace.c.  The wrappers  */
+/*     aren't MPI_ functions, so they don't clash with a profiling    */
+/*     library.                                                       */
+#if defined(TRACE) && defined(TRACE_MPI)
+int Trace_MPI_Send(const void* buf, int count, MPI_Datatype datatype,
+        int dest, int tag, MPI_Comm comm);
+int Trace_MPI_Ssend(const void* buf, int count, MPI_Datatype datatype,
+        int dest, int tag, MPI_Comm comm);
+int Trace_MPI_Recv(void* buf, int count, MPI_Datatype datatype,
+        int source, int tag, MPI_Comm comm, MPI_Status* status);
+int Trace_MPI_Wait(MPI_Request* request, MPI_Status* status);
+int Trace_MPI_Barrier(MPI_Comm comm);
+int Trace_MPI_Bcast(void* buffer, int count, MPI_Datatype datatype,
+        int root, MPI_Comm comm);
+int Trace_MPI_Reduce(const void* sendbuf, void* recvbuf, int count,
+        MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm);
+int Trace_MPI_Allreduce(const void* sendbuf, void* recvbuf, int count,
+        MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
+int Trace_MPI_Fetch_and_op(const void* origin_addr, void* result_addr,
+        MPI_Datatype datatype, int target_rank, MPI_Aint target_disp,
+        MPI_Op op, MPI_Win win);
+int Trace_MPI_Accumulate(const void* origin_addr, int origin_count,
+        MPI_Datatype origin_datatype, int target_rank,
+        MPI_Aint target_disp, int target_count,
+        MPI_Datatype target_datatype, MPI_Op op, MPI_Win win);
+int Trace_MPI_Win_flush(int rank, MPI_Win win);
+
+#ifndef TRACE_WRAPPERS
+#define MPI_Send          Trace_MPI_Send
+#define MPI_Ssend         Trace_MPI_Ssend
+#define MPI_Recv          Trace_MPI_Recv
+#define MPI_Wait          Trace_MPI_Wait
+#define MPI_Barrier       Trace_MPI_Barrier
+#define MPI_Bcast         Trace_MPI_Bcast
+#define MPI_Reduce        Trace_MPI_Reduce
+#define MPI_Allreduce     Trace_MPI_Allreduce
+#define MPI_Fetch_and_op  Trace_MPI_Fetch_and_op
+#define MPI_Accumulate    Trace_MPI_Accumulate
+#define MPI_Win_flush     Trace_MPI_Win_flush
+#endif
+#endif
+#endif
@@ -0,0 +1,320 @@
+/* victim.c -- functions for choosing the process to which a request
+ *     for work is sent -- for use in parallel tree search.
+ *
+ * The policy is chosen when Setup_victim_select is called.  Each
+ *     policy supplies two functions:  "next" returns the rank of
+ *     the next victim, and "reply" is told whether the victim
+ *     answered with work or with a reject.  The policies are
+ *
+ *     RANDOM:  rand() % p.  This is the original policy.
+ *     ROUND_ROBIN:  each process keeps its own counter, starting
+ *         at my_rank + 1.
+ *     GLOBAL_RR:  a single counter on process 0 is incremented with
+ *         MPI_Fetch_and_op, so successive requests from all processes
+ *         are spread over all processes.
+ *     NODE_RANDOM:  random process on the caller's (shared-memory)
+ *         node until node_size - 1 successive requests to the node
+ *         have been rejected.  Then one request goes to a random
+ *         process on another node.
+ *     HIERARCHICAL:  sweep through the processes on the caller's node
+ *         in order.  After a full sweep has been rejected, send one
+ *         request to a random process on the next node.
+ *
+ * Nodes are found with MPI_Comm_split_type.  Compile with
+ *     -DEMULATE_NODE_SIZE=<k> to treat each group of k consecutive
+ *     ranks as a node -- useful for testing on a single machine.
+ *
+ * See Chap 14, pp. 332 & ff, in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+#include "node_stack.h"
+#include "victim.h"
+#include "trace.h"
+
+extern int my_rank;
+extern int p;
+
+static int  Random_next(void);
+static int  Round_robin_next(void);
+static int  Global_rr_next(void);
+static int  Node_random_next(void);
+static int  Hierarchical_next(void);
+static void No_reply(int victim, int work_received);
+static void Node_reply(int victim, int work_received);
+static int  Find_nodes(MPI_Comm comm);
+static int  Random_on_node(void);
+static int  Random_off_node(void);
+
+static VICTIM_POLICY_T policy_table[NUM_POLICIES] = {
+    {"random",        Random_next,       No_reply},
+    {"round robin",   Round_robin_next,  No_reply},
+    {"global rr",     Global_rr_next,    No_reply},
+    {"node random",   Node_random_next,  Node_reply},
+    {"hierarchical",  Hierarchical_next, Node_reply}
+};
+static VICTIM_POLICY_T* policy = &policy_table[RANDOM_POLICY];
+
+/* Node structure:  the processes on node n are                  */
+/*     node_ranks[node_start[n]], ..., node_ranks[node_start[n+1]-1] */
+static int   num_nodes;
+static int   my_node;
+static int   my_node_size;
+static int*  node_of = (int*) NULL;
+static int*  node_start = (int*) NULL;
+static int*  node_ranks = (int*) NULL;
+
+static int   rr_next;          /* ROUND_ROBIN                       */
+static int   local_rejects;    /* NODE_RANDOM and HIERARCHICAL      */
+static int   sweep;            /* HIERARCHICAL:  index in my node   */
+static int   remote_node;      /* HIERARCHICAL:  last remote node   */
+
+static MPI_Win    counter_win = MPI_WIN_NULL;   /* GLOBAL_RR */
+static unsigned*  counter;
+
+
+/*********************************************************************/
+/* Return 0 if successful, negative otherwise.  Must be called by   */
+/*     every process in comm                                         */
+int Setup_victim_select(
+        int       which  /* in */,
+        MPI_Comm  comm   /* in */) {
+    int i;
+
+    if ((which < 0) || (which >= NUM_POLICIES))
+        which = RANDOM_POLICY;
+    policy = &policy_table[which];
+
+    srand(my_rank);
+    if (Find_nodes(comm) < 0)
+        return -1;
+
+    rr_next = (my_rank + 1) % p;
+    local_rejects = 0;
+    remote_node = my_node;
+    for (i = 0; i < my_node_size; i++)
+        if (node_ranks[node_start[my_node] + i] == my_rank)
+            sweep = (i + 1) % my_node_size;
+
+    if (which == GLOBAL_RR_POLICY) {
+        MPI_Win_allocate((my_rank == 0 ? sizeof(unsigned) : 0),
+            sizeof(unsigned), MPI_INFO_NULL, comm, &counter,
+            &counter_win);
+        if (my_rank == 0) *counter = 0;
+        MPI_Win_lock_all(0, counter_win);
+        MPI_Barrier(comm);
+    }
+
+    return 0;
+}  /* Setup_victim_select */
+
+
+/*********************************************************************/
+void Free_victim_select(void) {
+
+    if (counter_win != MPI_WIN_NULL) {
+        MPI_Win_unlock_all(counter_win);
+        MPI_Win_free(&counter_win);
+    }
+    free(node_of);
+    free(node_start);
+    free(node_ranks);
+}  /* Free_victim_select */
+
+
+/*********************************************************************/
+int Next_victim(void) {
+    return (*policy->next)();
+}  /* Next_victim */
+
+
+/*********************************************************************/
+void Victim_reply(
+         int  victim         /* in */,
+         int  work_received  /* in */) {
+    (*policy->reply)(victim, work_received);
+}  /* Victim_reply */
+
+
+/*********************************************************************/
+int On_my_node(
+        int  rank  /* in */) {
+    return (node_of[rank] == my_node);
+}  /* On_my_node */
+
+
+/*********************************************************************/
+char* Victim_policy_name(void) {
+    return policy->name;
+}  /* Victim_policy_name */
+
+
+/*********************************************************************/
+/* Build node_of, node_start and node_ranks.  Nodes are numbered in */
+/*     order of their lowest rank.                                   */
+static int Find_nodes(
+               MPI_Comm  comm  /* in */) {
+    MPI_Comm  node_comm;
+    int       leader;
+    int*      leaders;
+    int       q, n;
+
+#ifdef EMULATE_NODE_SIZE
+    MPI_Comm_split(comm, my_rank/EMULATE_NODE_SIZE, my_rank, &node_comm);
+#else
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, my_rank,
+        MPI_INFO_NULL, &node_comm);
+#endif
+    /* The leader of each node is its lowest rank in comm */
+    leader = my_rank;
+    MPI_Bcast(&leader, 1, MPI_INT, 0, node_comm);
+    MPI_Comm_free(&node_comm);
+
+    leaders    = (int*) malloc(p*sizeof(int));
+    node_of    = (int*) malloc(p*sizeof(int));
+    node_start = (int*) malloc((p+1)*sizeof(int));
+    node_ranks = (int*) malloc(p*sizeof(int));
+    if ((leaders == (int*) NULL) || (node_of == (int*) NULL) ||
+        (node_start == (int*) NULL) || (node_ranks == (int*) NULL))
+        return -1;
+
+    MPI_Allgather(&leader, 1, MPI_INT, leaders, 1, MPI_INT, comm);
+
+    /* A leader precedes every other process on its node */
+    num_nodes = 0;
+    for (q = 0; q < p; q++)
+        if (leaders[q] == q)
+            node_of[q] = num_nodes++;
+        else
+            node_of[q] = node_of[leaders[q]];
+
+    /* Counting sort of the ranks by node */
+    for (n = 0; n <= num_nodes; n++)
+        node_start[n] = 0;
+    for (q = 0; q < p; q++)
+        node_start[node_of[q]+1]++;
+    for (n = 1; n <= num_nodes; n++)
+        node_start[n] += node_start[n-1];
+    for (n = 0; n < num_nodes; n++)   /* reuse leaders as a cursor */
+        leaders[n] = node_start[n];
+    for (q = 0; q < p; q++)
+        node_ranks[leaders[node_of[q]]++] = q;
+
+    my_node = node_of[my_rank];
+    my_node_size = node_start[my_node+1] - node_start[my_node];
+
+    free(leaders);
+    return 0;
+}  /* Find_nodes */
+
+
+/*********************************************************************/
+/* Assumes my_node_size > 1 */
+static int Random_on_node(void) {
+    int rank;
+
+    do {
+        rank = node_ranks[node_start[my_node] + rand() % my_node_size];
+    } while (rank == my_rank);
+    return rank;
+}  /* Random_on_node */
+
+
+/*********************************************************************/
+/* Assumes num_nodes > 1 */
+static int Random_off_node(void) {
+    int rank;
+
+    while (node_of[rank = rand() % p] == my_node);
+    return rank;
+}  /* Random_off_node */
+
+
+/*********************************************************************/
+static int Random_next(void) {
+    int rank;
+
+    while ( (rank = rand() % p) == my_rank);
+    return rank;
+}  /* Random_next */
+
+
+/*********************************************************************/
+static int Round_robin_next(void) {
+    int rank = rr_next;
+
+    rr_next = (rr_next + 1) % p;
+    if (rr_next == my_rank)
+        rr_next = (rr_next + 1) % p;
+    return rank;
+}  /* Round_robin_next */
+
+
+/*********************************************************************/
+static int Global_rr_next(void) {
+    unsigned one = 1;
+    unsigned value;
+
+    do {
+        MPI_Fetch_and_op(&one, &value, MPI_UNSIGNED, 0, 0, MPI_SUM,
+            counter_win);
+        MPI_Win_flush(0, counter_win);
+    } while ((int) (value % p) == my_rank);
+    return (int) (value % p);
+}  /* Global_rr_next */
+
+
+/*********************************************************************/
+static int Node_random_next(void) {
+
+    if ((my_node_size > 1) &&
+        ((num_nodes == 1) || (local_rejects < my_node_size - 1)))
+        return Random_on_node();
+    else
+        return Random_off_node();
+}  /* Node_random_next */
+
+
+/*********************************************************************/
+static int Hierarchical_next(void) {
+    int rank;
+    int size;
+
+    if ((my_node_size > 1) &&
+        ((num_nodes == 1) || (local_rejects < my_node_size - 1))) {
+        do {
+            rank = node_ranks[node_start[my_node] + sweep];
+            sweep = (sweep + 1) % my_node_size;
+        } while (rank == my_rank);
+        return rank;
+    }
+
+    /* Every process on this node has rejected:  try the next node */
+    do {
+        remote_node = (remote_node + 1) % num_nodes;
+    } while (remote_node == my_node);
+    size = node_start[remote_node+1] - node_start[remote_node];
+    return node_ranks[node_start[remote_node] + rand() % size];
+}  /* Hierarchical_next */
+
+
+/*********************************************************************/
+static void No_reply(
+                int  victim         /* in */,
+                int  work_received  /* in */) {
+}  /* No_reply */
+
+
+/*********************************************************************/
+/* Count successive rejects from this node.  A reject from another */
+/*     node sends the next requests back to this node.              */
+static void Node_reply(
+                int  victim         /* in */,
+                int  work_received  /* in */) {
+
+    if (!work_received && On_my_node(victim))
+        local_rejects++;
+    else
+        local_rejects = 0;
+}  /* Node_reply */
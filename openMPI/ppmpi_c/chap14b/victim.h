@@ -0,0 +1,38 @@
+/* victim.h
+ *
+ * Definitions and declarations for choosing the process to which a
+ *     request for work is sent.
+ */
+#ifndef VICTIM_H
+#define VICTIM_H
+
+#include "mpi.h"
+
+/* Victim selection policies */
+#define RANDOM_POLICY        0  /* rand() % p                            */
+#define ROUND_ROBIN_POLICY   1  /* local counter, starts at my_rank+1    */
+#define GLOBAL_RR_POLICY     2  /* counter shared by all processes       */
+#define NODE_RANDOM_POLICY   3  /* random on-node, then random off-node  */
+#define HIERARCHICAL_POLICY  4  /* sweep on-node, then next remote node  */
+#define NUM_POLICIES         5
+
+/* Compile with -DVICTIM_POLICY=<n> to change the default */
+#ifndef VICTIM_POLICY
+#define VICTIM_POLICY RANDOM_POLICY
+#endif
+
+typedef struct {
+    char*  name;
+    int    (*next)(void);             /* rank of next victim       */
+    void   (*reply)(int victim,       /* called for every reply    */
+               int work_received);
+} VICTIM_POLICY_T;
+
+int    Setup_victim_select(int policy, MPI_Comm comm);
+void   Free_victim_select(void);
+int    Next_victim(void);
+void   Victim_reply(int victim, int work_received);
+int    On_my_node(int rank);
+char*  Victim_policy_name(void);
+
+#endif
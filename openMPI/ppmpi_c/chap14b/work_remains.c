@@ -2,20 +2,32 @@
  *     search program.  Checks whether local stack is empty.  If not,
  *     returns TRUE.  If it is, executes the following algorithm.
  *
- *         Send "energy" to process 0 (see terminate.c, below).
+ *         Tell the termination detector we're idle (see terminate.c).
  *         while(TRUE) {
  *             Send reject messages to all processes requesting work.
  *             if (the search is complete) {
  *                 Cancel outstanding work requests.
  *                 return FALSE.
- *             } else if (there's no outstanding request) {
- *                 Generate a process rank to which to send a request.
+ *             }
+ *             while (fewer than max_outstanding requests are pending) {
+ *                 Choose a process to which to send a request.
  *                 Send a request for work.
- *             } else if (a reply has been received) {
- *                 if (work has been received) return TRUE.
  *             }
+ *             Check for replies to outstanding requests.
+ *             if (work has been received) return TRUE.
  *         }
  *
+ * Up to MAX_OUTSTANDING requests (compile with -DMAX_OUTSTANDING=<n>)
+ *     may be pending at once.  Replies that arrive after work has
+ *     been received are picked up on the next call to Work_remains:
+ *     rejects are discarded and work is pushed onto the local stack.
+ *     The victims are chosen by the functions in victim.c.
+ *     In hybrid search (-DHYBRID), requests are only sent when every
+ *     thread on the process is out of work -- see hybrid.c.
+ *     If the program is compiled with -DCHECKPOINT, idle processes
+ *     take part in saving the stacks -- see Checkpoint_search in
+ *     solution.c.
+ *
  * See Chap 14, pp. 332 & ff, in PPMPI.
  */
 #include <stdlib.h>
@@ -24,6 +36,14 @@
 #include "terminate.h"
 #include "service_requests.h"
 #include "queue.h"
+#include "victim.h"
+#include "trace.h"
+#ifdef CHECKPOINT
+#include "solution.h"
+#endif
+#ifdef HYBRID
+#include "hybrid.h"
+#endif
 #ifdef STATS
 #include "stats.h"
 #endif
@@ -31,30 +51,74 @@
 extern int my_rank;
 extern int p;
 
-MPI_Request posted_recv;
+/* One entry for each request that hasn't been answered */
+typedef struct {
+    int          rank;
+    MPI_Request  posted_recv;
+    int*         buffer;
+} OUTSTANDING_T;
+
+static OUTSTANDING_T  outstanding[MAX_OUTSTANDING];
+static int            num_outstanding = 0;
+static int*           reply_buffers = (int*) NULL;
+static int            reply_buffer_size;
+
+int Reply_received(OUTSTANDING_T* req, int* work_available,
+        STACK_T local_stack, MPI_Comm comm);
+
+/*********************************************************************/
+/* Allocate a receive buffer for each possible outstanding request.
+ *     A victim never sends more than reply_buffer_size ints.
+ *     Return 0 if successful, negative otherwise 
+ */
+int Allocate_reply_buffers(
+        STACK_T  local_stack  /* in */) {
+    int i;
+
+    reply_buffer_size = Max_size(local_stack);
+    reply_buffers = (int*) malloc(MAX_OUTSTANDING*reply_buffer_size*
+        sizeof(int));
+    if (reply_buffers == (int*) NULL)
+        return -1;
+
+    for (i = 0; i < MAX_OUTSTANDING; i++)
+        outstanding[i].buffer = reply_buffers + i*reply_buffer_size;
+    return 0;
+}  /* Allocate_reply_buffers */
+
+
+/*********************************************************************/
+void Free_reply_buffers(void) {
+    free(reply_buffers);
+}  /* Free_reply_buffers */
+
 
 /*********************************************************************/
 int Work_remains(
         STACK_T    local_stack  /* in/out */,
         MPI_Comm   comm         /* in     */ ) {
 
-    int      work_available;
     int      work_request_process;
-    int      request_sent;
+    int      max_outstanding;
 
 #ifdef STATS
     Start_time(work_rem_time);
 #endif 
+    Trace_begin(TR_WORK_REM);
    
 #ifdef DEBUG
     printf("Process %d > In Work_remains \n", my_rank);
     fflush(stdout);
 #endif
 
+    /* Pick up replies that arrived since the last call */
+    Replies_received(local_stack, comm);
+
     if (!Empty(local_stack)) {
 #ifdef STATS
         Finish_time(work_rem_time);
 #endif 
+        Trace_end(TR_WORK_REM);
 
 #ifdef DEBUG
         printf("Process %d > In Work_remains, stack not empty\n", my_rank);
@@ -62,15 +126,30 @@ int Work_remains(
 #endif
         return TRUE;
     } else {
-        Return_energy(comm);
+#ifdef HYBRID
+        /* Only look for work on other processes when no thread */
+        /*     has any                                          */
+        if (Node_work_remains(local_stack, comm)) {
+#ifdef STATS
+            Finish_time(work_rem_time);
+#endif 
+            Trace_end(TR_WORK_REM);
+            return TRUE;
+        }
+#endif
+        Term_idle(comm);
+        Trace_begin(TR_IDLE);
 #ifdef DEBUG
-        printf("Process %d > In Work_remains, stack empty, energy returned\n", 
+        printf("Process %d > In Work_remains, stack empty, now idle\n", 
            my_rank);
         fflush(stdout);
 #endif
-        request_sent = FALSE;
+        max_outstanding = (p - 1 < MAX_OUTSTANDING ? p - 1 : MAX_OUTSTANDING);
         while (TRUE) {
             Send_all_rejects(comm);
+#if defined(CHECKPOINT) && !defined(HYBRID)
+            Checkpoint_search(local_stack, comm);
+#endif
             if (Search_complete(comm)) {
 #ifdef DEBUG
                 printf("Process %d > In Work_remains, search complete\n", 
@@ -81,44 +160,37 @@ int Work_remains(
 #ifdef STATS
                 Finish_time(work_rem_time);
 #endif 
-                if (request_sent) Cancel_request();
+                Trace_end(TR_IDLE);
+                Trace_end(TR_WORK_REM);
+                Cancel_requests();
                 return FALSE;
-            } else if (!request_sent) {
+            }
+
+            while (num_outstanding < max_outstanding) {
                 work_request_process = New_request(comm);
                 Send_request(work_request_process, comm);
-                request_sent = TRUE;
 #ifdef DEBUG
                 printf("Process %d > In Work_remains, request sent to %d\n", 
                     my_rank, work_request_process);
                 fflush(stdout);
 #endif
-            } else if (Reply_received(work_request_process,
-                
-                    &work_available, local_stack, comm)) {
+            }
+
+            /* Work may also have arrived in Checkpoint_search */
+            Replies_received(local_stack, comm);
+            if (!Empty(local_stack)) {
 #ifdef DEBUG
-                printf("Process %d > In Work_remains, reply received from %d\n", 
-                        my_rank, work_request_process);
+                printf("Process %d > In Work_remains, received work\n", 
+                    my_rank);
                 fflush(stdout);
 #endif
-                if (work_available) {
-#ifdef DEBUG
-                    printf("Process %d > In Work_remains, received work from %d\n", 
-                        my_rank, work_request_process);
-                    fflush(stdout);
-#endif
 
 #ifdef STATS
-                    Finish_time(work_rem_time);
+                Finish_time(work_rem_time);
 #endif 
-                    return TRUE;
-                } else {
-#ifdef DEBUG
-                    printf("Process %d > In Work_remains, no work at %d\n", 
-                        my_rank, work_request_process);
-                    fflush(stdout);
-#endif
-                    request_sent = FALSE;
-                }
+                Trace_end(TR_IDLE);
+                Trace_end(TR_WORK_REM);
+                return TRUE;
             }
 
         } /* while (TRUE) */
@@ -128,75 +200,143 @@ int Work_remains(
 
 
 /*********************************************************************/
-/* Generates a process rank to which a new request should be sent --
- *     simply rand() % p
+/* Generates a process rank to which a new request should be sent.
+ *     Processes that haven't replied to an earlier request are
+ *     skipped.  If the policy keeps choosing such processes, take
+ *     the next rank after my_rank that has no request pending.
+ *     Assumes num_outstanding < p - 1.
  */
 int New_request(
         MPI_Comm  comm  /* in */) {
-    static int seeded = FALSE;
-    int        rank;
-    
+    int  rank;
+    int  tries;
 
-    if (!seeded) {
-        srand(my_rank);
-        seeded = TRUE;
+    for (tries = 0; tries < p; tries++) {
+        rank = Next_victim();
+        if (!Request_pending(rank)) return rank;
     }
- 
-    while ( (rank = rand() %p) == my_rank);
+
+    rank = my_rank;
+    do {
+        rank = (rank + 1) % p;
+    } while ((rank == my_rank) || Request_pending(rank));
 
     return rank;
 }  /* New_request */
 
 
 /*********************************************************************/
+int Request_pending(
+        int  rank  /* in */) {
+    int  i;
+
+    for (i = 0; i < num_outstanding; i++)
+        if (outstanding[i].rank == rank) return TRUE;
+    return FALSE;
+}  /* Request_pending */
+
+
+/*********************************************************************/
+/* The request tells the victim how many ints we can receive */
 void Send_request(
          int       work_request_process  /* in  */, 
          MPI_Comm  comm                  /* out */) {
 
-    int     x = 0;
-    STACK_T local_stack;
+    OUTSTANDING_T* req = &outstanding[num_outstanding];
 
-    MPI_Send(&x, 1, MPI_INT, work_request_process, REQUEST_TAG,
-        comm); 
+    MPI_Send(&reply_buffer_size, 1, MPI_INT, work_request_process, 
+        REQUEST_TAG, comm); 
 
     /* Post nonblocking receive */
-    Get_local_stack(&local_stack);
-    MPI_Irecv(Stack_list(local_stack), Max_size(local_stack),
-        MPI_INT, work_request_process, WORK_TAG, comm, 
-        &posted_recv);
+    req->rank = work_request_process;
+    MPI_Irecv(req->buffer, reply_buffer_size, MPI_INT, 
+        work_request_process, WORK_TAG, comm, &(req->posted_recv));
+    num_outstanding++;
+    Trace_instant(TR_REQ_SENT, work_request_process);
+
 #ifdef STATS
     Incr_stat(requests_sent);
+    if (!On_my_node(work_request_process))
+        Incr_stat(remote_reqs_sent);
 #endif
 }  /* Send_request */
 
 
+/*********************************************************************/
+/* Check each outstanding request for a reply.  Work is pushed onto
+ *     local_stack.  Returns the number of replies received.
+ */
+int Replies_received(
+        STACK_T   local_stack  /* in/out */, 
+        MPI_Comm  comm         /* in     */) {
+    int            i = 0;
+    int            replies = 0;
+    int            work_available;
+    OUTSTANDING_T  temp;
+
+    while (i < num_outstanding) {
+        if (Reply_received(&outstanding[i], &work_available, 
+                local_stack, comm)) {
+#ifdef DEBUG
+            printf("Process %d > Reply received from %d, work = %d\n", 
+                my_rank, outstanding[i].rank, work_available);
+            fflush(stdout);
+#endif
+            Victim_reply(outstanding[i].rank, work_available);
+
+            /* Swap, so that the buffer can be reused */
+            num_outstanding--;
+            temp = outstanding[i];
+            outstanding[i] = outstanding[num_outstanding];
+            outstanding[num_outstanding] = temp;
+            replies++;
+        } else {
+            i++;
+        }
+    }
+
+    return replies;
+}  /* Replies_received */
+
+
 /*********************************************************************/
 int Reply_received(
-        int       work_request_process  /* in  */,
-        int*      work_available        /* out */,
-        STACK_T   local_stack           /* out */, 
-        MPI_Comm  comm                  /* in  */) {
+        OUTSTANDING_T*  req             /* in/out */,
+        int*            work_available  /* out    */,
+        STACK_T         local_stack     /* out    */, 
+        MPI_Comm        comm            /* in     */) {
     int         reply_received;
     MPI_Status  status;
     int         count;
+    int         error;
 
-    MPI_Test(&posted_recv, &reply_received, &status);
+    MPI_Test(&(req->posted_recv), &reply_received, &status);
 
     if (reply_received) {
-        if (*Stack_list(local_stack) == -1) {
+        if (*(req->buffer) == -1) {
+            Trace_instant(TR_REJECT_RECD, req->rank);
 #ifdef STATS
             Incr_stat(rejects_recd);
 #endif
             *work_available = FALSE;
         } else {
             MPI_Get_count(&status, MPI_INT, &count);
-            Set_stack_scalars(count, local_stack);
+            error = Append_nodes(req->buffer, count, local_stack);
+            if (error < 0) {
+                fprintf(stderr, "Process %d > Stack overflow, In_use(stack) = %d, Max_size(stack) = %d\n",
+                    my_rank, In_use(local_stack), Max_size(local_stack));
+                fprintf(stderr, "Quitting!\n");
+                MPI_Abort(MPI_COMM_WORLD, -1);
+            }
 #ifdef DEBUG
-            Print_stack_list(count, local_stack, comm);
+            Print_stack_list(In_use(local_stack), local_stack, comm);
 #endif
-            Recv_half_energy(work_request_process, comm);
+            Term_work_recd(req->rank, comm);
+            Trace_instant(TR_WORK_RECD, req->rank);
 #ifdef STATS
             Incr_stat(work_recd);
+            if (!On_my_node(req->rank))
+                Incr_stat(remote_work_recd);
 #endif
             *work_available = TRUE;
         }
@@ -208,13 +348,45 @@ int Reply_received(
 
 
 /*********************************************************************/
-/* Tree search has completed, but there is still an outstanding work */
-/*    request.  Try to cancel it.                                    */
-void Cancel_request(void) {
+/* Stop sending requests for work, reject the requests that arrive,  */
+/*     and wait for replies to the requests already sent.  Work that */
+/*     arrives is pushed onto local_stack.  Returns when every       */
+/*     process in comm has done this, so no requests or work are in  */
+/*     flight.  Must be called by every process in comm.             */
+void Drain_requests(
+         STACK_T   local_stack  /* in/out */,
+         MPI_Comm  comm         /* in     */) {
+    int          entered = FALSE;
+    int          done = FALSE;
+    MPI_Request  barrier;
+    MPI_Status   status;
+
+    while (!done) {
+        /* Process 0 may have to receive a loan of credit */
+        Term_progress(comm);
+        Send_all_rejects(comm);
+        Replies_received(local_stack, comm);
+        if (!entered && (num_outstanding == 0)) {
+            MPI_Ibarrier(comm, &barrier);
+            entered = TRUE;
+        }
+        if (entered)
+            MPI_Test(&barrier, &done, &status);
+    }
+}  /* Drain_requests */
+
+
+/*********************************************************************/
+/* Tree search has completed, but there may still be outstanding     */
+/*    requests.  Try to cancel them.                                 */
+void Cancel_requests(void) {
     MPI_Status status;
+    int        i;
 
-/*  Cancel not implemented in mpich prior to 1.0.13 */
-    MPI_Cancel(&posted_recv);
-    MPI_Wait(&posted_recv, &status);
+    for (i = 0; i < num_outstanding; i++) {
+        MPI_Cancel(&(outstanding[i].posted_recv));
+        MPI_Wait(&(outstanding[i].posted_recv), &status);
+    }
+    num_outstanding = 0;
 
-}  /* Cancel_request */
+}  /* Cancel_requests */
@@ -8,14 +8,24 @@
 #include "mpi.h"
 #include "node_stack.h"
 
+/* Maximum number of requests for work a process can have pending */
+#ifndef MAX_OUTSTANDING
+#define MAX_OUTSTANDING 2
+#endif
+
+int   Allocate_reply_buffers(STACK_T local_stack);
+void  Free_reply_buffers(void);
+
 /* Called in Work_remains */
 int   Work_remains(STACK_T local_stack, MPI_Comm comm);
-void  Send_energy(MPI_Comm comm);
 int   Search_complete(MPI_Comm comm);
 int   New_request(MPI_Comm comm);
+int   Request_pending(int rank);
 void  Send_request(int work_request_process, MPI_Comm comm);
-int   Reply_received(int work_request_process, int* work_available, 
-          STACK_T local_stack, MPI_Comm comm);
-void Cancel_request(void);
+int   Replies_received(STACK_T local_stack, MPI_Comm comm);
+void  Cancel_requests(void);
+
+/* Called in Checkpoint_search -- see solution.c */
+void  Drain_requests(STACK_T local_stack, MPI_Comm comm);
 
 #endif
@@ -0,0 +1,619 @@
+/* block_lu.c
+ *
+ *   LU factorization with partial pivoting of a dense matrix that's
+ *   block-cyclically distributed over a rectangular grid of
+ *   processes, and the triangular solves that use it.  Only MPI
+ *   is needed.
+ *
+ *   Factorization:
+ *      The matrix is factored one block column (panel) at a time.
+ *      For block column K,
+ *      1.  The process column that owns it factors the panel.  For
+ *          each column, the pivot is found with an MPI_Allreduce
+ *          using MPI_MAXLOC on the process column, the pivot row is
+ *          swapped into place, and then it's broadcast down the
+ *          process column for the rank-1 update of the rest of the
+ *          panel.
+ *      2.  The panel and its pivots are broadcast across the process
+ *          rows.
+ *      3.  Every process column applies the row swaps to its
+ *          columns outside the panel.
+ *      4.  The process row that owns block row K computes
+ *          U12 = L11^{-1} A12, and broadcasts it down the process
+ *          columns.
+ *      5.  The trailing matrix is updated, A22 -= L21*U12, as a
+ *          blocked matrix-matrix product over the panel width.
+ *
+ *   Look-ahead:
+ *      Step 1 for panel K+1 can start as soon as block column K+1
+ *      has been updated in step 5 for panel K.  So each iteration
+ *      updates block column K+1 first, factors it, and starts a
+ *      nonblocking broadcast of it before updating the rest of the
+ *      trailing matrix.  The broadcast runs while the rest of the
+ *      update is computed, and the panel factorization, which is
+ *      mostly latency, is off the critical path of the other process
+ *      columns.  The rest of the update is done a block column at a
+ *      time, and MPI_Testall is called between block columns so the
+ *      broadcast makes progress.  Compile with -DNO_LOOKAHEAD for a
+ *      plain right-looking factorization.
+ *
+ *   Solve:
+ *      Forward and back substitution are done one block at a time.
+ *      The updates to a block of b are accumulated by the processes
+ *      that own the corresponding block row of the matrix, and
+ *      added with an MPI_Reduce onto the process that owns the
+ *      diagonal block.
+ *
+ *   Notes:
+ *      1.  The blocks are square.
+ *      2.  The local matrices are column major.
+ *      3.  pivot_list has n entries, and it's the same on every
+ *          process.  pivot_list[j] is the row that was swapped
+ *          with row j.
+ *      4.  Lu_factor returns -1 on every process if any process
+ *          can't allocate its work space.
+ *
+ *   See Chap 15, pp. 340 & ff, in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "mpi.h"
+#include "block_lu.h"
+
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+
+/* Rows of L21 per block in the trailing update */
+#define UPDATE_ROWS 256
+
+static void Factor_panel(float* A_local, LU_DESCRIP_T* descrip,
+		int k0, int kb, int* pivot_list, float* row,
+		int* info);
+static void Start_panel(float* A_local, LU_DESCRIP_T* descrip,
+		int k0, int kb, int* pivot_list, float* panel,
+		float* row, MPI_Request* requests, int* info);
+static void Swap_rows(float* A_local, LU_DESCRIP_T* descrip,
+		int row1, int row2, int* ranges, float* buffer);
+static void Compute_u_row(float* A_local, LU_DESCRIP_T* descrip,
+		float* L, int k0, int kb, float* u_row);
+static void Update_trailing(float* A_local, LU_DESCRIP_T* descrip,
+		float* L, float* u_row, int k0, int kb, int first_col,
+		int last_col);
+
+/*===================================================================
+ *
+ * Build an nproc_rows x nproc_cols grid, with ranks in row major
+ * order, and fill in descrip.  Processes that aren't in the grid
+ * get a negative return value.
+ */
+int Build_descrip(int n, int block_size, int nproc_rows,
+		int nproc_cols, LU_DESCRIP_T* descrip) {
+    int dimensions[2];
+    int periods[2] = {0, 0};
+    int coordinates[2];
+    int free_coords[2];
+    int my_grid_rank;
+
+    dimensions[0] = nproc_rows;
+    dimensions[1] = nproc_cols;
+    /* Don't reorder:  process 0 must be process (0,0) */
+    MPI_Cart_create(MPI_COMM_WORLD, 2, dimensions, periods, 0,
+        &(descrip->grid_comm));
+    if (descrip->grid_comm == MPI_COMM_NULL)
+        return -1;
+
+    MPI_Comm_rank(descrip->grid_comm, &my_grid_rank);
+    MPI_Cart_coords(descrip->grid_comm, my_grid_rank, 2, coordinates);
+    descrip->my_process_row = coordinates[0];
+    descrip->my_process_col = coordinates[1];
+
+    free_coords[0] = 0;
+    free_coords[1] = 1;
+    MPI_Cart_sub(descrip->grid_comm, free_coords, &(descrip->row_comm));
+    free_coords[0] = 1;
+    free_coords[1] = 0;
+    MPI_Cart_sub(descrip->grid_comm, free_coords, &(descrip->col_comm));
+
+    descrip->n = n;
+    descrip->block_size = block_size;
+    descrip->nproc_rows = nproc_rows;
+    descrip->nproc_cols = nproc_cols;
+    descrip->local_rows = Get_dimension(n, block_size,
+        descrip->my_process_row, nproc_rows);
+    descrip->local_cols = Get_dimension(n, block_size,
+        descrip->my_process_col, nproc_cols);
+    return 0;
+}  /* Build_descrip */
+
+
+/*===================================================================*/
+void Free_descrip(LU_DESCRIP_T* descrip) {
+    MPI_Comm_free(&(descrip->row_comm));
+    MPI_Comm_free(&(descrip->col_comm));
+    MPI_Comm_free(&(descrip->grid_comm));
+}  /* Free_descrip */
+
+
+/*===================================================================
+ *
+ * Number of the indices 0, 1, ..., order-1 that are assigned to
+ * my_process_row_or_col.  Since the blocks are assigned in order,
+ * this is also the local index of the first global index >= order.
+ * Same as ScaLAPACK's numroc.
+ */
+int Get_dimension(int order, int block_size, int my_process_row_or_col,
+	int nproc_rows_or_cols) {
+    int block_count = order/block_size;
+    int extra_blocks = block_count % nproc_rows_or_cols;
+    int return_val;
+
+    return_val = (block_count/nproc_rows_or_cols)*block_size;
+    if (my_process_row_or_col < extra_blocks)
+        return_val += block_size;
+    else if (my_process_row_or_col == extra_blocks)
+        return_val += order % block_size;
+    return return_val;
+}  /* Get_dimension */
+
+
+/*===================================================================
+ *
+ * Swap global rows row1 and row2 in the local columns
+ * ranges[0], ..., ranges[1]-1 and ranges[2], ..., ranges[3]-1.
+ * Called by every process in a process column.
+ */
+static void Swap_rows(float* A_local, LU_DESCRIP_T* descrip,
+		int row1, int row2, int* ranges, float* buffer) {
+    int		nb = descrip->block_size;
+    int		P = descrip->nproc_rows;
+    int		lda = descrip->local_rows;
+    int		owner1 = Owner(row1, nb, P);
+    int		owner2 = Owner(row2, nb, P);
+    int		my_row = descrip->my_process_row;
+    int		local, partner;
+    int		r, j, count;
+    float	temp;
+    MPI_Status	status;
+
+    if (row1 == row2) return;
+
+    if ((my_row == owner1) && (my_row == owner2)) {
+        row1 = Local_index(row1, nb, P);
+        row2 = Local_index(row2, nb, P);
+        for (r = 0; r < 4; r += 2)
+            for (j = ranges[r]; j < ranges[r+1]; j++) {
+                temp = A_local[row1 + j*lda];
+                A_local[row1 + j*lda] = A_local[row2 + j*lda];
+                A_local[row2 + j*lda] = temp;
+            }
+    } else if ((my_row == owner1) || (my_row == owner2)) {
+        if (my_row == owner1) {
+            local = Local_index(row1, nb, P);
+            partner = owner2;
+        } else {
+            local = Local_index(row2, nb, P);
+            partner = owner1;
+        }
+        count = 0;
+        for (r = 0; r < 4; r += 2)
+            for (j = ranges[r]; j < ranges[r+1]; j++)
+                buffer[count++] = A_local[local + j*lda];
+        MPI_Sendrecv_replace(buffer, count, MPI_FLOAT, partner, 0,
+            partner, 0, descrip->col_comm, &status);
+        count = 0;
+        for (r = 0; r < 4; r += 2)
+            for (j = ranges[r]; j < ranges[r+1]; j++)
+                A_local[local + j*lda] = buffer[count++];
+    }
+}  /* Swap_rows */
+
+
+/*===================================================================
+ *
+ * Factor the panel in global columns k0, ..., k0+kb-1.  Called by
+ * the process column that owns it.  row should have room for
+ * local_cols floats.
+ */
+static void Factor_panel(float* A_local, LU_DESCRIP_T* descrip,
+		int k0, int kb, int* pivot_list, float* row,
+		int* info) {
+    int		nb = descrip->block_size;
+    int		P = descrip->nproc_rows;
+    int		lda = descrip->local_rows;
+    int		my_row = descrip->my_process_row;
+    int		lc = Local_index(k0, nb, descrip->nproc_cols);
+    int		ranges[4];
+    int		i, j, c, s;
+    int		first, count;
+    int		owner;
+    float	l;
+    struct {
+        float	value;
+        int	index;
+    } local_max, global_max;
+
+    ranges[0] = lc;
+    ranges[1] = lc + kb;
+    ranges[2] = ranges[3] = 0;
+
+    for (j = k0; j < k0 + kb; j++) {
+        c = lc + j - k0;
+
+        /* Find the pivot */
+        first = Get_dimension(j, nb, my_row, P);
+        local_max.value = -1.0;
+        local_max.index = j;
+        for (i = first; i < lda; i++)
+            if (fabs(A_local[i + c*lda]) > local_max.value) {
+                local_max.value = fabs(A_local[i + c*lda]);
+                local_max.index = Global_index(i, nb, my_row, P);
+            }
+        MPI_Allreduce(&local_max, &global_max, 1, MPI_FLOAT_INT,
+            MPI_MAXLOC, descrip->col_comm);
+        pivot_list[j] = global_max.index;
+        Swap_rows(A_local, descrip, j, global_max.index, ranges, row);
+
+        /* Broadcast the rest of the pivot row in the panel */
+        owner = Owner(j, nb, P);
+        count = lc + kb - c;
+        if (my_row == owner)
+            for (s = 0; s < count; s++)
+                row[s] = A_local[Local_index(j, nb, P) + (c+s)*lda];
+        MPI_Bcast(row, count, MPI_FLOAT, owner, descrip->col_comm);
+        if (row[0] == 0.0) {
+            if (*info == 0) *info = j + 1;
+            continue;
+        }
+
+        /* Compute multipliers, and update the rest of the panel */
+        first = Get_dimension(j + 1, nb, my_row, P);
+        for (i = first; i < lda; i++)
+            A_local[i + c*lda] /= row[0];
+        for (s = 1; s < count; s++) {
+            l = row[s];
+            for (i = first; i < lda; i++)
+                A_local[i + (c+s)*lda] -= A_local[i + c*lda]*l;
+        }
+    }
+}  /* Factor_panel */
+
+
+/*===================================================================
+ *
+ * Factor the panel starting at global column k0 on the process
+ * column that owns it, and start broadcasting it and its pivots
+ * across the process rows.  The owner sends directly from A_local,
+ * the other processes receive into panel.
+ */
+static void Start_panel(float* A_local, LU_DESCRIP_T* descrip,
+		int k0, int kb, int* pivot_list, float* panel,
+		float* row, MPI_Request* requests, int* info) {
+    int		nb = descrip->block_size;
+    int		owner = Owner(k0, nb, descrip->nproc_cols);
+    float*	buffer = panel;
+
+    if (descrip->my_process_col == owner) {
+        Factor_panel(A_local, descrip, k0, kb, pivot_list, row, info);
+        buffer = A_local + Local_index(k0, nb, descrip->nproc_cols)*
+            descrip->local_rows;
+    }
+    MPI_Ibcast(buffer, descrip->local_rows*kb, MPI_FLOAT, owner,
+        descrip->row_comm, &requests[0]);
+    MPI_Ibcast(pivot_list + k0, kb, MPI_INT, owner,
+        descrip->row_comm, &requests[1]);
+}  /* Start_panel */
+
+
+/*===================================================================
+ *
+ * On the process row that owns block row k0, overwrite A12 with
+ * U12 = L11^{-1} A12.  Then broadcast U12 down the process columns
+ * into u_row, which is kb x (local columns to the right of the
+ * panel), column major.
+ */
+static void Compute_u_row(float* A_local, LU_DESCRIP_T* descrip,
+		float* L, int k0, int kb, float* u_row) {
+    int		nb = descrip->block_size;
+    int		P = descrip->nproc_rows;
+    int		lda = descrip->local_rows;
+    int		owner = Owner(k0, nb, P);
+    int		first_col = Get_dimension(k0 + kb, nb,
+                        descrip->my_process_col, descrip->nproc_cols);
+    int		col_count = descrip->local_cols - first_col;
+    int		lr, c, r, s;
+    float*	a;
+    float	x;
+
+    if (descrip->my_process_row == owner) {
+        lr = Local_index(k0, nb, P);
+        for (c = 0; c < col_count; c++) {
+            a = A_local + lr + (first_col + c)*lda;
+            for (s = 0; s < kb; s++) {
+                x = a[s];
+                for (r = s + 1; r < kb; r++)
+                    a[r] -= L[lr + r + s*lda]*x;
+            }
+            for (r = 0; r < kb; r++)
+                u_row[r + c*kb] = a[r];
+        }
+    }
+    MPI_Bcast(u_row, kb*col_count, MPI_FLOAT, owner, descrip->col_comm);
+}  /* Compute_u_row */
+
+
+/*===================================================================
+ *
+ * A22 -= L21*U12 in local columns first_col, ..., last_col-1.
+ * Column j of u_row corresponds to local column
+ * (first local column to the right of the panel) + j.
+ *
+ * This is a matrix-matrix update over the whole panel width.  The
+ * rows are done UPDATE_ROWS at a time, so the block of L21 that's
+ * used stays in cache, and the columns are done four at a time,
+ * so each entry of L21 that's loaded is used four times.
+ */
+static void Update_trailing(float* A_local, LU_DESCRIP_T* descrip,
+		float* L, float* u_row, int k0, int kb, int first_col,
+		int last_col) {
+    int		nb = descrip->block_size;
+    int		lda = descrip->local_rows;
+    int		first_row = Get_dimension(k0 + kb, nb,
+                        descrip->my_process_row, descrip->nproc_rows);
+    int		u_first_col = Get_dimension(k0 + kb, nb,
+                        descrip->my_process_col, descrip->nproc_cols);
+    int		i, i0, i1, j, s;
+    float	u0, u1, u2, u3;
+    float	l;
+    float*	a0;
+    float*	a1;
+    float*	a2;
+    float*	a3;
+    float*	u;
+    float*	ls;
+
+    for (i0 = first_row; i0 < lda; i0 = i1) {
+        i1 = MIN(i0 + UPDATE_ROWS, lda);
+        for (j = first_col; j + 3 < last_col; j += 4) {
+            a0 = A_local + j*lda;
+            a1 = a0 + lda;
+            a2 = a1 + lda;
+            a3 = a2 + lda;
+            u = u_row + (j - u_first_col)*kb;
+            for (s = 0; s < kb; s++) {
+                u0 = u[s];
+                u1 = u[s + kb];
+                u2 = u[s + 2*kb];
+                u3 = u[s + 3*kb];
+                ls = L + s*lda;
+                for (i = i0; i < i1; i++) {
+                    l = ls[i];
+                    a0[i] -= l*u0;
+                    a1[i] -= l*u1;
+                    a2[i] -= l*u2;
+                    a3[i] -= l*u3;
+                }
+            }
+        }
+        for ( ; j < last_col; j++) {
+            a0 = A_local + j*lda;
+            u = u_row + (j - u_first_col)*kb;
+            for (s = 0; s < kb; s++) {
+                u0 = u[s];
+                ls = L + s*lda;
+                for (i = i0; i < i1; i++)
+                    a0[i] -= ls[i]*u0;
+            }
+        }
+    }
+}  /* Update_trailing */
+
+
+/*===================================================================
+ *
+ * Overwrite A_local with L and U, where PA = LU.  The unit diagonal
+ * of L isn't stored.  Returns 0 if successful, j+1 if U(j,j) = 0,
+ * and -1 on every process if any process couldn't allocate its
+ * work space.
+ */
+int Lu_factor(float* A_local, LU_DESCRIP_T* descrip, int* pivot_list) {
+    int		n = descrip->n;
+    int		nb = descrip->block_size;
+    int		Q = descrip->nproc_cols;
+    int		my_col = descrip->my_process_col;
+    int		block_count = (n + nb - 1)/nb;
+    int		max_size;
+    float*	panel[2];
+    float*	u_row;
+    float*	row;
+    float*	L;
+    MPI_Request	requests[2][2];
+    int		K, cur;
+    int		k0, kb, k1, kb1;
+    int		first_col, next_col;
+    int		ranges[4];
+    int		j;
+    int		done;
+    int		info = 0;
+    int		global_info;
+    int		alloc_ok, global_alloc_ok;
+
+    panel[0] = (float*) malloc((descrip->local_rows*nb + 1)*sizeof(float));
+    panel[1] = (float*) malloc((descrip->local_rows*nb + 1)*sizeof(float));
+    u_row = (float*) malloc((nb*descrip->local_cols + 1)*sizeof(float));
+    max_size = (descrip->local_cols > nb ? descrip->local_cols : nb);
+    row = (float*) malloc((max_size + 1)*sizeof(float));
+
+    /* Every process has to fail if any process does */
+    alloc_ok = (panel[0] != NULL) && (panel[1] != NULL) &&
+        (u_row != NULL) && (row != NULL);
+    MPI_Allreduce(&alloc_ok, &global_alloc_ok, 1, MPI_INT, MPI_LAND,
+        descrip->grid_comm);
+    if (!global_alloc_ok) {
+        free(panel[0]);
+        free(panel[1]);
+        free(u_row);
+        free(row);
+        return -1;
+    }
+
+    if (n > 0)
+        Start_panel(A_local, descrip, 0, MIN(nb, n), pivot_list,
+            panel[0], row, requests[0], &info);
+
+    for (K = 0; K < block_count; K++) {
+        cur = K % 2;
+        k0 = K*nb;
+        kb = MIN(nb, n - k0);
+        k1 = k0 + kb;
+        kb1 = MIN(nb, n - k1);
+        MPI_Waitall(2, requests[cur], MPI_STATUSES_IGNORE);
+        if (my_col == Owner(k0, nb, Q))
+            L = A_local + Local_index(k0, nb, Q)*descrip->local_rows;
+        else
+            L = panel[cur];
+
+        /* Swap rows outside the panel */
+        ranges[0] = 0;
+        ranges[1] = Get_dimension(k0, nb, my_col, Q);
+        ranges[2] = Get_dimension(k1, nb, my_col, Q);
+        ranges[3] = descrip->local_cols;
+        for (j = k0; j < k1; j++)
+            Swap_rows(A_local, descrip, j, pivot_list[j], ranges, row);
+
+        Compute_u_row(A_local, descrip, L, k0, kb, u_row);
+
+        first_col = ranges[2];
+        if (K + 1 == block_count) continue;
+#       ifndef NO_LOOKAHEAD
+        /* Update and factor the next panel, and start sending it */
+        if (my_col == Owner(k1, nb, Q)) {
+            Update_trailing(A_local, descrip, L, u_row, k0, kb,
+                first_col, first_col + kb1);
+            first_col += kb1;
+        }
+        Start_panel(A_local, descrip, k1, kb1, pivot_list,
+            panel[1-cur], row, requests[1-cur], &info);
+
+        /* Update the rest while the panel is sent */
+        while (first_col < descrip->local_cols) {
+            next_col = MIN(first_col + nb, descrip->local_cols);
+            Update_trailing(A_local, descrip, L, u_row, k0, kb,
+                first_col, next_col);
+            first_col = next_col;
+            MPI_Testall(2, requests[1-cur], &done, MPI_STATUSES_IGNORE);
+        }
+#       else
+        Update_trailing(A_local, descrip, L, u_row, k0, kb,
+            first_col, descrip->local_cols);
+        Start_panel(A_local, descrip, k1, kb1, pivot_list,
+            panel[1-cur], row, requests[1-cur], &info);
+#       endif
+    }
+
+    free(panel[0]);
+    free(panel[1]);
+    free(u_row);
+    free(row);
+
+    MPI_Allreduce(&info, &global_info, 1, MPI_INT, MPI_MAX,
+        descrip->grid_comm);
+    return global_info;
+}  /* Lu_factor */
+
+
+/*===================================================================
+ *
+ * Solve Ax = b, where PA = LU has been computed by Lu_factor.
+ * Overwrite b with x.
+ */
+void Lu_solve(float* A_local, LU_DESCRIP_T* descrip, int* pivot_list,
+	float* b_local) {
+    int		n = descrip->n;
+    int		nb = descrip->block_size;
+    int		P = descrip->nproc_rows;
+    int		Q = descrip->nproc_cols;
+    int		lda = descrip->local_rows;
+    int		my_row = descrip->my_process_row;
+    int		my_col = descrip->my_process_col;
+    int		block_count = (n + nb - 1)/nb;
+    int		ranges[4] = {0, 1, 0, 0};
+    float*	w;          /* Accumulated updates to b */
+    float*	x;
+    int		K, k0, kb;
+    int		prow, pcol;
+    int		lr = 0, lc = 0;
+    int		i, j, r;
+
+    w = (float*) malloc((lda + 1)*sizeof(float));
+    x = (float*) malloc(nb*sizeof(float));
+
+    /* b = Pb.  b is a 1-column matrix */
+    for (j = 0; j < n; j++)
+        Swap_rows(b_local, descrip, j, pivot_list[j], ranges, x);
+
+    /* Solve Ly = b */
+    for (i = 0; i < lda; i++) w[i] = 0.0;
+    for (K = 0; K < block_count; K++) {
+        k0 = K*nb;
+        kb = MIN(nb, n - k0);
+        prow = Owner(k0, nb, P);
+        pcol = Owner(k0, nb, Q);
+        if (my_row == prow) lr = Local_index(k0, nb, P);
+        if (my_col == pcol) lc = Local_index(k0, nb, Q);
+
+        if (my_row == prow) {
+            MPI_Reduce(w + lr, x, kb, MPI_FLOAT, MPI_SUM, pcol,
+                descrip->row_comm);
+            if (my_col == pcol)
+                for (r = 0; r < kb; r++) {
+                    x[r] = b_local[lr + r] - x[r];
+                    for (j = 0; j < r; j++)
+                        x[r] -= A_local[lr + r + (lc + j)*lda]*x[j];
+                    b_local[lr + r] = x[r];
+                }
+        }
+        if (my_col == pcol) {
+            MPI_Bcast(x, kb, MPI_FLOAT, prow, descrip->col_comm);
+            for (j = 0; j < kb; j++)
+                for (i = Get_dimension(k0 + kb, nb, my_row, P); i < lda; i++)
+                    w[i] += A_local[i + (lc + j)*lda]*x[j];
+        }
+    }
+
+    /* Solve Ux = y */
+    for (i = 0; i < lda; i++) w[i] = 0.0;
+    for (K = block_count - 1; K >= 0; K--) {
+        k0 = K*nb;
+        kb = MIN(nb, n - k0);
+        prow = Owner(k0, nb, P);
+        pcol = Owner(k0, nb, Q);
+        if (my_row == prow) lr = Local_index(k0, nb, P);
+        if (my_col == pcol) lc = Local_index(k0, nb, Q);
+
+        if (my_row == prow) {
+            MPI_Reduce(w + lr, x, kb, MPI_FLOAT, MPI_SUM, pcol,
+                descrip->row_comm);
+            if (my_col == pcol)
+                for (r = kb - 1; r >= 0; r--) {
+                    x[r] = b_local[lr + r] - x[r];
+                    for (j = r + 1; j < kb; j++)
+                        x[r] -= A_local[lr + r + (lc + j)*lda]*x[j];
+                    x[r] /= A_local[lr + r + (lc + r)*lda];
+                }
+        }
+        if (my_col == pcol) {
+            MPI_Bcast(x, kb, MPI_FLOAT, prow, descrip->col_comm);
+            for (j = 0; j < kb; j++)
+                for (i = 0; i < Get_dimension(k0, nb, my_row, P); i++)
+                    w[i] += A_local[i + (lc + j)*lda]*x[j];
+        }
+        if (my_row == prow) {
+            MPI_Bcast(x, kb, MPI_FLOAT, pcol, descrip->row_comm);
+            for (r = 0; r < kb; r++)
+                b_local[lr + r] = x[r];
+        }
+    }
+
+    free(w);
+    free(x);
+}  /* Lu_solve */
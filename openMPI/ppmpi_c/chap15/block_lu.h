@@ -0,0 +1,74 @@
+/* block_lu.h -- header file for block_lu.c -- declarations and
+ *     definitions for solving a dense linear system with a
+ *     block-cyclically distributed LU factorization.
+ */
+#ifndef BLOCK_LU_H
+#define BLOCK_LU_H
+
+#include "mpi.h"
+
+/*===================================================================
+ *
+ * Describes the process grid and the distribution of an n x n
+ * matrix in square blocks of order block_size.  Block (I,J) is
+ * assigned to process (I % nproc_rows, J % nproc_cols), and the
+ * local matrix is stored in column major order with leading
+ * dimension local_rows.  A vector is distributed over the process
+ * rows like the rows of the matrix, and every process in a process
+ * row has a copy of its entries.
+ */
+typedef struct {
+    int		n;
+    int		block_size;
+    int		nproc_rows;
+    int		nproc_cols;
+    int		my_process_row;
+    int		my_process_col;
+    int		local_rows;
+    int		local_cols;
+    MPI_Comm	grid_comm;  /* Ranks in row major order   */
+    MPI_Comm	row_comm;   /* My process row:  rank is   */
+                            /*     my_process_col         */
+    MPI_Comm	col_comm;   /* My process column:  rank   */
+                            /*     is my_process_row      */
+} LU_DESCRIP_T;
+
+/* Process row or column that owns global row or column index */
+#define Owner(index, block_size, nprocs) \
+    (((index)/(block_size)) % (nprocs))
+
+/* Local index of global index on the process that owns it */
+#define Local_index(index, block_size, nprocs) \
+    ((((index)/(block_size))/(nprocs))*(block_size) + \
+     (index) % (block_size))
+
+/* Global index of local index on process row or column my_proc */
+#define Global_index(local, block_size, my_proc, nprocs) \
+    ((((local)/(block_size))*(nprocs) + (my_proc))*(block_size) + \
+     (local) % (block_size))
+
+/* Compare the right-looking factorization without look-ahead */
+/*     by compiling with -DNO_LOOKAHEAD                        */
+
+/* Build the grid and fill in descrip.  Returns 0 if successful, */
+/*     negative if the calling process isn't in the grid         */
+int Build_descrip(int n, int block_size, int nproc_rows,
+        int nproc_cols, LU_DESCRIP_T* descrip);
+
+/* Number of the first order rows or columns assigned to  */
+/*     my_process_row_or_col                              */
+int Get_dimension(int order, int block_size, int my_process_row_or_col,
+        int nproc_rows_or_cols);
+
+/* Overwrite A_local with its LU factorization.  Returns 0 if  */
+/*     successful, positive if a zero pivot was found, and -1  */
+/*     if the work space couldn't be allocated                 */
+int Lu_factor(float* A_local, LU_DESCRIP_T* descrip, int* pivot_list);
+
+/* Solve Ax = b using the output of Lu_factor.  Return x in b  */
+void Lu_solve(float* A_local, LU_DESCRIP_T* descrip, int* pivot_list,
+        float* b_local);
+
+void Free_descrip(LU_DESCRIP_T* descrip);
+
+#endif
@@ -0,0 +1,283 @@
+/* dist_csr.c
+ *
+ *   Functions for a sparse matrix that's distributed by block rows
+ *   and stored in compressed sparse row format, and for multiplying
+ *   it by a vector that's distributed the same way.
+ *
+ *   Each process needs the entries of x in the columns of its rows.
+ *   The ones it doesn't own are its ghost entries.  Setup_spmv works
+ *   out once which ghosts each process needs, and from whom, and
+ *   builds persistent send and receive requests for them.  Then
+ *   each call to Spmv packs the entries other processes need,
+ *   starts the requests, multiplies the entries of its rows that
+ *   are in its own columns while the ghosts are in transit, and
+ *   finishes with the entries in ghost columns.
+ *
+ *   See Chap 15, pp. 350 & ff, in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+#include "dist_csr.h"
+
+static int Compare_ints(const void* a, const void* b);
+static int Find_ghost(int* ghosts, int count, int column);
+
+/*===================================================================
+ *
+ * Allocate the struct and the CSR arrays for my block of rows.
+ * Returns NULL if malloc fails.
+ */
+DIST_CSR_T* Allocate_dist_csr(int n, int nonzeros, MPI_Comm comm) {
+    DIST_CSR_T*	A;
+    int		p, my_rank;
+
+    MPI_Comm_size(comm, &p);
+    MPI_Comm_rank(comm, &my_rank);
+
+    A = (DIST_CSR_T*) calloc(1, sizeof(DIST_CSR_T));
+    if (A == (DIST_CSR_T*) NULL) return A;
+    A->n = n;
+    A->comm = comm;
+    A->first_row = Block_low(my_rank, p, n);
+    A->local_rows = Block_size(my_rank, p, n);
+    A->row_start = (int*) malloc((A->local_rows + 1)*sizeof(int));
+    A->local_end = (int*) malloc((A->local_rows + 1)*sizeof(int));
+    A->col_index = (int*) malloc((nonzeros + 1)*sizeof(int));
+    A->values = (double*) malloc((nonzeros + 1)*sizeof(double));
+    if ((A->row_start == NULL) || (A->local_end == NULL) ||
+            (A->col_index == NULL) || (A->values == NULL)) {
+        Free_dist_csr(&A);
+        return (DIST_CSR_T*) NULL;
+    }
+    A->row_start[0] = 0;
+    return A;
+}  /* Allocate_dist_csr */
+
+
+/*===================================================================*/
+static int Compare_ints(const void* a, const void* b) {
+    return *((int*) a) - *((int*) b);
+}  /* Compare_ints */
+
+
+/*===================================================================
+ *
+ * Binary search of the sorted list of ghosts
+ */
+static int Find_ghost(int* ghosts, int count, int column) {
+    int low = 0, high = count - 1, mid;
+
+    while (low <= high) {
+        mid = (low + high)/2;
+        if (ghosts[mid] == column)
+            return mid;
+        else if (ghosts[mid] < column)
+            low = mid + 1;
+        else
+            high = mid - 1;
+    }
+    return -1;
+}  /* Find_ghost */
+
+
+/*===================================================================
+ *
+ * Build the communication plan for Spmv, and convert the column
+ * indices to local indices.  Collective on A->comm.
+ */
+int Setup_spmv(DIST_CSR_T* A) {
+    int		p, my_rank;
+    int		first = A->first_row;
+    int		last = A->first_row + A->local_rows;
+    int		nonzeros = A->row_start[A->local_rows];
+    int*	recv_counts;   /* Ghosts I get from each process */
+    int*	send_counts;   /* Entries I send each process    */
+    int*	recv_displs;
+    int*	send_displs;
+    int		i, j, k, q, count;
+    int		col;
+    double	temp;
+
+    MPI_Comm_size(A->comm, &p);
+    MPI_Comm_rank(A->comm, &my_rank);
+
+    /* Collect the ghost columns, sort them, and remove duplicates */
+    A->ghost_global = (int*) malloc((nonzeros + 1)*sizeof(int));
+    if (A->ghost_global == (int*) NULL) return -1;
+    count = 0;
+    for (k = 0; k < nonzeros; k++)
+        if ((A->col_index[k] < first) || (A->col_index[k] >= last))
+            A->ghost_global[count++] = A->col_index[k];
+    qsort(A->ghost_global, count, sizeof(int), Compare_ints);
+    A->ghost_count = 0;
+    for (k = 0; k < count; k++)
+        if ((A->ghost_count == 0) ||
+                (A->ghost_global[k] != A->ghost_global[A->ghost_count-1]))
+            A->ghost_global[A->ghost_count++] = A->ghost_global[k];
+
+    /* Convert to local indices, and move local columns to the front */
+    for (i = 0; i < A->local_rows; i++) {
+        j = A->row_start[i];
+        for (k = A->row_start[i]; k < A->row_start[i+1]; k++) {
+            col = A->col_index[k];
+            if ((col >= first) && (col < last)) {
+                A->col_index[k] = A->col_index[j];
+                A->col_index[j] = col - first;
+                temp = A->values[k];
+                A->values[k] = A->values[j];
+                A->values[j] = temp;
+                j++;
+            }
+        }
+        A->local_end[i] = j;
+        for (k = j; k < A->row_start[i+1]; k++)
+            A->col_index[k] = A->local_rows +
+                Find_ghost(A->ghost_global, A->ghost_count,
+                    A->col_index[k]);
+    }
+
+    /* The ghosts are sorted, so each process's are contiguous */
+    recv_counts = (int*) calloc(4*p, sizeof(int));
+    if (recv_counts == (int*) NULL) return -1;
+    send_counts = recv_counts + p;
+    recv_displs = send_counts + p;
+    send_displs = recv_displs + p;
+    for (k = 0; k < A->ghost_count; k++)
+        recv_counts[Block_owner(A->ghost_global[k], p, A->n)]++;
+
+    /* Tell the owners which entries I need */
+    MPI_Alltoall(recv_counts, 1, MPI_INT, send_counts, 1, MPI_INT,
+        A->comm);
+    for (q = 1; q < p; q++) {
+        recv_displs[q] = recv_displs[q-1] + recv_counts[q-1];
+        send_displs[q] = send_displs[q-1] + send_counts[q-1];
+    }
+    count = send_displs[p-1] + send_counts[p-1];
+    A->send_index = (int*) malloc((count + 1)*sizeof(int));
+    A->send_buffer = (double*) malloc((count + 1)*sizeof(double));
+    A->ghost_values = (double*) malloc((A->ghost_count + 1)*
+        sizeof(double));
+    A->recv_ranks = (int*) malloc((2*p + 2)*sizeof(int));
+    A->recv_offsets = (int*) malloc((p + 1)*sizeof(int));
+    A->send_offsets = (int*) malloc((p + 1)*sizeof(int));
+    A->requests = (MPI_Request*) malloc((2*p + 1)*sizeof(MPI_Request));
+    if ((A->send_index == NULL) || (A->send_buffer == NULL) ||
+            (A->ghost_values == NULL) || (A->recv_ranks == NULL) ||
+            (A->recv_offsets == NULL) || (A->send_offsets == NULL) ||
+            (A->requests == NULL)) {
+        free(recv_counts);
+        return -1;
+    }
+    A->send_ranks = A->recv_ranks + p + 1;
+    MPI_Alltoallv(A->ghost_global, recv_counts, recv_displs, MPI_INT,
+        A->send_index, send_counts, send_displs, MPI_INT, A->comm);
+    for (k = 0; k < count; k++)
+        A->send_index[k] -= first;
+
+    /* Keep only the processes I actually exchange with */
+    A->recv_procs = A->send_procs = 0;
+    for (q = 0; q < p; q++) {
+        if (recv_counts[q] > 0) {
+            A->recv_ranks[A->recv_procs] = q;
+            A->recv_offsets[A->recv_procs++] = recv_displs[q];
+        }
+        if (send_counts[q] > 0) {
+            A->send_ranks[A->send_procs] = q;
+            A->send_offsets[A->send_procs++] = send_displs[q];
+        }
+    }
+    A->recv_offsets[A->recv_procs] = A->ghost_count;
+    A->send_offsets[A->send_procs] = count;
+
+    /* Persistent requests:  receives first, then sends */
+    for (q = 0; q < A->recv_procs; q++)
+        MPI_Recv_init(A->ghost_values + A->recv_offsets[q],
+            A->recv_offsets[q+1] - A->recv_offsets[q], MPI_DOUBLE,
+            A->recv_ranks[q], 0, A->comm, &(A->requests[q]));
+    for (q = 0; q < A->send_procs; q++)
+        MPI_Send_init(A->send_buffer + A->send_offsets[q],
+            A->send_offsets[q+1] - A->send_offsets[q], MPI_DOUBLE,
+            A->send_ranks[q], 0, A->comm,
+            &(A->requests[A->recv_procs + q]));
+
+#   ifdef DEBUG
+    printf("Process %d > %d ghosts from %d processes, %d entries to %d processes\n",
+        my_rank, A->ghost_count, A->recv_procs, count, A->send_procs);
+    fflush(stdout);
+#   endif
+
+    free(recv_counts);
+    return 0;
+}  /* Setup_spmv */
+
+
+/*===================================================================
+ *
+ * y = A*x.  x and y are distributed like the rows of A.
+ */
+void Spmv(DIST_CSR_T* A, double* x, double* y) {
+    int		request_count = A->recv_procs + A->send_procs;
+    int		i, k;
+    double	sum;
+
+    for (k = 0; k < A->send_offsets[A->send_procs]; k++)
+        A->send_buffer[k] = x[A->send_index[k]];
+    MPI_Startall(request_count, A->requests);
+
+    /* Entries in my columns while the ghosts arrive */
+    for (i = 0; i < A->local_rows; i++) {
+        sum = 0.0;
+        for (k = A->row_start[i]; k < A->local_end[i]; k++)
+            sum += A->values[k]*x[A->col_index[k]];
+        y[i] = sum;
+    }
+
+    MPI_Waitall(request_count, A->requests, MPI_STATUSES_IGNORE);
+    for (i = 0; i < A->local_rows; i++)
+        for (k = A->local_end[i]; k < A->row_start[i+1]; k++)
+            y[i] += A->values[k]*
+                A->ghost_values[A->col_index[k] - A->local_rows];
+}  /* Spmv */
+
+
+/*===================================================================
+ *
+ * Must be called after Setup_spmv
+ */
+void Get_diagonal(DIST_CSR_T* A, double* diag) {
+    int i, k;
+
+    for (i = 0; i < A->local_rows; i++) {
+        diag[i] = 0.0;
+        for (k = A->row_start[i]; k < A->local_end[i]; k++)
+            if (A->col_index[k] == i)
+                diag[i] = A->values[k];
+    }
+}  /* Get_diagonal */
+
+
+/*===================================================================*/
+void Free_dist_csr(DIST_CSR_T** A_ptr) {
+    DIST_CSR_T*	A = *A_ptr;
+    int		q;
+
+    if (A->requests != (MPI_Request*) NULL)
+        for (q = 0; q < A->recv_procs + A->send_procs; q++)
+            MPI_Request_free(&(A->requests[q]));
+    free(A->requests);
+    free(A->row_start);
+    free(A->local_end);
+    free(A->col_index);
+    free(A->values);
+    free(A->ghost_global);
+    free(A->recv_ranks);
+    free(A->recv_offsets);
+    free(A->send_offsets);
+    free(A->send_index);
+    free(A->send_buffer);
+    free(A->ghost_values);
+    free(A);
+    *A_ptr = (DIST_CSR_T*) NULL;
+}  /* Free_dist_csr */
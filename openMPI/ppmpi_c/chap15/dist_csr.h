@@ -0,0 +1,68 @@
+/* dist_csr.h -- header file for dist_csr.c -- declarations and
+ *     definitions for a sparse matrix that's distributed by block
+ *     rows and stored in compressed sparse row (CSR) format.
+ */
+#ifndef DIST_CSR_H
+#define DIST_CSR_H
+
+#include "mpi.h"
+#include "block_dist.h"
+
+/* Block row distribution (see block_dist.h):  process q gets rows */
+/*     Block_low(q,p,n), ..., Block_high(q,p,n).  Vectors are       */
+/*     distributed the same way.                                    */
+
+/*===================================================================
+ *
+ * Before Setup_spmv, col_index holds global column indices.  After,
+ * it holds indices into a local copy of x:  0, ..., local_rows-1 for
+ * my entries of x, and local_rows, ..., local_rows+ghost_count-1 for
+ * the ghost entries, which belong to other processes.  The entries
+ * in each row are ordered so that the ones with local columns come
+ * first.
+ */
+typedef struct {
+    int		n;             /* Order of the matrix             */
+    int		first_row;     /* Global index of my first row    */
+    int		local_rows;
+    int*	row_start;     /* local_rows + 1 entries          */
+    int*	col_index;
+    double*	values;
+    int*	local_end;     /* Entries row_start[i], ...,      */
+                               /*     local_end[i]-1 of row i     */
+                               /*     have local columns          */
+
+    /* Communication plan for the ghost entries, built once */
+    int		ghost_count;
+    int*	ghost_global;  /* Global indices of ghosts, sorted */
+    int		recv_procs;    /* Number of processes I get from   */
+    int*	recv_ranks;
+    int*	recv_offsets;  /* recv_procs + 1 entries, offsets  */
+                               /*     into the ghosts              */
+    int		send_procs;    /* Number of processes I send to    */
+    int*	send_ranks;
+    int*	send_offsets;  /* send_procs + 1 entries           */
+    int*	send_index;    /* Local indices of entries to send */
+    double*	send_buffer;
+    double*	ghost_values;  /* Received entries of x            */
+    MPI_Request* requests;     /* Persistent:  receives, then sends */
+    MPI_Comm	comm;
+} DIST_CSR_T;
+
+/* Allocate an empty matrix with my block of rows, and room for */
+/*     nonzeros entries                                          */
+DIST_CSR_T* Allocate_dist_csr(int n, int nonzeros, MPI_Comm comm);
+
+/* Build the communication plan.  Collective.  Returns 0 if    */
+/*     successful, negative if malloc fails.                   */
+int  Setup_spmv(DIST_CSR_T* A);
+
+/* y = A*x.  Collective. */
+void Spmv(DIST_CSR_T* A, double* x, double* y);
+
+/* Store the diagonal entries in diag */
+void Get_diagonal(DIST_CSR_T* A, double* diag);
+
+void Free_dist_csr(DIST_CSR_T** A_ptr);
+
+#endif
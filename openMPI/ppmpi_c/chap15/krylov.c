@@ -0,0 +1,487 @@
+/* krylov.c
+ *
+ *   Preconditioned conjugate gradient and restarted GMRES for a
+ *   sparse matrix distributed by block rows (see dist_csr.c).
+ *
+ *   The dot products in both solvers are started with
+ *   MPI_Iallreduce, and the reduction overlaps a preconditioner
+ *   application and a matrix-vector product.
+ *
+ *   CG:
+ *      The pipelined CG of Ghysels and Vanroose, "Hiding global
+ *      synchronization latency in the preconditioned Conjugate
+ *      Gradient algorithm," Parallel Computing, 2014.  The three dot
+ *      products of an iteration are combined into one reduction, and
+ *      m = M^{-1} w and n = A m are computed while it's in flight.
+ *      The price is four extra vectors and updates.
+ *
+ *   GMRES:
+ *      Right preconditioned, with classical Gram-Schmidt, so all the
+ *      dot products for column j of the Hessenberg matrix, and
+ *      ||w_j||^2, go in one reduction.  Writing A' = A M^{-1}, we
+ *      keep w_i = A' v_i for each basis vector.  Since
+ *
+ *          v_{j+1} = (w_j - sum_i h_ij v_i)/h_{j+1,j},
+ *
+ *      w_{j+1} = (A' w_j - sum_i h_ij w_i)/h_{j+1,j}, so A' w_j can
+ *      be computed while the reduction is in flight, and h_{j+1,j}
+ *      comes from ||w_j||^2 - sum_i h_ij^2.  When that subtraction
+ *      loses too much, h_{j+1,j} is computed with a second reduction
+ *      and w_{j+1} with another product.  Rounding errors in w_{j+1}
+ *      can accumulate, so each restart computes the true residual.
+ *
+ *   Preconditioners:
+ *      Jacobi, and block Jacobi with one block per process, using
+ *      an incomplete LU factorization with no fill (ILU(0)) of the
+ *      block.
+ *
+ *   See Chap 15, pp. 350 & ff, in PPMPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "mpi.h"
+#include "krylov.h"
+
+/* Below this fraction of ||w_j||^2, compute h_{j+1,j} directly */
+#define CANCELLATION 1.0e-2
+
+static double Dot(int n, double* x, double* y);
+static void   Sort_row(int* col_index, double* values, int count);
+static double** Allocate_vectors(int count, int n);
+static void   Free_vectors(double** vectors);
+
+/*===================================================================*/
+static double Dot(int n, double* x, double* y) {
+    double sum = 0.0;
+    int    i;
+
+    for (i = 0; i < n; i++)
+        sum += x[i]*y[i];
+    return sum;
+}  /* Dot */
+
+
+/*===================================================================
+ *
+ * count vectors of n doubles in one block.  Returns NULL if malloc
+ * fails.
+ */
+static double** Allocate_vectors(int count, int n) {
+    double** vectors;
+    int      i;
+
+    vectors = (double**) malloc(count*sizeof(double*));
+    if (vectors == (double**) NULL) return vectors;
+    vectors[0] = (double*) calloc(count*n + 1, sizeof(double));
+    if (vectors[0] == (double*) NULL) {
+        free(vectors);
+        return (double**) NULL;
+    }
+    for (i = 1; i < count; i++)
+        vectors[i] = vectors[0] + i*n;
+    return vectors;
+}  /* Allocate_vectors */
+
+
+/*===================================================================*/
+static void Free_vectors(double** vectors) {
+    free(vectors[0]);
+    free(vectors);
+}  /* Free_vectors */
+
+
+/*===================================================================
+ *
+ * Insertion sort of a row by column
+ */
+static void Sort_row(int* col_index, double* values, int count) {
+    int    i, j, col;
+    double value;
+
+    for (i = 1; i < count; i++) {
+        col = col_index[i];
+        value = values[i];
+        for (j = i - 1; (j >= 0) && (col_index[j] > col); j--) {
+            col_index[j+1] = col_index[j];
+            values[j+1] = values[j];
+        }
+        col_index[j+1] = col;
+        values[j+1] = value;
+    }
+}  /* Sort_row */
+
+
+/*===================================================================*/
+int Setup_precond(DIST_CSR_T* A, int type, PRECOND_T* M) {
+    int		n = A->local_rows;
+    int		i, k, kk, j, jj;
+    int		count;
+    double	l;
+
+    M->type = type;
+    M->local_rows = n;
+    M->inv_diag = (double*) NULL;
+    M->row_start = M->col_index = M->diag_pos = (int*) NULL;
+    M->values = (double*) NULL;
+
+    if (type == PC_JACOBI) {
+        M->inv_diag = (double*) malloc((n + 1)*sizeof(double));
+        if (M->inv_diag == (double*) NULL) return -1;
+        Get_diagonal(A, M->inv_diag);
+        for (i = 0; i < n; i++) {
+            if (M->inv_diag[i] == 0.0) return -2;
+            M->inv_diag[i] = 1.0/M->inv_diag[i];
+        }
+    } else if (type == PC_BJACOBI) {
+        /* Copy the diagonal block */
+        count = 0;
+        for (i = 0; i < n; i++)
+            count += A->local_end[i] - A->row_start[i];
+        M->row_start = (int*) malloc((n + 1)*sizeof(int));
+        M->diag_pos = (int*) malloc((n + 1)*sizeof(int));
+        M->col_index = (int*) malloc((count + 1)*sizeof(int));
+        M->values = (double*) malloc((count + 1)*sizeof(double));
+        if ((M->row_start == NULL) || (M->diag_pos == NULL) ||
+                (M->col_index == NULL) || (M->values == NULL))
+            return -1;
+        M->row_start[0] = 0;
+        for (i = 0; i < n; i++) {
+            count = M->row_start[i];
+            for (k = A->row_start[i]; k < A->local_end[i]; k++) {
+                M->col_index[count] = A->col_index[k];
+                M->values[count++] = A->values[k];
+            }
+            M->row_start[i+1] = count;
+            Sort_row(M->col_index + M->row_start[i],
+                M->values + M->row_start[i], count - M->row_start[i]);
+            M->diag_pos[i] = -1;
+            for (k = M->row_start[i]; k < count; k++)
+                if (M->col_index[k] == i) M->diag_pos[i] = k;
+            if (M->diag_pos[i] < 0) return -2;
+        }
+
+        /* ILU(0):  for each row i, eliminate with the rows k < i */
+        /*     that it has entries in, and keep only the updates  */
+        /*     that land on existing entries                      */
+        for (i = 0; i < n; i++)
+            for (k = M->row_start[i]; k < M->diag_pos[i]; k++) {
+                kk = M->col_index[k];
+                if (M->values[M->diag_pos[kk]] == 0.0) return -2;
+                l = M->values[k] /= M->values[M->diag_pos[kk]];
+                j = k + 1;
+                jj = M->diag_pos[kk] + 1;
+                while ((j < M->row_start[i+1]) && (jj < M->row_start[kk+1])) {
+                    if (M->col_index[j] < M->col_index[jj])
+                        j++;
+                    else if (M->col_index[j] > M->col_index[jj])
+                        jj++;
+                    else
+                        M->values[j++] -= l*M->values[jj++];
+                }
+            }
+    }
+    return 0;
+}  /* Setup_precond */
+
+
+/*===================================================================
+ *
+ * z = M^{-1} r
+ */
+void Apply_precond(PRECOND_T* M, double* r, double* z) {
+    int		n = M->local_rows;
+    int		i, k;
+    double	sum;
+
+    if (M->type == PC_JACOBI) {
+        for (i = 0; i < n; i++)
+            z[i] = M->inv_diag[i]*r[i];
+    } else if (M->type == PC_BJACOBI) {
+        /* Solve Ly = r, then Uz = y */
+        for (i = 0; i < n; i++) {
+            sum = r[i];
+            for (k = M->row_start[i]; k < M->diag_pos[i]; k++)
+                sum -= M->values[k]*z[M->col_index[k]];
+            z[i] = sum;
+        }
+        for (i = n - 1; i >= 0; i--) {
+            sum = z[i];
+            for (k = M->diag_pos[i] + 1; k < M->row_start[i+1]; k++)
+                sum -= M->values[k]*z[M->col_index[k]];
+            z[i] = sum/M->values[M->diag_pos[i]];
+        }
+    } else {
+        for (i = 0; i < n; i++)
+            z[i] = r[i];
+    }
+}  /* Apply_precond */
+
+
+/*===================================================================*/
+void Free_precond(PRECOND_T* M) {
+    free(M->inv_diag);
+    free(M->row_start);
+    free(M->col_index);
+    free(M->values);
+    free(M->diag_pos);
+}  /* Free_precond */
+
+
+/*===================================================================
+ *
+ * Pipelined preconditioned CG.  A and M must be symmetric positive
+ * definite.
+ */
+int Cg(DIST_CSR_T* A, PRECOND_T* M, double* b, double* x,
+         double rtol, int max_its, int monitor, double* res_norm_ptr) {
+    int		n = A->local_rows;
+    int		my_rank;
+    double**	vectors;
+    double	*r, *u, *w, *m, *nn, *p, *s, *q, *z;
+    double	local[3], global[3];
+    double	gamma, delta, gamma_old = 1.0;
+    double	alpha, alpha_old = 1.0, beta;
+    double	b_norm, res_norm;
+    MPI_Request	request;
+    int		its, i;
+
+    MPI_Comm_rank(A->comm, &my_rank);
+    vectors = Allocate_vectors(9, n);
+    if (vectors == (double**) NULL) return -1;
+    r = vectors[0]; u = vectors[1]; w = vectors[2];
+    m = vectors[3]; nn = vectors[4]; p = vectors[5];
+    s = vectors[6]; q = vectors[7]; z = vectors[8];
+
+    local[0] = Dot(n, b, b);
+    MPI_Allreduce(local, global, 1, MPI_DOUBLE, MPI_SUM, A->comm);
+    b_norm = sqrt(global[0]);
+
+    /* r = b - Ax, u = M^{-1} r, w = Au */
+    Spmv(A, x, r);
+    for (i = 0; i < n; i++)
+        r[i] = b[i] - r[i];
+    Apply_precond(M, r, u);
+    Spmv(A, u, w);
+
+    for (its = 0; ; its++) {
+        local[0] = Dot(n, r, u);
+        local[1] = Dot(n, w, u);
+        local[2] = Dot(n, r, r);
+        MPI_Iallreduce(local, global, 3, MPI_DOUBLE, MPI_SUM, A->comm,
+            &request);
+
+        /* Overlaps the reduction */
+        Apply_precond(M, w, m);
+        Spmv(A, m, nn);
+
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+        gamma = global[0];
+        delta = global[1];
+        res_norm = sqrt(global[2]);
+        if (monitor && (my_rank == 0))
+            printf("%d KSP Residual norm %e\n", its, res_norm);
+        if ((res_norm <= rtol*b_norm) || (its >= max_its) ||
+                (gamma == 0.0))
+            break;
+
+        if (its > 0) {
+            beta = gamma/gamma_old;
+            alpha = gamma/(delta - beta*gamma/alpha_old);
+        } else {
+            beta = 0.0;
+            alpha = gamma/delta;
+        }
+        for (i = 0; i < n; i++) {
+            z[i] = nn[i] + beta*z[i];
+            q[i] = m[i] + beta*q[i];
+            s[i] = w[i] + beta*s[i];
+            p[i] = u[i] + beta*p[i];
+            x[i] += alpha*p[i];
+            r[i] -= alpha*s[i];
+            u[i] -= alpha*q[i];
+            w[i] -= alpha*z[i];
+        }
+        gamma_old = gamma;
+        alpha_old = alpha;
+    }
+
+    Free_vectors(vectors);
+    *res_norm_ptr = res_norm;
+    return its;
+}  /* Cg */
+
+
+/*===================================================================
+ *
+ * Restarted, right preconditioned GMRES.  See the notes at the top
+ * of the file.
+ */
+int Gmres(DIST_CSR_T* A, PRECOND_T* M, double* b, double* x,
+         int restart, double rtol, int max_its, int monitor,
+         double* res_norm_ptr) {
+    int		n = A->local_rows;
+    int		my_rank;
+    double**	V;      /* Orthonormal basis             */
+    double**	W;      /* W[i] = A M^{-1} V[i]          */
+    double*	t;      /* M^{-1} of something           */
+    double*	y;      /* A M^{-1} W[j]                 */
+    double*	H;      /* (restart+1) x restart, by rows */
+    double*	cs;     /* Givens rotations              */
+    double*	sn;
+    double*	g;      /* Rotated residual              */
+    double*	local;
+    double*	global;
+    double	b_norm, res_norm, beta;
+    double	nu, nu2, temp;
+    MPI_Request	request;
+    int		its = 0;
+    int		i, j, k;
+    int		direct;
+
+#   define h(i,j) H[(i)*restart + (j)]
+
+    MPI_Comm_rank(A->comm, &my_rank);
+    if (restart < 1) restart = RESTART;
+    V = Allocate_vectors(restart + 1, n);
+    W = Allocate_vectors(restart + 3, n);
+    H = (double*) calloc((restart + 1)*restart, sizeof(double));
+    local = (double*) malloc(4*(restart + 2)*sizeof(double));
+    if ((V == NULL) || (W == NULL) || (H == NULL) || (local == NULL))
+        return -1;
+    t = W[restart + 1];
+    y = W[restart + 2];
+    global = local + restart + 2;
+    cs = global + restart + 2;
+    sn = cs + restart + 1;
+    g = (double*) malloc((restart + 1)*sizeof(double));
+    if (g == (double*) NULL) return -1;
+
+    local[0] = Dot(n, b, b);
+    MPI_Allreduce(local, global, 1, MPI_DOUBLE, MPI_SUM, A->comm);
+    b_norm = sqrt(global[0]);
+
+    while (1) {
+        /* V[0] = b - Ax */
+        Spmv(A, x, V[0]);
+        for (i = 0; i < n; i++)
+            V[0][i] = b[i] - V[0][i];
+        local[0] = Dot(n, V[0], V[0]);
+        MPI_Allreduce(local, global, 1, MPI_DOUBLE, MPI_SUM, A->comm);
+        res_norm = beta = sqrt(global[0]);
+        if (monitor && (my_rank == 0))
+            printf("%d KSP Residual norm %e\n", its, res_norm);
+        if ((res_norm <= rtol*b_norm) || (its >= max_its))
+            break;
+
+        for (i = 0; i < n; i++)
+            V[0][i] /= beta;
+        g[0] = beta;
+        Apply_precond(M, V[0], t);
+        Spmv(A, t, W[0]);
+
+        for (j = 0; (j < restart) && (its < max_its); ) {
+            /* h(i,j) = V[i].W[j], and ||W[j]||^2 in one reduction */
+            for (i = 0; i <= j; i++)
+                local[i] = Dot(n, V[i], W[j]);
+            local[j+1] = Dot(n, W[j], W[j]);
+            MPI_Iallreduce(local, global, j + 2, MPI_DOUBLE, MPI_SUM,
+                A->comm, &request);
+
+            /* Overlaps the reduction */
+            if (j + 1 < restart) {
+                Apply_precond(M, W[j], t);
+                Spmv(A, t, y);
+            }
+
+            MPI_Wait(&request, MPI_STATUS_IGNORE);
+            nu2 = global[j+1];
+            for (i = 0; i <= j; i++) {
+                h(i,j) = global[i];
+                nu2 -= global[i]*global[i];
+            }
+
+            /* V[j+1] = W[j] - sum h(i,j) V[i] */
+            for (k = 0; k < n; k++) {
+                temp = W[j][k];
+                for (i = 0; i <= j; i++)
+                    temp -= h(i,j)*V[i][k];
+                V[j+1][k] = temp;
+            }
+            direct = (nu2 <= CANCELLATION*global[j+1]);
+            if (direct) {
+                local[0] = Dot(n, V[j+1], V[j+1]);
+                MPI_Allreduce(local, global, 1, MPI_DOUBLE, MPI_SUM,
+                    A->comm);
+                nu2 = global[0];
+            }
+            nu = sqrt(nu2);
+            h(j+1,j) = nu;
+            if (nu > 0.0) {
+                for (k = 0; k < n; k++)
+                    V[j+1][k] /= nu;
+                if (j + 1 < restart) {
+                    if (direct) {
+                        Apply_precond(M, V[j+1], t);
+                        Spmv(A, t, W[j+1]);
+                    } else {
+                        for (k = 0; k < n; k++) {
+                            temp = y[k];
+                            for (i = 0; i <= j; i++)
+                                temp -= h(i,j)*W[i][k];
+                            W[j+1][k] = temp/nu;
+                        }
+                    }
+                }
+            }
+
+            /* Apply the old rotations to column j, and find a new */
+            /*     one to zero h(j+1,j)                            */
+            for (i = 0; i < j; i++) {
+                temp = cs[i]*h(i,j) + sn[i]*h(i+1,j);
+                h(i+1,j) = -sn[i]*h(i,j) + cs[i]*h(i+1,j);
+                h(i,j) = temp;
+            }
+            temp = sqrt(h(j,j)*h(j,j) + h(j+1,j)*h(j+1,j));
+            cs[j] = h(j,j)/temp;
+            sn[j] = h(j+1,j)/temp;
+            h(j,j) = temp;
+            h(j+1,j) = 0.0;
+            g[j+1] = -sn[j]*g[j];
+            g[j] = cs[j]*g[j];
+
+            j++;
+            its++;
+            res_norm = fabs(g[j]);
+            if (monitor && (my_rank == 0))
+                printf("%d KSP Residual norm %e\n", its, res_norm);
+            if ((res_norm <= rtol*b_norm) || (nu == 0.0))
+                break;
+        }
+
+        /* Solve Hz = g, and x = x + M^{-1} V z.  z overwrites g. */
+        for (i = j - 1; i >= 0; i--) {
+            for (k = i + 1; k < j; k++)
+                g[i] -= h(i,k)*g[k];
+            g[i] /= h(i,i);
+        }
+        for (k = 0; k < n; k++) {
+            temp = 0.0;
+            for (i = 0; i < j; i++)
+                temp += g[i]*V[i][k];
+            y[k] = temp;
+        }
+        Apply_precond(M, y, t);
+        for (k = 0; k < n; k++)
+            x[k] += t[k];
+    }
+
+#   undef h
+    Free_vectors(V);
+    Free_vectors(W);
+    free(H);
+    free(local);
+    free(g);
+    *res_norm_ptr = res_norm;
+    return its;
+}  /* Gmres */
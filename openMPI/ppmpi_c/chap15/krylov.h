@@ -0,0 +1,47 @@
+/* krylov.h -- header file for krylov.c -- declarations and
+ *     definitions for the preconditioned conjugate gradient and
+ *     restarted GMRES solvers.
+ */
+#ifndef KRYLOV_H
+#define KRYLOV_H
+
+#include "dist_csr.h"
+
+/* Solvers */
+#define KSP_CG     0
+#define KSP_GMRES  1
+
+/* Preconditioners */
+#define PC_NONE     0
+#define PC_JACOBI   1
+#define PC_BJACOBI  2   /* ILU(0) of each process's diagonal block */
+
+/* Default GMRES restart */
+#define RESTART  30
+
+typedef struct {
+    int		type;
+    int		local_rows;
+    double*	inv_diag;      /* Jacobi                          */
+    int*	row_start;     /* Block Jacobi:  L and U, with the */
+    int*	col_index;     /*     unit diagonal of L omitted,  */
+    double*	values;        /*     in CSR format, and the       */
+    int*	diag_pos;      /*     columns of each row sorted   */
+} PRECOND_T;
+
+/* Returns 0 if successful, negative if malloc fails or there's */
+/*     a zero pivot.  Must be called after Setup_spmv.           */
+int  Setup_precond(DIST_CSR_T* A, int type, PRECOND_T* M);
+void Apply_precond(PRECOND_T* M, double* r, double* z);
+void Free_precond(PRECOND_T* M);
+
+/* Both return the number of iterations, and the 2-norm of the   */
+/*     final residual in *res_norm_ptr.  x holds the initial     */
+/*     guess on input.  monitor != 0 prints the residual norms.  */
+int  Cg(DIST_CSR_T* A, PRECOND_T* M, double* b, double* x,
+         double rtol, int max_its, int monitor, double* res_norm_ptr);
+int  Gmres(DIST_CSR_T* A, PRECOND_T* M, double* b, double* x,
+         int restart, double rtol, int max_its, int monitor,
+         double* res_norm_ptr);
+
+#endif
@@ -1,6 +1,6 @@
 /* sparse_linsolve.c
  *
- * Uses iterative methods in PETSc to solve a random 
+ * Uses iterative methods to solve a random 
  * sparse linear system Ax = b.
  *
  * Input:
@@ -15,7 +15,7 @@
  *        distributed among the processes.
  *
  * Output:
- *    Information from PETSc:  solver, tolerances,
+ *    Information on the solver:  solver, tolerances,
  *        type of preconditioning, and storage 
  *        information for the coefficient matrix 
  *    error:  2-norm of error in solution
@@ -23,98 +23,83 @@
  *        solver terminated
  *
  * To compile:
- *    See PETSc makefile.
+ *    See Makefile.sparse
  *
  * To run:
- *    mpirun -np p linsolve [petsc options]
+ *    mpirun -np p sparse_linsolve [options]
  *
- * Petsc Options:
+ * Options:
  *    Can specify solver and preconditioner.  Options have 
  *    the form
  *        -option_name option_value
- *    Some valid option names and values follow.
+ *    The valid option names and values follow.
  *        1.  ksp_method:  the Krylov Subspace method used 
- *            by the solver.  Possible values:  richardson, 
- *            chebychev, cg, gmres, tcqmr, bcgs, cgs, 
- *            tfqmr, cr, lsqr, preonly.
+ *            by the solver.  Possible values:  cg, gmres.
+ *            Default gmres.
  *        2.  ksp_rtol:  decrease in residual norm relative
- *            to size of initial residual for convergence.
- *            Values are doubles.
- *        3.  ksp_atol:  absolute size of the residual norm
- *            for convergence.  Values are doubles.
- *        4.  ksp_max_it:  maximum number of iterations
+ *            to size of b for convergence.  Values are
+ *            doubles.  Default 1.0e-5.
+ *        3.  ksp_max_it:  maximum number of iterations
  *            before terminating solve.  Values are ints. 
+ *            Default 10000.
+ *        4.  ksp_gmres_restart:  number of iterations
+ *            between restarts of gmres.  Values are ints.
+ *            Default 30.
  *        5.  ksp_monitor: display residual norms. 
  *            (No value.)
  *        6.  pc_method:  the preconditioning method.
- *            Some values are none, jacobi, bjacobi, sor,
- *            icc, ilu, lu.  (lu simply uses LU 
- *            factorization to solve the system.  This is
- *            only available when run with one process.)
- *        7.  pc_sor_omega:  the relaxation factor
- *            for sor.  Value is a double.
- *        8.  pc_sor_its:  the number of inner iterations
- *            to use in the sor.  Value is an int.
- *        9.  pc_bjacobi_blocks:  the number of blocks to
- *            to use in block jacobi.  Value is an int.
+ *            Values are none, jacobi, bjacobi.  bjacobi
+ *            uses one block per process, and solves it
+ *            approximately with ILU(0).  Default bjacobi.
  *
  * Algorithm:
- *    1.  Initialize MPI and PETSc.
- *    2.  Build derived datatype for input data.
- *    3a. Process 0 read and broadcast input data.
- *    3b. Processes != 0 receive input data.
- *    4.  if (initial_dist == 0)
- *            process 0 initializes the matrix
+ *    1.  Initialize MPI.
+ *    2.  Get the options.
+ *    3.  Build derived datatype for input data.
+ *    4a. Process 0 read and broadcast input data.
+ *    4b. Processes != 0 receive input data.
+ *    5.  if (initial_dist == 0)
+ *            process 0 initializes the matrix, and
+ *            scatters the rows
  *        else
  *            each process initializes its rows
- *    5.  All processes begin nonblocking distribution of 
- *        coefficient matrix using MatAssemblyBegin.
- *    6.  Use VecCreate and VecDuplicate to create 
- *        vectors b, x, and exact.
- *    7.  Set entries in exact to 1 using VecSet.
- *    8.  Complete distribution of matrix with
- *        MatAssemblyEnd.
- *    9.  Use MatMult to set rhs b = A*exact.
- *    10. Create solver context using SLESCreate.
- *    11. Associate matrix and preconditioning matrix
- *        with solver using SLESSetOperators.
- *    12. Get command line options specifying solver
- *        options such as type of solver and type of
- *        preconditioning.  Use SLESSetFromOptions.
- *    13  Solve the system with SLESSolve.
- *    14. Print information on solver and matrix
- *        using SLESView.
- *    15. Compute norm of error, ||x - exact||_2, using
- *        VecAXPY and VecNorm.
- *    16. Print error norm and number of iterations
- *        using MPIU_printf.
- *    17. Free storage used by PETSc.
- *    18. Shut down PETSc and MPI.
+ *    6.  Build the communication plan for matrix-vector
+ *        multiplication with Setup_spmv.
+ *    7.  Set entries in exact to 1.
+ *    8.  Use Spmv to set rhs b = A*exact.
+ *    9.  Set up the preconditioner.
+ *    10. Solve the system with Cg or Gmres.
+ *    11. Print information on solver and matrix.
+ *    12. Compute norm of error, ||x - exact||_2.
+ *    13. Print error norm and number of iterations.
+ *    14. Free storage and shut down MPI.
  *
  * Notes:
- *    1.  Our PETSc matrices and vectors are distributed 
- *        by block panels.
- *    2.  It is not necessary to initialize A on process 0:
- *        any entries can be inserted on any process; 
- *        MatAssemblyBegin/End will correctly distribute
- *        them among the processes.
- *    3.  Solver context consists of such things as a
- *        communicator for solver communication and data
- *        structures needed for solver operations such
- *        as matrix-vector multiply.
- *    4.  PETSc provides an extensive error-handling and
- *        traceback facility which we have not illustrated
- *        in this example to make source more readable.
+ *    1.  Our matrices and vectors are distributed 
+ *        by block panels.  See dist_csr.h.
+ *    2.  The entries of the matrix are functions of their
+ *        row and column, so the matrix doesn't depend
+ *        on p or initial_dist.
+ *    3.  CG needs a symmetric positive definite matrix,
+ *        so with -ksp_method cg, A(j,i) = A(i,j).  If
+ *        diagonal is large enough, A is then positive
+ *        definite.
+ *    4.  The original version of this program used
+ *        PETSc's SLES solvers.
  *
  * See Chap 15, pp. 350 & ff, in PPMPI.
  */
 #include <stdio.h>
-#include <stdlib.h> /* Needed for drand48 and srand48 */
-#include "sles.h"   /* Includes headers needed by PETSc */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include "mpi.h"
+#include "dist_csr.h"
+#include "krylov.h"
 
-/* Required in all PETSc programs */
-static char help[] = "Solve a random sparse linear system";
+void Get_options(int argc, char* argv[], int* ksp_type_ptr,
+               int* pc_type_ptr, double* rtol_ptr, int* max_its_ptr,
+               int* restart_ptr, int* monitor_ptr);
 
 void Get_input(int my_rank, int* n_ptr, 
                double* diagonal_ptr, double* prob_ptr,
@@ -124,18 +109,25 @@ void Build_input_datatype(MPI_Datatype* input_datatype_ptr,
     int* n_ptr, double* diagonal_ptr, double* prob_ptr,
     int* initial_dist_ptr);
 
-void Initialize_matrix(int my_rank, Mat A, int n,
+DIST_CSR_T* Initialize_matrix(int my_rank, int p, int n,
                        double diagonal, double prob,
-                       int initial_dist);
+                       int initial_dist, int symmetric);
+
+int Generate_row(int i, int n, double diagonal, double prob,
+                 int symmetric, int* columns, double* temp_row);
+
+double Uniform(int i, int j, int which);
 
 void Allocate(int my_rank, char* name, void* list, 
               int size, int datatype);
 
+void Allocate_failed(int my_rank, char* name);
+
 /*======================================================*/
 int main(int argc,char **argv) {
-    Vec       x;             /* computed solution       */
-    Vec       b;             /* right-hand side         */
-    Vec       exact;         /* exact solution          */
+    double*   x;             /* computed solution       */
+    double*   b;             /* right-hand side         */
+    double*   exact;         /* exact solution          */
     int       p;
     int       my_rank;
     int       n;             /* order of system         */
@@ -145,96 +137,162 @@ int main(int argc,char **argv) {
     int       initial_dist;  /* =0 matrix initialized   */
                              /* on process 0. =1 dist-  */
                              /* tributed initialization */
-    Mat       A;             /* coefficient matrix      */
-    double    one = 1.0;
-    double    minus_one = -1.0;
-    SLES      sles;          /* context for solver      */
+    DIST_CSR_T* A;           /* coefficient matrix      */
+    PRECOND_T M;             /* preconditioner          */
+    int       ksp_type;
+    int       pc_type;
+    double    rtol;
+    int       max_its;
+    int       restart;
+    int       monitor;
     int       iterations;    /* number of iterations    */
                              /* used by solver          */
+    double    res_norm;
     double    error;         /* 2-norm of error in sol- */
                              /* ution                   */
+    double    local[2], global[2];
+    double    start_time, elapsed_time;
+    int       i;
+    static char* ksp_names[] = {"cg", "gmres"};
+    static char* pc_names[] = {"none", "jacobi", "bjacobi"};
 
     MPI_Init(&argc, &argv);
-    PetscInitialize(&argc,&argv,0,0,help);
 
     MPI_Comm_rank(MPI_COMM_WORLD,&my_rank);
     MPI_Comm_size(MPI_COMM_WORLD,&p);  
 
+    Get_options(argc, argv, &ksp_type, &pc_type, &rtol, &max_its,
+        &restart, &monitor);
     Get_input(my_rank, &n, &diagonal, &prob, &initial_dist);
 
-    MatCreate(MPI_COMM_WORLD, n, n, &A);
-
-    Initialize_matrix(my_rank, A, n, diagonal, prob,
-                      initial_dist);
-
-    MatAssemblyBegin(A, FINAL_ASSEMBLY);
+    A = Initialize_matrix(my_rank, p, n, diagonal, prob,
+                      initial_dist, ksp_type == KSP_CG);
+    if (Setup_spmv(A) < 0) {
+        fprintf(stderr, "Process %d > Setup_spmv failed!\n", my_rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
     
     /* Create and set vectors */
-    VecCreate(MPI_COMM_WORLD,n,&x);
-    VecDuplicate(x, &exact);
-    VecDuplicate(x, &b);
-    VecSet(&one, exact);
-
-    MatAssemblyEnd(A, FINAL_ASSEMBLY);
-
-    MatMult(A, exact, b);
-
-    /* Set up solver context */
-    SLESCreate(MPI_COMM_WORLD, &sles);
+    Allocate(my_rank, "x", &x, A->local_rows + 1, 1);
+    Allocate(my_rank, "b", &b, A->local_rows + 1, 1);
+    Allocate(my_rank, "exact", &exact, A->local_rows + 1, 1);
+    for (i = 0; i < A->local_rows; i++) {
+        exact[i] = 1.0;
+        x[i] = 0.0;
+    }
 
-    /* Identify coefficient matrix and preconditioning */
-    /* matrix                                          */
-    SLESSetOperators(sles, A, A, 0);
+    Spmv(A, exact, b);
 
-    /* Use solver and preconditioner specified */
-    /* by command line options                 */
-    SLESSetFromOptions(sles);
+    if (Setup_precond(A, pc_type, &M) < 0) {
+        fprintf(stderr, "Process %d > Setup_precond failed!\n", my_rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
 
     /* Now solve the system */
-    SLESSolve(sles, b, x, &iterations);
+    MPI_Barrier(MPI_COMM_WORLD);
+    start_time = MPI_Wtime();
+    if (ksp_type == KSP_CG)
+        iterations = Cg(A, &M, b, x, rtol, max_its, monitor, &res_norm);
+    else
+        iterations = Gmres(A, &M, b, x, restart, rtol, max_its,
+            monitor, &res_norm);
+    elapsed_time = MPI_Wtime() - start_time;
+    if (iterations < 0) {
+        fprintf(stderr, "Process %d > Solver failed!\n", my_rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
 
 #ifdef DEBUG
-    VecView(x, STDOUT_VIEWER_WORLD);
-    MatView(A, STDOUT_VIEWER_WORLD);
+    for (i = 0; i < A->local_rows; i++)
+        printf("Process %d > x[%d] = %g\n", my_rank,
+            A->first_row + i, x[i]);
 #endif
 
-    SLESView(sles, STDOUT_VIEWER_WORLD);
-
-    /* Check solution */
-    VecAXPY(&minus_one, exact, x);
-    VecNorm(x, NORM_2, &error);
-    if (error >= 1.0e-12)
-        MPIU_printf(MPI_COMM_WORLD, 
-            "Norm of error %g, Iterations %d\n",
-            error, iterations);
-    else
-        MPIU_printf(MPI_COMM_WORLD, 
-            "Norm of error < 1.0e-12, Iterations %d\n",
-            iterations);
-
-    /* Pause before quitting */
-    {
-        int anything;
-        if (my_rank == 0) {
-            printf("Enter a number to continue\n");
-            scanf("%d",&anything);
-        }
-        MPI_Bcast(&anything, 1, MPI_INT, 0, MPI_COMM_WORLD);
-        printf("Process %d > anything = %d\n", my_rank, anything);
+    /* Check solution, and count nonzeros */
+    local[0] = 0.0;
+    for (i = 0; i < A->local_rows; i++)
+        local[0] += (x[i] - exact[i])*(x[i] - exact[i]);
+    local[1] = A->row_start[A->local_rows];
+    MPI_Reduce(local, global, 2, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    if (my_rank == 0) {
+        printf("KSP method: %s", ksp_names[ksp_type]);
+        if (ksp_type == KSP_GMRES)
+            printf(", restart = %d", restart);
+        printf("\n    rtol = %g, max_it = %d\n", rtol, max_its);
+        printf("PC method: %s\n", pc_names[pc_type]);
+        printf("Matrix: n = %d, nonzeros = %.0f, p = %d\n",
+            n, global[1], p);
+        error = sqrt(global[0]);
+        if (error >= 1.0e-12)
+            printf("Norm of error %g, Iterations %d\n",
+                error, iterations);
+        else
+            printf("Norm of error < 1.0e-12, Iterations %d\n",
+                iterations);
+        printf("Residual norm %g\n", res_norm);
+        printf("Elapsed time for solve = %g milliseconds\n",
+            1000.0*elapsed_time);
     }
 
     /* Free work space */
-    VecDestroy(x); 
-    VecDestroy(exact);
-    VecDestroy(b);
-    MatDestroy(A);
-    SLESDestroy(sles);
+    free(x); 
+    free(exact);
+    free(b);
+    Free_precond(&M);
+    Free_dist_csr(&A);
 
-    PetscFinalize();
     MPI_Finalize();
+    return 0;
 }  /* main */
 
 
+/*========================================================
+ *
+ * Parse the solver options.  Every process gets the
+ * command line.
+ */
+void Get_options(int argc, char* argv[], int* ksp_type_ptr,
+               int* pc_type_ptr, double* rtol_ptr, int* max_its_ptr,
+               int* restart_ptr, int* monitor_ptr) {
+    int i;
+
+    *ksp_type_ptr = KSP_GMRES;
+    *pc_type_ptr = PC_BJACOBI;
+    *rtol_ptr = 1.0e-5;
+    *max_its_ptr = 10000;
+    *restart_ptr = RESTART;
+    *monitor_ptr = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-ksp_monitor") == 0) {
+            *monitor_ptr = 1;
+        } else if (i + 1 < argc) {
+            if (strcmp(argv[i], "-ksp_method") == 0) {
+                if (strcmp(argv[++i], "cg") == 0)
+                    *ksp_type_ptr = KSP_CG;
+                else
+                    *ksp_type_ptr = KSP_GMRES;
+            } else if (strcmp(argv[i], "-pc_method") == 0) {
+                i++;
+                if (strcmp(argv[i], "none") == 0)
+                    *pc_type_ptr = PC_NONE;
+                else if (strcmp(argv[i], "jacobi") == 0)
+                    *pc_type_ptr = PC_JACOBI;
+                else
+                    *pc_type_ptr = PC_BJACOBI;
+            } else if (strcmp(argv[i], "-ksp_rtol") == 0) {
+                *rtol_ptr = atof(argv[++i]);
+            } else if (strcmp(argv[i], "-ksp_max_it") == 0) {
+                *max_its_ptr = atoi(argv[++i]);
+            } else if (strcmp(argv[i], "-ksp_gmres_restart") == 0) {
+                *restart_ptr = atoi(argv[++i]);
+            }
+        }
+    }
+}  /* Get_options */
+
+
 /*========================================================
  *
  * Process 0 read and broadcast input data
@@ -282,20 +340,19 @@ void Build_input_datatype(MPI_Datatype* input_datatype_ptr,
  
     /* Compute displacements from n */
     array_of_displacements[0] = 0; 
-    MPI_Address(n_ptr, &base_address);
-    MPI_Address(diagonal_ptr, &temp_address);
+    MPI_Get_address(n_ptr, &base_address);
+    MPI_Get_address(diagonal_ptr, &temp_address);
     array_of_displacements[1] = 
         temp_address - base_address;
-    MPI_Address(prob_ptr, &temp_address);
+    MPI_Get_address(prob_ptr, &temp_address);
     array_of_displacements[2] = 
         temp_address - base_address;
-    MPI_Address(initial_dist_ptr, &temp_address);
+    MPI_Get_address(initial_dist_ptr, &temp_address);
     array_of_displacements[3] = 
         temp_address - base_address;
 
-    MPI_Type_struct(4, array_of_block_lengths, 
-        array_of_displacements, array_of_types, 
-        input_datatype_ptr);
+    MPI_Type_create_struct(4, array_of_block_lengths,
+        array_of_displacements, array_of_types, input_datatype_ptr);
     MPI_Type_commit(input_datatype_ptr);
 
 }  /* Build_input_datatype */
@@ -307,60 +364,171 @@ void Build_input_datatype(MPI_Datatype* input_datatype_ptr,
  *    get value in diagonal.  Off-diagonals get zero
  *    or a random value in the range (-1,1).
  *    initial_dist = 0: entire matrix initialized by 
- *        process 0.
+ *        process 0, and the rows are scattered.
  *    initial_dist = 1: each processes initializes its
  *        rows.
  */
-void Initialize_matrix(int my_rank, Mat A, int n, 
+DIST_CSR_T* Initialize_matrix(int my_rank, int p, int n, 
                   double diagonal, double prob,
-                  int initial_dist) {
-    int*      columns;  /* temporary storage for col */
-    double*   temp_row; /* indices and row entries   */
+                  int initial_dist, int symmetric) {
+    DIST_CSR_T* A;
+    int*      columns = NULL;   /* CSR storage for the     */
+    double*   entries = NULL;   /* whole matrix on process */
+    int*      row_counts = NULL;/* 0, if initial_dist = 0  */
+    int*      counts = NULL;
+    int*      displs = NULL;
     int       nonzero_count;
     int       my_min_row;
     int       my_max_row;
-    int       i, j;
+    int       i, q;
 
     if (initial_dist == 0) { 
         if (my_rank == 0) {
             my_min_row = 0;
             my_max_row = n;
         } else {
-            return;
+            my_min_row = my_max_row = 0;
         }
     } else {
-        MatGetOwnershipRange(A, &my_min_row, &my_max_row);
+        my_min_row = Block_low(my_rank, p, n);
+        my_max_row = Block_low(my_rank + 1, p, n);
     }
     printf("Process %d: my_min_row = %d, my_max_row = %d\n",
            my_rank, my_min_row, my_max_row);
     fflush(stdout);
-        
-    /* Allocate temporary storage */
-    Allocate(my_rank, "columns", &columns, n, 0);
-    Allocate(my_rank, "temp_row", &temp_row, n, 1);
-
-    /* Seed random number generator */
-    srand48((long) (my_rank*my_rank));
-    for (i = my_min_row; i < my_max_row; i++) {
+
+    /* Count, then generate */
+    nonzero_count = 0;
+    for (i = my_min_row; i < my_max_row; i++)
+        nonzero_count += Generate_row(i, n, diagonal, prob, symmetric,
+            (int*) NULL, (double*) NULL);
+
+    if (initial_dist != 0) {
+        A = Allocate_dist_csr(n, nonzero_count, MPI_COMM_WORLD);
+        if (A == (DIST_CSR_T*) NULL)
+            Allocate_failed(my_rank, "A");
+        for (i = 0; i < A->local_rows; i++)
+            A->row_start[i+1] = A->row_start[i] +
+                Generate_row(A->first_row + i, n, diagonal, prob,
+                    symmetric, A->col_index + A->row_start[i],
+                    A->values + A->row_start[i]);
+        return A;
+    }
+
+    /* Process 0 generates the whole matrix */
+    Allocate(my_rank, "counts", &counts, 2*p, 0);
+    displs = counts + p;
+    if (my_rank == 0) {
+        Allocate(my_rank, "columns", &columns, nonzero_count + 1, 0);
+        Allocate(my_rank, "entries", &entries, nonzero_count + 1, 1);
+        Allocate(my_rank, "row_counts", &row_counts, n + 1, 0);
+        nonzero_count = 0;
+        for (i = 0; i < n; i++) {
+            row_counts[i] = Generate_row(i, n, diagonal, prob, symmetric,
+                columns + nonzero_count, entries + nonzero_count);
+            nonzero_count += row_counts[i];
+        }
+        /* Nonzeros in each process's rows */
         nonzero_count = 0;
-        for (j = 0; j < n; j++) {
-            if (i == j) {
+        for (q = 0; q < p; q++) {
+            displs[q] = nonzero_count;
+            counts[q] = 0;
+            for (i = Block_low(q, p, n); i < Block_low(q + 1, p, n); i++)
+                counts[q] += row_counts[i];
+            nonzero_count += counts[q];
+        }
+    }
+    MPI_Scatter(counts, 1, MPI_INT, &nonzero_count, 1, MPI_INT, 0,
+        MPI_COMM_WORLD);
+    A = Allocate_dist_csr(n, nonzero_count, MPI_COMM_WORLD);
+    if (A == (DIST_CSR_T*) NULL)
+        Allocate_failed(my_rank, "A");
+
+    MPI_Scatterv(columns, counts, displs, MPI_INT, A->col_index,
+        nonzero_count, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Scatterv(entries, counts, displs, MPI_DOUBLE, A->values,
+        nonzero_count, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    /* Now the row lengths */
+    if (my_rank == 0)
+        for (q = 0; q < p; q++) {
+            displs[q] = Block_low(q, p, n);
+            counts[q] = Block_size(q, p, n);
+        }
+    MPI_Scatterv(row_counts, counts, displs, MPI_INT, A->row_start + 1,
+        A->local_rows, MPI_INT, 0, MPI_COMM_WORLD);
+    for (i = 0; i < A->local_rows; i++)
+        A->row_start[i+1] += A->row_start[i];
+
+    free(counts);
+    if (my_rank == 0) {
+        free(columns);
+        free(entries);
+        free(row_counts);
+    }
+    return A;
+}  /* Initialize_matrix */
+
+
+/*========================================================
+ *
+ * Store the nonzeros in row i in columns and temp_row, and
+ *     return their number.  If columns is NULL, just count
+ *     them.
+ */
+int Generate_row(int i, int n, double diagonal, double prob,
+                 int symmetric, int* columns, double* temp_row) {
+    int nonzero_count = 0;
+    int j;
+    int row, col;
+
+    for (j = 0; j < n; j++) {
+        /* A symmetric matrix uses the entries above the diagonal */
+        if (symmetric && (j < i)) {
+            row = j;
+            col = i;
+        } else {
+            row = i;
+            col = j;
+        }
+        if (i == j) {
+            if (columns != NULL) {
                 temp_row[nonzero_count] = diagonal;
                 columns[nonzero_count] = j;
-                nonzero_count++;
-            } else if (drand48() <= prob) {
+            }
+            nonzero_count++;
+        } else if (Uniform(row, col, 0) <= prob) {
+            if (columns != NULL) {
                 temp_row[nonzero_count] = 
-                    2.0*drand48()-1.0;
+                    2.0*Uniform(row, col, 1)-1.0;
                 columns[nonzero_count] = j;
-                nonzero_count++;
             }
+            nonzero_count++;
         }
-        /* Insert entries in a single row (row i) into */
-        /* the matrix                                  */
-        MatSetValues(A, 1, &i, nonzero_count, columns, 
-                     temp_row, INSERT_VALUES);
     }
-}  /* Initialize_matrix */
+    return nonzero_count;
+}  /* Generate_row */
+
+
+/*========================================================
+ *
+ * Hash (i,j,which) to a double in [0,1)
+ */
+double Uniform(int i, int j, int which) {
+    unsigned long x = ((unsigned long) i)*0x9e3779b1UL +
+        ((unsigned long) j)*0x85ebca6bUL + which*0xc2b2ae35UL + 1;
+
+    x &= 0xffffffffUL;
+    x ^= x >> 16;
+    x *= 0x7feb352dUL;
+    x &= 0xffffffffUL;
+    x ^= x >> 15;
+    x *= 0x846ca68bUL;
+    x &= 0xffffffffUL;
+    x ^= x >> 16;
+
+    return x/4294967296.0;
+}  /* Uniform */
 
 
 /*========================================================
@@ -392,3 +560,17 @@ void Allocate(int my_rank, char* name, void* list,
         MPI_Abort(MPI_COMM_WORLD, -1);
     }
 }  /* Allocate */
+
+
+/*========================================================
+ * 
+ * Report a failed allocation of a struct and exit
+ */
+void Allocate_failed(int my_rank, char* name) {
+    fprintf(stderr, 
+        "Process %d > Malloc failed for %s!\n", 
+        my_rank, name); 
+    fprintf(stderr, "Process %d > Quitting.\n", 
+        my_rank);
+    MPI_Abort(MPI_COMM_WORLD, -1);
+}  /* Allocate_failed */
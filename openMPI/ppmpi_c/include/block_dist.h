@@ -0,0 +1,20 @@
+/* block_dist.h -- block distribution of n items among p processes.
+ *     Process id gets items Block_low(id,p,n), ...,
+ *     Block_high(id,p,n).  The block sizes differ by at most 1, so n
+ *     needn't be divisible by p.  The products are formed in long, so
+ *     id*n may exceed INT_MAX.
+ *
+ * Shared by the chapters:  their makefiles add -I../include.
+ */
+#ifndef BLOCK_DIST_H
+#define BLOCK_DIST_H
+
+#define Block_low(id,p,n)   ((int) (((long) (id))*(n)/(p)))
+#define Block_high(id,p,n)  (Block_low((id)+1,p,n) - 1)
+#define Block_size(id,p,n)  (Block_low((id)+1,p,n) - Block_low(id,p,n))
+
+/* The process whose block contains item index */
+#define Block_owner(index,p,n) \
+    ((int) ((((long) (p))*((index)+1) - 1)/(n)))
+
+#endif
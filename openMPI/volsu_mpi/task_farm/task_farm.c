@@ -0,0 +1,178 @@
+/*
+Раздача работы "мастер - рабочие", см. task_farm.h.
+
+Протокол:
+  - мастер сразу отправляет каждому рабочему первую порцию (два числа long:
+    first и last) с тегом TAG_WORK;
+  - рабочий вычисляет порцию и отправляет результат с тегом TAG_RESULT;
+    это же сообщение служит запросом следующей порции;
+  - мастер принимает результаты от MPI_ANY_SOURCE, объединяет их
+    (MPI_Reduce_local) и отвечает отправителю новой порцией или пустым
+    сообщением с тегом TAG_STOP, если элементы закончились.
+
+Если мастер тоже вычисляет, он берёт порции по minChunk элементов и между
+ними проверяет (MPI_Iprobe), не ждёт ли кто-нибудь из рабочих ответа.
+
+Результаты складываются в порядке прихода, поэтому при округлениях сумма
+может немного отличаться от запуска к запуску.
+*/
+
+#include <stdlib.h>
+#include "task_farm.h"
+
+#define TAG_WORK 1
+#define TAG_STOP 2
+#define TAG_RESULT 3
+
+// Порция равна остатку, делённому на TASK_FARM_FACTOR * (число вычисляющих
+// процессов). При 1 это классический guided self-scheduling, при больших
+// значениях первые порции меньше и нагрузка выравнивается лучше.
+#ifndef TASK_FARM_FACTOR
+#define TASK_FARM_FACTOR 2
+#endif
+
+static long NextChunk(long remaining, long minChunk, int computing)
+{
+    long chunk = (remaining + (long)TASK_FARM_FACTOR * computing - 1) /
+                 ((long)TASK_FARM_FACTOR * computing);
+
+    if (chunk < minChunk)
+        chunk = minChunk;
+    if (chunk > remaining)
+        chunk = remaining;
+    return chunk;
+}
+
+static void RunWorker(TaskFarmWork work, void *arg, void *partial, int count,
+                      MPI_Datatype type, MPI_Comm comm)
+{
+    long range[2];
+    MPI_Status status;
+
+    while (1)
+    {
+        MPI_Recv(range, 2, MPI_LONG, 0, MPI_ANY_TAG, comm, &status);
+        if (status.MPI_TAG == TAG_STOP)
+            break;
+        work(range[0], range[1], partial, arg);
+        MPI_Send(partial, count, type, 0, TAG_RESULT, comm);
+    }
+}
+
+static void RunMaster(long total, long minChunk, int masterWorks,
+                      TaskFarmWork work, void *arg, void *result,
+                      void *partial, int count, MPI_Datatype type, MPI_Op op,
+                      MPI_Comm comm, int procNum)
+{
+    long next = 0;        // первый ещё не розданный элемент
+    int outstanding = 0;  // рабочие, у которых сейчас есть порция
+    int computing = procNum - 1 + (masterWorks ? 1 : 0);
+    long range[2];
+    int flag;
+    MPI_Status status;
+
+    // Нейтральный элемент: результат пустого диапазона
+    work(0, 0, result, arg);
+
+    for (int i = 1; i < procNum; i++)
+    {
+        if (next < total)
+        {
+            range[0] = next;
+            range[1] = next + NextChunk(total - next, minChunk, computing);
+            next = range[1];
+            MPI_Send(range, 2, MPI_LONG, i, TAG_WORK, comm);
+            outstanding++;
+        }
+        else
+        {
+            MPI_Send(range, 0, MPI_LONG, i, TAG_STOP, comm);
+        }
+    }
+
+    while (outstanding > 0 || (masterWorks && next < total))
+    {
+        if (masterWorks && next < total)
+        {
+            flag = 0;
+            if (outstanding > 0)
+                MPI_Iprobe(MPI_ANY_SOURCE, TAG_RESULT, comm, &flag, &status);
+            if (!flag)
+            {
+                // Никто не ждёт: мастер вычисляет сам
+                range[0] = next;
+                if (outstanding > 0)
+                    range[1] = next + (total - next < minChunk ?
+                                       total - next : minChunk);
+                else
+                    range[1] = next + NextChunk(total - next, minChunk,
+                                                computing);
+                next = range[1];
+                work(range[0], range[1], partial, arg);
+                MPI_Reduce_local(partial, result, count, type, op);
+                continue;
+            }
+        }
+
+        MPI_Recv(partial, count, type, MPI_ANY_SOURCE, TAG_RESULT, comm,
+                 &status);
+        MPI_Reduce_local(partial, result, count, type, op);
+        outstanding--;
+
+        if (next < total)
+        {
+            range[0] = next;
+            range[1] = next + NextChunk(total - next, minChunk, computing);
+            next = range[1];
+            MPI_Send(range, 2, MPI_LONG, status.MPI_SOURCE, TAG_WORK, comm);
+            outstanding++;
+        }
+        else
+        {
+            MPI_Send(range, 0, MPI_LONG, status.MPI_SOURCE, TAG_STOP, comm);
+        }
+    }
+}
+
+int TaskFarmRun(long total, long minChunk, int masterWorks,
+                TaskFarmWork work, void *arg, void *result, int count,
+                MPI_Datatype type, MPI_Op op, MPI_Comm comm)
+{
+    int procNum, procRank;
+    int ok, allOk;
+    MPI_Aint lb, extent;
+    void *partial;
+    MPI_Comm farmComm;
+
+    // Отдельный коммуникатор, чтобы теги не пересекались с сообщениями
+    // программы
+    MPI_Comm_dup(comm, &farmComm);
+    MPI_Comm_size(farmComm, &procNum);
+    MPI_Comm_rank(farmComm, &procRank);
+
+    if (procNum == 1)
+        masterWorks = 1;
+    if (minChunk < 1)
+        minChunk = 1;
+
+    MPI_Type_get_extent(type, &lb, &extent);
+    partial = malloc(extent * count + 1);
+    ok = (partial != NULL);
+    MPI_Allreduce(&ok, &allOk, 1, MPI_INT, MPI_LAND, farmComm);
+    if (!allOk)
+    {
+        free(partial);
+        MPI_Comm_free(&farmComm);
+        return -1;
+    }
+
+    if (procRank == 0)
+        RunMaster(total, minChunk, masterWorks, work, arg, result, partial,
+                  count, type, op, farmComm, procNum);
+    else
+        RunWorker(work, arg, partial, count, type, farmComm);
+
+    free(partial);
+    MPI_Comm_free(&farmComm);
+    return 0;
+}
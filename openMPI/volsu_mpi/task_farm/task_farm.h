@@ -0,0 +1,36 @@
+/*
+Раздача работы "мастер - рабочие" (task farm).
+
+Элементы 0..total-1 (слагаемые суммы, отрезки разбиения интеграла и т.п.)
+раздаются порциями по запросу: процесс, закончивший свою порцию, сразу
+получает следующую. Размер порции убывает по мере выполнения работы
+(guided self-scheduling): сначала крупные порции, чтобы было меньше
+сообщений, в конце мелкие, чтобы процессы закончили одновременно.
+Частичные результаты мастер (процесс 0) принимает от MPI_ANY_SOURCE и
+сразу объединяет операцией op.
+
+Сборка: mpicc program.c task_farm.c -I<каталог task_farm>
+*/
+
+#ifndef TASK_FARM_H
+#define TASK_FARM_H
+
+#include "mpi.h"
+
+// Вычисляет результат для элементов first..last-1 и записывает его в result
+// (count элементов типа type). Для пустого диапазона (first == last) должна
+// записать нейтральный элемент операции op, например 0 для суммы.
+typedef void (*TaskFarmWork)(long first, long last, void *result, void *arg);
+
+// Вычисляет результат для всех total элементов. Коллективная функция: её
+// вызывают все процессы comm. Результат получает только процесс 0.
+//   minChunk    - наименьший размер порции
+//   masterWorks - если не 0, процесс 0 тоже вычисляет, в перерывах между
+//                 ответами рабочим (если процесс один, он вычисляет всегда)
+//   work, arg   - функция, вычисляющая порцию, и её параметры
+// Возвращает 0 или -1, если не хватило памяти.
+int TaskFarmRun(long total, long minChunk, int masterWorks,
+                TaskFarmWork work, void *arg, void *result, int count,
+                MPI_Datatype type, MPI_Op op, MPI_Comm comm);
+
+#endif